@@ -0,0 +1,715 @@
+/**
+ * bench.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  Microbenchmarks of the CPU kernels, run by `make bench`. Results are
+ *  written as JSON (to the file named on the command line, or stdout) in
+ *  a fixed order with fixed formatting, and with no times or host names
+ *  in them, so two commits' results can simply be diffed.
+ *
+ *  Each benchmark runs once to warm up, then BENCH_RUNS times; the median
+ *  and the best run are reported in nanoseconds per operation. Inputs
+ *  come from a fixed-seed generator, so every run sees the same data.
+ *
+ *  Accuracy checks ride along under "checks": RotateBatch() (qbatch.hpp)
+ *  against Quaternion::rotate(), forced onto each instruction set the CPU
+ *  has, in place and not, with every length of scalar tail; and the BVH's
+ *  closest hits against testing every box. A check over its limit makes
+ *  the program exit with 1.
+ */
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "./quaternion.hpp"
+#include "./qbatch.hpp"
+#include "./mesh.hpp"
+#include "./frustum.hpp"
+#include "./transform.hpp"
+#include "./jobs.hpp"
+
+using namespace std;
+
+const int BENCH_RUNS = 7;                   // Timed runs per benchmark
+const int QUAT_COUNT = 1 << 16;             // Quaternions and vectors
+const int LAYOUT_VERTICES = 1 << 18;        // Vertices per layout pass
+const int CULL_BOXES = 1 << 16;             // Boxes per frustum cull
+const int TREE_NODES = 1 << 15;             // Nodes in the transform tree
+const int GRID_SIZES[] = { 32, 128, 512 };  // Mesh grid edges, in vertices
+const int BVH_BOXES = 1 << 15;              // Boxes in the BVH
+const int BVH_LEAF_SIZE = 4;                // Most boxes in a leaf
+const int BVH_RAYS = 1 << 12;               // Rays per query run
+const int BVH_CHECK_RAYS = 256;             // Rays also tested brute force
+const int PARTICLES = 1 << 18;              // Particles integrated
+const float PARTICLE_STEP = 1.0f / 60.0f;   // Seconds per step
+const float PARTICLE_DRAG = 0.1f;           // Velocity lost per second
+const float PARTICLE_BOUNCE = 0.6f;         // Speed kept off the ground
+const float ROTATE_TOLERANCE = 1e-5f;       // Relative error allowed
+const float EMPTY_BOUNDS = 1e30f;           // Bounds before any box
+
+// RotateBatch() kernels to check, and lengths that leave every size of
+// scalar tail for SSE and a short and a long one for the wider kernels.
+const char *const ROTATE_ISAS[] = { "avx512", "avx2", "sse", "scalar" };
+const int ROTATE_ISA_COUNT = 4;
+const int ROTATE_CHECK_LENGTHS[] = { QUAT_COUNT, QUAT_COUNT - 13, 29, 23,
+                                     14, 1 };
+const int ROTATE_CHECK_SIZES = 6;
+
+/**
+ * One benchmark's timings.
+ */
+typedef struct {
+  string name;
+  long long size;                           // Problem size
+  long long ops;                            // Operations per run
+  double median, best;                      // Nanoseconds per operation
+} BenchResult;
+
+/**
+ * One accuracy check.
+ */
+typedef struct {
+  string name;
+  double value, limit;
+} BenchCheck;
+
+/**
+ * A BVH node. Inner nodes keep their left child right after them and the
+ * right child at first; leaves hold count boxes from first on.
+ */
+typedef struct {
+  glm::vec3 lo, hi;
+  int first, count;                         // count 0 for inner nodes
+} BVHNode;
+
+/**
+ * Random boxes and a BVH over them, built by median split.
+ */
+typedef struct {
+  vector<glm::vec3> lo, hi;
+  vector<int> order;                        // Box indices in leaf order
+  vector<BVHNode> nodes;
+} BVH;
+
+static vector<BenchResult> results;
+static vector<BenchCheck> checks;
+static volatile float sink;                 // Keeps results observable
+static unsigned int seed = 12345;
+
+
+/**
+ * Fixed-seed generator, the same on every platform.
+ * @return a float in [-1, 1)
+ */
+static float Random() {
+  seed = seed * 1664525u + 1013904223u;
+  return (seed >> 8) / 8388608.0f - 1.0f;
+}
+
+/**
+ * Times a benchmark body and records it.
+ * @param name - key in the JSON
+ * @param size - problem size, for benchmarks run at several
+ * @param ops - operations one call of the body performs
+ * @param body - the work; called BENCH_RUNS + 1 times
+ */
+template <typename Body>
+static void Measure(const string& name, long long size, long long ops,
+                    Body body) {
+  typedef chrono::steady_clock Clock;
+  vector<double> times;
+  BenchResult r;
+
+  body();
+  for (int i = 0; i < BENCH_RUNS; i++) {
+    Clock::time_point start = Clock::now();
+    body();
+    times.push_back(chrono::duration<double, nano>(Clock::now() - start)
+                    .count() / ops);
+  }
+  sort(times.begin(), times.end());
+
+  r.name = name;
+  r.size = size;
+  r.ops = ops;
+  r.median = times[times.size() / 2];
+  r.best = times[0];
+  results.push_back(r);
+}
+
+/**
+ * Records an accuracy check.
+ */
+static void Check(const string& name, double value, double limit) {
+  BenchCheck c = { name, value, limit };
+  checks.push_back(c);
+}
+
+/**
+ * A random unit quaternion.
+ */
+static Quaternion RandomRotation() {
+  glm::vec3 axis(Random(), Random(), Random() + 2.0f);
+
+  return Quaternion(Random() * PI, axis, RAD);
+}
+
+
+/**
+ * Quaternion products, rotation and matrices one at a time, and rotation
+ * of whole arrays by RotateBatch().
+ */
+static void BenchQuaternion() {
+  vector<Quaternion> qs(QUAT_COUNT), out(QUAT_COUNT);
+  vector<float> x(QUAT_COUNT), y(QUAT_COUNT), z(QUAT_COUNT);
+  vector<float> qw(QUAT_COUNT), qx(QUAT_COUNT), qy(QUAT_COUNT),
+                qz(QUAT_COUNT);
+  vector<float> ox(QUAT_COUNT), oy(QUAT_COUNT), oz(QUAT_COUNT);
+  Quaternion q = RandomRotation();
+  double error = 0.0;
+
+  for (int i = 0; i < QUAT_COUNT; i++) {
+    qs[i] = RandomRotation();
+    qw[i] = qs[i].w();
+    qx[i] = qs[i].x();
+    qy[i] = qs[i].y();
+    qz[i] = qs[i].z();
+    x[i] = Random() * 100.0f;
+    y[i] = Random() * 100.0f;
+    z[i] = Random() * 100.0f;
+  }
+
+  Measure("quaternion_multiply", QUAT_COUNT, QUAT_COUNT, [&]() {
+    for (int i = 0; i < QUAT_COUNT; i++)
+      out[i] = qs[i] * qs[(i + 1) & (QUAT_COUNT - 1)];
+    sink = out[QUAT_COUNT / 2].w();
+  });
+  Measure("quaternion_product", QUAT_COUNT, QUAT_COUNT, [&]() {
+    for (int i = 0; i < QUAT_COUNT; i++)
+      out[i] = qs[i].product(qs[(i + 1) & (QUAT_COUNT - 1)]);
+    sink = out[QUAT_COUNT / 2].w();
+  });
+  Measure("quaternion_rotate", QUAT_COUNT, QUAT_COUNT, [&]() {
+    for (int i = 0; i < QUAT_COUNT; i++) {
+      glm::vec3 r = q.rotate(glm::vec3(x[i], y[i], z[i]));
+      ox[i] = r.x;
+      oy[i] = r.y;
+      oz[i] = r.z;
+    }
+    sink = ox[QUAT_COUNT / 2];
+  });
+  Measure("quaternion_matrix", QUAT_COUNT, QUAT_COUNT, [&]() {
+    float sum = 0.0f;
+    for (int i = 0; i < QUAT_COUNT; i++) {
+      Quaternion fresh(qs[i].w(), qs[i].x(), qs[i].y(), qs[i].z());
+      sum += fresh.matrix()[5];
+    }
+    sink = sum;
+  });
+  Measure("rotate_batch_uniform", QUAT_COUNT, QUAT_COUNT, [&]() {
+    RotateBatch(q, &x[0], &y[0], &z[0], &ox[0], &oy[0], &oz[0],
+                QUAT_COUNT);
+    sink = ox[QUAT_COUNT / 2];
+  });
+  Measure("rotate_batch_per_element", QUAT_COUNT, QUAT_COUNT, [&]() {
+    RotateBatch(&qw[0], &qx[0], &qy[0], &qz[0], &x[0], &y[0], &z[0],
+                &ox[0], &oy[0], &oz[0], QUAT_COUNT);
+    sink = ox[QUAT_COUNT / 2];
+  });
+
+  // Every kernel the CPU can run, forced in turn, against the scalar
+  // path: both forms, out of place and in place (outputs = inputs), and
+  // at lengths that leave a different tail for each lane width.
+  for (int k = 0; k < ROTATE_ISA_COUNT; k++) {
+    if (!RotateBatchForceISA(ROTATE_ISAS[k]))
+      continue;
+    for (int pass = 0; pass < 4; pass++) {
+      bool perElement = pass & 1, inPlace = pass & 2;
+      string name = string("rotate_batch_") + ROTATE_ISAS[k] +
+                    (perElement ? "_per_element" : "_uniform") +
+                    (inPlace ? "_in_place_error" : "_error");
+
+      error = 0.0;
+      for (int s = 0; s < ROTATE_CHECK_SIZES; s++) {
+        int n = ROTATE_CHECK_LENGTHS[s];
+
+        // Past n must stay untouched.
+        fill(ox.begin(), ox.end(), 0.0f);
+        fill(oy.begin(), oy.end(), 0.0f);
+        fill(oz.begin(), oz.end(), 0.0f);
+        if (inPlace) {
+          copy(x.begin(), x.begin() + n, ox.begin());
+          copy(y.begin(), y.begin() + n, oy.begin());
+          copy(z.begin(), z.begin() + n, oz.begin());
+        }
+        const float *ix = inPlace ? &ox[0] : &x[0];
+        const float *iy = inPlace ? &oy[0] : &y[0];
+        const float *iz = inPlace ? &oz[0] : &z[0];
+        if (perElement)
+          RotateBatch(&qw[0], &qx[0], &qy[0], &qz[0], ix, iy, iz,
+                      &ox[0], &oy[0], &oz[0], n);
+        else
+          RotateBatch(q, ix, iy, iz, &ox[0], &oy[0], &oz[0], n);
+
+        for (int i = 0; i < n; i++) {
+          glm::vec3 v(x[i], y[i], z[i]);
+          glm::vec3 r = (perElement ? qs[i] : q).rotate(v);
+          glm::vec3 d = r - glm::vec3(ox[i], oy[i], oz[i]);
+          double e = glm::length(d) / max(glm::length(v), 1e-3f);
+
+          // max() would drop a NaN; a non-finite result always fails.
+          error = max(error, isfinite(e) ? e : HUGE_VAL);
+        }
+        for (int i = n; i < QUAT_COUNT; i++) {
+          if (ox[i] != 0.0f || oy[i] != 0.0f || oz[i] != 0.0f)
+            error = HUGE_VAL;
+        }
+      }
+      Check(name, error, ROTATE_TOLERANCE);
+    }
+  }
+  RotateBatchForceISA(NULL);
+}
+
+/**
+ * A flat grid of triangles as Assimp would import it, with no materials.
+ * @param edge - vertices along each side
+ * @return a new scene, for the caller to delete
+ */
+static aiScene* GridScene(int edge) {
+  aiScene *scene = new aiScene;
+  aiMesh *mesh = new aiMesh;
+  int quads = (edge - 1) * (edge - 1);
+
+  mesh->mNumVertices = edge * edge;
+  mesh->mVertices = new aiVector3D[edge * edge];
+  mesh->mNormals = new aiVector3D[edge * edge];
+  for (int j = 0; j < edge; j++) {
+    for (int i = 0; i < edge; i++) {
+      mesh->mVertices[j * edge + i] = aiVector3D(i, Random() * 0.1f, j);
+      mesh->mNormals[j * edge + i] = aiVector3D(0.0f, 1.0f, 0.0f);
+    }
+  }
+
+  mesh->mNumFaces = quads * 2;
+  mesh->mFaces = new aiFace[quads * 2];
+  for (int j = 0, f = 0; j + 1 < edge; j++) {
+    for (int i = 0; i + 1 < edge; i++) {
+      unsigned int a = j * edge + i, b = a + 1, c = a + edge, d = c + 1;
+      unsigned int tris[2][3] = { { a, c, b }, { b, c, d } };
+
+      for (int t = 0; t < 2; t++, f++) {
+        mesh->mFaces[f].mNumIndices = 3;
+        mesh->mFaces[f].mIndices = new unsigned int[3];
+        for (int k = 0; k < 3; k++)
+          mesh->mFaces[f].mIndices[k] = tris[t][k];
+      }
+    }
+  }
+
+  scene->mNumMeshes = 1;
+  scene->mMeshes = new aiMesh*[1];
+  scene->mMeshes[0] = mesh;
+
+  return scene;
+}
+
+/**
+ * Mesh::loadScene() (ProcessScene) on grids of growing size, per vertex
+ * written to the VBO.
+ */
+static void BenchProcessScene() {
+  for (int s = 0; s < sizeof(GRID_SIZES) / sizeof(GRID_SIZES[0]); s++) {
+    int edge = GRID_SIZES[s];
+    aiScene *scene = GridScene(edge);
+    long long written = 6LL * (edge - 1) * (edge - 1);
+    Mesh mesh;
+
+    Measure("mesh_process_scene", edge * edge, written, [&]() {
+      mesh.loadScene(scene);
+      sink = mesh.vboSize();
+    });
+    delete scene;
+  }
+}
+
+/**
+ * Positions and normals through a model matrix, read from interleaved
+ * VBOVertex records (AoS) and from one array per component (SoA).
+ */
+static void BenchVertexLayout() {
+  vector<VBOVertex> aos(LAYOUT_VERTICES);
+  vector<float> soa[6];
+  vector<float> out[6];
+  glm::mat4 model = glm::translate(glm::rotate(glm::mat4(1.0f), 0.5f,
+      glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(1.0f, 2.0f, 3.0f));
+  glm::mat3 normalMat(model);
+
+  for (int c = 0; c < 6; c++) {
+    soa[c].resize(LAYOUT_VERTICES);
+    out[c].resize(LAYOUT_VERTICES);
+  }
+  for (int i = 0; i < LAYOUT_VERTICES; i++) {
+    for (int c = 0; c < 3; c++) {
+      aos[i].position[c] = soa[c][i] = Random() * 50.0f;
+      aos[i].normal[c] = soa[3 + c][i] = Random();
+    }
+  }
+
+  Measure("vertex_transform_aos", LAYOUT_VERTICES, LAYOUT_VERTICES, [&]() {
+    for (int i = 0; i < LAYOUT_VERTICES; i++) {
+      const VBOVertex& v = aos[i];
+      glm::vec4 p = model * glm::vec4(v.position[0], v.position[1],
+                                      v.position[2], 1.0f);
+      glm::vec3 n = normalMat * glm::vec3(v.normal[0], v.normal[1],
+                                          v.normal[2]);
+      out[0][i] = p.x;
+      out[1][i] = p.y;
+      out[2][i] = p.z;
+      out[3][i] = n.x;
+      out[4][i] = n.y;
+      out[5][i] = n.z;
+    }
+    sink = out[0][LAYOUT_VERTICES / 2];
+  });
+  Measure("vertex_transform_soa", LAYOUT_VERTICES, LAYOUT_VERTICES, [&]() {
+    for (int i = 0; i < LAYOUT_VERTICES; i++) {
+      glm::vec4 p = model * glm::vec4(soa[0][i], soa[1][i], soa[2][i], 1.0f);
+      glm::vec3 n = normalMat * glm::vec3(soa[3][i], soa[4][i], soa[5][i]);
+      out[0][i] = p.x;
+      out[1][i] = p.y;
+      out[2][i] = p.z;
+      out[3][i] = n.x;
+      out[4][i] = n.y;
+      out[5][i] = n.z;
+    }
+    sink = out[0][LAYOUT_VERTICES / 2];
+  });
+}
+
+/**
+ * Frustum::cullBoxes() over boxes scattered around the view, the spatial
+ * query the scene and the crystal field run every frame. The view is
+ * main's 40 degree projection (this GLM takes fovy in degrees).
+ */
+static void BenchFrustum() {
+  vector<float> lo[3], hi[3];
+  vector<int> inside;
+  Frustum frustum(glm::perspective(40.0f, 4.0f / 3.0f, 1.0f, 800.0f) *
+                  glm::lookAt(glm::vec3(0.0f, 5.0f, 50.0f), glm::vec3(0.0f),
+                              glm::vec3(0.0f, 1.0f, 0.0f)));
+
+  for (int c = 0; c < 3; c++) {
+    lo[c].resize(CULL_BOXES);
+    hi[c].resize(CULL_BOXES);
+  }
+  for (int i = 0; i < CULL_BOXES; i++) {
+    for (int c = 0; c < 3; c++) {
+      lo[c][i] = Random() * 400.0f;
+      hi[c][i] = lo[c][i] + 2.0f;
+    }
+  }
+
+  Measure("frustum_cull_boxes", CULL_BOXES, CULL_BOXES, [&]() {
+    inside.clear();
+    sink = frustum.cullBoxes(&lo[0][0], &lo[1][0], &lo[2][0], &hi[0][0],
+                             &hi[1][0], &hi[2][0], CULL_BOXES, inside);
+  });
+}
+
+/**
+ * TransformTree::update() after every node moved, the per-object update
+ * each frame pays for everything that animates.
+ */
+static void BenchTransformTree() {
+  TransformTree tree;
+  vector<glm::mat4> locals(TREE_NODES);
+
+  for (int i = 0; i < TREE_NODES; i++) {
+    int parent = i == 0 ? -1 : static_cast<int>((Random() * 0.5f + 0.5f) *
+                                                 min(i, 64));
+    locals[i] = glm::translate(glm::mat4(1.0f),
+                               glm::vec3(Random(), Random(), Random()));
+    tree.addNode(parent, locals[i]);
+  }
+
+  Measure("transform_tree_update", TREE_NODES, TREE_NODES, [&]() {
+    for (int i = 0; i < TREE_NODES; i++)
+      tree.setLocal(i, locals[i]);
+    sink = tree.update();
+  });
+}
+
+/**
+ * Adds the node over order[first, first + count), then, unless it is
+ * small enough for a leaf, splits it at the median centroid along its
+ * longest axis and recurses.
+ * @return the node's index
+ */
+static int BuildBVH(BVH& bvh, int first, int count) {
+  int index = bvh.nodes.size();
+  BVHNode node;
+  glm::vec3 cLo(EMPTY_BOUNDS), cHi(-EMPTY_BOUNDS);
+
+  node.lo = glm::vec3(EMPTY_BOUNDS);
+  node.hi = glm::vec3(-EMPTY_BOUNDS);
+  for (int i = first; i < first + count; i++) {
+    int b = bvh.order[i];
+    node.lo = glm::min(node.lo, bvh.lo[b]);
+    node.hi = glm::max(node.hi, bvh.hi[b]);
+    cLo = glm::min(cLo, bvh.lo[b] + bvh.hi[b]);
+    cHi = glm::max(cHi, bvh.lo[b] + bvh.hi[b]);
+  }
+  node.first = first;
+  node.count = count;
+  bvh.nodes.push_back(node);
+  if (count <= BVH_LEAF_SIZE)
+    return index;
+
+  glm::vec3 extent = cHi - cLo;
+  int axis = (extent.x > extent.y && extent.x > extent.z) ? 0 :
+             (extent.y > extent.z) ? 1 : 2;
+  int half = count / 2;
+  nth_element(bvh.order.begin() + first, bvh.order.begin() + first + half,
+              bvh.order.begin() + first + count, [&](int a, int b) {
+    return bvh.lo[a][axis] + bvh.hi[a][axis] <
+           bvh.lo[b][axis] + bvh.hi[b][axis];
+  });
+
+  BuildBVH(bvh, first, half);
+  int right = BuildBVH(bvh, first + half, count - half);
+  bvh.nodes[index].first = right;
+  bvh.nodes[index].count = 0;
+  return index;
+}
+
+/**
+ * Slab test of a ray against a box.
+ * @param tNear - set to where the ray enters the box
+ * @return true if it enters before tMax
+ */
+static bool RayHitsBox(const glm::vec3& origin, const glm::vec3& invDir,
+                       const glm::vec3& lo, const glm::vec3& hi, float tMax,
+                       float& tNear) {
+  glm::vec3 t0 = (lo - origin) * invDir;
+  glm::vec3 t1 = (hi - origin) * invDir;
+  glm::vec3 tMin = glm::min(t0, t1), tOut = glm::max(t0, t1);
+
+  tNear = max(max(tMin.x, tMin.y), max(tMin.z, 0.0f));
+  return tNear <= min(min(tOut.x, tOut.y), min(tOut.z, tMax));
+}
+
+/**
+ * Closest box a ray enters, walking the BVH.
+ * @return the distance to it, or EMPTY_BOUNDS for a miss
+ */
+static float ClosestHit(const BVH& bvh, const glm::vec3& origin,
+                        const glm::vec3& invDir) {
+  int stack[64];
+  int top = 0;
+  float closest = EMPTY_BOUNDS, t;
+
+  stack[top++] = 0;
+  while (top) {
+    int n = stack[--top];
+    const BVHNode& node = bvh.nodes[n];
+
+    if (!RayHitsBox(origin, invDir, node.lo, node.hi, closest, t))
+      continue;
+    if (node.count) {
+      for (int i = node.first; i < node.first + node.count; i++) {
+        int b = bvh.order[i];
+        if (RayHitsBox(origin, invDir, bvh.lo[b], bvh.hi[b], closest, t))
+          closest = t;
+      }
+    } else {
+      stack[top++] = node.first;
+      stack[top++] = n + 1;
+    }
+  }
+
+  return closest;
+}
+
+/**
+ * A median-split BVH over random boxes: the build, and closest-hit ray
+ * queries, checked against testing every box.
+ */
+static void BenchBVH() {
+  BVH bvh;
+  vector<glm::vec3> origins(BVH_RAYS), invDirs(BVH_RAYS);
+  int mismatches = 0;
+
+  for (int i = 0; i < BVH_BOXES; i++) {
+    glm::vec3 lo(Random() * 400.0f, Random() * 400.0f, Random() * 400.0f);
+    glm::vec3 size(Random() + 2.0f, Random() + 2.0f, Random() + 2.0f);
+    bvh.lo.push_back(lo);
+    bvh.hi.push_back(lo + size);
+  }
+  for (int i = 0; i < BVH_RAYS; i++) {
+    glm::vec3 dir(Random(), Random(), Random());
+    origins[i] = glm::vec3(Random(), Random(), Random()) * 400.0f;
+    invDirs[i] = 1.0f / glm::normalize(dir);
+  }
+
+  Measure("bvh_build", BVH_BOXES, BVH_BOXES, [&]() {
+    bvh.order.resize(BVH_BOXES);
+    for (int i = 0; i < BVH_BOXES; i++)
+      bvh.order[i] = i;
+    bvh.nodes.clear();
+    BuildBVH(bvh, 0, BVH_BOXES);
+    sink = bvh.nodes.size();
+  });
+  Measure("bvh_ray_closest", BVH_BOXES, BVH_RAYS, [&]() {
+    float sum = 0.0f;
+    for (int i = 0; i < BVH_RAYS; i++)
+      sum += ClosestHit(bvh, origins[i], invDirs[i]);
+    sink = sum;
+  });
+
+  for (int i = 0; i < BVH_CHECK_RAYS; i++) {
+    float closest = EMPTY_BOUNDS, t;
+
+    for (int b = 0; b < BVH_BOXES; b++) {
+      if (RayHitsBox(origins[i], invDirs[i], bvh.lo[b], bvh.hi[b], closest,
+                     t))
+        closest = t;
+    }
+    if (ClosestHit(bvh, origins[i], invDirs[i]) != closest)
+      mismatches++;
+  }
+  Check("bvh_ray_mismatches", mismatches, 0.0);
+}
+
+/**
+ * Particles under gravity and drag, bouncing off the ground plane, kept
+ * as one array per component so each step is a straight vector loop.
+ */
+static void BenchParticles() {
+  vector<float> px(PARTICLES), py(PARTICLES), pz(PARTICLES);
+  vector<float> vx(PARTICLES), vy(PARTICLES), vz(PARTICLES);
+  const float keep = 1.0f - PARTICLE_DRAG * PARTICLE_STEP;
+  const float fall = -9.8f * PARTICLE_STEP;
+
+  for (int i = 0; i < PARTICLES; i++) {
+    px[i] = Random() * 100.0f;
+    py[i] = Random() * 50.0f + 50.0f;
+    pz[i] = Random() * 100.0f;
+    vx[i] = Random() * 5.0f;
+    vy[i] = Random() * 5.0f;
+    vz[i] = Random() * 5.0f;
+  }
+
+  Measure("particles_soa_step", PARTICLES, PARTICLES, [&]() {
+    float *x = &px[0], *y = &py[0], *z = &pz[0];
+    float *u = &vx[0], *v = &vy[0], *w = &vz[0];
+
+    for (int i = 0; i < PARTICLES; i++) {
+      u[i] *= keep;
+      v[i] = v[i] * keep + fall;
+      w[i] *= keep;
+      x[i] += u[i] * PARTICLE_STEP;
+      y[i] += v[i] * PARTICLE_STEP;
+      z[i] += w[i] * PARTICLE_STEP;
+
+      // Reflect off y = 0, losing some speed.
+      bool under = y[i] < 0.0f;
+      y[i] = under ? -y[i] : y[i];
+      v[i] = under ? -v[i] * PARTICLE_BOUNCE : v[i];
+    }
+    sink = py[PARTICLES / 2];
+  });
+}
+
+/**
+ * Formats a number for the JSON. JSON has no inf or nan, so a
+ * non-finite value is written as null.
+ * @param format - printf format for one double
+ * @param value - the number
+ */
+static string JSONNumber(const char *format, double value) {
+  char text[64];
+
+  if (!isfinite(value))
+    return "null";
+  snprintf(text, sizeof(text), format, value);
+  return text;
+}
+
+/**
+ * Writes every result and check, in the order they ran.
+ * @param out - open file or stdout
+ * @return true if every check passed
+ */
+static bool WriteJSON(FILE *out) {
+  bool passed = true;
+
+  fprintf(out, "{\n");
+  fprintf(out, "  \"schema\": 1,\n");
+  fprintf(out, "  \"rotate_isa\": \"%s\",\n", RotateBatchISA());
+  fprintf(out, "  \"runs\": %d,\n", BENCH_RUNS);
+  fprintf(out, "  \"results\": [\n");
+  for (int i = 0; i < results.size(); i++) {
+    BenchResult& r = results[i];
+    fprintf(out, "    { \"name\": \"%s\", \"size\": %lld, \"ops\": %lld, "
+            "\"ns_per_op\": %s, \"best_ns_per_op\": %s }%s\n",
+            r.name.c_str(), r.size, r.ops,
+            JSONNumber("%.3f", r.median).c_str(),
+            JSONNumber("%.3f", r.best).c_str(),
+            i + 1 < results.size() ? "," : "");
+  }
+  fprintf(out, "  ],\n");
+  fprintf(out, "  \"checks\": [\n");
+  for (int i = 0; i < checks.size(); i++) {
+    BenchCheck& c = checks[i];
+    bool ok = c.value <= c.limit;
+    fprintf(out, "    { \"name\": \"%s\", \"value\": %s, \"limit\": %s, "
+            "\"pass\": %s }%s\n", c.name.c_str(),
+            JSONNumber("%.3e", c.value).c_str(),
+            JSONNumber("%.3e", c.limit).c_str(),
+            ok ? "true" : "false", i + 1 < checks.size() ? "," : "");
+    passed = passed && ok;
+  }
+  fprintf(out, "  ]\n");
+  fprintf(out, "}\n");
+
+  return passed;
+}
+
+int main(int argc, char* argv[]) {
+  FILE *out = stdout;
+  bool passed;
+
+  jobs.start();
+
+  BenchQuaternion();
+  BenchProcessScene();
+  BenchVertexLayout();
+  BenchFrustum();
+  BenchTransformTree();
+  BenchBVH();
+  BenchParticles();
+
+  if (argc > 1 && !(out = fopen(argv[1], "w"))) {
+    fprintf(stderr, "Cannot write %s.\n", argv[1]);
+    return 1;
+  }
+  passed = WriteJSON(out);
+  if (out != stdout) {
+    fclose(out);
+    fprintf(stderr, "Wrote %s.\n", argv[1]);
+  }
+
+  return passed ? 0 : 1;
+}
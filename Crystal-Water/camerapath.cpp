@@ -0,0 +1,248 @@
+/**
+ * camerapath.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "./camerapath.hpp"
+
+using namespace std;
+
+
+/**
+ * Cubic Hermite interpolation over one segment.
+ * @param p0 - value at the start
+ * @param p1 - value at the end
+ * @param m0 - tangent at the start, per second
+ * @param m1 - tangent at the end, per second
+ * @param dt - length of the segment in seconds
+ * @param s - position in the segment, 0 to 1
+ * @return the value in between
+ */
+static glm::vec3 Hermite(const glm::vec3& p0, const glm::vec3& p1,
+                         const glm::vec3& m0, const glm::vec3& m1,
+                         float dt, float s) {
+  float s2 = s * s;
+  float s3 = s2 * s;
+
+  return p0 * (2.0f * s3 - 3.0f * s2 + 1.0f) +
+         m0 * ((s3 - 2.0f * s2 + s) * dt) +
+         p1 * (-2.0f * s3 + 3.0f * s2) +
+         m1 * ((s3 - s2) * dt);
+}
+
+
+/**
+ * Default Constructor. An empty path.
+ */
+CameraPath::CameraPath()
+: dirty(false) {
+}
+
+/**
+ * Default Destructor.
+ */
+CameraPath::~CameraPath() {
+}
+
+/**
+ * Removes every key.
+ */
+void CameraPath::clear() {
+  this->keys.clear();
+  this->dirty = true;
+}
+
+/**
+ * Appends a key. Times must increase from key to key.
+ * @param time - seconds from the start of the path
+ * @param eye - vEye
+ * @param slide - translation of mTrans
+ * @param rotation - qTotalRotation
+ */
+void CameraPath::addKey(double time, const glm::vec3& eye,
+                        const glm::vec3& slide, const Quaternion& rotation) {
+  CameraKey key;
+
+  if (!keys.empty() && time <= keys.back().time)
+    return;
+
+  key.time = time;
+  key.eye = eye;
+  key.slide = slide;
+  key.rotation = rotation;
+
+  // q and -q are the same rotation; keep the one nearer the last key.
+  if (!keys.empty() && key.rotation.dot(keys.back().rotation) < 0.0f)
+    key.rotation = Quaternion(-rotation.w(), -rotation.x(), -rotation.y(),
+                              -rotation.z());
+
+  this->keys.push_back(key);
+  this->dirty = true;
+}
+
+/**
+ * Writes the keys to a text file.
+ * @param filename - path file to write
+ * @return true if it was written
+ */
+bool CameraPath::save(const string& filename) {
+  ofstream file(filename.c_str());
+
+  if (!file.is_open()) {
+    cout << "Cannot write " << filename << "." << endl;
+    return false;
+  }
+
+  file << "# time  eye.xyz  slide.xyz  rotation.wxyz" << endl;
+  file.precision(9);
+  for (int i = 0; i < keys.size(); i++) {
+    CameraKey& k = keys[i];
+
+    file << k.time << "  " << k.eye.x << " " << k.eye.y << " " << k.eye.z
+         << "  " << k.slide.x << " " << k.slide.y << " " << k.slide.z
+         << "  " << k.rotation.w() << " " << k.rotation.x() << " "
+         << k.rotation.y() << " " << k.rotation.z() << endl;
+  }
+
+  return file.good();
+}
+
+/**
+ * Replaces the keys with those of a file written by save().
+ * @param filename - path file to read
+ * @return true if it held at least two keys
+ */
+bool CameraPath::load(const string& filename) {
+  ifstream file(filename.c_str());
+  string line;
+
+  if (!file.is_open()) {
+    cout << "Cannot open " << filename << "." << endl;
+    return false;
+  }
+
+  this->clear();
+  while (getline(file, line)) {
+    istringstream in(line);
+    double time;
+    glm::vec3 eye, slide;
+    float w, x, y, z;
+
+    if (line.empty() || line[0] == '#')
+      continue;
+    if (!(in >> time >> eye.x >> eye.y >> eye.z >> slide.x >> slide.y
+             >> slide.z >> w >> x >> y >> z)) {
+      cout << "Bad camera key in " << filename << ": " << line << endl;
+      return false;
+    }
+    this->addKey(time, eye, slide, Quaternion(w, x, y, z));
+  }
+
+  if (keys.size() < 2) {
+    cout << filename << " needs at least two camera keys." << endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Interpolates the camera at a time on the path. Before the first key and
+ * after the last, the camera holds at that key.
+ * @param time - seconds from the start of the path
+ * @param eye - returns vEye
+ * @param slide - returns the translation of mTrans
+ * @param rotation - returns qTotalRotation
+ */
+void CameraPath::sample(double time, glm::vec3& eye, glm::vec3& slide,
+                        Quaternion& rotation) {
+  int i;
+  float dt, s;
+
+  if (keys.empty())
+    return;
+  if (dirty)
+    this->BuildTangents();
+
+  if (keys.size() == 1 || time <= keys.front().time) {
+    eye = keys.front().eye;
+    slide = keys.front().slide;
+    rotation = keys.front().rotation;
+    return;
+  }
+  if (time >= keys.back().time) {
+    eye = keys.back().eye;
+    slide = keys.back().slide;
+    rotation = keys.back().rotation;
+    return;
+  }
+
+  // The segment [i, i + 1] that holds the time.
+  i = 0;
+  while (keys[i + 1].time < time)
+    i++;
+  dt = static_cast<float>(keys[i + 1].time - keys[i].time);
+  s = static_cast<float>((time - keys[i].time) / dt);
+
+  eye = Hermite(keys[i].eye, keys[i + 1].eye, eyeTangents[i],
+                eyeTangents[i + 1], dt, s);
+  slide = Hermite(keys[i].slide, keys[i + 1].slide, slideTangents[i],
+                  slideTangents[i + 1], dt, s);
+  rotation = Quaternion::squad(keys[i].rotation, keys[i + 1].rotation,
+                               controls[i], controls[i + 1], s);
+}
+
+/**
+ * Retrieves the number of keys.
+ * @return key count
+ */
+int CameraPath::numKeys() {
+  return this->keys.size();
+}
+
+/**
+ * Time of the last key.
+ * @return seconds, or 0 for an empty path
+ */
+double CameraPath::duration() {
+  return keys.empty() ? 0.0 : keys.back().time;
+}
+
+/**
+ * Computes the spline tangents and squad control points of every key.
+ * The first and last keys use their one neighbor.
+ */
+void CameraPath::BuildTangents() {
+  int n = keys.size();
+
+  this->eyeTangents.resize(n);
+  this->slideTangents.resize(n);
+  this->controls.resize(n);
+
+  for (int i = 0; i < n; i++) {
+    int prev = max(i - 1, 0);
+    int next = min(i + 1, n - 1);
+    float span = static_cast<float>(keys[next].time - keys[prev].time);
+
+    if (span > 0.0f) {
+      eyeTangents[i] = (keys[next].eye - keys[prev].eye) / span;
+      slideTangents[i] = (keys[next].slide - keys[prev].slide) / span;
+    } else {
+      eyeTangents[i] = glm::vec3(0.0f);
+      slideTangents[i] = glm::vec3(0.0f);
+    }
+    controls[i] = Quaternion::squadControl(keys[prev].rotation,
+        keys[i].rotation, keys[next].rotation);
+  }
+
+  this->dirty = false;
+}
@@ -0,0 +1,87 @@
+/**
+ * camerapath.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  Recorded camera keyframes and smooth playback between them, so a run
+ *  can be repeated view for view: for demos, and for comparing the frame
+ *  times of two builds on exactly the same frames.
+ *
+ *  Notes:
+ *
+ *    A key is the whole interactive camera: the eye (vEye, moved by the
+ *    wheel), the slide (the translation of mTrans, moved by dragging up
+ *    and down) and the orbit rotation (qTotalRotation), at a time in
+ *    seconds from the start of the path.
+ *
+ *    sample() interpolates the eye and slide with a cubic Hermite spline
+ *    through the keys (Catmull-Rom tangents, scaled for uneven key
+ *    spacing), and the rotation with Quaternion::squad(), so the camera
+ *    passes through every key without a kink in either. Rotations are
+ *    flipped into one hemisphere as keys are added, so no segment takes
+ *    the long way round.
+ *
+ *    The path itself keeps no clock. The caller steps its own, by a fixed
+ *    amount per frame when playing back for a benchmark, so the views do
+ *    not depend on how fast the frames came.
+ *
+ *    save() and load() use a plain text file, one key per line:
+ *
+ *          time  eye.xyz  slide.xyz  rotation.wxyz
+ */
+
+#ifndef CAMERAPATH_HPP_
+#define CAMERAPATH_HPP_
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "./quaternion.hpp"
+
+
+/**
+ * One recorded camera.
+ */
+typedef struct {
+  double time;                              /**< Seconds into the path */
+  glm::vec3 eye;                            /**< vEye */
+  glm::vec3 slide;                          /**< Translation of mTrans */
+  Quaternion rotation;                      /**< qTotalRotation */
+} CameraKey;
+
+
+/**
+ * Camera keyframes with spline and squad interpolation.
+ */
+class CameraPath {
+ public:
+  CameraPath();
+  ~CameraPath();
+
+  void clear();
+  void addKey(double time, const glm::vec3& eye, const glm::vec3& slide,
+              const Quaternion& rotation);
+  bool save(const std::string& filename);
+  bool load(const std::string& filename);
+
+  void sample(double time, glm::vec3& eye, glm::vec3& slide,
+              Quaternion& rotation);
+
+  int numKeys();
+  double duration();
+
+ private:
+  std::vector<CameraKey> keys;
+  std::vector<glm::vec3> eyeTangents, slideTangents;
+  std::vector<Quaternion> controls;
+  bool dirty;
+
+  void BuildTangents();
+};
+
+#endif /* CAMERAPATH_HPP_ */
@@ -0,0 +1,331 @@
+/**
+ * cluster.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <cmath>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "./cluster.hpp"
+#include "./glstate.hpp"
+#include "./jobs.hpp"
+
+using namespace std;
+
+const float PAD_LIGHT_R2 = -1.0f;           // Padding lights reach nothing
+
+
+/**
+ * Default Constructor. No lights and no buffers until upload().
+ */
+LightClusters::LightClusters()
+: boxNear(0.0f),
+  boxFar(0.0f),
+  sliceIndices(CLUSTER_Z),
+  clusters(CLUSTER_COUNT * 2, 0),
+  lightsID(0),
+  clustersID(0),
+  indicesID(0),
+  lightsBytes(0),
+  indicesBytes(0) {
+}
+
+/**
+ * Default Destructor. Frees the storage buffers.
+ */
+LightClusters::~LightClusters() {
+  GLuint ids[3] = { lightsID, clustersID, indicesID };
+
+  if (lightsID)
+    glDeleteBuffers(3, ids);
+}
+
+/**
+ * Adds a point light.
+ * @param position - scene-space position
+ * @param radius - distance at which the light fades to nothing
+ * @param color - light color
+ * @return the new light index
+ */
+int LightClusters::addLight(const glm::vec3& position, float radius,
+                            const glm::vec3& color) {
+  this->positions.push_back(position);
+  this->radii.push_back(radius);
+  this->colors.push_back(color);
+
+  return positions.size() - 1;
+}
+
+/**
+ * Moves a light. Takes effect on the next update().
+ * @param light - index returned by addLight()
+ * @param position - new scene-space position
+ */
+void LightClusters::setPosition(int light, const glm::vec3& position) {
+  positions[light] = position;
+}
+
+/**
+ * Creates the storage buffers. Requires a GL context.
+ */
+void LightClusters::upload() {
+  glGenBuffers(1, &lightsID);
+  glGenBuffers(1, &clustersID);
+  glGenBuffers(1, &indicesID);
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, clustersID);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, clusters.size() * sizeof(GLuint),
+      &clusters[0], GL_STREAM_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/**
+ * Bins every light into the clusters of the current view and uploads the
+ * result. Call once per frame, before drawing.
+ * @param view - scene-to-view matrix (mModel)
+ * @param proj - the projection matrix
+ * @param zNear - near plane distance
+ * @param zFar - far plane distance
+ */
+void LightClusters::update(const glm::mat4& view, const glm::mat4& proj,
+                           float zNear, float zFar) {
+  int nLights = positions.size();
+  int padded = (nLights + 3) & ~3;
+
+  if (proj != boxProj || zNear != boxNear || zFar != boxFar)
+    this->BuildClusterBoxes(proj, zNear, zFar);
+
+  // Lights into view space, packed for the SSE test.
+  lightX.assign(padded, 0.0f);
+  lightY.assign(padded, 0.0f);
+  lightZ.assign(padded, 0.0f);
+  lightR2.assign(padded, PAD_LIGHT_R2);
+  gpuLights.assign(nLights ? nLights : 1, ClusterLight());
+  for (int i = 0; i < nLights; i++) {
+    glm::vec4 p = view * glm::vec4(positions[i], 1.0f);
+
+    lightX[i] = p.x;
+    lightY[i] = p.y;
+    lightZ[i] = p.z;
+    lightR2[i] = radii[i] * radii[i];
+    gpuLights[i].positionRadius = glm::vec4(p.x, p.y, p.z, radii[i]);
+    gpuLights[i].color = glm::vec4(colors[i], 0.0f);
+  }
+
+  // Slices are independent; spread them across the job pool.
+  jobs.parallelFor(CLUSTER_Z, 1, [this](int begin, int end) {
+    for (int z = begin; z < end; z++)
+      this->BinSlice(z);
+  });
+
+  // Join the slice lists; cluster offsets become offsets into the whole.
+  this->indices.clear();
+  for (int z = 0; z < CLUSTER_Z; z++) {
+    GLuint base = indices.size();
+    int first = z * CLUSTER_X * CLUSTER_Y;
+
+    for (int c = first; c < first + CLUSTER_X * CLUSTER_Y; c++)
+      clusters[2 * c] += base;
+    indices.insert(indices.end(), sliceIndices[z].begin(),
+                   sliceIndices[z].end());
+  }
+  if (indices.empty())
+    indices.push_back(0);
+
+  if (!lightsID)
+    return;
+
+  Upload(lightsID, lightsBytes, gpuLights.size() * sizeof(ClusterLight),
+         &gpuLights[0]);
+  Upload(indicesID, indicesBytes, indices.size() * sizeof(GLuint),
+         &indices[0]);
+  glState.bindBuffer(GL_SHADER_STORAGE_BUFFER, clustersID);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+      clusters.size() * sizeof(GLuint), &clusters[0]);
+}
+
+/**
+ * Binds the three storage buffers for shader0.frag.
+ */
+void LightClusters::bind() {
+  glState.bindBufferBase(GL_SHADER_STORAGE_BUFFER, BIND_LIGHTS, lightsID);
+  glState.bindBufferBase(GL_SHADER_STORAGE_BUFFER, BIND_CLUSTERS, clustersID);
+  glState.bindBufferBase(GL_SHADER_STORAGE_BUFFER, BIND_LIGHT_INDICES,
+                         indicesID);
+}
+
+/**
+ * Retrieves the number of lights.
+ * @return number of lights
+ */
+int LightClusters::numLights() {
+  return this->positions.size();
+}
+
+/**
+ * Retrieves the total length of the light index list after the last
+ * update(), i.e. the number of (cluster, light) pairs.
+ * @return number of light indices
+ */
+int LightClusters::numIndices() {
+  return this->indices.size();
+}
+
+/**
+ * Retrieves the view-space lights of the last update(), as uploaded.
+ * @return reference to the packed lights
+ */
+const vector<ClusterLight>& LightClusters::viewLights() {
+  return this->gpuLights;
+}
+
+/**
+ * Retrieves the (offset, count) pair of every cluster after the last
+ * update(), as uploaded.
+ * @return reference to 2 * CLUSTER_COUNT values
+ */
+const vector<GLuint>& LightClusters::clusterRanges() {
+  return this->clusters;
+}
+
+/**
+ * Retrieves the light index list of the last update(), as uploaded.
+ * @return reference to the light indices
+ */
+const vector<GLuint>& LightClusters::lightIndices() {
+  return this->indices;
+}
+
+/**
+ * Computes the view-space box of every cluster. Slice z spans depths
+ * zNear * (zFar / zNear)^(z / CLUSTER_Z) to the next slice; a tile's box
+ * covers its frustum section between those depths.
+ */
+void LightClusters::BuildClusterBoxes(const glm::mat4& proj, float zNear,
+                                      float zFar) {
+  float ratio = zFar / zNear;
+
+  boxMinX.resize(CLUSTER_COUNT);  boxMaxX.resize(CLUSTER_COUNT);
+  boxMinY.resize(CLUSTER_COUNT);  boxMaxY.resize(CLUSTER_COUNT);
+  boxMinZ.resize(CLUSTER_COUNT);  boxMaxZ.resize(CLUSTER_COUNT);
+
+  for (int z = 0; z < CLUSTER_Z; z++) {
+    float dNear = zNear * pow(ratio, z / static_cast<float>(CLUSTER_Z));
+    float dFar = zNear * pow(ratio, (z + 1) / static_cast<float>(CLUSTER_Z));
+
+    for (int y = 0; y < CLUSTER_Y; y++) {
+      float y0 = -1.0f + 2.0f * y / CLUSTER_Y;
+      float y1 = y0 + 2.0f / CLUSTER_Y;
+
+      for (int x = 0; x < CLUSTER_X; x++) {
+        float x0 = -1.0f + 2.0f * x / CLUSTER_X;
+        float x1 = x0 + 2.0f / CLUSTER_X;
+        int c = (z * CLUSTER_Y + y) * CLUSTER_X + x;
+
+        // View-space x at depth d is ndc.x * d / proj[0][0].
+        boxMinX[c] = glm::min(x0 * dNear, x0 * dFar) / proj[0][0];
+        boxMaxX[c] = glm::max(x1 * dNear, x1 * dFar) / proj[0][0];
+        boxMinY[c] = glm::min(y0 * dNear, y0 * dFar) / proj[1][1];
+        boxMaxY[c] = glm::max(y1 * dNear, y1 * dFar) / proj[1][1];
+        boxMinZ[c] = -dFar;
+        boxMaxZ[c] = -dNear;
+      }
+    }
+  }
+
+  this->boxProj = proj;
+  this->boxNear = zNear;
+  this->boxFar = zFar;
+}
+
+/**
+ * Bins the lights of one depth slice into its tiles. Writes only this
+ * slice's clusters and index list, so slices may run concurrently.
+ */
+void LightClusters::BinSlice(int z) {
+  int first = z * CLUSTER_X * CLUSTER_Y;
+  float zMin = boxMinZ[first], zMax = boxMaxZ[first];
+  vector<GLuint>& out = sliceIndices[z];
+  vector<float> cx, cy, cz, cr2;
+  vector<GLuint> cIdx;
+
+  // Lights whose depth range reaches this slice.
+  for (int i = 0; i < positions.size(); i++) {
+    if (lightZ[i] - radii[i] > zMax || lightZ[i] + radii[i] < zMin)
+      continue;
+    cx.push_back(lightX[i]);
+    cy.push_back(lightY[i]);
+    cz.push_back(lightZ[i]);
+    cr2.push_back(lightR2[i]);
+    cIdx.push_back(i);
+  }
+  int nCand = cIdx.size();
+  int padded = (nCand + 3) & ~3;
+  cx.resize(padded, 0.0f);
+  cy.resize(padded, 0.0f);
+  cz.resize(padded, 0.0f);
+  cr2.resize(padded, PAD_LIGHT_R2);
+
+  out.clear();
+  for (int c = first; c < first + CLUSTER_X * CLUSTER_Y; c++) {
+    GLuint start = out.size();
+
+#ifdef __SSE__
+    __m128 loX = _mm_set1_ps(boxMinX[c]), hiX = _mm_set1_ps(boxMaxX[c]);
+    __m128 loY = _mm_set1_ps(boxMinY[c]), hiY = _mm_set1_ps(boxMaxY[c]);
+    __m128 loZ = _mm_set1_ps(boxMinZ[c]), hiZ = _mm_set1_ps(boxMaxZ[c]);
+
+    for (int j = 0; j < padded; j += 4) {
+      // Distance from each sphere center to its closest point in the box.
+      __m128 px = _mm_loadu_ps(&cx[j]);
+      __m128 py = _mm_loadu_ps(&cy[j]);
+      __m128 pz = _mm_loadu_ps(&cz[j]);
+      __m128 dx = _mm_sub_ps(_mm_min_ps(_mm_max_ps(px, loX), hiX), px);
+      __m128 dy = _mm_sub_ps(_mm_min_ps(_mm_max_ps(py, loY), hiY), py);
+      __m128 dz = _mm_sub_ps(_mm_min_ps(_mm_max_ps(pz, loZ), hiZ), pz);
+      __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                             _mm_mul_ps(dz, dz));
+      int hits = _mm_movemask_ps(_mm_cmple_ps(d2, _mm_loadu_ps(&cr2[j])));
+
+      for (int k = 0; hits; k++, hits >>= 1) {
+        if (hits & 1)
+          out.push_back(cIdx[j + k]);
+      }
+    }
+#else
+    for (int j = 0; j < nCand; j++) {
+      float dx = glm::clamp(cx[j], boxMinX[c], boxMaxX[c]) - cx[j];
+      float dy = glm::clamp(cy[j], boxMinY[c], boxMaxY[c]) - cy[j];
+      float dz = glm::clamp(cz[j], boxMinZ[c], boxMaxZ[c]) - cz[j];
+
+      if (dx * dx + dy * dy + dz * dz <= cr2[j])
+        out.push_back(cIdx[j]);
+    }
+#endif
+
+    clusters[2 * c] = start;
+    clusters[2 * c + 1] = out.size() - start;
+  }
+}
+
+/**
+ * Refills a storage buffer, growing it only when the data no longer fits.
+ */
+void LightClusters::Upload(GLuint id, GLsizeiptr& capacity, GLsizeiptr bytes,
+                           const void *data) {
+  glState.bindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+  if (bytes > capacity) {
+    capacity = bytes;
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, data, GL_STREAM_DRAW);
+  } else {
+    glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, data);
+  }
+}
@@ -0,0 +1,114 @@
+/**
+ * cluster.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  Clustered forward lighting: any number of small point lights, of which
+ *  each fragment only shades the few that can reach it.
+ *
+ *  Notes:
+ *
+ *    The view frustum is cut into CLUSTER_X by CLUSTER_Y screen tiles and
+ *    CLUSTER_Z depth slices. Slices are spaced exponentially between the
+ *    near and far planes, so clusters stay roughly cubic at every depth.
+ *
+ *    Every frame update() moves the lights into view space and bins them:
+ *    for each slice, the lights whose depth range touches the slice are
+ *    gathered, then every tile's box is tested against those lights four
+ *    at a time with SSE (sphere against box). Slices are independent, so
+ *    they are spread over the job pool (see jobs.hpp), and the per-slice
+ *    lists are joined into one index list afterwards.
+ *
+ *    Three storage buffers are read by shader0.frag (CLUSTERED_LIGHTS):
+ *
+ *          BIND_LIGHTS         view-space position and radius, color
+ *          BIND_CLUSTERS       (first index, count) per cluster
+ *          BIND_LIGHT_INDICES  light indices of all clusters back to back
+ *
+ *    The cluster grid size must match clusterGrid in shader0.frag.
+ */
+
+#ifndef CLUSTER_HPP_
+#define CLUSTER_HPP_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+const int CLUSTER_X = 16;                   // Screen tiles across
+const int CLUSTER_Y = 9;                    // Screen tiles down
+const int CLUSTER_Z = 24;                   // Depth slices
+const int CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+
+// Storage buffer bindings shared with shader0.frag.
+const GLuint BIND_LIGHTS = 5;
+const GLuint BIND_CLUSTERS = 6;
+const GLuint BIND_LIGHT_INDICES = 7;
+
+/**
+ * One point light as laid out (std430) in the Lights buffer.
+ */
+typedef struct {
+  glm::vec4 positionRadius;                 /**< View-space xyz, radius */
+  glm::vec4 color;                          /**< rgb, unused */
+} ClusterLight;
+
+
+/**
+ * Point lights binned into view-space clusters.
+ */
+class LightClusters {
+ public:
+  LightClusters();
+  ~LightClusters();
+
+  int addLight(const glm::vec3& position, float radius,
+               const glm::vec3& color);
+  void setPosition(int light, const glm::vec3& position);
+  void upload();
+
+  void update(const glm::mat4& view, const glm::mat4& proj, float zNear,
+              float zFar);
+  void bind();
+
+  int numLights();
+  int numIndices();
+  const std::vector<ClusterLight>& viewLights();
+  const std::vector<GLuint>& clusterRanges();
+  const std::vector<GLuint>& lightIndices();
+
+ private:
+  // Scene-space lights.
+  std::vector<glm::vec3> positions;
+  std::vector<float> radii;
+  std::vector<glm::vec3> colors;
+
+  // View-space lights, packed and padded to a multiple of four.
+  std::vector<float> lightX, lightY, lightZ, lightR2;
+  std::vector<ClusterLight> gpuLights;
+
+  // View-space cluster boxes, rebuilt when the projection changes.
+  std::vector<float> boxMinX, boxMinY, boxMinZ, boxMaxX, boxMaxY, boxMaxZ;
+  glm::mat4 boxProj;
+  float boxNear, boxFar;
+
+  // Binning output, per slice and then joined.
+  std::vector<std::vector<GLuint> > sliceIndices;
+  std::vector<GLuint> clusters;
+  std::vector<GLuint> indices;
+
+  GLuint lightsID, clustersID, indicesID;
+  GLsizeiptr lightsBytes, indicesBytes;
+
+  void BuildClusterBoxes(const glm::mat4& proj, float zNear, float zFar);
+  void BinSlice(int z);
+  static void Upload(GLuint id, GLsizeiptr& capacity, GLsizeiptr bytes,
+                     const void *data);
+};
+
+#endif /* CLUSTER_HPP_ */
@@ -0,0 +1,27 @@
+#version 420
+
+// Resolves weighted blended transparency (see oit.hpp). Blended over the
+// opaque image with glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA).
+
+uniform sampler2D accumTex;
+uniform sampler2D revealTex;
+
+out vec4 fragColor;
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float revealage = texelFetch(revealTex, texel, 0).r;
+    vec4 accum;
+
+    // Nothing transparent covers this pixel.
+    if (revealage >= 1.0)
+        discard;
+
+    accum = texelFetch(accumTex, texel, 0);
+
+    // Keep the average finite if the weighted sum overflowed half floats.
+    if (any(isinf(accum.rgb)))
+        accum.rgb = vec3(accum.a);
+
+    fragColor = vec4(accum.rgb / max(accum.a, 1e-5), revealage);
+}
@@ -0,0 +1,10 @@
+#version 420
+
+// One triangle that covers the screen, built from gl_VertexID alone (see
+// WeightedOIT::composite()).
+
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,154 @@
+/**
+ * dynres.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "./dynres.hpp"
+
+using namespace std;
+
+
+/**
+ * Default Constructor. Full scale, no budget, enabled.
+ */
+ResolutionController::ResolutionController()
+: budget(0.0),
+  minScale(0.25f),
+  maxScale(1.0f),
+  scale(1.0f),
+  active(true),
+  nSamples(0),
+  next(0) {
+}
+
+/**
+ * Sets the time the pass should take.
+ * @param millis - budget in milliseconds
+ */
+void ResolutionController::setBudget(double millis) {
+  this->budget = millis;
+}
+
+/**
+ * Sets the range the scale may move in.
+ * @param minScale - smallest scale, above zero
+ * @param maxScale - largest scale, usually 1
+ */
+void ResolutionController::setRange(float minScale, float maxScale) {
+  this->minScale = minScale;
+  this->maxScale = maxScale;
+  this->scale = min(max(scale, minScale), maxScale);
+}
+
+/**
+ * Turns the controller on or off. Off, the scale stays at its maximum.
+ * @param enabled - true to adapt the scale
+ */
+void ResolutionController::setEnabled(bool enabled) {
+  this->active = enabled;
+  this->reset();
+}
+
+/**
+ * Forgets every sample and returns to the largest scale.
+ */
+void ResolutionController::reset() {
+  this->scale = maxScale;
+  this->nSamples = 0;
+  this->next = 0;
+}
+
+/**
+ * Records the time of the frame just drawn at getScale() and picks the
+ * scale for the next one.
+ * @param millis - time the pass took
+ * @return scale for the next frame
+ */
+float ResolutionController::update(double millis) {
+  return this->update(millis, scale);
+}
+
+/**
+ * Records the time of a frame drawn at some earlier scale and picks the
+ * scale for the next one.
+ * @param millis - time the pass took
+ * @param drawnScale - the scale that frame was drawn at
+ * @return scale for the next frame
+ */
+float ResolutionController::update(double millis, float drawnScale) {
+  double cost, average, target;
+
+  cost = millis / (static_cast<double>(drawnScale) * drawnScale);
+  this->costs[next] = cost;
+  this->times[next] = millis;
+  this->next = (next + 1) % DYNRES_WINDOW;
+  this->nSamples = min(nSamples + 1, DYNRES_WINDOW);
+
+  if (!active || budget <= 0.0)
+    return this->scale;
+
+  // Rises at once, falls once the whole window has seen it.
+  average = 0.0;
+  for (int i = 0; i < nSamples; i++)
+    average += costs[i];
+  average /= nSamples;
+  cost = max(cost, average);
+  if (cost <= 0.0)
+    return this->scale;
+
+  target = sqrt(budget * DYNRES_HEADROOM / cost);
+  target = min(max(target, scale - static_cast<double>(DYNRES_MAX_STEP)),
+               scale + static_cast<double>(DYNRES_MAX_STEP));
+  target = floor(target / DYNRES_QUANTUM + 0.5) * DYNRES_QUANTUM;
+  target = min(max(target, static_cast<double>(minScale)),
+               static_cast<double>(maxScale));
+
+  if (fabs(target - scale) >= DYNRES_DEADBAND)
+    this->scale = static_cast<float>(target);
+
+  return this->scale;
+}
+
+/**
+ * Retrieves the scale to draw the next frame at.
+ * @return fraction of the full width and height
+ */
+float ResolutionController::getScale() const {
+  return this->scale;
+}
+
+/**
+ * Retrieves the budget given to setBudget().
+ * @return budget in milliseconds
+ */
+double ResolutionController::getBudget() const {
+  return this->budget;
+}
+
+/**
+ * Retrieves the average measured time over the window.
+ * @return milliseconds, or 0 before the first update()
+ */
+double ResolutionController::averageMillis() const {
+  double sum = 0.0;
+
+  for (int i = 0; i < nSamples; i++)
+    sum += times[i];
+
+  return nSamples ? sum / nSamples : 0.0;
+}
+
+/**
+ * Reports whether the scale adapts.
+ * @return true unless setEnabled(false)
+ */
+bool ResolutionController::enabled() const {
+  return this->active;
+}
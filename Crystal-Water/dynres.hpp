@@ -0,0 +1,73 @@
+/**
+ * dynres.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  Dynamic resolution: picks the render scale of a pass from its recent
+ *  timings, so that its cost stays near a fixed budget however much of
+ *  the screen it has to fill.
+ *
+ *  Notes:
+ *
+ *    The pass reports its time every frame through update(), along with
+ *    the scale it was drawn at if that may no longer be getScale() (its
+ *    timings arrive frames late). Since the cost of a per-pixel pass goes
+ *    with the pixel count, each sample is first turned into the cost of
+ *    one full-size frame (time / scale^2), so samples taken at different
+ *    scales can be averaged together.
+ *
+ *    The scale that would meet the budget is then sqrt(budget / cost).
+ *    Costs rise quickly (the camera zooms in on the crystal) and fall
+ *    slowly, so the estimate is the larger of the last sample and the
+ *    average of the last DYNRES_WINDOW: the scale drops on the first slow
+ *    frame and only climbs back once the window agrees.
+ *
+ *    To keep the image from shimmering, the scale moves at most
+ *    DYNRES_MAX_STEP per frame, ignores changes smaller than
+ *    DYNRES_DEADBAND, and is rounded to multiples of DYNRES_QUANTUM.
+ */
+
+#ifndef DYNRES_HPP_
+#define DYNRES_HPP_
+
+
+const int DYNRES_WINDOW = 8;                // Samples averaged
+const float DYNRES_MAX_STEP = 0.1f;         // Largest scale change a frame
+const float DYNRES_DEADBAND = 0.03f;        // Smallest scale change made
+const float DYNRES_QUANTUM = 1.0f / 32.0f;  // Scale granularity
+const float DYNRES_HEADROOM = 0.9f;         // Fraction of the budget aimed at
+
+/**
+ * Frame-time controller for the render scale of one pass.
+ */
+class ResolutionController {
+ public:
+  ResolutionController();
+
+  void setBudget(double millis);
+  void setRange(float minScale, float maxScale);
+  void setEnabled(bool enabled);
+  void reset();
+
+  float update(double millis);
+  float update(double millis, float drawnScale);
+
+  float getScale() const;
+  double getBudget() const;
+  double averageMillis() const;
+  bool enabled() const;
+
+ private:
+  double budget;
+  float minScale, maxScale, scale;
+  bool active;
+
+  double costs[DYNRES_WINDOW];              // Full-size cost per sample
+  double times[DYNRES_WINDOW];              // Measured time per sample
+  int nSamples, next;
+};
+
+#endif /* DYNRES_HPP_ */
@@ -0,0 +1,395 @@
+/**
+ * frames.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <GL/freeglut.h>
+#include <GL/glx.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "./frames.hpp"
+
+using namespace std;
+using namespace std::chrono;
+
+const double SMOOTHING = 0.1;               // Weight of the newest sample
+const double MAX_GAP_MS = 1000.0;           // Longer pauses skip the average
+const int HIDDEN_WAIT_MS = 1;               // Posted but not drawn yet
+
+FrameScheduler frames;
+
+
+/**
+ * Default Constructor. On-demand at the default rate, vsync on.
+ */
+FrameScheduler::FrameScheduler()
+: mode(FRAMES_ON_DEMAND),
+  rate(FRAMES_DEFAULT_RATE),
+  vsync(true),
+  animating(false),
+  pending(true),
+  posted(false),
+  idleAttached(false),
+  idleFunc(NULL),
+  avgMillis(0.0),
+  avgPeriod(0.0),
+  lastPeriod(0.0),
+  frameCount(0) {
+  this->start = Clock::now();
+  this->nextFrame = start;
+  this->frameStart = start;
+  this->lastEnd = start;
+  this->interval = duration_cast<Clock::duration>(
+      duration<double>(1.0 / rate));
+}
+
+/**
+ * Default Destructor.
+ */
+FrameScheduler::~FrameScheduler() {
+}
+
+/**
+ * Gives the scheduler the program's idle callback, which must call idle().
+ * The scheduler registers and removes it with glutIdleFunc() as needed.
+ * @param idleFunc - GLUT idle callback
+ */
+void FrameScheduler::attach(void (*idleFunc)()) {
+  this->idleFunc = idleFunc;
+  this->idleAttached = false;
+  this->AttachIdle(this->WantFrame());
+}
+
+/**
+ * Switches modes. Needs a current GL context, since it sets the swap
+ * interval.
+ * @param mode - FRAMES_ON_DEMAND, FRAMES_FIXED or FRAMES_UNCAPPED
+ * @param rate - frames per second for the fixed mode, and the cap in
+ *               on-demand mode; 0 keeps the current rate
+ */
+void FrameScheduler::setMode(FrameMode mode, double rate) {
+  this->mode = mode;
+  if (rate > 0.0)
+    this->rate = rate;
+
+  if (mode == FRAMES_UNCAPPED)
+    this->interval = Clock::duration::zero();
+  else
+    this->interval = duration_cast<Clock::duration>(
+        duration<double>(1.0 / this->rate));
+  this->nextFrame = Clock::now();
+
+  if (!SetSwapInterval(mode == FRAMES_UNCAPPED ? 0 : (vsync ? 1 : 0)))
+    cout << "Swap interval control not supported." << endl;
+
+  this->AttachIdle(this->WantFrame());
+}
+
+/**
+ * Turns vsync on or off. Always off in uncapped mode.
+ * @param enabled - true to wait for vertical blank on every swap
+ */
+void FrameScheduler::setVsync(bool enabled) {
+  this->vsync = enabled;
+
+  if (mode != FRAMES_UNCAPPED)
+    SetSwapInterval(enabled ? 1 : 0);
+}
+
+/**
+ * Keeps frames coming in on-demand mode while something moves by itself.
+ * @param animating - true while the scene changes without input
+ */
+void FrameScheduler::setAnimating(bool animating) {
+  this->animating = animating;
+
+  if (animating)
+    this->AttachIdle(true);
+}
+
+/**
+ * Asks for one more frame. Any number of requests before it is drawn
+ * cost a single frame.
+ */
+void FrameScheduler::requestRedraw() {
+  this->pending = true;
+
+  if (idleFunc)
+    this->AttachIdle(true);
+  else
+    glutPostRedisplay();
+}
+
+/**
+ * Body of the GLUT idle callback. Posts a redisplay once the next frame
+ * is due, and sleeps until then otherwise.
+ */
+void FrameScheduler::idle() {
+  Clock::time_point now;
+
+  if (!this->WantFrame()) {
+    this->AttachIdle(false);
+    return;
+  }
+
+  // Already posted but not drawn, as when the window is hidden.
+  if (posted) {
+    this_thread::sleep_for(milliseconds(HIDDEN_WAIT_MS));
+    return;
+  }
+
+  now = Clock::now();
+  if (now < nextFrame) {
+    this_thread::sleep_until(nextFrame);
+    return;
+  }
+
+  glutPostRedisplay();
+  this->posted = true;
+}
+
+/**
+ * Marks the start of a frame in the display callback. Requests made from
+ * here on are for the next frame.
+ */
+void FrameScheduler::beginFrame() {
+  this->frameStart = Clock::now();
+  this->pending = false;
+  this->posted = false;
+}
+
+/**
+ * Marks the end of a frame (after the buffer swap) and sets the next
+ * deadline.
+ */
+void FrameScheduler::endFrame() {
+  Clock::time_point end = Clock::now();
+  double ms = duration<double, milli>(end - frameStart).count();
+  double period = duration<double, milli>(end - lastEnd).count();
+
+  this->avgMillis = frameCount ?
+      avgMillis + SMOOTHING * (ms - avgMillis) : ms;
+  this->lastPeriod = frameCount ? period : ms;
+  if (frameCount && period < MAX_GAP_MS)
+    this->avgPeriod = avgPeriod > 0.0 ?
+        avgPeriod + SMOOTHING * (period - avgPeriod) : period;
+  this->lastEnd = end;
+  this->frameCount++;
+
+  // Keep to the grid, unless this frame started more than one interval
+  // late (after an idle stretch, or a slow frame).
+  this->nextFrame += interval;
+  if (nextFrame < frameStart)
+    this->nextFrame = frameStart + interval;
+}
+
+/**
+ * Retrieves the current mode.
+ * @return FRAMES_ON_DEMAND, FRAMES_FIXED or FRAMES_UNCAPPED
+ */
+FrameMode FrameScheduler::getMode() {
+  return this->mode;
+}
+
+/**
+ * Clock for animation.
+ * @return seconds since the scheduler was created
+ */
+double FrameScheduler::time() {
+  return duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Average time from beginFrame() to endFrame().
+ * @return milliseconds
+ */
+double FrameScheduler::frameMillis() {
+  return this->avgMillis;
+}
+
+/**
+ * Time between the ends of the last two frames: the whole frame, waits
+ * included, unsmoothed.
+ * @return milliseconds
+ */
+double FrameScheduler::lastFrameMillis() {
+  return this->lastPeriod;
+}
+
+/**
+ * Average rate of consecutive frames, ignoring idle gaps.
+ * @return frames per second, or 0 before two frames were drawn
+ */
+double FrameScheduler::framesPerSecond() {
+  return avgPeriod > 0.0 ? 1000.0 / avgPeriod : 0.0;
+}
+
+/**
+ * Retrieves the number of frames drawn.
+ * @return frame count
+ */
+long long FrameScheduler::numFrames() {
+  return this->frameCount;
+}
+
+/**
+ * Whether another frame is wanted at all.
+ */
+bool FrameScheduler::WantFrame() {
+  return mode != FRAMES_ON_DEMAND || pending || animating;
+}
+
+/**
+ * Registers or removes the idle callback, only when that changes.
+ */
+void FrameScheduler::AttachIdle(bool attach) {
+  if (!idleFunc || attach == idleAttached)
+    return;
+
+  glutIdleFunc(attach ? idleFunc : NULL);
+  this->idleAttached = attach;
+}
+
+/**
+ * Sets the swap interval of the current GLX drawable.
+ * @param interval - 0 for no vsync, 1 to swap on every vertical blank
+ * @return true if one of the swap control extensions took it
+ */
+bool FrameScheduler::SetSwapInterval(int interval) {
+  Display *display = glXGetCurrentDisplay();
+  GLXDrawable drawable = glXGetCurrentDrawable();
+  const char *extensions;
+
+  if (!display || !drawable)
+    return false;
+  extensions = glXQueryExtensionsString(display, DefaultScreen(display));
+  if (!extensions)
+    return false;
+
+  if (strstr(extensions, "GLX_EXT_swap_control")) {
+    PFNGLXSWAPINTERVALEXTPROC swapEXT = (PFNGLXSWAPINTERVALEXTPROC)
+        glXGetProcAddress((const GLubyte *) "glXSwapIntervalEXT");
+    if (swapEXT) {
+      swapEXT(display, drawable, interval);
+      return true;
+    }
+  }
+  if (strstr(extensions, "GLX_MESA_swap_control")) {
+    PFNGLXSWAPINTERVALMESAPROC swapMESA = (PFNGLXSWAPINTERVALMESAPROC)
+        glXGetProcAddress((const GLubyte *) "glXSwapIntervalMESA");
+    if (swapMESA)
+      return swapMESA(interval) == 0;
+  }
+  // The SGI extension cannot turn vsync off.
+  if (interval > 0 && strstr(extensions, "GLX_SGI_swap_control")) {
+    PFNGLXSWAPINTERVALSGIPROC swapSGI = (PFNGLXSWAPINTERVALSGIPROC)
+        glXGetProcAddress((const GLubyte *) "glXSwapIntervalSGI");
+    if (swapSGI)
+      return swapSGI(interval) == 0;
+  }
+
+  return false;
+}
+
+
+/**
+ * Default Constructor. No frames yet.
+ */
+FrameStats::FrameStats() {
+}
+
+/**
+ * Default Destructor.
+ */
+FrameStats::~FrameStats() {
+}
+
+/**
+ * Records one frame.
+ * @param millis - its time
+ */
+void FrameStats::add(double millis) {
+  this->samples.push_back(millis);
+}
+
+/**
+ * Forgets every frame.
+ */
+void FrameStats::clear() {
+  this->samples.clear();
+}
+
+/**
+ * Prints the count, mean, standard deviation, extremes and percentiles.
+ * @param title - what was measured
+ */
+void FrameStats::print(const string& title) {
+  double avg = this->mean();
+  double var = 0.0;
+
+  if (samples.empty()) {
+    cout << title << ": no frames." << endl;
+    return;
+  }
+
+  for (int i = 0; i < samples.size(); i++)
+    var += (samples[i] - avg) * (samples[i] - avg);
+  var /= samples.size();
+
+  cout << title << ": " << samples.size() << " frames, " << avg
+       << " ms mean (" << (avg > 0.0 ? 1000.0 / avg : 0.0) << " fps), "
+       << sqrt(var) << " ms std dev" << endl;
+  cout << "  min " << this->percentile(0.0) << ", median "
+       << this->percentile(50.0) << ", 95th " << this->percentile(95.0)
+       << ", 99th " << this->percentile(99.0) << ", max "
+       << this->percentile(100.0) << " ms" << endl;
+}
+
+/**
+ * Retrieves the number of frames recorded.
+ * @return frame count
+ */
+int FrameStats::size() {
+  return this->samples.size();
+}
+
+/**
+ * Average frame time.
+ * @return milliseconds, or 0 with no frames
+ */
+double FrameStats::mean() {
+  double sum = 0.0;
+
+  for (int i = 0; i < samples.size(); i++)
+    sum += samples[i];
+
+  return samples.empty() ? 0.0 : sum / samples.size();
+}
+
+/**
+ * Frame time below which the given share of frames fall, nearest rank.
+ * @param p - percentage, 0 for the fastest frame and 100 for the slowest
+ * @return milliseconds, or 0 with no frames
+ */
+double FrameStats::percentile(double p) {
+  vector<double> sorted(samples);
+  int rank;
+
+  if (sorted.empty())
+    return 0.0;
+
+  rank = static_cast<int>(ceil(p / 100.0 * sorted.size())) - 1;
+  rank = min(max(rank, 0), static_cast<int>(sorted.size()) - 1);
+  nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+
+  return sorted[rank];
+}
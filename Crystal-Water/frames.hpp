@@ -0,0 +1,124 @@
+/**
+ * frames.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  Decides when GLUT should draw the next frame, instead of every input
+ *  event posting a redisplay of its own.
+ *
+ *  Notes:
+ *
+ *    There are three modes:
+ *
+ *          FRAMES_ON_DEMAND    draw only after requestRedraw() (or while
+ *                              setAnimating(true)), at most at maxRate
+ *          FRAMES_FIXED        draw at a steady rate, paced by sleeping
+ *          FRAMES_UNCAPPED     draw as fast as possible, vsync off
+ *
+ *    Input handlers call requestRedraw() rather than glutPostRedisplay().
+ *    Requests only set a flag; the idle callback posts one redisplay once
+ *    the frame interval has passed, so a burst of motion events costs one
+ *    frame, and the wait for it is never longer than one interval.
+ *
+ *    With nothing to draw in on-demand mode the idle callback removes
+ *    itself, so the program sleeps in GLUT's event wait and uses no CPU.
+ *    The next request puts it back.
+ *
+ *    The display callback brackets each frame with beginFrame() and
+ *    endFrame(). endFrame() moves the next deadline on by exactly one
+ *    interval (not from "now", which would drift), and starts over from
+ *    now when a frame ran late, rather than rushing to catch up.
+ *
+ *    FrameStats keeps every frame's time for a run (a camera path played
+ *    back, say) and reports the mean, spread and percentiles at the end.
+ *
+ *    Vsync is set through GLX_EXT_swap_control, GLX_MESA_swap_control or
+ *    GLX_SGI_swap_control, whichever the driver offers.
+ */
+
+#ifndef FRAMES_HPP_
+#define FRAMES_HPP_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+enum FrameMode {
+  FRAMES_ON_DEMAND,
+  FRAMES_FIXED,
+  FRAMES_UNCAPPED
+};
+
+const double FRAMES_DEFAULT_RATE = 60.0;    // Hz, fixed and on-demand cap
+
+/**
+ * Frame pacing for the GLUT main loop.
+ */
+class FrameScheduler {
+ public:
+  FrameScheduler();
+  ~FrameScheduler();
+
+  void attach(void (*idleFunc)());
+  void setMode(FrameMode mode, double rate = 0.0);
+  void setVsync(bool enabled);
+  void setAnimating(bool animating);
+
+  void requestRedraw();
+  void idle();
+  void beginFrame();
+  void endFrame();
+
+  FrameMode getMode();
+  double time();
+  double frameMillis();
+  double lastFrameMillis();
+  double framesPerSecond();
+  long long numFrames();
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  FrameMode mode;
+  double rate;
+  bool vsync, animating;
+  bool pending, posted, idleAttached;
+  void (*idleFunc)();
+
+  Clock::time_point start, nextFrame, frameStart, lastEnd;
+  Clock::duration interval;
+  double avgMillis, avgPeriod, lastPeriod;
+  long long frameCount;
+
+  bool WantFrame();
+  void AttachIdle(bool attach);
+  static bool SetSwapInterval(int interval);
+};
+
+/**
+ * Frame times of one run, for its statistics.
+ */
+class FrameStats {
+ public:
+  FrameStats();
+  ~FrameStats();
+
+  void add(double millis);
+  void clear();
+  void print(const std::string& title);
+
+  int size();
+  double mean();
+  double percentile(double p);
+
+ private:
+  std::vector<double> samples;
+};
+
+extern FrameScheduler frames;
+
+#endif /* FRAMES_HPP_ */
@@ -0,0 +1,115 @@
+/**
+ * frustum.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <cstring>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "./frustum.hpp"
+
+using namespace std;
+
+
+/**
+ * Default Constructor. All planes pass everything.
+ */
+Frustum::Frustum() {
+  memset(planes, 0, sizeof(planes));
+}
+
+/**
+ * Constructs the frustum of the given matrix.
+ * @param viewProj - combined projection and modelview matrix
+ */
+Frustum::Frustum(const glm::mat4& viewProj) {
+  this->extract(viewProj);
+}
+
+/**
+ * Gribb-Hartmann extraction: each plane is the w row of the matrix plus or
+ * minus one of the x, y, or z rows. Planes are left unnormalized, which is
+ * fine for inside/outside tests.
+ * @param viewProj - combined projection and modelview matrix
+ */
+void Frustum::extract(const glm::mat4& viewProj) {
+  for (int p = 0; p < 6; p++) {
+    int row = p / 2;
+    float sign = (p % 2) ? -1.0f : 1.0f;
+    for (int c = 0; c < 4; c++)
+      planes[p][c] = viewProj[c][3] + sign * viewProj[c][row];
+  }
+}
+
+/**
+ * Accessor for a single plane.
+ * @param p - plane index, 0 through 5
+ * @return pointer to the four plane coefficients
+ */
+const float *Frustum::plane(int p) const {
+  return this->planes[p];
+}
+
+/**
+ * Tests a packed array of boxes and appends the index of every box that
+ * is at least partly inside. The arrays must be readable up to count
+ * rounded up to a multiple of four.
+ * @param minX, minY, minZ - box minimum corners
+ * @param maxX, maxY, maxZ - box maximum corners
+ * @param count - number of boxes
+ * @param inside - receives the indices of boxes that pass
+ * @return the number of boxes that passed
+ */
+int Frustum::cullBoxes(const float *minX, const float *minY, const float *minZ,
+                       const float *maxX, const float *maxY, const float *maxZ,
+                       int count, vector<int>& inside) const {
+  int before = inside.size();
+
+#ifdef __SSE__
+  for (int b = 0; b < count; b += 4) {
+    __m128 outside = _mm_setzero_ps();
+
+    for (int p = 0; p < 6; p++) {
+      const float *px = planes[p][0] > 0 ? maxX + b : minX + b;
+      const float *py = planes[p][1] > 0 ? maxY + b : minY + b;
+      const float *pz = planes[p][2] > 0 ? maxZ + b : minZ + b;
+
+      __m128 dist = _mm_set1_ps(planes[p][3]);
+      dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p][0]), _mm_loadu_ps(px)));
+      dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p][1]), _mm_loadu_ps(py)));
+      dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(planes[p][2]), _mm_loadu_ps(pz)));
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_setzero_ps()));
+    }
+
+    int mask = _mm_movemask_ps(outside);
+    for (int k = 0; k < 4 && b + k < count; k++) {
+      if (!(mask & (1 << k)))
+        inside.push_back(b + k);
+    }
+  }
+#else
+  for (int b = 0; b < count; b++) {
+    bool outside = false;
+
+    for (int p = 0; p < 6 && !outside; p++) {
+      float dist = planes[p][3];
+      dist += planes[p][0] * (planes[p][0] > 0 ? maxX[b] : minX[b]);
+      dist += planes[p][1] * (planes[p][1] > 0 ? maxY[b] : minY[b]);
+      dist += planes[p][2] * (planes[p][2] > 0 ? maxZ[b] : minZ[b]);
+      outside = dist < 0.0f;
+    }
+
+    if (!outside)
+      inside.push_back(b);
+  }
+#endif
+
+  return inside.size() - before;
+}
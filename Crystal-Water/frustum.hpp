@@ -0,0 +1,45 @@
+/**
+ * frustum.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  View frustum planes and a batched box test, shared by everything that
+ *  culls (Scene objects, instance groups).
+ *
+ *  Boxes are passed as separate min/max coordinate arrays. Because the
+ *  corner of a box that is furthest along a plane normal (the p-vertex)
+ *  depends only on the signs of the normal, the min-or-max choice is made
+ *  once per plane and the test then runs four boxes per SSE operation.
+ */
+
+#ifndef FRUSTUM_HPP_
+#define FRUSTUM_HPP_
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+/**
+ * Six clip planes (left, right, bottom, top, near, far) as (a, b, c, d)
+ * with a*x + b*y + c*z + d >= 0 on the inside.
+ */
+class Frustum {
+ public:
+  Frustum();
+  explicit Frustum(const glm::mat4& viewProj);
+
+  void extract(const glm::mat4& viewProj);
+  const float *plane(int p) const;
+  int cullBoxes(const float *minX, const float *minY, const float *minZ,
+                const float *maxX, const float *maxY, const float *maxZ,
+                int count, std::vector<int>& inside) const;
+
+ private:
+  float planes[6][4];
+};
+
+#endif /* FRUSTUM_HPP_ */
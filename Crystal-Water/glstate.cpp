@@ -0,0 +1,279 @@
+/**
+ * glstate.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <cstring>
+
+#include "./glstate.hpp"
+
+using namespace std;
+
+const GLuint UNKNOWN_BINDING = ~0u;         // Never matches a real object
+
+RenderState glState;
+
+
+/**
+ * Default Constructor. Nothing is known about GL state yet.
+ */
+RenderState::RenderState() {
+  memset(&current, 0, sizeof(current));
+  memset(&previous, 0, sizeof(previous));
+  this->invalidate();
+}
+
+/**
+ * Forgets every cached binding, so the next bind of each kind is always
+ * issued. Call after any code that binds through GL directly.
+ */
+void RenderState::invalidate() {
+  this->program = UNKNOWN_BINDING;
+  this->vertexArray = UNKNOWN_BINDING;
+  this->activeUnit = UNKNOWN_BINDING;
+
+  for (int i = 0; i < 6; i++)
+    buffers[i] = UNKNOWN_BINDING;
+  for (int t = 0; t < 2; t++) {
+    for (int i = 0; i < STATE_BUFFER_INDICES; i++)
+      indexed[t][i] = UNKNOWN_BINDING;
+  }
+  for (int u = 0; u < STATE_TEXTURE_UNITS; u++) {
+    textures[u][0] = textures[u][1] = textures[u][2] = UNKNOWN_BINDING;
+    samplers[u] = UNKNOWN_BINDING;
+  }
+}
+
+/**
+ * Starts counting a new frame.
+ */
+void RenderState::beginFrame() {
+  this->previous = current;
+  memset(&current, 0, sizeof(current));
+}
+
+/**
+ * Retrieves the call counts of the last complete frame.
+ * @return reference to the counts
+ */
+const GLCallStats& RenderState::lastFrame() const {
+  return this->previous;
+}
+
+/**
+ * Retrieves the call counts of the frame in progress.
+ * @return reference to the counts
+ */
+const GLCallStats& RenderState::thisFrame() const {
+  return this->current;
+}
+
+/**
+ * Filtered glUseProgram().
+ * @param program - program ID, or 0
+ */
+void RenderState::useProgram(GLuint program) {
+  if (this->program == program) {
+    current.filtered++;
+    return;
+  }
+
+  glUseProgram(program);
+  this->program = program;
+  current.issued++;
+}
+
+/**
+ * Filtered glBindVertexArray(). Changing the vertex array also changes the
+ * element array binding, which is then unknown.
+ * @param vao - vertex array ID, or 0
+ */
+void RenderState::bindVertexArray(GLuint vao) {
+  if (this->vertexArray == vao) {
+    current.filtered++;
+    return;
+  }
+
+  glBindVertexArray(vao);
+  this->vertexArray = vao;
+  this->buffers[BufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN_BINDING;
+  current.issued++;
+}
+
+/**
+ * Filtered glBindBuffer(). Targets the cache does not track are always
+ * passed through.
+ * @param target - buffer binding target
+ * @param buffer - buffer ID, or 0
+ */
+void RenderState::bindBuffer(GLenum target, GLuint buffer) {
+  int slot = BufferSlot(target);
+
+  if (slot >= 0 && buffers[slot] == buffer) {
+    current.filtered++;
+    return;
+  }
+
+  glBindBuffer(target, buffer);
+  if (slot >= 0)
+    this->buffers[slot] = buffer;
+  current.issued++;
+}
+
+/**
+ * Filtered glBindBufferBase(). Like GL, this also sets the generic binding
+ * of the target.
+ * @param target - GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+ * @param index - binding point
+ * @param buffer - buffer ID, or 0
+ */
+void RenderState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+  this->bindBufferRange(target, index, buffer, 0, 0);
+}
+
+/**
+ * Filtered glBindBufferRange(). A size of zero binds the whole buffer.
+ * @param target - GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+ * @param index - binding point
+ * @param buffer - buffer ID, or 0
+ * @param offset - byte offset of the range
+ * @param size - byte size of the range, or 0 for the whole buffer
+ */
+void RenderState::bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                                  GLintptr offset, GLsizeiptr size) {
+  int slot = IndexedSlot(target);
+  bool tracked = slot >= 0 && index < STATE_BUFFER_INDICES;
+
+  if (tracked && indexed[slot][index] == buffer &&
+      indexedOffset[slot][index] == offset && indexedSize[slot][index] == size) {
+    current.filtered++;
+    return;
+  }
+
+  if (size)
+    glBindBufferRange(target, index, buffer, offset, size);
+  else
+    glBindBufferBase(target, index, buffer);
+
+  if (tracked) {
+    this->indexed[slot][index] = buffer;
+    this->indexedOffset[slot][index] = offset;
+    this->indexedSize[slot][index] = size;
+  }
+  if (BufferSlot(target) >= 0)
+    this->buffers[BufferSlot(target)] = buffer;
+  current.issued++;
+}
+
+/**
+ * Filtered glBindTexture() on a given unit. The active unit is only changed
+ * when a bind is actually needed.
+ * @param unit - texture unit number (not the GL_TEXTURE0 enum)
+ * @param target - texture target
+ * @param texture - texture ID, or 0
+ */
+void RenderState::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+  int slot = TextureSlot(target);
+  bool tracked = slot >= 0 && unit < STATE_TEXTURE_UNITS;
+
+  if (tracked && textures[unit][slot] == texture) {
+    current.filtered++;
+    return;
+  }
+
+  this->ActiveTexture(unit);
+  glBindTexture(target, texture);
+  if (tracked)
+    this->textures[unit][slot] = texture;
+  current.issued++;
+}
+
+/**
+ * Filtered glBindSampler().
+ * @param unit - texture unit number
+ * @param sampler - sampler ID, or 0
+ */
+void RenderState::bindSampler(GLuint unit, GLuint sampler) {
+  bool tracked = unit < STATE_TEXTURE_UNITS;
+
+  if (tracked && samplers[unit] == sampler) {
+    current.filtered++;
+    return;
+  }
+
+  glBindSampler(unit, sampler);
+  if (tracked)
+    this->samplers[unit] = sampler;
+  current.issued++;
+}
+
+/**
+ * Records one glUniform* call made outside the cache.
+ */
+void RenderState::countUniform() {
+  current.uniforms++;
+}
+
+/**
+ * Records one draw or dispatch call made outside the cache.
+ */
+void RenderState::countDraw() {
+  current.draws++;
+}
+
+/**
+ * Selects the active texture unit if it is not already selected.
+ */
+void RenderState::ActiveTexture(GLuint unit) {
+  if (activeUnit == unit)
+    return;
+
+  glActiveTexture(GL_TEXTURE0 + unit);
+  this->activeUnit = unit;
+  current.issued++;
+}
+
+/**
+ * Maps a generic buffer target to its cache slot.
+ * @return slot index, or -1 if the target is not tracked
+ */
+int RenderState::BufferSlot(GLenum target) {
+  switch (target) {
+    case GL_ARRAY_BUFFER:             return 0;
+    case GL_ELEMENT_ARRAY_BUFFER:     return 1;
+    case GL_UNIFORM_BUFFER:           return 2;
+    case GL_SHADER_STORAGE_BUFFER:    return 3;
+    case GL_DRAW_INDIRECT_BUFFER:     return 4;
+    case GL_DISPATCH_INDIRECT_BUFFER: return 5;
+    default:                          return -1;
+  }
+}
+
+/**
+ * Maps an indexed buffer target to its cache slot.
+ * @return slot index, or -1 if the target is not tracked
+ */
+int RenderState::IndexedSlot(GLenum target) {
+  switch (target) {
+    case GL_UNIFORM_BUFFER:           return 0;
+    case GL_SHADER_STORAGE_BUFFER:    return 1;
+    default:                          return -1;
+  }
+}
+
+/**
+ * Maps a texture target to its cache slot.
+ * @return slot index, or -1 if the target is not tracked
+ */
+int RenderState::TextureSlot(GLenum target) {
+  switch (target) {
+    case GL_TEXTURE_2D:               return 0;
+    case GL_TEXTURE_2D_ARRAY:         return 1;
+    case GL_TEXTURE_CUBE_MAP:         return 2;
+    default:                          return -1;
+  }
+}
@@ -0,0 +1,92 @@
+/**
+ * glstate.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  A shadow copy of the GL binding state, so that per-frame code can ask
+ *  for a binding every time it needs one and only the calls that actually
+ *  change something reach the driver.
+ *
+ *  Notes:
+ *
+ *    All per-frame binds (programs, vertex arrays, buffers, textures,
+ *    samplers) should go through the global glState. Load-time code may
+ *    call GL directly, but must call glState.invalidate() afterwards so the
+ *    shadow copy is not trusted.
+ *
+ *    The element array binding belongs to the bound vertex array, so it is
+ *    forgotten whenever the vertex array changes.
+ *
+ *    Calls are counted per frame: beginFrame() starts a new count and
+ *    lastFrame() returns the totals of the previous frame.
+ */
+
+#ifndef GLSTATE_HPP_
+#define GLSTATE_HPP_
+
+#include <GL/glew.h>
+
+
+const int STATE_TEXTURE_UNITS = 16;         // Units tracked by the cache
+const int STATE_BUFFER_INDICES = 16;        // Indexed bindings tracked
+
+/**
+ * GL calls made during one frame.
+ */
+typedef struct {
+  int issued;                               /**< Binds passed to GL */
+  int filtered;                             /**< Redundant binds dropped */
+  int uniforms;                             /**< glUniform* calls */
+  int draws;                                /**< Draw and dispatch calls */
+} GLCallStats;
+
+
+/**
+ * Redundant-state filter for GL binding calls.
+ */
+class RenderState {
+ public:
+  RenderState();
+
+  void invalidate();
+  void beginFrame();
+  const GLCallStats& lastFrame() const;
+  const GLCallStats& thisFrame() const;
+
+  void useProgram(GLuint program);
+  void bindVertexArray(GLuint vao);
+  void bindBuffer(GLenum target, GLuint buffer);
+  void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+  void bindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                       GLintptr offset, GLsizeiptr size);
+  void bindTexture(GLuint unit, GLenum target, GLuint texture);
+  void bindSampler(GLuint unit, GLuint sampler);
+
+  void countUniform();
+  void countDraw();
+
+ private:
+  GLuint program;
+  GLuint vertexArray;
+  GLuint activeUnit;
+  GLuint buffers[6];
+  GLuint indexed[2][STATE_BUFFER_INDICES];
+  GLintptr indexedOffset[2][STATE_BUFFER_INDICES];
+  GLsizeiptr indexedSize[2][STATE_BUFFER_INDICES];
+  GLuint textures[STATE_TEXTURE_UNITS][3];
+  GLuint samplers[STATE_TEXTURE_UNITS];
+
+  GLCallStats current, previous;
+
+  void ActiveTexture(GLuint unit);
+  static int BufferSlot(GLenum target);
+  static int IndexedSlot(GLenum target);
+  static int TextureSlot(GLenum target);
+};
+
+extern RenderState glState;
+
+#endif /* GLSTATE_HPP_ */
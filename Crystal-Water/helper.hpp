@@ -17,17 +17,32 @@
 
 #include <CL/cl.hpp>
 
+#include <map>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
 
 #include "./program.hpp"
 #include "./quaternion.hpp"
 #include "./mesh.hpp"
-
-
-#define NULL_PTR        reinterpret_cast<char *>(NULL)
-#define OFFSET_PTR(n)   (reinterpret_cast<GLvoid *>(NULL_PTR + (n)))
+#include "./scene.hpp"
+#include "./instances.hpp"
+#include "./glstate.hpp"
+#include "./uniformring.hpp"
+#include "./variants.hpp"
+#include "./cluster.hpp"
+#include "./jobs.hpp"
+#include "./transform.hpp"
+#include "./frames.hpp"
+#include "./oit.hpp"
+#include "./occlusion.hpp"
+#include "./software.hpp"
+#include "./probe.hpp"
+#include "./raytrace.hpp"
+#include "./camerapath.hpp"
+#include "./startup.hpp"
 
 
 /*********************************
@@ -35,26 +50,99 @@
  */
 
 // Shader Program
-Program progSky, progCube;
+const int RELOAD_POLL_MS = 250;             // Shader file watch interval
+const char* const SHADER_FILES[] = { "shader0.vert", "shader0.frag",
+                                     "composite.vert", "composite.frag",
+                                     "cull.comp", "upsample.frag" };
+Program progCube, progCull, progComposite, progUpsample;
+ProgramVariants sceneShaders;                // shader0 permutations
 
 // OpenCL
 cl_platform_id clPlatformId;
 cl_device_id clDeviceId;
 cl_context clContext;
-cl_mem clVBObuffer;
 cl_command_queue clQueue;
-cl_kernel clKernel;
-cl_long clGlobalSize;
 
-// Vertex Buffers
-GLuint vboID, uboID;
-vector<GLuint *> iboIDs;
+// Ray traced crystal (the smallest sub-mesh of skybox.obj)
+const double TRACE_BUDGET_MS = 6.0;         // Kernel time to scale towards
+CrystalTracer tracer;
+int crystalSubmesh;
+bool useTracing, traceReady;
+
+// Uniform Buffers
+const GLuint BLOCK_BINDING_LIGHT = 1;
+const GLuint BLOCK_BINDING_FRAME = 2;
+const int FRAME_RING_SIZE = 3;              // Frames the GPU may lag behind
+                                            // (one slot per view in each)
+GLuint uboID;
+UniformRing frameRing;
+
+/**
+ * Per-frame constants, laid out as the std140 Frame block in the shaders.
+ */
+typedef struct {
+  glm::mat4 projectionMatrix;
+  glm::mat4 viewMatrix;                     /**< Scene modelview (mModel) */
+  glm::vec4 viewport;                       /**< Width, height, near, far */
+} FrameConstants;
+
+/**
+ * A linked scene shader variant and its per-object uniform handles.
+ */
+typedef struct {
+  Program *prog;
+  Uniform<glm::mat4> modelview;             /**< Unused when instanced */
+  Uniform<glm::mat3> normalMatrix;          /**< Unused when instanced */
+  Uniform<float> opacity;                   /**< Transparent variants only */
+  Uniform<glm::vec4> envProbe;              /**< Environment variants only */
+} ShaderVariant;
+
+std::map<unsigned, ShaderVariant> shaderVariants;
 
 // Objects
-Mesh mesh;
+Scene scene;
+TransformTree transforms;
+std::vector<int> nodeObject;                // Scene object per node, or -1
+std::vector<int> nodeCrystal;               // Crystal instance per node, or -1
+int skyboxMesh;
 bool useSkyBox;
 
+// Instanced crystal field (only if crystal.obj is present)
+const int CRYSTAL_GRID = 32;                // Crystals per side of the field
+const float CRYSTAL_SPACING = 6.0f;         // Distance between neighbours
+int crystalMesh, fieldNode;
+InstanceGroup *crystals;
+bool useInstancing, useComputeCull;
+bool checkCull;                             // Compare the next cullGPU()
+
+// Occlusion culling (the crystals hide whatever is behind them)
+OcclusionCuller occlusion;
+int crystalOccluder;
+bool useOcclusion;
+
+// Environment probe at the center crystal, for its reflections
+const int PROBE_SIZE = 128;                 // Cube face edge in texels
+const int PROBE_FACES_PER_FRAME = 2;        // Faces refreshed each frame
+EnvironmentProbe probe;
+int probeNode;
+bool useProbe;
+
+// Software rendering (--software: no window, no GL)
+const int SOFTWARE_FRAMES = 10;             // Frames timed per run
+const char SOFTWARE_IMAGE[] = "software.ppm";
+const char SCREENSHOT_IMAGE[] = "screenshot.ppm";
+bool useSoftware;
+bool screenshotPending;                     // Next frame is for --compare
+
+// Transparency
+WeightedOIT oit;
+bool useOIT, anyTransparent;
+
 // Lighting
+const int FIELD_LIGHTS = 16;                // Point lights per side of field
+const float FIELD_LIGHT_RADIUS = 14.0f;     // Reach of each point light
+LightClusters lights;
+bool useClusteredLights;
 glm::vec4 light_ambient(1.0f, 1.0f, 1.0f, 1.0f);
 glm::vec4 light_diffuse(1.0f, 1.0f, 1.0f, 1.0f);
 glm::vec4 light_specular(1.0f, 1.0f, 1.0f, 1.0f);
@@ -75,6 +163,22 @@ GLfloat fovy, aspect, zNear, zFar;
 glm::vec3 vEye, vCenter, vUp;
 glm::mat4 mModel, mProj, mRot, mTrans, mLook;
 Quaternion qTotalRotation;
+bool viewDirty;                             // mModel needs rebuilding
+
+// Camera paths ('c' records, 'v' plays back; --path names the file and
+// --bench plays it once, uncapped, and exits with the frame times)
+const double PATH_KEY_INTERVAL = 0.25;      // Seconds between recorded keys
+const double PATH_STEP = 1.0 / 60.0;        // Path seconds per played frame
+const int PATH_WARMUP_FRAMES = 10;          // Played but left out of stats
+CameraPath cameraPath;
+FrameStats pathStats;
+std::string pathFile = "camera.path";
+double pathClock, pathLastKey;
+int pathFrame;
+bool pathRecording, pathPlaying, pathBenchmark;
+
+// Startup (timed from launch to the first frame, then printed)
+int firstFrameStage = -1;
 
 // Input
 glm::vec3 zoomAnchor;
@@ -88,16 +192,27 @@ bool stateOrbiting;
  */
 
 void CrystalDisplay();
-void RenderMesh();
+void RenderMesh(bool transparent, const glm::mat4& view);
+void RenderInstances(bool transparent);
+void RenderProbe();
+void RenderSoftware(SoftwareRenderer& renderer);
+void CrystalFieldInit();
+void LightsInit();
 void MouseClick(int button, int state, int x, int y);
 void MouseMotion(int x, int y);
 void MouseWheel(int wheel, int direction, int x, int y);
 void Keyboard(unsigned char key, int x, int y);
+void ReloadTimer(int value);
 void Idle();
 void OpenCLInit();
+int FindCrystalSubmesh(Mesh& mesh);
 void BufferInit();
 void ShaderInit();
 void OpenGLInit();
+void ViewInit();
+bool SceneInit();
+void PrefetchInit();
+int SoftwareMain(const std::string& compareFile);
 
 
 /*********************************
@@ -136,11 +251,240 @@ void SetAnchor(float x, float y) {
   cout << zoomAnchor.x << ", " << zoomAnchor.y << ", " << zoomAnchor.z << endl;
 }
 
+void UpdateFrameConstants(const glm::mat4& view, const glm::mat4& proj,
+                          const glm::vec4& viewport) {
+  FrameConstants frame;
+
+  frame.projectionMatrix = proj;
+  frame.viewMatrix = view;
+  frame.viewport = viewport;
+
+  frameRing.push(&frame);
+}
+
+ShaderVariant& GetVariant(unsigned key) {
+  std::map<unsigned, ShaderVariant>::iterator it = shaderVariants.find(key);
+
+  if (it != shaderVariants.end())
+    return it->second;
+
+  // First use (or first since a reload): build it and resolve its handles.
+  ShaderVariant& sv = shaderVariants[key];
+  sv.prog = sceneShaders.get(key);
+  if (!(key & VARIANT_INSTANCED)) {
+    sv.modelview = sv.prog->getUniform<glm::mat4>("modelviewMatrix");
+    sv.normalMatrix = sv.prog->getUniform<glm::mat3>("normalMatrix");
+  }
+  if (key & VARIANT_TRANSPARENT)
+    sv.opacity = sv.prog->getUniform<float>("opacity");
+  if (key & VARIANT_ENVIRONMENT)
+    sv.envProbe = sv.prog->getUniform<glm::vec4>("envProbe");
+
+  return sv;
+}
+
+void PrintCallStats() {
+  const GLCallStats& stats = glState.lastFrame();
+
+  cout << "Frame " << frames.numFrames() << ": " << frames.frameMillis()
+       << " ms to draw, " << frames.framesPerSecond() << " fps" << endl;
+  cout << "GL calls last frame: " << stats.issued << " binds ("
+       << stats.filtered << " filtered), " << stats.uniforms << " uniforms, "
+       << stats.draws << " draws" << endl;
+  if (useClusteredLights)
+    cout << "Clustered lights: " << lights.numLights() << " lights, "
+         << lights.numIndices() << " cluster entries" << endl;
+  if (useOcclusion)
+    cout << "Occlusion: " << occlusion.numOccluders() << " occluders, "
+         << occlusion.numTriangles() << " triangles in "
+         << occlusion.renderMillis() << " ms, " << occlusion.numOccluded()
+         << " boxes hidden on the CPU" << endl;
+  if (useTracing)
+    cout << "Ray traced crystal: " << tracer.traceWidth() << "x"
+         << tracer.traceHeight() << " in " << tracer.traceMillis()
+         << " ms (" << tracer.resolution().averageMillis()
+         << " ms average, " << tracer.resolution().getBudget()
+         << " ms budget), temporal accumulation "
+         << (tracer.temporal() ? "on" : "off") << ", pipelining "
+         << (tracer.pipelined() ? "on" : "off") << endl;
+}
+
+void SaveScreenshot(const std::string& filename) {
+  vector<unsigned char> rgb(WIN_WIDTH * WIN_HEIGHT * 3);
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadBuffer(GL_BACK);
+  glReadPixels(0, 0, WIN_WIDTH, WIN_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, &rgb[0]);
+
+  if (SoftwareRenderer::writePPM(filename, WIN_WIDTH, WIN_HEIGHT, &rgb[0]))
+    cout << "Saved " << filename << "." << endl;
+}
+
+void CycleFrameMode() {
+  const char *names[] = { "on demand", "fixed rate", "uncapped" };
+  FrameMode next = static_cast<FrameMode>((frames.getMode() + 1) % 3);
+
+  frames.setMode(next);
+  cout << "Frame scheduling: " << names[next] << "." << endl;
+}
+
+void RecordCameraKey() {
+  double now = frames.time();
+
+  cameraPath.addKey(now - pathClock, vEye, glm::vec3(mTrans[3]),
+                    qTotalRotation);
+  pathLastKey = now;
+}
+
+void ToggleCameraRecording() {
+  pathRecording = !pathRecording;
+
+  // The clock holds the start time while recording.
+  if (pathRecording) {
+    pathPlaying = false;
+    cameraPath.clear();
+    pathClock = frames.time();
+    RecordCameraKey();
+    cout << "Recording camera path." << endl;
+  } else {
+    RecordCameraKey();
+    cout << "Recorded " << cameraPath.numKeys() << " camera keys over "
+         << cameraPath.duration() << " s." << endl;
+    if (cameraPath.numKeys() > 1)
+      cameraPath.save(pathFile);
+  }
+  frames.setAnimating(pathRecording);
+}
+
+bool StartCameraPlayback(bool benchmark) {
+  if (cameraPath.numKeys() < 2 && !cameraPath.load(pathFile))
+    return false;
+
+  pathRecording = false;
+  pathPlaying = true;
+  pathBenchmark = benchmark;
+  pathClock = 0.0;
+  pathFrame = 0;
+  pathStats.clear();
+  frames.setAnimating(true);
+  cout << "Playing " << pathFile << ": " << cameraPath.numKeys()
+       << " keys over " << cameraPath.duration() << " s." << endl;
+
+  return true;
+}
+
+void StopCameraPlayback() {
+  pathPlaying = false;
+  frames.setAnimating(false);
+  pathStats.print("Camera path");
+
+  if (pathBenchmark)
+    exit(0);
+}
+
+/**
+ * Moves the camera along the path before a frame is drawn, or records
+ * where it is. The played clock steps by PATH_STEP per frame, not by real
+ * time, so every run draws exactly the same views.
+ */
+void StepCameraPath() {
+  if (pathRecording && frames.time() - pathLastKey >= PATH_KEY_INTERVAL)
+    RecordCameraKey();
+  if (!pathPlaying)
+    return;
+
+  glm::vec3 slide;
+  cameraPath.sample(pathClock, vEye, slide, qTotalRotation);
+  mTrans = glm::translate(glm::mat4(1.0), slide);
+  viewDirty = true;
+}
+
+/**
+ * Takes the time of the frame just drawn, and ends playback after the
+ * last key's frame.
+ */
+void EndCameraPathFrame() {
+  if (!pathPlaying)
+    return;
+
+  if (pathFrame++ >= PATH_WARMUP_FRAMES)
+    pathStats.add(frames.lastFrameMillis());
+  if (pathClock >= cameraPath.duration())
+    StopCameraPlayback();
+  pathClock += PATH_STEP;
+}
+
 void CollapseMatrices() {
+  if (!viewDirty)
+    return;
+
   mLook = glm::lookAt(vEye, vCenter, vUp);
   mRot = glm::make_mat4(&qTotalRotation.matrix()[0]);
 
   mModel = mLook * mTrans * mRot;
+  viewDirty = false;
+}
+
+int AddTransformNode(int parent, const glm::mat4& local) {
+  int node = transforms.addNode(parent, local);
+
+  nodeObject.resize(node + 1, -1);
+  nodeCrystal.resize(node + 1, -1);
+
+  return node;
+}
+
+int AddSceneObject(int meshIdx, int parent, const glm::mat4& local) {
+  int node = AddTransformNode(parent, local);
+
+  nodeObject[node] = scene.addObject(meshIdx, local);
+  return node;
+}
+
+int AddCrystal(int parent, const glm::mat4& local) {
+  int node = AddTransformNode(parent, local);
+
+  nodeCrystal[node] = crystals->addInstance(local);
+  occlusion.addOccluder(crystalOccluder, local);
+  return node;
+}
+
+void SyncTransforms() {
+  const vector<int>& changed = transforms.changed();
+
+  // Nothing moved: no matrix math and nothing to upload.
+  if (!transforms.update())
+    return;
+
+  for (int i = 0; i < changed.size(); i++) {
+    int node = changed[i];
+
+    if (nodeObject[node] >= 0) {
+      scene.setTransform(nodeObject[node], transforms.world(node));
+      probe.invalidate();
+    } else if (nodeCrystal[node] >= 0) {
+      crystals->setTransform(nodeCrystal[node], transforms.world(node));
+      occlusion.setTransform(nodeCrystal[node], transforms.world(node));
+    }
+  }
+}
+
+/**
+ * Picks the crystal out of a mesh that also holds its surroundings: the
+ * sub-mesh with the smallest bounding sphere.
+ * @param mesh - loaded mesh, such as skybox.obj
+ * @return sub-mesh index
+ */
+int FindCrystalSubmesh(Mesh& mesh) {
+  vector<SubmeshBounds>& bounds = mesh.getBounds();
+  int crystal = 0;
+
+  for (int i = 1; i < bounds.size(); i++) {
+    if (bounds[i].radius < bounds[crystal].radius)
+      crystal = i;
+  }
+
+  return crystal;
 }
 
 void CameraInit() {
@@ -155,6 +499,7 @@ void MatrixInit() {
   mModel = glm::mat4(1.0);
   mRot = glm::mat4(1.0);
   mTrans = glm::mat4(1.0);
+  viewDirty = true;
 }
 
 int ProcessErrorCL(cl_int errorCode) {
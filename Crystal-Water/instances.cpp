@@ -0,0 +1,580 @@
+/**
+ * instances.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <cstring>
+
+#include "./instances.hpp"
+#include "./frustum.hpp"
+#include "./glstate.hpp"
+#include "./variants.hpp"
+
+using namespace std;
+
+const float EMPTY_BOX = 1e30f;              // Padding boxes are never inside
+const int CULL_GROUP_SIZE = 64;             // local_size_x in cull.comp
+
+// Storage buffer bindings shared with cull.comp and shader0.vert.
+const GLuint BIND_INSTANCES = 0;
+const GLuint BIND_VISIBLE = 1;
+const GLuint BIND_LODSTATE = 2;
+const GLuint BIND_COUNTS = 3;
+const GLuint BIND_COMMANDS = 4;
+
+// Orders matrices bit by bit, to match the GPU's copies to the CPU's.
+static bool MatrixLess(const glm::mat4& a, const glm::mat4& b) {
+  return memcmp(&a, &b, sizeof(glm::mat4)) < 0;
+}
+
+/**
+ * Constructor.
+ * @param scene - the Scene that owns the mesh
+ * @param meshIdx - index returned by Scene::loadMesh()
+ */
+InstanceGroup::InstanceGroup(Scene *scene, int meshIdx)
+: scene(scene),
+  meshIdx(meshIdx),
+  nSubmeshes(0),
+  nLevels(0),
+  capacity(0),
+  anyDirty(false),
+  gpuCulled(false),
+  instanceID(0),
+  visibleID(0),
+  commandID(0),
+  lodStateID(0),
+  countID(0),
+  cullProgramId(0) {
+  Mesh& mesh = *scene->getMesh(meshIdx).mesh;
+  vector<SubmeshBounds>& bounds = mesh.getBounds();
+
+  // One box and sphere around every sub-mesh; instances are culled whole.
+  this->nSubmeshes = bounds.size();
+  meshBounds.min = glm::vec3(EMPTY_BOX);
+  meshBounds.max = glm::vec3(-EMPTY_BOX);
+  for (int s = 0; s < nSubmeshes; s++) {
+    meshBounds.min = glm::min(meshBounds.min, bounds[s].min);
+    meshBounds.max = glm::max(meshBounds.max, bounds[s].max);
+    if (mesh.numLODs(s) > nLevels)
+      this->nLevels = mesh.numLODs(s);
+  }
+  meshBounds.center = (meshBounds.min + meshBounds.max) * 0.5f;
+  meshBounds.radius = glm::length(meshBounds.max - meshBounds.min) * 0.5f;
+}
+
+/**
+ * Default Destructor. Frees the GPU buffers.
+ */
+InstanceGroup::~InstanceGroup() {
+  GLuint ids[5] = { instanceID, visibleID, commandID, lodStateID, countID };
+
+  if (instanceID)
+    glDeleteBuffers(5, ids);
+}
+
+/**
+ * Adds one copy of the mesh. Instances must all be added before upload().
+ * @param transform - instance-to-scene transform
+ * @return the new instance index
+ */
+int InstanceGroup::addInstance(const glm::mat4& transform) {
+  int count = transforms.size() + 1;
+  int padded = (count + 3) & ~3;
+
+  this->transforms.push_back(transform);
+  this->lodCurrent.push_back(0);
+  this->dirty.push_back(1);
+  this->isMoved.push_back(1);
+  this->moved.push_back(count - 1);
+
+  minX.resize(padded, EMPTY_BOX);  maxX.resize(padded, -EMPTY_BOX);
+  minY.resize(padded, EMPTY_BOX);  maxY.resize(padded, -EMPTY_BOX);
+  minZ.resize(padded, EMPTY_BOX);  maxZ.resize(padded, -EMPTY_BOX);
+
+  this->anyDirty = true;
+
+  return count - 1;
+}
+
+/**
+ * Moves an instance. Its box is recomputed on the next cull, and only the
+ * moved matrices are sent to the GPU on the next cullGPU().
+ * @param instance - index returned by addInstance()
+ * @param transform - new instance-to-scene transform
+ */
+void InstanceGroup::setTransform(int instance, const glm::mat4& transform) {
+  transforms[instance] = transform;
+  dirty[instance] = 1;
+  this->anyDirty = true;
+  if (!isMoved[instance]) {
+    isMoved[instance] = 1;
+    this->moved.push_back(instance);
+  }
+}
+
+/**
+ * Creates the storage and command buffers. The Scene must already have been
+ * uploaded, since the commands point into the mesh's index buffer.
+ *
+ * Commands are laid out by LOD and then sub-mesh in variant order, so the
+ * commands of one LOD bucket are consecutive and so are those of one run.
+ * Sub-meshes with fewer levels repeat their coarsest one.
+ */
+void InstanceGroup::upload() {
+  SceneMesh& entry = scene->getMesh(meshIdx);
+  Mesh& mesh = *entry.mesh;
+  int nInstances = transforms.size();
+
+  this->capacity = (nInstances + 3) & ~3;
+  this->buckets.assign(nLevels, vector<glm::mat4>());
+  this->commands.clear();
+  this->runs.clear();
+
+  for (int i = 0; i < nSubmeshes; i++) {
+    int s = entry.submeshOrder[i];
+    unsigned variant = entry.variants[s] | VARIANT_INSTANCED;
+    float opacity = mesh.getMaterials()[s].opacity;
+
+    if (runs.empty() || runs.back().variant != variant ||
+        runs.back().opacity != opacity) {
+      SubmeshRun run = { variant, opacity, i, 0 };
+      this->runs.push_back(run);
+    }
+    this->runs.back().count++;
+  }
+
+  for (int l = 0; l < nLevels; l++) {
+    for (int i = 0; i < nSubmeshes; i++) {
+      int s = entry.submeshOrder[i];
+      int lod = l < mesh.numLODs(s) ? l : mesh.numLODs(s) - 1;
+      DrawCommand cmd;
+
+      cmd.count = mesh.lodSizes()[s][lod];
+      cmd.instanceCount = 0;
+      cmd.firstIndex = entry.lodFirst[s][lod];
+      cmd.baseVertex = 0;
+      cmd.baseInstance = 0;
+      this->commands.push_back(cmd);
+    }
+  }
+
+  glGenBuffers(1, &instanceID);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, instanceID);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(glm::mat4), NULL,
+      GL_DYNAMIC_DRAW);
+
+  glGenBuffers(1, &visibleID);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, visibleID);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+      nLevels * capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+
+  glGenBuffers(1, &lodStateID);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, lodStateID);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, capacity * sizeof(GLint), NULL,
+      GL_DYNAMIC_COPY);
+  if (nInstances)
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, nInstances * sizeof(GLint),
+        &lodCurrent[0]);
+
+  glGenBuffers(1, &countID);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, countID);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, nLevels * sizeof(GLuint), NULL,
+      GL_DYNAMIC_COPY);
+
+  glGenBuffers(1, &commandID);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandID);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawCommand),
+      &commands[0], GL_DYNAMIC_DRAW);
+
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/**
+ * CPU culling. Tests every instance box against the frustum (four at a time,
+ * see Frustum::cullBoxes()), picks an LOD for each survivor, and writes the
+ * survivors' matrices into their LOD bucket and the bucket sizes into the
+ * command buffer.
+ * @param model - the scene's modelview matrix (mModel)
+ * @param proj - the projection matrix
+ * @param occlusion - culler already rendered this frame, or NULL
+ */
+void InstanceGroup::cull(const glm::mat4& model, const glm::mat4& proj,
+                         OcclusionCuller *occlusion) {
+  for (int l = 0; l < nLevels; l++)
+    buckets[l].clear();
+
+  this->CullBoxes(proj * model, occlusion);
+
+  for (int i = 0; i < inside.size(); i++) {
+    int idx = inside[i];
+    int lod = Scene::levelForSize(meshBounds, model * transforms[idx], proj,
+                                  nLevels, lodCurrent[idx]);
+    buckets[lod].push_back(transforms[idx]);
+  }
+
+  // Orphan the bucket storage, then fill only the part in use.
+  glState.bindBuffer(GL_SHADER_STORAGE_BUFFER, visibleID);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+      nLevels * capacity * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+  for (int l = 0; l < nLevels; l++) {
+    if (buckets[l].empty())
+      continue;
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+        l * capacity * sizeof(glm::mat4),
+        buckets[l].size() * sizeof(glm::mat4), &buckets[l][0]);
+  }
+
+  for (int l = 0; l < nLevels; l++) {
+    for (int s = 0; s < nSubmeshes; s++)
+      commands[l * nSubmeshes + s].instanceCount = buckets[l].size();
+  }
+  glState.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandID);
+  glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+      commands.size() * sizeof(DrawCommand), &commands[0]);
+
+  this->gpuCulled = false;
+}
+
+/**
+ * GPU culling with the cull.comp compute shader. The first dispatch runs
+ * one invocation per instance: box test, LOD selection, and an atomic
+ * append into the chosen bucket. The second writes the bucket sizes into
+ * the instanceCount of every command. Nothing is read back to the CPU, so
+ * numVisible() is unknown afterwards.
+ * @param cullProg - linked program built from cull.comp, with the sampler
+ *                   hiZ added
+ * @param model - the scene's modelview matrix (mModel)
+ * @param proj - the projection matrix
+ * @param occlusion - culler rendered and uploaded this frame, or NULL
+ */
+void InstanceGroup::cullGPU(Program& cullProg, const glm::mat4& model,
+                            const glm::mat4& proj,
+                            OcclusionCuller *occlusion) {
+  Frustum frustum(proj * model);
+  int nInstances = transforms.size();
+  int nCommands = commands.size();
+
+  if (!nInstances)
+    return;
+
+  this->UploadMoved();
+
+  glState.bindBuffer(GL_SHADER_STORAGE_BUFFER, countID);
+  glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER,
+      GL_UNSIGNED_INT, NULL);
+
+  glState.bindBufferBase(GL_SHADER_STORAGE_BUFFER, BIND_INSTANCES, instanceID);
+  glState.bindBufferBase(GL_SHADER_STORAGE_BUFFER, BIND_VISIBLE, visibleID);
+  glState.bindBufferBase(GL_SHADER_STORAGE_BUFFER, BIND_LODSTATE, lodStateID);
+  glState.bindBufferBase(GL_SHADER_STORAGE_BUFFER, BIND_COUNTS, countID);
+  glState.bindBufferBase(GL_SHADER_STORAGE_BUFFER, BIND_COMMANDS, commandID);
+
+  if (cullProg.getProgramId() != cullProgramId)
+    this->ResolveCullUniforms(cullProg);
+
+  cullProg.enable();
+  cullProg.set(uPlanes, frustum.plane(0), 6);
+  cullProg.set(uBoxMin, meshBounds.min);
+  cullProg.set(uBoxMax, meshBounds.max);
+  cullProg.set(uSphere, glm::vec4(meshBounds.center, meshBounds.radius));
+  cullProg.set(uModelMatrix, model);
+  cullProg.set(uFocalScale, proj[1][1]);
+  cullProg.set(uFullCoverage, LOD_FULL_COVERAGE);
+  cullProg.set(uHysteresis, LOD_HYSTERESIS);
+  cullProg.set(uNumInstances, nInstances);
+  cullProg.set(uNumLevels, nLevels);
+  cullProg.set(uNumSubmeshes, nSubmeshes);
+  cullProg.set(uCapacity, capacity);
+  cullProg.set(uUseHiZ, occlusion ? 1 : 0);
+  if (occlusion) {
+    cullProg.setTexture(0, occlusion->texture());
+    cullProg.set(uViewProj, proj * model);
+    cullProg.set(uHiZInfo, glm::vec4(HIZ_WIDTH, HIZ_HEIGHT,
+                                     occlusion->numLevels(), 0.0f));
+  }
+
+  cullProg.set(uStage, 0);
+  glDispatchCompute((nInstances + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+  glState.countDraw();
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+  cullProg.set(uStage, 1);
+  glDispatchCompute((nCommands + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+  glState.countDraw();
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+  cullProg.disable();
+
+  this->gpuCulled = true;
+}
+
+/**
+ * Debug check of cullGPU() against the CPU tests. Call it right after
+ * cullGPU() with the same arguments: it reads back the GPU's LOD buckets,
+ * runs the CPU frustum and occlusion tests, and prints how many instances
+ * only one side kept. Boxes right on a plane or an occluder edge may
+ * still differ by rounding. The CPU buckets and LOD state are untouched.
+ * @param model - the scene's modelview matrix (mModel)
+ * @param proj - the projection matrix
+ * @param occlusion - culler passed to cullGPU(), or NULL
+ * @return number of instances the two culls disagree on, or -1 if the
+ *         last cull was not cullGPU()
+ */
+int InstanceGroup::checkGPUCull(const glm::mat4& model, const glm::mat4& proj,
+                                OcclusionCuller *occlusion) {
+  vector<GLuint> counts(nLevels);
+  vector<glm::mat4> onGPU, onCPU, missed;
+  int extra = 0;
+
+  if (!gpuCulled) {
+    cout << "Crystal cull check: last cull ran on the CPU." << endl;
+    return -1;
+  }
+
+  glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+  glState.bindBuffer(GL_SHADER_STORAGE_BUFFER, countID);
+  glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, nLevels * sizeof(GLuint),
+      &counts[0]);
+  glState.bindBuffer(GL_SHADER_STORAGE_BUFFER, visibleID);
+  for (int l = 0; l < nLevels; l++) {
+    int first = onGPU.size();
+
+    if (!counts[l])
+      continue;
+    onGPU.resize(first + counts[l]);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER,
+        l * capacity * sizeof(glm::mat4), counts[l] * sizeof(glm::mat4),
+        &onGPU[first]);
+  }
+
+  this->CullBoxes(proj * model, occlusion);
+  for (int i = 0; i < inside.size(); i++)
+    onCPU.push_back(transforms[inside[i]]);
+
+  sort(onGPU.begin(), onGPU.end(), MatrixLess);
+  sort(onCPU.begin(), onCPU.end(), MatrixLess);
+  set_difference(onCPU.begin(), onCPU.end(), onGPU.begin(), onGPU.end(),
+                 back_inserter(missed), MatrixLess);
+  extra = onGPU.size() - (onCPU.size() - missed.size());
+
+  cout << "Crystal cull check: " << onGPU.size() << " visible on the GPU, "
+       << onCPU.size() << " on the CPU; " << missed.size()
+       << " only on the CPU, " << extra << " only on the GPU." << endl;
+  return missed.size() + extra;
+}
+
+/**
+ * Draws one run of sub-meshes from every LOD bucket. The caller must have
+ * enabled the run's shader variant and bound the mesh's VAO and array
+ * texture. Each bucket is bound as the instance matrix buffer (binding 0
+ * in shader0.vert) and drawn with a single multi-draw over the run's
+ * commands.
+ *
+ * Without ARB_multi_draw_indirect this falls back to one
+ * glDrawElementsInstanced() per sub-mesh, which needs the CPU counts.
+ * @param run - index below numRuns()
+ */
+void InstanceGroup::draw(int run) {
+  GLsizeiptr bucketBytes = capacity * sizeof(glm::mat4);
+  SubmeshRun& r = runs[run];
+
+  if (!capacity)
+    return;
+
+  glState.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandID);
+
+  for (int l = 0; l < nLevels; l++) {
+    // Buckets known to be empty cost nothing; after cullGPU() nothing is.
+    if (!gpuCulled && buckets[l].empty())
+      continue;
+
+    glState.bindBufferRange(GL_SHADER_STORAGE_BUFFER, BIND_INSTANCES, visibleID,
+        l * bucketBytes, bucketBytes);
+
+    if (GLEW_ARB_multi_draw_indirect) {
+      glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+          OFFSET_PTR((l * nSubmeshes + r.first) * sizeof(DrawCommand)),
+          r.count, 0);
+      glState.countDraw();
+    } else if (!gpuCulled) {
+      for (int s = r.first; s < r.first + r.count; s++) {
+        DrawCommand& cmd = commands[l * nSubmeshes + s];
+        glDrawElementsInstanced(GL_TRIANGLES, cmd.count, GL_UNSIGNED_INT,
+            OFFSET_PTR(cmd.firstIndex * sizeof(GLuint)), cmd.instanceCount);
+        glState.countDraw();
+      }
+    }
+  }
+}
+
+/**
+ * Retrieves the number of shader-variant runs built by upload().
+ * @return number of runs
+ */
+int InstanceGroup::numRuns() {
+  return this->runs.size();
+}
+
+/**
+ * Retrieves the shader variant a run must be drawn with.
+ * @param run - index below numRuns()
+ * @return VARIANT_* key, always including VARIANT_INSTANCED
+ */
+unsigned InstanceGroup::runVariant(int run) {
+  return this->runs[run].variant;
+}
+
+/**
+ * Retrieves the material opacity of a run, for the TRANSPARENT variant.
+ * @param run - index below numRuns()
+ * @return opacity, 1 for opaque runs
+ */
+float InstanceGroup::runOpacity(int run) {
+  return this->runs[run].opacity;
+}
+
+/**
+ * Retrieves the mesh this group draws.
+ * @return the mesh index
+ */
+int InstanceGroup::getMeshIdx() {
+  return this->meshIdx;
+}
+
+/**
+ * Retrieves the number of instances.
+ * @return number of instances
+ */
+int InstanceGroup::numInstances() {
+  return this->transforms.size();
+}
+
+/**
+ * Retrieves the number of instances that passed the last cull().
+ * @return number of visible instances, or -1 after cullGPU()
+ */
+int InstanceGroup::numVisible() {
+  return gpuCulled ? -1 : this->inside.size();
+}
+
+/**
+ * Picks the detail level of one instance the way cull() does, for drawing
+ * it some other way.
+ * @param instance - index returned by addInstance()
+ * @param model - the scene's modelview matrix (mModel)
+ * @param proj - the projection matrix
+ * @return the detail level to draw
+ */
+int InstanceGroup::selectLOD(int instance, const glm::mat4& model,
+                             const glm::mat4& proj) {
+  return Scene::levelForSize(meshBounds, model * transforms[instance], proj,
+                             nLevels, lodCurrent[instance]);
+}
+
+/**
+ * Runs the CPU frustum and occlusion tests, leaving the indices of the
+ * instances that pass in inside.
+ * @param viewProj - projection * modelview
+ * @param occlusion - culler already rendered this frame, or NULL
+ */
+void InstanceGroup::CullBoxes(const glm::mat4& viewProj,
+                              OcclusionCuller *occlusion) {
+  Frustum frustum(viewProj);
+  int nInstances = transforms.size();
+
+  if (anyDirty)
+    this->UpdateBounds();
+
+  this->inside.clear();
+  if (nInstances)
+    frustum.cullBoxes(&minX[0], &minY[0], &minZ[0], &maxX[0], &maxY[0],
+                      &maxZ[0], nInstances, inside);
+  if (occlusion && nInstances)
+    occlusion->filterBoxes(&minX[0], &minY[0], &minZ[0], &maxX[0], &maxY[0],
+                           &maxZ[0], inside);
+}
+
+/**
+ * Looks up every cull.comp uniform once per program.
+ */
+void InstanceGroup::ResolveCullUniforms(Program& cullProg) {
+  this->uPlanes = cullProg.getUniform<glm::vec4>("planes");
+  this->uSphere = cullProg.getUniform<glm::vec4>("sphere");
+  this->uBoxMin = cullProg.getUniform<glm::vec3>("boxMin");
+  this->uBoxMax = cullProg.getUniform<glm::vec3>("boxMax");
+  this->uModelMatrix = cullProg.getUniform<glm::mat4>("modelMatrix");
+  this->uFocalScale = cullProg.getUniform<float>("focalScale");
+  this->uFullCoverage = cullProg.getUniform<float>("fullCoverage");
+  this->uHysteresis = cullProg.getUniform<float>("hysteresis");
+  this->uStage = cullProg.getUniform<int>("stage");
+  this->uNumInstances = cullProg.getUniform<int>("numInstances");
+  this->uNumLevels = cullProg.getUniform<int>("numLevels");
+  this->uNumSubmeshes = cullProg.getUniform<int>("numSubmeshes");
+  this->uCapacity = cullProg.getUniform<int>("capacity");
+  this->uUseHiZ = cullProg.getUniform<int>("useHiZ");
+  this->uViewProj = cullProg.getUniform<glm::mat4>("viewProj");
+  this->uHiZInfo = cullProg.getUniform<glm::vec4>("hiZInfo");
+  this->cullProgramId = cullProg.getProgramId();
+}
+
+/**
+ * Transforms the boxes of every moved instance into scene space.
+ */
+void InstanceGroup::UpdateBounds() {
+  for (int i = 0; i < transforms.size(); i++) {
+    glm::vec3 lo, hi;
+
+    if (!dirty[i])
+      continue;
+
+    Scene::transformBox(meshBounds.min, meshBounds.max, transforms[i], lo, hi);
+    minX[i] = lo.x;  maxX[i] = hi.x;
+    minY[i] = lo.y;  maxY[i] = hi.y;
+    minZ[i] = lo.z;  maxZ[i] = hi.z;
+    dirty[i] = 0;
+  }
+
+  this->anyDirty = false;
+}
+
+/**
+ * Sends the matrices of instances moved since the last call to the
+ * instance buffer, one glBufferSubData() per run of consecutive indices.
+ * When most instances moved, the whole array goes in one call instead.
+ */
+void InstanceGroup::UploadMoved() {
+  int nMoved = moved.size();
+
+  if (!nMoved)
+    return;
+
+  glState.bindBuffer(GL_SHADER_STORAGE_BUFFER, instanceID);
+  if (nMoved * 2 > transforms.size()) {
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+        transforms.size() * sizeof(glm::mat4), &transforms[0]);
+  } else {
+    sort(moved.begin(), moved.end());
+    for (int i = 0; i < nMoved; ) {
+      int first = moved[i];
+      int count = 1;
+
+      while (i + count < nMoved && moved[i + count] == first + count)
+        count++;
+      glBufferSubData(GL_SHADER_STORAGE_BUFFER, first * sizeof(glm::mat4),
+          count * sizeof(glm::mat4), &transforms[first]);
+      i += count;
+    }
+  }
+
+  for (int i = 0; i < nMoved; i++)
+    isMoved[moved[i]] = 0;
+  this->moved.clear();
+}
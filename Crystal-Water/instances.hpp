@@ -0,0 +1,138 @@
+/**
+ * instances.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  An InstanceGroup draws many copies of one Scene mesh (a field of
+ *  crystals, say) with instanced draws instead of one draw per copy.
+ *
+ *  Notes:
+ *
+ *    The order of use is:
+ *
+ *          addInstance()       // as many as you need
+ *          upload()            // once, after Scene::upload()
+ *          cull() or cullGPU() // every frame
+ *          draw(run)           // per run, with runVariant(run) enabled
+ *
+ *    Every frame the instances are tested against the frustum, given an
+ *    LOD from their screen size, and the model matrices of the survivors
+ *    are compacted into a shader storage buffer, one bucket per LOD. Each
+ *    bucket is then drawn with one instanced multi-draw whose commands
+ *    carry the bucket size as their instance count, so the cost of the
+ *    draw calls does not depend on the number of instances.
+ *
+ *    cull() does the compaction on the CPU with the SSE box test from
+ *    Frustum. cullGPU() does the same work in the cull.comp compute shader
+ *    and writes the instance counts straight into the command buffer, so
+ *    nothing is read back. Either can also drop instances hidden behind
+ *    the occluders of an OcclusionCuller (its uploaded pyramid, for the
+ *    GPU).
+ *
+ *    Only the matrices of instances moved since the last cullGPU() are
+ *    copied into the instance buffer, in runs of consecutive indices.
+ *
+ *    Sub-meshes that need the same shader variant are drawn together as
+ *    one run; a mesh with a single material has a single run.
+ *
+ *    Buckets are padded to a multiple of four matrices (256 bytes) so each
+ *    can be bound with glBindBufferRange() at any storage buffer offset
+ *    alignment the spec allows.
+ */
+
+#ifndef INSTANCES_HPP_
+#define INSTANCES_HPP_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "./scene.hpp"
+#include "./program.hpp"
+
+
+/**
+ * Many instances of one mesh, each with its own model matrix.
+ */
+class InstanceGroup {
+ public:
+  InstanceGroup(Scene *scene, int meshIdx);
+  ~InstanceGroup();
+
+  int addInstance(const glm::mat4& transform);
+  void setTransform(int instance, const glm::mat4& transform);
+  void upload();
+
+  void cull(const glm::mat4& model, const glm::mat4& proj,
+            OcclusionCuller *occlusion = NULL);
+  void cullGPU(Program& cullProg, const glm::mat4& model,
+               const glm::mat4& proj, OcclusionCuller *occlusion = NULL);
+  int checkGPUCull(const glm::mat4& model, const glm::mat4& proj,
+                   OcclusionCuller *occlusion = NULL);
+  void draw(int run);
+
+  int numRuns();
+  unsigned runVariant(int run);
+  float runOpacity(int run);
+  int getMeshIdx();
+  int numInstances();
+  int numVisible();
+  int selectLOD(int instance, const glm::mat4& model, const glm::mat4& proj);
+
+ private:
+  Scene *scene;
+  int meshIdx;
+  int nSubmeshes, nLevels, capacity;
+  SubmeshBounds meshBounds;
+
+  std::vector<glm::mat4> transforms;
+  std::vector<int> lodCurrent;
+  std::vector<char> dirty;
+  bool anyDirty, gpuCulled;
+
+  // Instances whose matrices the GPU has not seen yet.
+  std::vector<int> moved;
+  std::vector<char> isMoved;
+
+  // Packed scene-space boxes, padded to a multiple of four.
+  std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+  std::vector<int> inside;
+
+  std::vector<std::vector<glm::mat4> > buckets;
+  std::vector<DrawCommand> commands;
+
+  /**
+   * Consecutive sub-meshes (in variant order) sharing a shader variant
+   * and opacity.
+   */
+  typedef struct {
+    unsigned variant;                       /**< VARIANT_* key */
+    float opacity;                          /**< Material opacity */
+    int first;                              /**< First command in a level */
+    int count;                              /**< Commands in the run */
+  } SubmeshRun;
+  std::vector<SubmeshRun> runs;
+
+  GLuint instanceID, visibleID, commandID, lodStateID, countID;
+
+  // Handles into the cull.comp program, resolved on first use.
+  GLuint cullProgramId;
+  Uniform<glm::vec4> uPlanes, uSphere;
+  Uniform<glm::vec3> uBoxMin, uBoxMax;
+  Uniform<glm::mat4> uModelMatrix, uViewProj;
+  Uniform<glm::vec4> uHiZInfo;
+  Uniform<float> uFocalScale, uFullCoverage, uHysteresis;
+  Uniform<int> uStage, uNumInstances, uNumLevels, uNumSubmeshes, uCapacity;
+  Uniform<int> uUseHiZ;
+
+  void CullBoxes(const glm::mat4& viewProj, OcclusionCuller *occlusion);
+  void ResolveCullUniforms(Program& cullProg);
+  void UpdateBounds();
+  void UploadMoved();
+};
+
+#endif /* INSTANCES_HPP_ */
@@ -0,0 +1,367 @@
+/**
+ * jobs.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "./jobs.hpp"
+
+using namespace std;
+
+const int CHUNKS_PER_THREAD = 4;            // parallelFor() load balance
+const int MAX_NUMA_NODES = 64;              // Nodes probed in /sys
+
+JobSystem jobs;
+
+// Deque owned by the calling thread: 0 outside the pool.
+static thread_local int currentQueue = 0;
+
+
+/**
+ * Default Constructor. Nothing pending.
+ */
+JobCounter::JobCounter()
+: pending(0) {
+}
+
+/**
+ * Reports whether every job that signals this counter has finished.
+ * @return true if none are pending
+ */
+bool JobCounter::done() {
+  // Locked, so a waiter never frees the counter while Finish() holds it.
+  lock_guard<mutex> guard(lock);
+
+  return pending.load() == 0;
+}
+
+
+/**
+ * Default Constructor. No workers until start().
+ */
+JobSystem::JobSystem()
+: queued(0),
+  stopping(false) {
+}
+
+/**
+ * Default Destructor. Stops the workers.
+ */
+JobSystem::~JobSystem() {
+  this->stop();
+}
+
+/**
+ * Starts the worker threads.
+ * @param workers - number of workers, or 0 for one per CPU less the
+ *                  calling thread (which helps out in wait())
+ * @param flags - JOBS_PIN_THREADS and/or JOBS_NUMA_SPREAD
+ */
+void JobSystem::start(int workers, int flags) {
+  if (!threads.empty())
+    return;
+
+  if (workers <= 0)
+    workers = thread::hardware_concurrency() - 1;
+  if (workers < 1)
+    workers = 1;
+
+  this->stopping = false;
+  for (int i = 0; i <= workers; i++)
+    this->queues.push_back(new WorkQueue());
+  for (int i = 0; i < workers; i++) {
+    this->threads.push_back(thread(&JobSystem::WorkerLoop, this, i + 1));
+    PlaceThread(threads.back(), i, flags);
+  }
+}
+
+/**
+ * Stops and joins the workers. Jobs still queued are dropped.
+ */
+void JobSystem::stop() {
+  if (threads.empty())
+    return;
+
+  {
+    lock_guard<mutex> guard(sleepLock);
+    this->stopping = true;
+  }
+  wake.notify_all();
+
+  for (int i = 0; i < threads.size(); i++)
+    threads[i].join();
+  for (int i = 0; i < queues.size(); i++)
+    delete queues[i];
+
+  this->threads.clear();
+  this->queues.clear();
+  this->queued = 0;
+}
+
+/**
+ * Queues a job.
+ * @param job - the work to do
+ * @param signal - counter to decrement when the job finishes, or NULL
+ * @param after - counter that must reach zero before the job starts, or
+ *                NULL to start it as soon as a worker is free
+ */
+void JobSystem::run(const JobFunction& job, JobCounter *signal,
+                    JobCounter *after) {
+  Job entry = { job, signal };
+
+  if (signal)
+    signal->pending++;
+
+  if (after) {
+    lock_guard<mutex> guard(after->lock);
+
+    if (after->pending.load() > 0) {
+      after->waiting.push_back(make_pair(job, signal));
+      return;
+    }
+  }
+
+  if (threads.empty())
+    this->Execute(entry);
+  else
+    this->Push(entry);
+}
+
+/**
+ * Returns once every job signalling the counter has finished, running
+ * queued jobs in the meantime.
+ * @param counter - the counter to wait on
+ */
+void JobSystem::wait(JobCounter *counter) {
+  while (!counter->done()) {
+    Job job;
+
+    if (!threads.empty() && this->Pop(currentQueue, job))
+      this->Execute(job);
+    else
+      this_thread::yield();
+  }
+}
+
+/**
+ * Runs body over [0, count) in chunks spread across the pool, and waits
+ * for all of them. Chunks must be independent.
+ * @param count - number of indices
+ * @param grain - indices per chunk, or 0 to pick a size that gives each
+ *                thread a few chunks
+ * @param body - called as body(begin, end) for each chunk
+ */
+void JobSystem::parallelFor(int count, int grain,
+                            const function<void(int, int)>& body) {
+  JobCounter counter;
+
+  if (count <= 0)
+    return;
+  if (grain <= 0)
+    grain = count / ((threads.size() + 1) * CHUNKS_PER_THREAD);
+  if (grain < 1)
+    grain = 1;
+
+  for (int begin = 0; begin < count; begin += grain) {
+    int end = begin + grain < count ? begin + grain : count;
+
+    this->run([&body, begin, end]() { body(begin, end); }, &counter);
+  }
+
+  this->wait(&counter);
+}
+
+/**
+ * Retrieves the number of worker threads.
+ * @return number of workers, 0 if not started
+ */
+int JobSystem::numWorkers() {
+  return this->threads.size();
+}
+
+/**
+ * Pushes a job onto the calling thread's deque and wakes a sleeper.
+ */
+void JobSystem::Push(const Job& job) {
+  WorkQueue& queue = *queues[currentQueue];
+
+  {
+    lock_guard<mutex> guard(queue.lock);
+    queue.jobs.push_back(job);
+    this->queued++;
+  }
+
+  // Taking the lock orders this wake after any sleeper's last check.
+  { lock_guard<mutex> guard(sleepLock); }
+  wake.notify_one();
+}
+
+/**
+ * Takes the newest job from our own deque, or else steals the oldest job
+ * from someone else's.
+ * @return true if a job was found
+ */
+bool JobSystem::Pop(int self, Job& job) {
+  int nQueues = queues.size();
+
+  for (int i = 0; i < nQueues; i++) {
+    int victim = (self + i) % nQueues;
+    WorkQueue& queue = *queues[victim];
+    lock_guard<mutex> guard(queue.lock);
+
+    if (queue.jobs.empty())
+      continue;
+
+    if (victim == self) {
+      job = queue.jobs.back();
+      queue.jobs.pop_back();
+    } else {
+      job = queue.jobs.front();
+      queue.jobs.pop_front();
+    }
+    this->queued--;
+    return true;
+  }
+
+  return false;
+}
+
+/**
+ * Runs a job and signals its counter.
+ */
+void JobSystem::Execute(Job& job) {
+  job.function();
+  this->Finish(job.signal);
+}
+
+/**
+ * Decrements a counter. The last job to finish releases the jobs that
+ * were waiting on the counter.
+ */
+void JobSystem::Finish(JobCounter *counter) {
+  vector<pair<JobFunction, JobCounter *> > released;
+
+  if (!counter)
+    return;
+
+  {
+    lock_guard<mutex> guard(counter->lock);
+    if (--counter->pending == 0)
+      released.swap(counter->waiting);
+  }
+
+  // Their signal counters were already incremented by run().
+  for (int i = 0; i < released.size(); i++) {
+    Job job = { released[i].first, released[i].second };
+
+    if (threads.empty())
+      this->Execute(job);
+    else
+      this->Push(job);
+  }
+}
+
+/**
+ * Worker thread body: run jobs until stopped, sleeping when there are none.
+ */
+void JobSystem::WorkerLoop(int self) {
+  currentQueue = self;
+
+  while (!stopping) {
+    Job job;
+
+    if (this->Pop(self, job)) {
+      this->Execute(job);
+      continue;
+    }
+
+    unique_lock<mutex> guard(sleepLock);
+    wake.wait(guard, [this]() { return stopping || queued.load() > 0; });
+  }
+}
+
+/**
+ * Sets a worker's CPU affinity. With JOBS_NUMA_SPREAD, worker i goes to
+ * node i mod nodes (any CPU of it, or one CPU if also pinned). With only
+ * JOBS_PIN_THREADS, worker i gets CPU i + 1, leaving CPU 0 to the GLUT
+ * thread.
+ */
+void JobSystem::PlaceThread(thread& worker, int index, int flags) {
+#ifdef __linux__
+  int nCPUs = thread::hardware_concurrency();
+  cpu_set_t cpus;
+
+  if (!flags || nCPUs < 1)
+    return;
+
+  CPU_ZERO(&cpus);
+  if (flags & JOBS_NUMA_SPREAD) {
+    vector<vector<int> > nodes = NumaNodes();
+
+    if (!nodes.empty()) {
+      vector<int>& node = nodes[index % nodes.size()];
+
+      if (flags & JOBS_PIN_THREADS)
+        CPU_SET(node[(index / nodes.size()) % node.size()], &cpus);
+      else
+        for (int i = 0; i < node.size(); i++)
+          CPU_SET(node[i], &cpus);
+    }
+  }
+  if (!CPU_COUNT(&cpus) && (flags & JOBS_PIN_THREADS))
+    CPU_SET((index + 1) % nCPUs, &cpus);
+  if (!CPU_COUNT(&cpus))
+    return;
+
+  if (pthread_setaffinity_np(worker.native_handle(), sizeof(cpus), &cpus))
+    cout << "Could not set affinity of worker " << index << "." << endl;
+#endif
+}
+
+/**
+ * Reads the CPUs of each NUMA node from /sys/devices/system/node.
+ * @return one list of CPU numbers per node; empty if unavailable
+ */
+vector<vector<int> > JobSystem::NumaNodes() {
+  vector<vector<int> > nodes;
+
+  for (int n = 0; n < MAX_NUMA_NODES; n++) {
+    ostringstream path;
+    path << "/sys/devices/system/node/node" << n << "/cpulist";
+    ifstream file(path.str().c_str());
+    string range;
+
+    if (!file.is_open())
+      break;
+
+    // Format: "0-3,8-11"
+    nodes.push_back(vector<int>());
+    while (getline(file, range, ',')) {
+      int lo = 0, hi = -1;
+      char dash = 0;
+      istringstream parse(range);
+
+      parse >> lo;
+      if (!(parse >> dash >> hi))
+        hi = lo;
+      for (int cpu = lo; cpu <= hi; cpu++)
+        nodes.back().push_back(cpu);
+    }
+    if (nodes.back().empty())
+      nodes.pop_back();
+  }
+
+  return nodes;
+}
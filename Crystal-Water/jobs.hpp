@@ -0,0 +1,134 @@
+/**
+ * jobs.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  One pool of worker threads for every parallel task in the program
+ *  (mesh import, texture decoding, light binning), so that no module
+ *  starts threads of its own and the machine is never oversubscribed.
+ *
+ *  Notes:
+ *
+ *    Each worker owns a deque. A worker pushes and pops its own jobs at
+ *    the back (newest first, which keeps caches warm) and, when it runs
+ *    dry, steals the oldest job from the front of another deque. Threads
+ *    outside the pool (the GLUT thread) submit to an extra deque that all
+ *    workers steal from.
+ *
+ *    Completion is tracked with JobCounters. Every job may signal one
+ *    counter when it finishes, and may wait on another before it starts:
+ *
+ *          JobCounter loaded, built;
+ *          jobs.run(LoadA, &loaded);
+ *          jobs.run(LoadB, &loaded);
+ *          jobs.run(Build, &built, &loaded);   // after both loads
+ *          jobs.wait(&built);
+ *
+ *    wait() runs other jobs while it waits rather than blocking, so it may
+ *    be called from inside a job. parallelFor() splits an index range into
+ *    chunks, runs them, and waits for all of them.
+ *
+ *    start() may pin each worker to one CPU (JOBS_PIN_THREADS) and spread
+ *    workers evenly over the NUMA nodes listed in /sys (JOBS_NUMA_SPREAD).
+ *    Both are Linux-only and ignored elsewhere. Until start() is called,
+ *    run() and parallelFor() simply execute on the calling thread.
+ */
+
+#ifndef JOBS_HPP_
+#define JOBS_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Options for JobSystem::start().
+const int JOBS_PIN_THREADS = 1 << 0;        // One CPU per worker
+const int JOBS_NUMA_SPREAD = 1 << 1;        // Round-robin over NUMA nodes
+
+typedef std::function<void()> JobFunction;
+
+class JobSystem;
+
+/**
+ * Number of unfinished jobs in a group, plus the jobs waiting for the
+ * group to finish.
+ */
+class JobCounter {
+ public:
+  JobCounter();
+
+  bool done();
+
+ private:
+  std::atomic<int> pending;
+  std::mutex lock;
+  std::vector<std::pair<JobFunction, JobCounter *> > waiting;
+
+  friend class JobSystem;
+};
+
+
+/**
+ * Work-stealing thread pool.
+ */
+class JobSystem {
+ public:
+  JobSystem();
+  ~JobSystem();
+
+  void start(int workers = 0, int flags = 0);
+  void stop();
+
+  void run(const JobFunction& job, JobCounter *signal = NULL,
+           JobCounter *after = NULL);
+  void wait(JobCounter *counter);
+  void parallelFor(int count, int grain,
+                   const std::function<void(int, int)>& body);
+
+  int numWorkers();
+
+ private:
+  /**
+   * A queued job and the counter it signals.
+   */
+  typedef struct {
+    JobFunction function;
+    JobCounter *signal;
+  } Job;
+
+  /**
+   * One worker's queue. Each is allocated separately so that workers
+   * taking their own locks do not contend on one cache line.
+   */
+  struct WorkQueue {
+    std::mutex lock;
+    std::deque<Job> jobs;
+  };
+
+  std::vector<std::thread> threads;
+  std::vector<WorkQueue *> queues;          // [0] is for outside threads
+  std::atomic<int> queued;
+  std::atomic<bool> stopping;
+  std::mutex sleepLock;
+  std::condition_variable wake;
+
+  void Push(const Job& job);
+  bool Pop(int self, Job& job);
+  void Execute(Job& job);
+  void Finish(JobCounter *counter);
+  void WorkerLoop(int self);
+  static void PlaceThread(std::thread& worker, int index, int flags);
+  static std::vector<std::vector<int> > NumaNodes();
+};
+
+extern JobSystem jobs;
+
+#endif /* JOBS_HPP_ */
@@ -15,29 +15,108 @@
  */
 
 void CrystalDisplay() {
+  // A screenshot frame draws only what the software renderer can, so
+  // --software --compare measures the two paths on the same image.
+  bool probeWas = useProbe, tracingWas = useTracing;
+  if (screenshotPending)
+    useProbe = useTracing = false;
+
+  frames.beginFrame();
+  glState.beginFrame();
   glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+  StepCameraPath();
   CollapseMatrices();
+  SyncTransforms();
+
+  // OpenCL program: start tracing the crystal before any GL work, so the
+  // kernels run beside it. Only the composite below waits for them.
+  if (useTracing)
+    tracer.trace(mModel, mProj);
+
+  // Refresh a face or two of the crystal's environment first; each face
+  // pushes its own frame constants and bins the lights for its own view.
+  if (useProbe)
+    RenderProbe();
+  UpdateFrameConstants(mModel, mProj,
+                       glm::vec4(WIN_WIDTH, WIN_HEIGHT, zNear, zFar));
+
+  // Bin the point lights into this view's clusters.
+  if (useClusteredLights) {
+    lights.update(mModel, mProj, zNear, zFar);
+    lights.bind();
+  }
 
-  // OpenCL program
-//  glFinish();
-//  clEnqueueAcquireGLObjects(clQueue, 1, &clVBObuffer, 0, NULL, NULL);
-//  clEnqueueNDRangeKernel(clQueue, clKernel, 1, NULL, &clGlobalSize, NULL, 0, 0, 0);
-//  clEnqueueReleaseGLObjects(clQueue, 1, &clVBObuffer, 0, NULL, NULL);
-//  clFinish(clQueue);
+  // Draw the occluders into the software depth pyramid first, so both
+  // culls below can drop what they hide.
+  OcclusionCuller *occluders = useOcclusion ? &occlusion : NULL;
+  if (useOcclusion) {
+    occlusion.render(mProj * mModel);
+    if (useComputeCull)
+      occlusion.upload();
+  }
+
+  // Cull once; the opaque and transparent passes draw from the same
+  // lists. Drop every sub-mesh outside the view frustum, then write one
+  // indirect command per survivor at its screen-size LOD.
+  scene.cull(mProj * mModel, occluders);
+  scene.buildCommands(mModel, mProj);
+  if (crystals) {
+    // Cull on the GPU when compute shaders are available; the draw then
+    // reads its instance counts straight from the command buffer.
+    if (useComputeCull) {
+      crystals->cullGPU(progCull, mModel, mProj, occluders);
+      if (checkCull)
+        crystals->checkGPUCull(mModel, mProj, occluders);
+      checkCull = false;
+    } else
+      crystals->cull(mModel, mProj, occluders);
+  }
 
   // OpenGL program
-  progSky.enable();
-  RenderMesh();
-  progSky.disable();
+  RenderMesh(false, mModel);
+  if (crystals)
+    RenderInstances(false);
+
+  // The crystal, ray traced at whatever resolution keeps it within
+  // budget, over the opaque scene.
+  if (useTracing)
+    tracer.composite(progUpsample, zNear, zFar);
+
+  // Transparent surfaces in any order, then one fullscreen resolve.
+  if (useOIT && anyTransparent) {
+    oit.begin();
+    RenderMesh(true, mModel);
+    if (crystals)
+      RenderInstances(true);
+    oit.end();
+    oit.composite(progComposite);
+  }
 
-  /* TODO
-   * We need a simple heuristic to separate cube from skybox, but we ought
-   * to design something flexible for future projects (not relying on all
-   * skyboxes to be 256x256 centered on origin).
-   */
+  // Keep drawing until every face has caught up with the last change,
+  // and until a still view has gathered all its samples.
+  if (useProbe && probe.stale())
+    frames.requestRedraw();
+  if (useTracing && tracer.converging())
+    frames.requestRedraw();
+
+  if (screenshotPending) {
+    SaveScreenshot(SCREENSHOT_IMAGE);
+    useProbe = probeWas;
+    useTracing = tracingWas;
+    screenshotPending = false;
+    frames.requestRedraw();
+  }
 
   glFlush();
   glutSwapBuffers();
+  frames.endFrame();
+  EndCameraPathFrame();
+
+  if (firstFrameStage >= 0) {
+    startup.end(firstFrameStage);
+    startup.finish();
+    firstFrameStage = -1;
+  }
 }
 
 
@@ -46,57 +125,181 @@ void CrystalDisplay() {
  */
 
 
-void RenderMesh() {
-  vector<TexInfo>& texIds = mesh.getTextures();
-  vector<int>& iboSizes = mesh.iboSizes();
-  int nIBOs = mesh.numIBOs();
-  GLuint locLight0;
-  GLuint blockBindingLight0 = 1;
+/**
+ * Draws the scene's visible batches of one kind.
+ * @param transparent - true for the TRANSPARENT variants (inside the OIT
+ *                      pass), false for everything else
+ * @param view - scene to eye space, mModel for the window
+ */
+void RenderMesh(bool transparent, const glm::mat4& view) {
+  vector<DrawBatch>& batches = scene.batches();
+  int nBatches;
+  int lastMesh = -1;
+  int lastObject = -1;
+  unsigned lastVariant = ~0u;
+  ShaderVariant *sv = NULL;
+  glm::mat4 mObject;
+  glm::mat3 mNormal;
+
+  // Projection comes from the Frame block; the Light block was bound once
+  // in BufferInit().
+
+  // One multi-draw per object and shader variant, however many sub-meshes
+  // it has.
+  nBatches = batches.size();
+  for (int i = 0; i < nBatches; i++) {
+    SceneObject& obj = scene.getObject(batches[i].object);
+    SceneMesh& entry = scene.getMesh(obj.meshIdx);
+    bool newVariant = batches[i].variant != lastVariant;
+    bool newObject = batches[i].object != lastObject;
+
+    if (((batches[i].variant & VARIANT_TRANSPARENT) != 0) != transparent)
+      continue;
+
+    // Switch programs only when the material calls for another variant.
+    if (newVariant) {
+      sv = &GetVariant(batches[i].variant);
+      sv->prog->enable();
+      lastVariant = batches[i].variant;
+    }
 
-  // Load matrices.
-  progSky.setUniformMatrix(4, "modelviewMatrix", glm::value_ptr(mModel));
-  progSky.setUniformMatrix(4, "projectionMatrix", glm::value_ptr(mProj));
+    // Load the mesh's VAO.
+    if (obj.meshIdx != lastMesh) {
+      glState.bindVertexArray(entry.vaoID);
+      lastMesh = obj.meshIdx;
+    }
 
-  // Bind the (static) location/properties of the light.
-  glBindBuffer(GL_UNIFORM_BUFFER, uboID);
-  locLight0 = glGetUniformBlockIndex(progSky.getProgramId(), "Light");
-  glUniformBlockBinding(progSky.getProgramId(), locLight0, blockBindingLight0);
-  glBindBufferBase(GL_UNIFORM_BUFFER, blockBindingLight0, uboID);
-
-  // Load the VBO.
-  glBindBuffer(GL_ARRAY_BUFFER, vboID);
-  glEnableVertexAttribArray(0);
-  glEnableVertexAttribArray(1);
-  glEnableVertexAttribArray(2);
-  glEnableVertexAttribArray(3);
-  glEnableVertexAttribArray(4);
-  glEnableVertexAttribArray(5);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(0));
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(12));
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(24));
-  glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(32));
-  glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(44));
-  glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(56));
-
-  // Load each IBO and draw elements. Loads one texture per IBO.
-  for (int i = 0; i < nIBOs; i++) {
-    if (texIds[i].present) {
-      glEnable(GL_TEXTURE_2D);
-      progSky.setTexture(0, texIds[i]);
+    // The normal matrix is inverted once per object here, not per vertex.
+    if (newObject) {
+      mObject = view * obj.transform;
+      mNormal = glm::inverseTranspose(glm::mat3(mObject));
+      lastObject = batches[i].object;
+    }
+    if (newObject || newVariant) {
+      sv->prog->set(sv->modelview, mObject);
+      sv->prog->set(sv->normalMatrix, mNormal);
+    }
+    if (transparent)
+      sv->prog->set(sv->opacity, batches[i].opacity);
+
+    // Only textured variants declare the sampler; setTexture() filters
+    // repeated binds.
+    if ((lastVariant & VARIANT_TEXTURED) &&
+        entry.mesh->getTextureArray().present)
+      sv->prog->setTexture(0, entry.mesh->getTextureArray());
+
+    scene.drawBatch(i);
+  }
+
+  if (sv)
+    sv->prog->disable();
+}
+
+/**
+ * Draws the crystal field's runs of one kind (see RenderMesh()).
+ */
+void RenderInstances(bool transparent) {
+  SceneMesh& entry = scene.getMesh(crystals->getMeshIdx());
+  unsigned environment = useProbe ? VARIANT_ENVIRONMENT : 0;
+
+  glState.bindVertexArray(entry.vaoID);
+
+  // One multi-draw per LOD and shader variant, however many crystals are
+  // visible.
+  for (int r = 0; r < crystals->numRuns(); r++) {
+    unsigned variant = crystals->runVariant(r) | environment;
+    ShaderVariant& sv = GetVariant(variant);
+    Program *prog = sv.prog;
+
+    if (((variant & VARIANT_TRANSPARENT) != 0) != transparent)
+      continue;
+
+    prog->enable();
+    if (transparent)
+      prog->set(sv.opacity, crystals->runOpacity(r));
+    if ((variant & VARIANT_TEXTURED) && entry.mesh->getTextureArray().present)
+      prog->setTexture(0, entry.mesh->getTextureArray());
+    if (variant & VARIANT_ENVIRONMENT) {
+      prog->set(sv.envProbe, probe.lookupSphere());
+      prog->setTexture(1, probe.texture());
     }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *(iboIDs[i]));
-    glDrawElements(GL_TRIANGLES, iboSizes[i], GL_UNSIGNED_INT, OFFSET_PTR(0));
+    crystals->draw(r);
+    prog->disable();
   }
+}
 
-  glDisableVertexAttribArray(0);
-  glDisableVertexAttribArray(1);
-  glDisableVertexAttribArray(2);
-  glDisableVertexAttribArray(3);
-  glDisableVertexAttribArray(4);
-  glDisableVertexAttribArray(5);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+/**
+ * Draws the environment probe's faces due this frame: the scene's opaque
+ * objects, without the crystal field, as seen from the center crystal.
+ */
+void RenderProbe() {
+  glm::mat4 proj = probe.projection();
+  glm::vec4 viewport(PROBE_SIZE, PROBE_SIZE, PROBE_NEAR, PROBE_FAR);
+  int nFaces = probe.facesDue(PROBE_FACES_PER_FRAME);
+  glm::vec3 center(transforms.world(probeNode)[3]);
+
+  probe.setPosition(center);
+  if (!nFaces)
+    return;
+
+  // One cull and one command list for all of this frame's faces: the
+  // cube of PROBE_FAR around the probe, at a fixed detail level so the
+  // main view's LOD hysteresis never sees the probe's views.
+  glm::mat4 reach = glm::ortho(-PROBE_FAR, PROBE_FAR, -PROBE_FAR, PROBE_FAR,
+                               -PROBE_FAR, PROBE_FAR) *
+                    glm::translate(glm::mat4(1.0), -center);
+  scene.cull(reach);
+  scene.buildCommands(glm::mat4(1.0), proj, PROBE_LOD);
+
+  for (int i = 0; i < nFaces; i++) {
+    int face = probe.beginFace();
+    glm::mat4 view = probe.faceView(face);
+
+    UpdateFrameConstants(view, proj, viewport);
+    if (useClusteredLights) {
+      lights.update(view, proj, PROBE_NEAR, PROBE_FAR);
+      lights.bind();
+    }
+    RenderMesh(false, view);
+    probe.endFace();
+  }
+}
+
+/**
+ * Draws one frame of the scene with the software renderer: the same
+ * objects and detail levels as the GL path, without the culling.
+ */
+void RenderSoftware(SoftwareRenderer& renderer) {
+  vector<int> lods;
+
+  CollapseMatrices();
+  SyncTransforms();
+  if (useClusteredLights)
+    lights.update(mModel, mProj, zNear, zFar);
+
+  // Scene objects, then the crystal field one instance at a time.
+  renderer.begin(mProj, zNear, zFar);
+  for (int i = 0; i < scene.numObjects(); i++) {
+    SceneObject& obj = scene.getObject(i);
+    Mesh& mesh = *scene.getMesh(obj.meshIdx).mesh;
+    glm::mat4 mObject = mModel * obj.transform;
+
+    lods.resize(mesh.numIBOs());
+    for (int s = 0; s < lods.size(); s++)
+      lods[s] = scene.selectLOD(i, s, mObject, mProj);
+    renderer.drawMesh(mesh, mObject, lods);
+  }
+  for (int node = 0; crystals && node < nodeCrystal.size(); node++) {
+    int instance = nodeCrystal[node];
+    Mesh& mesh = *scene.getMesh(crystalMesh).mesh;
+
+    if (instance < 0)
+      continue;
+    lods.assign(mesh.numIBOs(), crystals->selectLOD(instance, mModel, mProj));
+    renderer.drawMesh(mesh, mModel * transforms.world(node), lods);
+  }
+  renderer.finish(useClusteredLights ? &lights : NULL);
 }
 
 
@@ -123,9 +326,10 @@ void MouseClick(int button, int state, int x, int y) {
     float step = vEye.z / 15.0f;
 
     vEye.z += (button == 4) ? step : -step;
+    viewDirty = true;
   }
 
-  glutPostRedisplay();
+  frames.requestRedraw();
 }
 
 /**
@@ -141,6 +345,7 @@ void MouseMotion(int x, int y) {
       float slideFactor = vEye.z / WIN_WIDTH;
       GLfloat slideDist = slideFactor * (orbitDest.y - orbitAnchor.y);
       mTrans = glm::translate(mTrans, glm::vec3(0.0, slideDist, 0.0));
+      viewDirty = true;
     }
 
     // Horizontal Orbit
@@ -150,10 +355,12 @@ void MouseMotion(int x, int y) {
       GLfloat orbitAngle = FindRotationAngle(orbitDest, orbitAnchor);
       Quaternion qOrbitRot = Quaternion(orbitAngle, orbitAxis, RAD);
       qTotalRotation = qOrbitRot * qTotalRotation;
+      viewDirty = true;
     }
   }
 
-  glutPostRedisplay();
+  // Motion events arrive far faster than frames; this only sets a flag.
+  frames.requestRedraw();
 }
 
 /**
@@ -170,7 +377,62 @@ void Keyboard(unsigned char key, int x, int y) {
     case 'r':
       CameraInit();
       MatrixInit();
-      glutPostRedisplay();
+      frames.requestRedraw();
+      break;
+    case 'f':
+      CycleFrameMode();
+      break;
+    case 't':
+      useTracing = traceReady && !useTracing;
+      cout << "Ray traced crystal " << (useTracing ? "on." : "off.") << endl;
+      frames.requestRedraw();
+      break;
+    case 'd':
+      tracer.resolution().setEnabled(!tracer.resolution().enabled());
+      cout << "Dynamic resolution "
+           << (tracer.resolution().enabled() ? "on." : "off.") << endl;
+      frames.requestRedraw();
+      break;
+    case 'a':
+      tracer.setTemporal(!tracer.temporal());
+      cout << "Temporal accumulation "
+           << (tracer.temporal() ? "on." : "off.") << endl;
+      frames.requestRedraw();
+      break;
+    case 'l':
+      tracer.setPipelined(!tracer.pipelined());
+      cout << "Pipelined ray tracing "
+           << (tracer.pipelined() ? "on." : "off.") << endl;
+      frames.requestRedraw();
+      break;
+    case 'c':
+      ToggleCameraRecording();
+      break;
+    case 'v':
+      if (pathPlaying)
+        StopCameraPlayback();
+      else
+        StartCameraPlayback(false);
+      break;
+    case 'e':
+      useProbe = probe.ready() && !useProbe;
+      probe.invalidate();
+      cout << "Crystal reflections " << (useProbe ? "on." : "off.") << endl;
+      frames.requestRedraw();
+      break;
+    case 'o':
+      useOcclusion = crystals && !useOcclusion;
+      cout << "Occlusion culling " << (useOcclusion ? "on." : "off.") << endl;
+      frames.requestRedraw();
+      break;
+    case 'g':
+      PrintCallStats();
+      checkCull = crystals && useComputeCull;
+      frames.requestRedraw();
+      break;
+    case 'p':
+      screenshotPending = true;
+      frames.requestRedraw();
       break;
     case 'q':
     case 27:
@@ -181,10 +443,33 @@ void Keyboard(unsigned char key, int x, int y) {
   }
 }
 
-void Idle() {
-  // Currently not registered. Needed?
+/**
+ * Polls the shader files for edits and any background rebuilds they
+ * started, without ever waiting on the compiler. Redraws when a rebuilt
+ * program has been swapped in.
+ */
+void ReloadTimer(int value) {
+  vector<unsigned> rebuilt = sceneShaders.reloadIfChanged();
+  bool swapped = !rebuilt.empty();
+
+  // Rebuilt variants have new uniform locations; resolve them on next use.
+  for (int i = 0; i < rebuilt.size(); i++)
+    shaderVariants.erase(rebuilt[i]);
+  if (crystals && useComputeCull)
+    swapped = progCull.reloadIfChanged() || swapped;
+  if (traceReady)
+    swapped = progUpsample.reloadIfChanged() || swapped;
+
+  if (swapped)
+    frames.requestRedraw();
+  glutTimerFunc(RELOAD_POLL_MS, ReloadTimer, 0);
+}
 
-  glutPostRedisplay();
+/**
+ * Registered and removed by the frame scheduler; posts each redisplay.
+ */
+void Idle() {
+  frames.idle();
 }
 
 
@@ -192,41 +477,62 @@ void Idle() {
  * Init Functions
  */
 
+void PrefetchInit() {
+  // Import and texture decoding of each model, one job per file.
+  scene.prefetch("skybox.obj", "../tex/");
+  scene.prefetch("crystal.obj", "../tex/");
+
+  if (useSoftware)
+    return;
+
+  jobs.run([]() {
+    int stage = startup.begin("shader sources");
+
+    for (int i = 0; i < sizeof(SHADER_FILES) / sizeof(SHADER_FILES[0]); i++)
+      Shader::prefetch(SHADER_FILES[i]);
+    startup.end(stage);
+  });
+}
+
 void OpenCLInit() {
   cl_int errorCode;
 
-  // Redirect Vertex Buffer to OpenCL
-  clVBObuffer = clCreateFromGLBuffer(clContext, CL_MEM_READ_WRITE, vboID, &errorCode);
-  if (errorCode != CL_SUCCESS) {
-    exit(ProcessErrorCL(errorCode));
-  }
-  clQueue = clCreateCommandQueue(clContext, clDeviceId, 0, &errorCode);
+  // Profiled, so the tracer can scale by the kernel's own time.
+  clQueue = clCreateCommandQueue(clContext, clDeviceId,
+      CL_QUEUE_PROFILING_ENABLE, &errorCode);
   if (errorCode != CL_SUCCESS) {
     exit(ProcessErrorCL(errorCode));
   }
 
-  // TODO Specify CL program to execute on kernel and release object.
+  // The geometry was handed over in SceneInit().
+  traceReady = tracer.init(clContext, clDeviceId, clQueue, "trace.cl",
+                           WIN_WIDTH, WIN_HEIGHT);
+  if (!traceReady)
+    cout << "The crystal will only be rasterized." << endl;
+  tracer.setLight(glm::vec3(light_position));
+  tracer.resolution().setBudget(TRACE_BUDGET_MS);
+  useTracing = traceReady;
 }
 
 void BufferInit() {
-  std::vector<VBOVertex>& vboArray = mesh.getVBOVertexArray();
-  std::vector<vector<GLuint> >& iboArrays = mesh.getIBOIndexArrays();
-  int nVBO = vboArray.size();
-  int nIBOs = iboArrays.size();
   GLfloat align = 0.0f;
 
-  // Vertex Buffer Object
-  glGenBuffers(1, &vboID);
-  glBindBuffer(GL_ARRAY_BUFFER, vboID);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(VBOVertex)*nVBO, NULL, GL_STATIC_DRAW);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(VBOVertex)*nVBO, &vboArray[0]);
+  // Vertex and Index Buffer Objects for every mesh in the scene.
+  // Data will then be in GPU memory (server-side), so heap memory is freed.
+  // TODO This data will not be assigned to any buffer yet when using OpenCL.
+  scene.upload();
+  if (crystals)
+    crystals->upload();
+  if (useClusteredLights)
+    lights.upload();
+
+  // Accumulation and revealage targets for transparent sub-meshes.
+  useOIT = anyTransparent && oit.init(WIN_WIDTH, WIN_HEIGHT);
+  if (anyTransparent && !useOIT)
+    cout << "Transparent sub-meshes will not be drawn." << endl;
 
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(0));
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(12));
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(24));
-  glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(32));
-  glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(44));
-  glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(56));
+  // Cube map the crystals reflect and refract.
+  useProbe = useProbe && probe.init(PROBE_SIZE);
 
   // Uniform Buffer Object
   GLfloat uLight0[16] = { light_position.x, light_position.y, light_position.z, align,
@@ -239,33 +545,175 @@ void BufferInit() {
   glBufferData(GL_UNIFORM_BUFFER, sizeof(uLight0), NULL, GL_STATIC_DRAW);
   glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(uLight0), uLight0);
 
-  // Index Buffer Objects
-  for (int i = 0; i < nIBOs; i++) {
-    iboIDs.push_back(new GLuint);
-    glGenBuffers(1, iboIDs[i]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *(iboIDs[i]));
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, iboArrays[i].size() * sizeof(GLuint),
-        &iboArrays[i][0], GL_STATIC_DRAW);
-  }
-  // Data should now be in GPU memory (server-side), so free heap memory.
-  // TODO This data will not be assigned to any buffer yet when using OpenCL.
-  mesh.freeArrays();
+  // Per-frame constants, one slot per frame in flight.
+  frameRing.init(BLOCK_BINDING_FRAME, sizeof(FrameConstants),
+                 FRAME_RING_SIZE * (1 + PROBE_FACES_PER_FRAME));
+
+  // Everything above bound through GL directly.
+  glState.invalidate();
+  glState.bindBufferBase(GL_UNIFORM_BUFFER, BLOCK_BINDING_LIGHT, uboID);
 }
 
 void ShaderInit() {
   GLint texLoad;
 
-  progSky.addShader("shader0.vert", GL_VERTEX_SHADER);
-  progSky.addShader("shader0.frag", GL_FRAGMENT_SHADER);
-  progSky.init();
-  progSky.bindAttribute(0, "vertexLocation");
-  progSky.bindAttribute(1, "vertexNormal");
-  progSky.bindAttribute(2, "vertexTexCoord");
-  progSky.bindAttribute(3, "vertexMatDiffuse");
-  progSky.bindAttribute(4, "vertexMatSpecular");
-  progSky.bindAttribute(5, "vertexShininess");
-  progSky.linkAndValidate();
-  progSky.addSampler("tex");
+  // Submit every program before asking after any of them, so that drivers
+  // with parallel compilation build them side by side.
+  Program::enableParallelCompile();
+
+  sceneShaders.setShaders("shader0.vert", "shader0.frag");
+  sceneShaders.bindAttribute(0, "vertexLocation");
+  sceneShaders.bindAttribute(1, "vertexNormal");
+  sceneShaders.bindAttribute(2, "vertexTexCoord");
+  sceneShaders.bindAttribute(3, "vertexMatDiffuse");
+  sceneShaders.bindAttribute(4, "vertexMatSpecular");
+  sceneShaders.bindAttribute(5, "vertexShininess");
+  sceneShaders.bindAttribute(6, "vertexTexLayer");
+  sceneShaders.addSampler("tex");
+  sceneShaders.addSampler("envMap");
+  sceneShaders.bindUniformBlock("Light", BLOCK_BINDING_LIGHT);
+  sceneShaders.bindUniformBlock("Frame", BLOCK_BINDING_FRAME);
+  if (useClusteredLights)
+    sceneShaders.addDefine("CLUSTERED_LIGHTS");
+
+  // Every variant the scene's materials need, so none compiles mid-frame.
+  anyTransparent = false;
+  for (int m = 0; m < scene.numMeshes(); m++) {
+    vector<unsigned>& variants = scene.getMesh(m).variants;
+    unsigned extra = (crystals && m == crystalMesh) ? VARIANT_INSTANCED : 0;
+
+    for (int i = 0; i < variants.size(); i++) {
+      sceneShaders.submit(variants[i] | extra);
+      if (extra && useProbe)
+        sceneShaders.submit(variants[i] | extra | VARIANT_ENVIRONMENT);
+      if (variants[i] & VARIANT_TRANSPARENT)
+        anyTransparent = true;
+    }
+  }
+
+  if (anyTransparent) {
+    progComposite.addShader("composite.vert", GL_VERTEX_SHADER);
+    progComposite.addShader("composite.frag", GL_FRAGMENT_SHADER);
+    progComposite.init();
+    progComposite.submit();
+  }
+
+  if (crystals && useComputeCull) {
+    progCull.addShader("cull.comp", GL_COMPUTE_SHADER);
+    progCull.init();
+    progCull.submit();
+  }
+
+  if (traceReady) {
+    progUpsample.addShader("composite.vert", GL_VERTEX_SHADER);
+    progUpsample.addShader("upsample.frag", GL_FRAGMENT_SHADER);
+    progUpsample.init();
+    progUpsample.submit();
+  }
+
+  sceneShaders.finishAll();
+  cout << sceneShaders.numVariants() << " scene shader variants built." << endl;
+
+  if (crystals && useComputeCull) {
+    useComputeCull = progCull.finish();
+    if (useComputeCull)
+      progCull.addSampler("hiZ");
+  }
+
+  if (anyTransparent && progComposite.finish()) {
+    progComposite.addSampler("accumTex");
+    progComposite.addSampler("revealTex");
+  } else {
+    anyTransparent = false;
+  }
+
+  if (traceReady && progUpsample.finish()) {
+    progUpsample.addSampler("traceTex");
+  } else {
+    traceReady = useTracing = false;
+  }
+}
+
+void CrystalFieldInit() {
+  int centerNode = TRANSFORM_ROOT;
+  glm::vec3 lo, hi;
+
+  crystals = NULL;
+  useOcclusion = false;
+  useProbe = false;
+  screenshotPending = false;
+  useInstancing = useSoftware || (GLEW_ARB_shader_storage_buffer_object &&
+                                  GLEW_ARB_multi_draw_indirect);
+  useComputeCull = !useSoftware && useInstancing && GLEW_ARB_compute_shader;
+  checkCull = false;
+
+  if (!useInstancing) {
+    cout << "Storage buffers not supported; no crystal field." << endl;
+    return;
+  }
+
+  crystalMesh = scene.loadMesh("crystal.obj", "../tex/");
+  if (crystalMesh < 0) {
+    cout << "No crystal mesh found; no crystal field." << endl;
+    return;
+  }
+
+  // A grid of crystals on the floor, each turned a different way. They all
+  // hang off one field node, so the whole field moves with one setLocal().
+  crystals = new InstanceGroup(&scene, crystalMesh);
+  crystalOccluder = occlusion.addGeometry(*scene.getMesh(crystalMesh).mesh);
+  useOcclusion = true;
+  fieldNode = AddTransformNode(TRANSFORM_ROOT, glm::mat4(1.0));
+  for (int x = 0; x < CRYSTAL_GRID; x++) {
+    for (int z = 0; z < CRYSTAL_GRID; z++) {
+      glm::vec3 pos((x - CRYSTAL_GRID / 2) * CRYSTAL_SPACING, -5.0f,
+                    (z - CRYSTAL_GRID / 2) * CRYSTAL_SPACING);
+      float turn = static_cast<float>((x * 37 + z * 61) % 360);
+      glm::mat4 m = glm::translate(glm::mat4(1.0), pos);
+
+      int node = AddCrystal(fieldNode,
+          glm::rotate(m, turn, glm::vec3(0.0f, 1.0f, 0.0f)));
+      if (x == CRYSTAL_GRID / 2 && z == CRYSTAL_GRID / 2)
+        centerNode = node;
+    }
+  }
+
+  // The environment probe rides at the center of the middle crystal.
+  vector<SubmeshBounds>& bounds = scene.getMesh(crystalMesh).mesh->getBounds();
+  lo = bounds[0].min;
+  hi = bounds[0].max;
+  for (int i = 1; i < bounds.size(); i++) {
+    lo = glm::min(lo, bounds[i].min);
+    hi = glm::max(hi, bounds[i].max);
+  }
+  probeNode = AddTransformNode(centerNode,
+      glm::translate(glm::mat4(1.0), (lo + hi) * 0.5f));
+  useProbe = !useSoftware;
+}
+
+void LightsInit() {
+  const glm::vec3 palette[4] = { glm::vec3(0.9f, 0.5f, 0.2f),
+                                 glm::vec3(0.2f, 0.6f, 0.9f),
+                                 glm::vec3(0.6f, 0.9f, 0.4f),
+                                 glm::vec3(0.8f, 0.3f, 0.8f) };
+  float spacing = CRYSTAL_GRID * CRYSTAL_SPACING / FIELD_LIGHTS;
+
+  useClusteredLights = useSoftware || GLEW_ARB_shader_storage_buffer_object;
+  if (!useClusteredLights) {
+    cout << "Storage buffers not supported; key light only." << endl;
+    return;
+  }
+
+  // Small colored lights scattered just above the crystal field.
+  for (int x = 0; x < FIELD_LIGHTS; x++) {
+    for (int z = 0; z < FIELD_LIGHTS; z++) {
+      float jitter = ((x * 13 + z * 29) % 10) / 10.0f - 0.5f;
+      glm::vec3 pos((x - FIELD_LIGHTS / 2 + jitter) * spacing, -2.0f,
+                    (z - FIELD_LIGHTS / 2 - jitter) * spacing);
+
+      lights.addLight(pos, FIELD_LIGHT_RADIUS, palette[(x + 3 * z) % 4]);
+    }
+  }
 }
 
 void OpenGLInit() {
@@ -279,6 +727,10 @@ void OpenGLInit() {
   glEnable(GL_NORMALIZE);
   glEnable(GL_RESCALE_NORMAL);
 
+  ViewInit();
+}
+
+void ViewInit() {
   // View/Projection
   fovy = 40.0f;
   aspect = WIN_WIDTH / static_cast<float>(WIN_HEIGHT);
@@ -291,29 +743,165 @@ void OpenGLInit() {
   MatrixInit();
 }
 
+bool SceneInit() {
+  // Load skybox mesh
+  skyboxMesh = scene.loadMesh("skybox.obj", "../tex/");
+  if (skyboxMesh < 0) {
+    cout << "Error loading object/mesh file. Aborting program..." << endl;
+    return false;
+  }
+  AddSceneObject(skyboxMesh, TRANSFORM_ROOT, glm::mat4(1.0));
+
+  // The ray tracer keeps its own copy of the crystal and its surroundings.
+  crystalSubmesh = FindCrystalSubmesh(*scene.getMesh(skyboxMesh).mesh);
+  if (!useSoftware)
+    tracer.setGeometry(*scene.getMesh(skyboxMesh).mesh, glm::mat4(1.0),
+                       crystalSubmesh);
+  CrystalFieldInit();
+  LightsInit();
+
+  return true;
+}
+
+int SoftwareMain(const string& compareFile) {
+  SoftwareRenderer renderer(WIN_WIDTH, WIN_HEIGHT);
+  double vertexMs = 0.0, setupMs = 0.0, rasterMs = 0.0;
+  double meanError;
+  int maxError;
+
+  if (!SceneInit())
+    return -1;
+  ViewInit();
+
+  renderer.setLight(glm::vec3(light_position), glm::vec3(light_ambient),
+                    glm::vec3(light_diffuse), glm::vec3(light_specular));
+  renderer.setClearColor(glm::vec3(1.0f, 1.0f, 1.0f));
+
+  for (int f = 0; f < SOFTWARE_FRAMES; f++) {
+    RenderSoftware(renderer);
+    startup.finish();
+    vertexMs += renderer.stats().vertexMillis;
+    setupMs += renderer.stats().setupMillis;
+    rasterMs += renderer.stats().rasterMillis;
+  }
+
+  const SoftwareStats& stats = renderer.stats();
+  vertexMs /= SOFTWARE_FRAMES;
+  setupMs /= SOFTWARE_FRAMES;
+  rasterMs /= SOFTWARE_FRAMES;
+  cout << "Software frame, " << jobs.numWorkers() << " workers, average of "
+       << SOFTWARE_FRAMES << ":" << endl;
+  cout << "  vertex: " << vertexMs << " ms, " << stats.vertices
+       << " vertices (" << stats.vertices / vertexMs / 1000.0 << " M/s)"
+       << endl;
+  cout << "  setup:  " << setupMs << " ms, " << stats.triangles
+       << " triangles (" << stats.triangles / setupMs / 1000.0 << " M/s), "
+       << stats.binned << " tile entries" << endl;
+  cout << "  raster: " << rasterMs << " ms, " << stats.fragments
+       << " fragments (" << stats.fragments / rasterMs / 1000.0 << " M/s)"
+       << endl;
+  cout << "  total:  " << vertexMs + setupMs + rasterMs << " ms" << endl;
+
+  if (renderer.writeImage(SOFTWARE_IMAGE))
+    cout << "Saved " << SOFTWARE_IMAGE << "." << endl;
+
+  if (!compareFile.empty()) {
+    if (!renderer.compareImage(compareFile, meanError, maxError))
+      return -1;
+    cout << "Against " << compareFile << ": mean error " << meanError
+         << ", largest " << maxError << " (of 255)." << endl;
+  }
+
+  return 0;
+}
+
 int main(int argc, char* argv[]) {
+  int stage;
+
+  // The software renderer needs no window, nor even a display.
+  useSoftware = false;
+  for (int i = 1; i < argc; i++) {
+    if (string(argv[i]) == "--software")
+      useSoftware = true;
+  }
+
   // Initialize freeglut
-  glutInit(&argc, argv);
-  glutInitDisplayMode(GLUT_DEPTH | GLUT_RGBA | GLUT_DOUBLE);
-  glutInitWindowSize(WIN_WIDTH, WIN_HEIGHT);
-  glutInitWindowPosition(50, 50);
+  if (!useSoftware) {
+    stage = startup.begin("glut");
+    glutInit(&argc, argv);
+    // Stencil too: the usual D24S8 buffer, which WeightedOIT's depth copy
+    // then matches.
+    glutInitDisplayMode(GLUT_DEPTH | GLUT_STENCIL | GLUT_RGBA | GLUT_DOUBLE);
+    glutInitWindowSize(WIN_WIDTH, WIN_HEIGHT);
+    glutInitWindowPosition(50, 50);
+    startup.end(stage);
+  }
+
+  // Start the job pool (glutInit() has removed its own arguments)
+  int jobFlags = 0;
+  FrameMode frameMode = FRAMES_ON_DEMAND;
+  double frameRate = FRAMES_DEFAULT_RATE;
+  bool vsync = true;
+  string compareFile;
+  for (int i = 1; i < argc; i++) {
+    string arg(argv[i]);
+    if (arg == "--software")
+      continue;
+    else if (arg == "--compare" && i + 1 < argc)
+      compareFile = argv[++i];
+    else if (arg == "--pin-threads")
+      jobFlags |= JOBS_PIN_THREADS;
+    else if (arg == "--numa")
+      jobFlags |= JOBS_NUMA_SPREAD;
+    else if (arg == "--fixed")
+      frameMode = FRAMES_FIXED;
+    else if (arg == "--fps" && i + 1 < argc)
+      frameRate = atof(argv[++i]);
+    else if (arg == "--uncapped")
+      frameMode = FRAMES_UNCAPPED;
+    else if (arg == "--no-vsync")
+      vsync = false;
+    else if (arg == "--path" && i + 1 < argc)
+      pathFile = argv[++i];
+    else if (arg == "--bench")
+      pathBenchmark = true;
+    else
+      cout << "Ignoring unknown option " << arg << "." << endl;
+  }
+  if (pathBenchmark)
+    frameMode = FRAMES_UNCAPPED;
+  jobs.start(0, jobFlags);
+
+  // Files load in the background from here on; SceneInit() and
+  // ShaderInit() pick them up once the contexts they need exist.
+  PrefetchInit();
 
+  if (useSoftware)
+    return SoftwareMain(compareFile);
+
+  stage = startup.begin("window");
   glutCreateWindow("Crystal-Water");
   glutDisplayFunc(CrystalDisplay);
   glutMouseFunc(MouseClick);
   glutMotionFunc(MouseMotion);
   glutMouseWheelFunc(MouseWheel);
   glutKeyboardFunc(Keyboard);
-  glutIdleFunc(NULL);
+  frames.attach(Idle);
+  frames.setVsync(vsync);
+  frames.setMode(frameMode, frameRate);
+  startup.end(stage);
 
   // Initialize GLEW
+  stage = startup.begin("glew");
   glewExperimental = true;
   if (glewInit() != GLEW_OK) {
     cout << "GLEW initialization failed. Aborting program..." << endl;
     return -1;
   }
+  startup.end(stage);
 
   // Initialize OpenCL
+  stage = startup.begin("opencl context");
   clGetPlatformIDs(1, &clPlatformId, NULL);
   clGetDeviceIDs(clPlatformId, CL_DEVICE_TYPE_GPU, 1, &clDeviceId, NULL);
   cl_context_properties properties[] = {
@@ -326,19 +914,37 @@ int main(int argc, char* argv[]) {
   if (contextError != CL_SUCCESS) {
     return ProcessErrorCL(contextError);
   }
+  startup.end(stage);
 
-  // Load skybox mesh
-  mesh.setTexturePath("../tex/");
-  if (!mesh.loadFile("skybox.obj")) {
-    cout << "Error loading object/mesh file. Aborting program..." << endl;
+  stage = startup.begin("scene");
+  if (!SceneInit())
     return -1;
-  }
+  startup.end(stage);
 
+  stage = startup.begin("opengl");
   OpenGLInit();
+  startup.end(stage);
+
+  stage = startup.begin("opencl kernels");
+  OpenCLInit();
+  startup.end(stage);
+
+  stage = startup.begin("shaders");
   ShaderInit();
+  startup.end(stage);
+
+  stage = startup.begin("buffers");
   BufferInit();
-//  OpenCLInit();
+  startup.end(stage);
+
+  // Same views, same frame count, every run.
+  if (pathBenchmark && !StartCameraPlayback(true))
+    return -1;
+
+  glutTimerFunc(RELOAD_POLL_MS, ReloadTimer, 0);
 
+  // Ended, and the whole timeline printed, by the first CrystalDisplay().
+  firstFrameStage = startup.begin("first frame");
   glutMainLoop();
 
   return 0;
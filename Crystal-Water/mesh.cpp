@@ -13,6 +13,8 @@
 #include <cstring>
 
 #include "./mesh.hpp"
+#include "./simplify.hpp"
+#include "./jobs.hpp"
 
 using namespace std;
 
@@ -23,9 +25,11 @@ Mesh::Mesh()
 : loaded(false),
   vboArray(NULL),
   iboArrays(NULL),
-  textures(NULL),
+  lodArrays(NULL),
+  images(NULL),
   nVBO(0),
   nIBOs(0) {
+  texArray.present = false;
 }
 
 /**
@@ -36,16 +40,25 @@ void Mesh::Reset() {
   loaded = false;
   vboArray = NULL;
   iboArrays = NULL;
-  textures = NULL;
+  lodArrays = NULL;
+  images = NULL;
+  texArray.present = false;
   nVBO = 0;
   nIBOs = 0;
+  _lodSizes.clear();
+  bounds.clear();
+  materials.clear();
 }
 
 /**
  * Default destructor.
  */
 Mesh::~Mesh() {
-  textures->~vector();
+  if (images) {
+    for (int i = 0; i < images->size(); i++)
+      SOIL_free_image_data((*images)[i].pixels);
+    images->~vector();
+  }
 }
 
 /**
@@ -72,6 +85,22 @@ bool Mesh::loadFile(const string& filename) {
   return loaded;
 }
 
+/**
+ * Loads a scene that is already in memory, as if read from a file: built
+ * by hand, or imported elsewhere. It must be triangulated and have normals.
+ * @param scene - the Assimp scene object; still owned by the caller
+ * @return true if load is successful, false if it fails
+ */
+bool Mesh::loadScene(const aiScene *scene) {
+  if (loaded)
+    Reset();
+
+  if ((loaded = scene))
+    this->ProcessScene(scene);
+
+  return loaded;
+}
+
 /**
  * The main processing of the class. This takes the scene object returned from
  * Assimp and interleaves the vertex and material data into a single VBO and
@@ -83,7 +112,7 @@ bool Mesh::loadFile(const string& filename) {
 void Mesh::ProcessScene(const aiScene *s) {
   this->iboArrays = new vector<vector<GLuint> >(s->mNumMeshes);
   this->vboArray = new vector<VBOVertex>;
-  this->textures = new vector<TexInfo>;
+  this->images = new vector<TexImage>;
 
   /**************************************************************************
    * According to doc, materials will correspond to meshes in a 1-to-1 mapping.
@@ -94,7 +123,12 @@ void Mesh::ProcessScene(const aiScene *s) {
    * IBOs for forward flexibility.
    */
 
-  /*  Construct internal buffers for VBO and IBOs while loading textures  */
+  /*  Decode every texture up front, in parallel on the job pool.  */
+
+  vector<int> layers;
+  this->LoadTextures(s, layers);
+
+  /*  Construct internal buffers for VBO and IBOs  */
 
   for (int i = 0; i < s->mNumMeshes; i++) {
     aiMesh *mesh = s->mMeshes[i];
@@ -103,35 +137,23 @@ void Mesh::ProcessScene(const aiScene *s) {
     aiColor3D diff(0.5f, 0.1f, 0.2f);
     float shiny = 42;                                 // The answer to LTU&E.
     int lastIdx;
-    bool tex;
+    int layer = -1;
+    int shadingMode = aiShadingMode_Phong;
+    float opacity = 1.0f;
 
-    // Load texture.
+    // Report texture (already decoded by LoadTextures()).
     int m = i + 1;
     if (s->HasMaterials() && s->mNumMaterials > 1) {
       aiMaterial* mat = s->mMaterials[m];
       aiString fileName;
       if (mat->GetTexture(aiTextureType_DIFFUSE, 0, &fileName) == AI_SUCCESS) {
-        string fullPath = this->filePath + fileName.data;
-        GLint texLoad = this->LoadTexture(fullPath, m);
-        if (texLoad) {
-          TexInfo texInfo;
-          texInfo.texID = texLoad;
-          texInfo.texUnit = m;
-          texInfo.present = true;
-
-          this->textures->push_back(texInfo);
-          tex = true;
+        // Failures were reported by DecodeTexture(), with SOIL's reason.
+        layer = layers[i];
+        if (layer >= 0)
           cout << "Loaded " << fileName.C_Str() << "." << endl;
-        } else {
-          cout << "SOIL: Error loading texture from " << fullPath << endl;
-        }
       } else {
         cout << "AssImp: Error retrieving texture file name from material "
              << m << "." << endl;
-        TexInfo texInfo;
-        texInfo.present = false;
-        this->textures->push_back(texInfo);
-        tex = false;
       }
 
       // Load material.
@@ -141,8 +163,22 @@ void Mesh::ProcessScene(const aiScene *s) {
         cout << "No specular color found in material " << m << "." << endl;
       if (mat->Get(AI_MATKEY_SHININESS, shiny) != AI_SUCCESS)
         cout << "No shininess value found in material " << m << "." << endl;
+      mat->Get(AI_MATKEY_SHADING_MODEL, shadingMode);
+      mat->Get(AI_MATKEY_OPACITY, opacity);
     }
 
+    // Remember what the shader needs to know about this material.
+    SubmeshMaterial material;
+    material.textured = layer >= 0;
+    if (shadingMode == aiShadingMode_Blinn)
+      material.shading = SHADING_BLINN;
+    else if (shadingMode == aiShadingMode_NoShading)
+      material.shading = SHADING_UNLIT;
+    else
+      material.shading = SHADING_PHONG;
+    material.opacity = opacity;
+    this->materials.push_back(material);
+
     lastIdx = 0;
     for (int n = 0; n < i; n++) {
       lastIdx += (*iboArrays)[n].size();
@@ -164,8 +200,8 @@ void Mesh::ProcessScene(const aiScene *s) {
         vbo.normal[0] = mesh->mNormals[normIdx][0];
         vbo.normal[1] = mesh->mNormals[normIdx][1];
         vbo.normal[2] = mesh->mNormals[normIdx][2];
-        vbo.texture[0] = tex ? mesh->mTextureCoords[0][texCIdx].x : 0;
-        vbo.texture[1] = tex ? mesh->mTextureCoords[0][texCIdx].y : 0;
+        vbo.texture[0] = layer >= 0 ? mesh->mTextureCoords[0][texCIdx].x : 0;
+        vbo.texture[1] = layer >= 0 ? mesh->mTextureCoords[0][texCIdx].y : 0;
         vbo.diffuse[0] = diff.r;
         vbo.diffuse[1] = diff.g;
         vbo.diffuse[2] = diff.b;
@@ -173,7 +209,7 @@ void Mesh::ProcessScene(const aiScene *s) {
         vbo.specular[1] = spec.g;
         vbo.specular[2] = spec.b;
         vbo.shininess = shiny;
-        vbo.align = 0;
+        vbo.texLayer = layer;
 
         vboArray->push_back(vbo);
         (*iboArrays)[i].push_back(face.mIndices[k] + lastIdx);
@@ -187,32 +223,223 @@ void Mesh::ProcessScene(const aiScene *s) {
   nIBOs = iboArrays->size();
   for (int i = 0; i < nIBOs; i++) {
     this->_iboSizes.push_back((*iboArrays)[i].size());
+    this->_lodSizes.push_back(vector<int>(1, (*iboArrays)[i].size()));
+  }
+
+  /*  Bound each sub-mesh for culling and screen-size LOD selection.  */
+
+  for (int i = 0; i < nIBOs; i++) {
+    vector<GLuint>& ibo = (*iboArrays)[i];
+    glm::vec3 lo(0.0f), hi(0.0f);
+    SubmeshBounds b;
+
+    for (int j = 0; j < ibo.size(); j++) {
+      GLfloat *p = (*vboArray)[ibo[j]].position;
+      glm::vec3 v(p[0], p[1], p[2]);
+      lo = j ? glm::min(lo, v) : v;
+      hi = j ? glm::max(hi, v) : v;
+    }
+
+    b.min = lo;
+    b.max = hi;
+    b.center = (lo + hi) * 0.5f;
+    b.radius = 0.0f;
+    for (int j = 0; j < ibo.size(); j++) {
+      GLfloat *p = (*vboArray)[ibo[j]].position;
+      float d = glm::length(glm::vec3(p[0], p[1], p[2]) - b.center);
+      b.radius = d > b.radius ? d : b.radius;
+    }
+    this->bounds.push_back(b);
+  }
+}
+
+/**
+ * Generates reduced levels of detail for every sub-mesh by quadric error
+ * simplification. Each level is another index array into the same VBO, so
+ * this must be called before the arrays are pushed to the GPU and freed.
+ * Sub-meshes too small to simplify simply get fewer (or no) extra levels.
+ * Sub-meshes are simplified in parallel on the job pool.
+ * @param levels - maximum number of reduced levels per sub-mesh
+ * @param ratio - fraction of triangles kept from one level to the next
+ */
+void Mesh::buildLODs(int levels, float ratio) {
+  if (!loaded) {
+    cout << "Cannot build LODs: no mesh loaded." << endl;
+    return;
+  }
+
+  this->lodArrays = new vector<vector<vector<GLuint> > >(nIBOs);
+
+  // Each sub-mesh writes only its own LOD arrays and sizes.
+  jobs.parallelFor(nIBOs, 1, [this, levels, ratio](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      Simplifier simplifier(*vboArray, (*iboArrays)[i]);
+      vector<vector<GLuint> >& lods = (*lodArrays)[i];
+
+      simplifier.buildLODs(levels, ratio, lods);
+
+      this->_lodSizes[i].resize(1);
+      for (int l = 0; l < lods.size(); l++) {
+        this->_lodSizes[i].push_back(lods[l].size());
+      }
+    }
+  });
+}
+
+/**
+ * Finds the diffuse texture of every sub-mesh's material and decodes them
+ * all in parallel on the job pool. Layers are then assigned in sub-mesh
+ * order, so the result matches decoding them one by one.
+ * @param s - the Assimp scene object
+ * @param layers - receives the array layer of each sub-mesh, or -1
+ */
+void Mesh::LoadTextures(const aiScene *s, vector<int>& layers) {
+  int n = s->mNumMeshes;
+  vector<string> paths(n);
+  vector<TexImage> decoded(n);
+
+  layers.assign(n, -1);
+  if (!s->HasMaterials() || s->mNumMaterials <= 1)
+    return;
+
+  for (int i = 0; i < n && i + 1 < s->mNumMaterials; i++) {
+    aiString fileName;
+    if (s->mMaterials[i + 1]->GetTexture(aiTextureType_DIFFUSE, 0,
+                                         &fileName) == AI_SUCCESS)
+      paths[i] = this->filePath + fileName.data;
+  }
+
+  jobs.parallelFor(n, 1, [&paths, &decoded](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      decoded[i].pixels = NULL;
+      if (!paths[i].empty())
+        DecodeTexture(paths[i], decoded[i]);
+    }
+  });
+
+  for (int i = 0; i < n; i++) {
+    if (!decoded[i].pixels)
+      continue;
+    this->images->push_back(decoded[i]);
+    layers[i] = images->size() - 1;
   }
 }
 
 /**
- * Uses SOIL to load textures discovered by Assimp in the loading of an object
- * or mesh file's materials.
+ * Uses SOIL to decode textures discovered by Assimp in the loading of an
+ * object or mesh file's materials. The image is kept client-side (flipped
+ * to OpenGL's bottom-up row order) until uploadTextures() is called.
+ * Touches no Mesh state, so several may run at once.
  * @param filename - the filename of the compressed image texture
- * @param texUnit - the texture unit to bind this texture under (mesh index)
- * @return the texture ID assigned by OpenGL via SOIL
+ * @param img - receives the decoded image
+ * @return true on success
  */
-GLuint Mesh::LoadTexture(string filename, int texUnit) {
-  GLuint id;
+bool Mesh::DecodeTexture(const string& filename, TexImage& img) {
+  static mutex reportLock;
+  int channels;
+
+  img.pixels = SOIL_load_image(filename.c_str(), &img.width, &img.height,
+                               &channels, SOIL_LOAD_RGBA);
+  if (!img.pixels) {
+    // SOIL (and stb_image inside it) keep the reason for the last failure
+    // in one global, which every decode running at once writes. It only
+    // ever points at a string literal, so reading it is safe, but under
+    // load it may name another file's failure. The lock keeps each report
+    // on its own line.
+    lock_guard<mutex> guard(reportLock);
+    cout << "Cannot load texture " << filename << " ("
+         << SOIL_last_result() << ")." << endl;
+    return false;
+  }
+
+  // Equivalent of SOIL_FLAG_INVERT_Y.
+  int rowBytes = img.width * 4;
+  vector<unsigned char> row(rowBytes);
+  for (int y = 0; y < img.height / 2; y++) {
+    unsigned char *top = img.pixels + y * rowBytes;
+    unsigned char *bottom = img.pixels + (img.height - 1 - y) * rowBytes;
+    memcpy(&row[0], top, rowBytes);
+    memcpy(top, bottom, rowBytes);
+    memcpy(bottom, &row[0], rowBytes);
+  }
+
+  return true;
+}
+
+/**
+ * Packs every decoded texture into the layers of one 2D array texture and
+ * frees the client-side images. Array layers must share a size, so images
+ * that differ from the largest one are bilinearly resampled to match.
+ * Requires a current GL context.
+ * @param texUnit - the texture unit to bind the array under
+ */
+void Mesh::uploadTextures(int texUnit) {
+  int nLayers = images ? images->size() : 0;
+  int width = 0, height = 0;
+
+  texArray.present = false;
+  if (!nLayers)
+    return;
+
+  for (int i = 0; i < nLayers; i++) {
+    width = (*images)[i].width > width ? (*images)[i].width : width;
+    height = (*images)[i].height > height ? (*images)[i].height : height;
+  }
 
-  glEnable(GL_TEXTURE_2D);
   glActiveTexture(GL_TEXTURE0 + texUnit);
+  glGenTextures(1, &texArray.texID);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, texArray.texID);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, nLayers, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+  for (int i = 0; i < nLayers; i++) {
+    TexImage& img = (*images)[i];
+    vector<unsigned char> scaled;
+    unsigned char *texels = img.pixels;
+
+    if (img.width != width || img.height != height) {
+      scaled.resize(width * height * 4);
+      for (int y = 0; y < height; y++) {
+        float sy = (y + 0.5f) * img.height / height - 0.5f;
+        int y0 = sy < 0 ? 0 : static_cast<int>(sy);
+        int y1 = y0 + 1 < img.height ? y0 + 1 : y0;
+        float fy = sy < 0 ? 0 : sy - y0;
+
+        for (int x = 0; x < width; x++) {
+          float sx = (x + 0.5f) * img.width / width - 0.5f;
+          int x0 = sx < 0 ? 0 : static_cast<int>(sx);
+          int x1 = x0 + 1 < img.width ? x0 + 1 : x0;
+          float fx = sx < 0 ? 0 : sx - x0;
+
+          for (int c = 0; c < 4; c++) {
+            float a = img.pixels[(y0 * img.width + x0) * 4 + c];
+            float b = img.pixels[(y0 * img.width + x1) * 4 + c];
+            float d = img.pixels[(y1 * img.width + x0) * 4 + c];
+            float e = img.pixels[(y1 * img.width + x1) * 4 + c];
+            float top = a + (b - a) * fx;
+            float bottom = d + (e - d) * fx;
+            scaled[(y * width + x) * 4 + c] =
+                static_cast<unsigned char>(top + (bottom - top) * fy + 0.5f);
+          }
+        }
+      }
+      texels = &scaled[0];
+    }
 
-  id = SOIL_load_OGL_texture(filename.c_str(),
-                             SOIL_LOAD_AUTO,
-                             SOIL_CREATE_NEW_ID,
-                             SOIL_FLAG_MIPMAPS | SOIL_FLAG_INVERT_Y);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1,
+                    GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    SOIL_free_image_data(img.pixels);
+  }
+  images->clear();
 
-  glBindTexture(GL_TEXTURE_2D, id);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR);
+  glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-  return id;
+  texArray.texUnit = texUnit;
+  texArray.texTarget = GL_TEXTURE_2D_ARRAY;
+  texArray.present = true;
 }
 
 /**
@@ -232,6 +459,8 @@ void Mesh::setTexturePath(string path) {
 void Mesh::freeArrays() {
   vboArray->~vector();
   iboArrays->~vector();
+  if (lodArrays)
+    lodArrays->~vector();
 }
 
 /**
@@ -275,9 +504,63 @@ std::vector<vector<GLuint> >& Mesh::getIBOIndexArrays() {
 }
 
 /**
- * Retrieves all loaded texture IDs with associated texture units.
- * @return reference to an STL vector of TexInfo pairings
+ * Retrieves the array texture holding every sub-mesh texture. Only present
+ * once uploadTextures() has run and at least one texture was loaded.
+ * @return reference to the TexInfo of the array texture
+ */
+TexInfo& Mesh::getTextureArray() {
+  return this->texArray;
+}
+
+/**
+ * Retrieves the decoded texture images, one per array layer. Empty once
+ * uploadTextures() has run.
+ * @return reference to the STL vector of images
+ */
+std::vector<TexImage>& Mesh::getTextureImages() {
+  return *this->images;
+}
+
+/**
+ * Retrieves the number of detail levels (including the full mesh) built for
+ * the given sub-mesh.
+ * @param ibo - index of the sub-mesh
+ * @return number of levels, at least 1
+ */
+int Mesh::numLODs(int ibo) {
+  return this->_lodSizes[ibo].size();
+}
+
+/**
+ * Retrieves index counts for every level of every sub-mesh. Level 0 is the
+ * full-detail IBO.
+ * @return reference to an STL vector of per-level sizes for each IBO
+ */
+std::vector<std::vector<int> >& Mesh::lodSizes() {
+  return this->_lodSizes;
+}
+
+/**
+ * Retrieves the reduced index arrays built by buildLODs(). Entry [i][l] is
+ * level l + 1 of sub-mesh i.
+ * @return reference to an STL vector of reduced IBO arrays per sub-mesh
+ */
+std::vector<std::vector<std::vector<GLuint> > >& Mesh::getLODIndexArrays() {
+  return *(this->lodArrays);
+}
+
+/**
+ * Retrieves the object-space bounding box and sphere of every sub-mesh.
+ * @return reference to an STL vector of SubmeshBounds, one per IBO
+ */
+std::vector<SubmeshBounds>& Mesh::getBounds() {
+  return this->bounds;
+}
+
+/**
+ * Retrieves the shader-relevant material of every sub-mesh.
+ * @return reference to an STL vector of SubmeshMaterials, one per IBO
  */
-std::vector<TexInfo>& Mesh::getTextures() {
-  return *(this->textures);
+std::vector<SubmeshMaterial>& Mesh::getMaterials() {
+  return this->materials;
 }
@@ -18,8 +18,14 @@
 #include <assimp/postprocess.h>
 #include <assimp/DefaultLogger.hpp>
 #include <SOIL/SOIL.h>
+#include <glm/glm.hpp>
 
 #include <string>
+#include <vector>
+
+
+#define NULL_PTR        reinterpret_cast<char *>(NULL)
+#define OFFSET_PTR(n)   (reinterpret_cast<GLvoid *>(NULL_PTR + (n)))
 
 
 /**
@@ -33,7 +39,7 @@ typedef struct {
   GLfloat diffuse[3];       /**< Vertex material diffuse property */
   GLfloat specular[3];      /**< Vertex material specular property */
   GLfloat shininess;        /**< Vertex material shininess coefficient */
-  GLfloat align;            /**< 4 empty bytes for alignment */
+  GLfloat texLayer;         /**< Texture array layer, or -1 if untextured */
 } VBOVertex;
 
 /**
@@ -42,15 +48,56 @@ typedef struct {
 typedef struct {
   GLint texUnit;            /**< Texture unit in which texture was bound */
   GLuint texID;             /**< Generated texture ID */
+  GLenum texTarget;         /**< GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY */
   bool present;             /**< Whether this TexInfo should be considered */
 } TexInfo;
 
+/**
+ * A decoded texture image held client-side until it is uploaded.
+ */
+typedef struct {
+  int width;                /**< Width in texels */
+  int height;               /**< Height in texels */
+  unsigned char *pixels;    /**< RGBA8 texels, bottom row first */
+} TexImage;
+
+/**
+ * Object-space bounds of one sub-mesh: the box for culling and the sphere
+ * for screen-size LOD selection.
+ */
+typedef struct {
+  glm::vec3 min;            /**< Box minimum corner */
+  glm::vec3 max;            /**< Box maximum corner */
+  glm::vec3 center;         /**< Sphere center (also the box center) */
+  float radius;             /**< Sphere radius */
+} SubmeshBounds;
+
+// Lighting models a material may ask for.
+const int SHADING_PHONG = 0;
+const int SHADING_BLINN = 1;
+const int SHADING_UNLIT = 2;
+
+/**
+ * The parts of a sub-mesh's material that decide which shader variant
+ * draws it, and its opacity (set per draw). Colors and shininess stay
+ * per-vertex in the VBO.
+ */
+typedef struct {
+  bool textured;            /**< Has a diffuse texture layer */
+  int shading;              /**< One of the SHADING_* models */
+  float opacity;            /**< 1 for opaque, less to draw transparent */
+} SubmeshMaterial;
+
 
 /**
  * Class representing a loaded object and material file. Somewhat misnamed in
  * that the driver for the class, Assimp, subdivides such files into multiple
  * meshes for each material. This is largely abstracted, however, as this
  * detail is not visible from outside the class.
+ *
+ * Textures are decoded on load but not sent to OpenGL until uploadTextures(),
+ * which packs every sub-mesh texture into the layers of one 2D array texture
+ * so the whole mesh can be drawn with a single texture binding.
  */
 class Mesh {
  public:
@@ -58,28 +105,44 @@ class Mesh {
   ~Mesh();
 
   bool loadFile(const std::string& filename);
+  bool loadScene(const aiScene *scene);
 
   int vboSize();
   int numIBOs();
   std::vector<int>& iboSizes();
-  std::vector<TexInfo>& getTextures();
+  TexInfo& getTextureArray();
+  std::vector<TexImage>& getTextureImages();
+  void uploadTextures(int texUnit);
   std::vector<VBOVertex>& getVBOVertexArray();
   std::vector<std::vector<GLuint> >& getIBOIndexArrays();
 
+  void buildLODs(int levels, float ratio);
+  int numLODs(int ibo);
+  std::vector<std::vector<int> >& lodSizes();
+  std::vector<std::vector<std::vector<GLuint> > >& getLODIndexArrays();
+  std::vector<SubmeshBounds>& getBounds();
+  std::vector<SubmeshMaterial>& getMaterials();
+
   void setTexturePath(std::string path);
   void freeArrays();
 
  private:
   std::string filePath;
-  std::vector<TexInfo> *textures;
+  std::vector<TexImage> *images;
+  TexInfo texArray;
   std::vector<VBOVertex> *vboArray;
   std::vector<std::vector<GLuint> > *iboArrays;
+  std::vector<std::vector<std::vector<GLuint> > > *lodArrays;
   std::vector<int> _iboSizes;
+  std::vector<std::vector<int> > _lodSizes;
+  std::vector<SubmeshBounds> bounds;
+  std::vector<SubmeshMaterial> materials;
   int nVBO, nIBOs;
   bool loaded;
 
   void ProcessScene(const aiScene *s);
-  GLuint LoadTexture(std::string filename, int texUnit);
+  void LoadTextures(const aiScene *s, std::vector<int>& layers);
+  static bool DecodeTexture(const std::string& filename, TexImage& img);
 
   void Reset();
 };
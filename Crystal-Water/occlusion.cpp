@@ -0,0 +1,604 @@
+/**
+ * occlusion.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HIZ_AVX2
+#include <immintrin.h>
+#endif
+
+#include "./occlusion.hpp"
+#include "./frustum.hpp"
+#include "./scene.hpp"
+#include "./glstate.hpp"
+#include "./jobs.hpp"
+
+using namespace std;
+
+const float EMPTY_BOX = 1e30f;              // Padding boxes are never inside
+const float FAR_DEPTH = 1.0f;               // Cleared depth
+
+/**
+ * Edge functions and depth plane of one triangle, clipped to the screen.
+ * A pixel center (px, py) is inside when a[i] * px + b[i] * py + c[i] >= 0
+ * for all three edges.
+ */
+typedef struct {
+  float a[3], b[3], c[3];
+  float za, zb, zc;
+  int colMin, colMax;
+} EdgeSetup;
+
+typedef void (*FillFunction)(const EdgeSetup& s, float *depth, int rowBegin,
+                             int rowEnd);
+
+
+/**
+ * Fills rows [rowBegin, rowEnd) of a triangle one pixel at a time, keeping
+ * the nearer depth.
+ */
+static void FillScalar(const EdgeSetup& s, float *depth, int rowBegin,
+                       int rowEnd) {
+  for (int y = rowBegin; y < rowEnd; y++) {
+    float py = y + 0.5f;
+    float *row = depth + y * HIZ_WIDTH;
+
+    for (int x = s.colMin; x <= s.colMax; x++) {
+      float px = x + 0.5f;
+      float e0 = s.a[0] * px + s.b[0] * py + s.c[0];
+      float e1 = s.a[1] * px + s.b[1] * py + s.c[1];
+      float e2 = s.a[2] * px + s.b[2] * py + s.c[2];
+
+      if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) {
+        float z = s.za * px + s.zb * py + s.zc;
+        if (z < row[x])
+          row[x] = z;
+      }
+    }
+  }
+}
+
+#ifdef HIZ_AVX2
+/**
+ * FillScalar(), eight pixels at a time. Blocks start on a multiple of 8,
+ * and HIZ_WIDTH is one, so a block never leaves its row.
+ */
+__attribute__((target("avx2,fma")))
+static void FillAVX2(const EdgeSetup& s, float *depth, int rowBegin,
+                     int rowEnd) {
+  const __m256 lane = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f,
+                                     4.5f, 5.5f, 6.5f, 7.5f);
+  const __m256 zero = _mm256_setzero_ps();
+  __m256 a0 = _mm256_set1_ps(s.a[0]);
+  __m256 a1 = _mm256_set1_ps(s.a[1]);
+  __m256 a2 = _mm256_set1_ps(s.a[2]);
+  __m256 za = _mm256_set1_ps(s.za);
+  int colStart = s.colMin & ~7;
+
+  for (int y = rowBegin; y < rowEnd; y++) {
+    float py = y + 0.5f;
+    float *row = depth + y * HIZ_WIDTH;
+    __m256 r0 = _mm256_set1_ps(s.b[0] * py + s.c[0]);
+    __m256 r1 = _mm256_set1_ps(s.b[1] * py + s.c[1]);
+    __m256 r2 = _mm256_set1_ps(s.b[2] * py + s.c[2]);
+    __m256 rz = _mm256_set1_ps(s.zb * py + s.zc);
+
+    for (int x = colStart; x <= s.colMax; x += 8) {
+      __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lane);
+      __m256 e0 = _mm256_fmadd_ps(a0, px, r0);
+      __m256 e1 = _mm256_fmadd_ps(a1, px, r1);
+      __m256 e2 = _mm256_fmadd_ps(a2, px, r2);
+      __m256 inside = _mm256_and_ps(
+          _mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ),
+                        _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)),
+          _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+
+      if (!_mm256_movemask_ps(inside))
+        continue;
+
+      __m256 z = _mm256_fmadd_ps(za, px, rz);
+      __m256 old = _mm256_loadu_ps(row + x);
+      __m256 nearer = _mm256_min_ps(old, z);
+      _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, nearer, inside));
+    }
+  }
+}
+#endif
+
+/**
+ * Picks the widest fill the CPU supports.
+ */
+static FillFunction PickFill() {
+#ifdef HIZ_AVX2
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return FillAVX2;
+#endif
+  return FillScalar;
+}
+
+static const FillFunction fillSpans = PickFill();
+
+
+/**
+ * Default Constructor. Allocates the depth buffer and every pyramid level.
+ */
+OcclusionCuller::OcclusionCuller()
+: nTriangles(0),
+  nOccluded(0),
+  millis(0.0),
+  rendered(false) {
+  int w = HIZ_WIDTH, h = HIZ_HEIGHT;
+
+  for (;;) {
+    this->levels.push_back(vector<float>(w * h, FAR_DEPTH));
+    this->levelWidth.push_back(w);
+    this->levelHeight.push_back(h);
+    if (w == 1 && h == 1)
+      break;
+    // glTexStorage2D() rounds level sizes down; BuildPyramid() folds
+    // the odd row and column into the edge texels.
+    w = max(1, w / 2);
+    h = max(1, h / 2);
+  }
+
+  hiZ.texID = 0;
+  hiZ.texUnit = HIZ_TEXTURE_UNIT;
+  hiZ.texTarget = GL_TEXTURE_2D;
+  hiZ.present = false;
+}
+
+/**
+ * Default Destructor. Frees the pyramid texture.
+ */
+OcclusionCuller::~OcclusionCuller() {
+  if (hiZ.present)
+    glDeleteTextures(1, &hiZ.texID);
+}
+
+/**
+ * Copies the coarsest LOD of every sub-mesh of a mesh as one occluder
+ * shape. Must be called before the mesh's arrays are freed by upload.
+ * @param mesh - a loaded mesh with LODs built
+ * @return geometry index for addOccluder()
+ */
+int OcclusionCuller::addGeometry(Mesh& mesh) {
+  vector<VBOVertex>& vbo = mesh.getVBOVertexArray();
+  vector<vector<GLuint> >& ibos = mesh.getIBOIndexArrays();
+  vector<vector<vector<GLuint> > >& lods = mesh.getLODIndexArrays();
+  Geometry geometry;
+
+  geometry.min = glm::vec3(EMPTY_BOX);
+  geometry.max = glm::vec3(-EMPTY_BOX);
+  for (int i = 0; i < vbo.size(); i++) {
+    glm::vec3 p(vbo[i].position[0], vbo[i].position[1], vbo[i].position[2]);
+
+    geometry.positions.push_back(p);
+    geometry.min = glm::min(geometry.min, p);
+    geometry.max = glm::max(geometry.max, p);
+  }
+
+  for (int s = 0; s < ibos.size(); s++) {
+    vector<GLuint>& coarsest = lods[s].empty() ? ibos[s] : lods[s].back();
+    geometry.indices.insert(geometry.indices.end(), coarsest.begin(),
+                            coarsest.end());
+  }
+
+  this->geometries.push_back(geometry);
+
+  return geometries.size() - 1;
+}
+
+/**
+ * Places an occluder.
+ * @param geometry - index returned by addGeometry()
+ * @param transform - occluder-to-scene transform
+ * @return the new occluder index
+ */
+int OcclusionCuller::addOccluder(int geometry, const glm::mat4& transform) {
+  int count = occluderGeometry.size() + 1;
+  int padded = (count + 3) & ~3;
+
+  this->occluderGeometry.push_back(geometry);
+  this->transforms.push_back(transform);
+  this->triangles.resize(count);
+
+  minX.resize(padded, EMPTY_BOX);  maxX.resize(padded, -EMPTY_BOX);
+  minY.resize(padded, EMPTY_BOX);  maxY.resize(padded, -EMPTY_BOX);
+  minZ.resize(padded, EMPTY_BOX);  maxZ.resize(padded, -EMPTY_BOX);
+
+  this->setTransform(count - 1, transform);
+
+  return count - 1;
+}
+
+/**
+ * Moves an occluder.
+ * @param occluder - index returned by addOccluder()
+ * @param transform - new occluder-to-scene transform
+ */
+void OcclusionCuller::setTransform(int occluder, const glm::mat4& transform) {
+  Geometry& geometry = geometries[occluderGeometry[occluder]];
+  glm::vec3 lo, hi;
+
+  transforms[occluder] = transform;
+
+  Scene::transformBox(geometry.min, geometry.max, transform, lo, hi);
+  minX[occluder] = lo.x;  maxX[occluder] = hi.x;
+  minY[occluder] = lo.y;  maxY[occluder] = hi.y;
+  minZ[occluder] = lo.z;  maxZ[occluder] = hi.z;
+}
+
+/**
+ * Rasterizes every occluder in view and rebuilds the pyramid.
+ * @param viewProj - combined projection and model matrix (mProj * mModel)
+ */
+void OcclusionCuller::render(const glm::mat4& viewProj) {
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  Frustum frustum(viewProj);
+  int nOccluders = occluderGeometry.size();
+  int nBands = HIZ_HEIGHT / HIZ_BAND_ROWS;
+
+  this->viewProj = viewProj;
+
+  this->drawn.clear();
+  if (nOccluders)
+    frustum.cullBoxes(&minX[0], &minY[0], &minZ[0], &maxX[0], &maxY[0],
+                      &maxZ[0], nOccluders, drawn);
+
+  jobs.parallelFor(drawn.size(), 0, [this](int begin, int end) {
+    for (int i = begin; i < end; i++)
+      this->SetupOccluder(drawn[i]);
+  });
+
+  jobs.parallelFor(nBands, 1, [this](int begin, int end) {
+    for (int band = begin; band < end; band++)
+      this->RasterizeBand(band);
+  });
+
+  this->BuildPyramid();
+
+  this->nTriangles = 0;
+  for (int i = 0; i < drawn.size(); i++)
+    this->nTriangles += triangles[drawn[i]].size();
+  this->nOccluded = 0;
+  this->rendered = true;
+  this->millis = chrono::duration<double, milli>(
+      chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Tests a scene-space box against the pyramid from the last render().
+ * @param lo - box minimum corner
+ * @param hi - box maximum corner
+ * @return false only if the box is certainly hidden
+ */
+bool OcclusionCuller::testBox(const glm::vec3& lo, const glm::vec3& hi) const {
+  float sx0 = EMPTY_BOX, sy0 = EMPTY_BOX, sx1 = -EMPTY_BOX, sy1 = -EMPTY_BOX;
+  float zNearest = EMPTY_BOX;
+  float farthest = 0.0f;
+  int level = 0;
+  int top = levels.size() - 1;
+
+  if (!rendered)
+    return true;
+
+  for (int k = 0; k < 8; k++) {
+    glm::vec4 p((k & 1) ? hi.x : lo.x, (k & 2) ? hi.y : lo.y,
+                (k & 4) ? hi.z : lo.z, 1.0f);
+    glm::vec4 clip = viewProj * p;
+
+    // Crosses the near plane: the camera may be inside it.
+    if (clip.z < -clip.w)
+      return true;
+
+    float inv = 1.0f / clip.w;
+    sx0 = min(sx0, clip.x * inv);  sx1 = max(sx1, clip.x * inv);
+    sy0 = min(sy0, clip.y * inv);  sy1 = max(sy1, clip.y * inv);
+    zNearest = min(zNearest, clip.z * inv);
+  }
+
+  // Screen rectangle in depth buffer pixels.
+  sx0 = min(max((sx0 * 0.5f + 0.5f) * HIZ_WIDTH, 0.0f), 1.0f * HIZ_WIDTH);
+  sx1 = min(max((sx1 * 0.5f + 0.5f) * HIZ_WIDTH, 0.0f), 1.0f * HIZ_WIDTH);
+  sy0 = min(max((sy0 * 0.5f + 0.5f) * HIZ_HEIGHT, 0.0f), 1.0f * HIZ_HEIGHT);
+  sy1 = min(max((sy1 * 0.5f + 0.5f) * HIZ_HEIGHT, 0.0f), 1.0f * HIZ_HEIGHT);
+  if (sx1 <= sx0 || sy1 <= sy0)
+    return true;
+
+  int x0 = static_cast<int>(sx0);
+  int y0 = static_cast<int>(sy0);
+  int x1 = min(static_cast<int>(sx1), HIZ_WIDTH - 1);
+  int y1 = min(static_cast<int>(sy1), HIZ_HEIGHT - 1);
+
+  // The level where the rectangle spans at most two texels each way.
+  while (level < top &&
+         ((x1 >> level) - (x0 >> level) > 1 ||
+          (y1 >> level) - (y0 >> level) > 1))
+    level++;
+
+  // Pixels past a rounded-down edge belong to the last texel.
+  const vector<float>& texels = levels[level];
+  int width = levelWidth[level];
+  int xMax = min(x1 >> level, width - 1);
+  int yMax = min(y1 >> level, levelHeight[level] - 1);
+  for (int y = min(y0 >> level, yMax); y <= yMax; y++) {
+    for (int x = min(x0 >> level, xMax); x <= xMax; x++)
+      farthest = max(farthest, texels[y * width + x]);
+  }
+
+  return zNearest * 0.5f + 0.5f <= farthest;
+}
+
+/**
+ * Removes the hidden boxes from a list of packed boxes that passed the
+ * frustum test.
+ * @param minX, minY, minZ, maxX, maxY, maxZ - packed box coordinates
+ * @param indices - box indices to test; hidden ones are removed
+ */
+void OcclusionCuller::filterBoxes(const float *minX, const float *minY,
+                                  const float *minZ, const float *maxX,
+                                  const float *maxY, const float *maxZ,
+                                  vector<int>& indices) {
+  int kept = 0;
+
+  for (int i = 0; i < indices.size(); i++) {
+    int b = indices[i];
+
+    if (this->testBox(glm::vec3(minX[b], minY[b], minZ[b]),
+                      glm::vec3(maxX[b], maxY[b], maxZ[b])))
+      indices[kept++] = b;
+  }
+
+  this->nOccluded += indices.size() - kept;
+  indices.resize(kept);
+}
+
+/**
+ * Copies the pyramid into its mipmapped texture for cull.comp.
+ */
+void OcclusionCuller::upload() {
+  int nLevels = levels.size();
+
+  if (!hiZ.present) {
+    glGenTextures(1, &hiZ.texID);
+    glState.bindTexture(HIZ_TEXTURE_UNIT, GL_TEXTURE_2D, hiZ.texID);
+    glTexStorage2D(GL_TEXTURE_2D, nLevels, GL_R32F, HIZ_WIDTH, HIZ_HEIGHT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+        GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    hiZ.present = true;
+  }
+
+  glState.bindTexture(HIZ_TEXTURE_UNIT, GL_TEXTURE_2D, hiZ.texID);
+  for (int l = 0; l < nLevels; l++)
+    glTexSubImage2D(GL_TEXTURE_2D, l, 0, 0, levelWidth[l], levelHeight[l],
+        GL_RED, GL_FLOAT, &levels[l][0]);
+}
+
+/**
+ * Retrieves the pyramid texture (valid after upload()).
+ * @return texture info, bound under HIZ_TEXTURE_UNIT
+ */
+TexInfo& OcclusionCuller::texture() {
+  return this->hiZ;
+}
+
+/**
+ * Retrieves the number of pyramid levels, the depth buffer included.
+ * @return number of levels
+ */
+int OcclusionCuller::numLevels() const {
+  return this->levels.size();
+}
+
+/**
+ * Retrieves the number of occluders rasterized by the last render().
+ * @return number of occluders in view
+ */
+int OcclusionCuller::numOccluders() {
+  return this->drawn.size();
+}
+
+/**
+ * Retrieves the number of triangles rasterized by the last render().
+ * @return number of triangles
+ */
+int OcclusionCuller::numTriangles() {
+  return this->nTriangles;
+}
+
+/**
+ * Retrieves the number of boxes filterBoxes() removed since render().
+ * @return number of hidden boxes
+ */
+int OcclusionCuller::numOccluded() {
+  return this->nOccluded;
+}
+
+/**
+ * Retrieves the time the last render() took.
+ * @return milliseconds
+ */
+double OcclusionCuller::renderMillis() {
+  return this->millis;
+}
+
+/**
+ * Transforms one occluder into clip space and sets up its triangles.
+ */
+void OcclusionCuller::SetupOccluder(int occluder) {
+  static thread_local vector<glm::vec4> clip;
+  Geometry& geometry = geometries[occluderGeometry[occluder]];
+  vector<ScreenTriangle>& out = triangles[occluder];
+  glm::mat4 M = viewProj * transforms[occluder];
+  int nIndices = geometry.indices.size();
+
+  clip.resize(geometry.positions.size());
+  for (int i = 0; i < clip.size(); i++)
+    clip[i] = M * glm::vec4(geometry.positions[i], 1.0f);
+
+  out.clear();
+  for (int i = 0; i + 2 < nIndices; i += 3) {
+    glm::vec4 corners[3] = { clip[geometry.indices[i]],
+                             clip[geometry.indices[i + 1]],
+                             clip[geometry.indices[i + 2]] };
+    this->EmitTriangle(corners, out);
+  }
+}
+
+/**
+ * Clips a clip-space triangle against the near plane, projects it, and
+ * keeps what faces the camera and touches the depth buffer.
+ */
+void OcclusionCuller::EmitTriangle(const glm::vec4 *clip,
+                                   vector<ScreenTriangle>& out) {
+  glm::vec4 poly[4];
+  float sx[4], sy[4], sz[4];
+  int n = 0;
+
+  // Inside the near plane: z + w >= 0.
+  for (int i = 0; i < 3; i++) {
+    const glm::vec4& a = clip[i];
+    const glm::vec4& b = clip[(i + 1) % 3];
+    float da = a.z + a.w, db = b.z + b.w;
+
+    if (da >= 0.0f)
+      poly[n++] = a;
+    if ((da >= 0.0f) != (db >= 0.0f))
+      poly[n++] = a + (b - a) * (da / (da - db));
+  }
+  if (n < 3)
+    return;
+
+  for (int i = 0; i < n; i++) {
+    float inv = 1.0f / poly[i].w;
+    sx[i] = (poly[i].x * inv * 0.5f + 0.5f) * HIZ_WIDTH;
+    sy[i] = (poly[i].y * inv * 0.5f + 0.5f) * HIZ_HEIGHT;
+    sz[i] = poly[i].z * inv * 0.5f + 0.5f;
+  }
+
+  // A triangle, or a quad split into two.
+  for (int t = 1; t + 1 < n; t++) {
+    int v[3] = { 0, t, t + 1 };
+    ScreenTriangle tri;
+    float area, lowY = EMPTY_BOX, highY = -EMPTY_BOX;
+    float lowX = EMPTY_BOX, highX = -EMPTY_BOX;
+
+    for (int k = 0; k < 3; k++) {
+      tri.x[k] = sx[v[k]];
+      tri.y[k] = sy[v[k]];
+      tri.z[k] = sz[v[k]];
+      lowX = min(lowX, tri.x[k]);  highX = max(highX, tri.x[k]);
+      lowY = min(lowY, tri.y[k]);  highY = max(highY, tri.y[k]);
+    }
+
+    // Counter-clockwise faces the camera.
+    area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) -
+           (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+    if (area <= 0.0f)
+      continue;
+    if (highX < 0.5f || lowX > HIZ_WIDTH - 0.5f)
+      continue;
+
+    // Rows whose pixel centers the triangle spans.
+    tri.rowMin = max(0, static_cast<int>(ceil(lowY - 0.5f)));
+    tri.rowMax = min(HIZ_HEIGHT - 1, static_cast<int>(floor(highY - 0.5f)));
+    if (tri.rowMin > tri.rowMax)
+      continue;
+
+    out.push_back(tri);
+  }
+}
+
+/**
+ * Clears one band of rows and draws every triangle that touches it.
+ */
+void OcclusionCuller::RasterizeBand(int band) {
+  float *depth = &levels[0][0];
+  int rowBegin = band * HIZ_BAND_ROWS;
+  int rowEnd = rowBegin + HIZ_BAND_ROWS;
+
+  fill_n(depth + rowBegin * HIZ_WIDTH, HIZ_BAND_ROWS * HIZ_WIDTH, FAR_DEPTH);
+
+  for (int i = 0; i < drawn.size(); i++) {
+    vector<ScreenTriangle>& tris = triangles[drawn[i]];
+
+    for (int t = 0; t < tris.size(); t++) {
+      const ScreenTriangle& tri = tris[t];
+      EdgeSetup s;
+      float area, lowX, highX;
+
+      if (tri.rowMax < rowBegin || tri.rowMin >= rowEnd)
+        continue;
+
+      // Edge i runs from corner i to corner i + 1.
+      for (int e = 0; e < 3; e++) {
+        int j = (e + 1) % 3;
+        s.a[e] = tri.y[e] - tri.y[j];
+        s.b[e] = tri.x[j] - tri.x[e];
+        s.c[e] = (tri.y[j] - tri.y[e]) * tri.x[e] -
+                 (tri.x[j] - tri.x[e]) * tri.y[e];
+      }
+
+      // Depth by barycentric weights: edge (1,2) weighs corner 0, etc.
+      area = s.c[0] + s.c[1] + s.c[2];
+      s.za = (tri.z[0] * s.a[1] + tri.z[1] * s.a[2] + tri.z[2] * s.a[0]) /
+             area;
+      s.zb = (tri.z[0] * s.b[1] + tri.z[1] * s.b[2] + tri.z[2] * s.b[0]) /
+             area;
+      s.zc = (tri.z[0] * s.c[1] + tri.z[1] * s.c[2] + tri.z[2] * s.c[0]) /
+             area;
+
+      lowX = min(tri.x[0], min(tri.x[1], tri.x[2]));
+      highX = max(tri.x[0], max(tri.x[1], tri.x[2]));
+      s.colMin = max(0, static_cast<int>(ceil(lowX - 0.5f)));
+      s.colMax = min(HIZ_WIDTH - 1, static_cast<int>(floor(highX - 0.5f)));
+      if (s.colMin > s.colMax)
+        continue;
+
+      fillSpans(s, depth, max(tri.rowMin, rowBegin),
+                min(tri.rowMax + 1, rowEnd));
+    }
+  }
+}
+
+/**
+ * Builds each pyramid level from the farthest of the 2x2 texels below.
+ * Level sizes round down, so the last column and row also take the odd
+ * column and row of the level below.
+ */
+void OcclusionCuller::BuildPyramid() {
+  for (int l = 1; l < levels.size(); l++) {
+    const vector<float>& below = levels[l - 1];
+    vector<float>& level = levels[l];
+    int bw = levelWidth[l - 1], bh = levelHeight[l - 1];
+    int w = levelWidth[l], h = levelHeight[l];
+
+    for (int y = 0; y < h; y++) {
+      int y0 = min(2 * y, bh - 1);
+      int y1 = (y == h - 1) ? bh - 1 : 2 * y + 1;
+
+      for (int x = 0; x < w; x++) {
+        int x0 = min(2 * x, bw - 1);
+        int x1 = (x == w - 1) ? bw - 1 : 2 * x + 1;
+        float farthest = 0.0f;
+
+        for (int by = y0; by <= y1; by++) {
+          for (int bx = x0; bx <= x1; bx++)
+            farthest = max(farthest, below[by * bw + bx]);
+        }
+        level[y * w + x] = farthest;
+      }
+    }
+  }
+}
@@ -0,0 +1,124 @@
+/**
+ * occlusion.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  Occlusion culling on the CPU: a few large, simple meshes (occluders)
+ *  are rasterized into a small depth buffer, and the bounding boxes of
+ *  everything else are tested against it before any draw is submitted.
+ *
+ *  Notes:
+ *
+ *    Every frame, render() does three things:
+ *
+ *      1. Occluders inside the frustum are transformed to clip space,
+ *         clipped against the near plane, back-face culled and set up as
+ *         screen triangles, spread over the job pool by occluder.
+ *      2. The HIZ_WIDTH by HIZ_HEIGHT depth buffer is cut into bands of
+ *         HIZ_BAND_ROWS rows, one job per band, and each band draws every
+ *         triangle that touches it. Spans are filled eight pixels at a
+ *         time with AVX2 when the CPU has it (chosen at run time), one at
+ *         a time otherwise. Bands never share pixels, so there are no
+ *         locks.
+ *      3. A Hi-Z pyramid is built above the depth buffer: each texel of a
+ *         level holds the farthest depth of the 2x2 texels below it.
+ *
+ *    testBox() projects a box, picks the level at which its screen
+ *    rectangle covers at most two texels each way, and reports it hidden
+ *    only if its nearest depth is behind the farthest depth there. Boxes
+ *    that cross the near plane are always visible.
+ *
+ *    Occluders only ever make things disappear, so they should be solid
+ *    and closed, and should use the coarsest LOD that still fills their
+ *    silhouette (addGeometry() takes the coarsest LOD of a Mesh).
+ *
+ *    upload() copies the pyramid into a mipmapped R32F texture, so that
+ *    cull.comp can run the same test on the GPU.
+ */
+
+#ifndef OCCLUSION_HPP_
+#define OCCLUSION_HPP_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "./mesh.hpp"
+
+
+const int HIZ_WIDTH = 256;                  // Depth buffer size; multiples
+const int HIZ_HEIGHT = 192;                 // of 8 and of HIZ_BAND_ROWS
+const int HIZ_BAND_ROWS = 16;               // Rows per raster job
+const GLint HIZ_TEXTURE_UNIT = 3;           // Unit for cull.comp
+
+/**
+ * Software depth rasterizer and Hi-Z pyramid for occlusion tests.
+ */
+class OcclusionCuller {
+ public:
+  OcclusionCuller();
+  ~OcclusionCuller();
+
+  int addGeometry(Mesh& mesh);
+  int addOccluder(int geometry, const glm::mat4& transform);
+  void setTransform(int occluder, const glm::mat4& transform);
+
+  void render(const glm::mat4& viewProj);
+  bool testBox(const glm::vec3& lo, const glm::vec3& hi) const;
+  void filterBoxes(const float *minX, const float *minY, const float *minZ,
+                   const float *maxX, const float *maxY, const float *maxZ,
+                   std::vector<int>& indices);
+  void upload();
+
+  TexInfo& texture();
+  int numLevels() const;
+  int numOccluders();
+  int numTriangles();
+  int numOccluded();
+  double renderMillis();
+
+ private:
+  /**
+   * Positions and indices of one occluder mesh.
+   */
+  typedef struct {
+    std::vector<glm::vec3> positions;
+    std::vector<GLuint> indices;
+    glm::vec3 min, max;
+  } Geometry;
+
+  /**
+   * One triangle in depth buffer space, ready to rasterize.
+   */
+  typedef struct {
+    float x[3], y[3], z[3];
+    int rowMin, rowMax;
+  } ScreenTriangle;
+
+  std::vector<Geometry> geometries;
+  std::vector<int> occluderGeometry;
+  std::vector<glm::mat4> transforms;
+  std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+  std::vector<int> drawn;
+  std::vector<std::vector<ScreenTriangle> > triangles;
+
+  glm::mat4 viewProj;
+  std::vector<std::vector<float> > levels;  // [0] is the depth buffer
+  std::vector<int> levelWidth, levelHeight;
+  TexInfo hiZ;
+
+  int nTriangles, nOccluded;
+  double millis;
+  bool rendered;
+
+  void SetupOccluder(int occluder);
+  void RasterizeBand(int band);
+  void BuildPyramid();
+  void EmitTriangle(const glm::vec4 *clip, std::vector<ScreenTriangle>& out);
+};
+
+#endif /* OCCLUSION_HPP_ */
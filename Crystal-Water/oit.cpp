@@ -0,0 +1,250 @@
+/**
+ * oit.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <iostream>
+
+#include "./oit.hpp"
+#include "./glstate.hpp"
+
+using namespace std;
+
+static const GLfloat ACCUM_CLEAR[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+static const GLfloat REVEAL_CLEAR[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+
+/**
+ * Default Constructor. No targets until init().
+ */
+WeightedOIT::WeightedOIT()
+: width(0),
+  height(0),
+  fboID(0),
+  depthID(0),
+  emptyVAO(0),
+  depthChecked(false),
+  depthCopies(true) {
+  accumTex.present = false;
+  revealTex.present = false;
+}
+
+/**
+ * Default Destructor. Frees the render targets.
+ */
+WeightedOIT::~WeightedOIT() {
+  this->Release();
+}
+
+/**
+ * Creates (or recreates, for a new size) the accumulation and revealage
+ * targets and their depth buffer.
+ * @param width - framebuffer width in pixels
+ * @param height - framebuffer height in pixels
+ * @return true if the framebuffer is complete
+ */
+bool WeightedOIT::init(int width, int height) {
+  const GLenum targets[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+  GLenum depthFormat = DefaultDepthFormat();
+  GLenum depthAttachment = GL_DEPTH_ATTACHMENT;
+  GLenum status;
+
+  this->Release();
+  this->width = width;
+  this->height = height;
+
+  this->accumTex = CreateTarget(OIT_ACCUM_UNIT, GL_RGBA16F, width, height);
+  this->revealTex = CreateTarget(OIT_REVEAL_UNIT, GL_R16F, width, height);
+
+  // Same format as the default framebuffer, so the depth blit works.
+  glGenRenderbuffers(1, &depthID);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthID);
+  glRenderbufferStorage(GL_RENDERBUFFER, depthFormat, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  if (depthFormat == GL_DEPTH24_STENCIL8 ||
+      depthFormat == GL_DEPTH32F_STENCIL8)
+    depthAttachment = GL_DEPTH_STENCIL_ATTACHMENT;
+  this->depthChecked = false;
+  this->depthCopies = true;
+
+  glGenFramebuffers(1, &fboID);
+  glBindFramebuffer(GL_FRAMEBUFFER, fboID);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+      accumTex.texID, 0);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D,
+      revealTex.texID, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, depthAttachment,
+      GL_RENDERBUFFER, depthID);
+  glDrawBuffers(2, targets);
+
+  status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  // The composite triangle is made from gl_VertexID alone.
+  glGenVertexArrays(1, &emptyVAO);
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    cout << "Transparency framebuffer incomplete: 0x" << hex << status
+         << dec << "." << endl;
+    this->Release();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Starts the transparent pass: copies the opaque depth in, clears both
+ * targets and sets up their blending. Draw transparent surfaces with the
+ * TRANSPARENT shader variant until end().
+ */
+void WeightedOIT::begin() {
+  if (depthCopies) {
+    // Errors from before are not the blit's.
+    if (!depthChecked)
+      while (glGetError() != GL_NO_ERROR) {}
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fboID);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+        GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    // Checked once; a format mismatch would fail the same way every frame.
+    if (!depthChecked) {
+      GLenum error = glGetError();
+
+      this->depthChecked = true;
+      if (error != GL_NO_ERROR) {
+        cout << "Opaque depth cannot be copied for transparency (GL error 0x"
+             << hex << error << dec << "); transparent surfaces will not "
+             << "be hidden by opaque ones." << endl;
+        this->depthCopies = false;
+      }
+    }
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, fboID);
+  if (!depthCopies)
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+  glClearBufferfv(GL_COLOR, 0, ACCUM_CLEAR);
+  glClearBufferfv(GL_COLOR, 1, REVEAL_CLEAR);
+
+  glDepthMask(GL_FALSE);
+  glEnable(GL_BLEND);
+  glBlendFunci(0, GL_ONE, GL_ONE);
+  glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+}
+
+/**
+ * Ends the transparent pass and returns to the default framebuffer.
+ */
+void WeightedOIT::end() {
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDisable(GL_BLEND);
+  glDepthMask(GL_TRUE);
+}
+
+/**
+ * Blends the resolved transparent layer over the default framebuffer.
+ * @param compositeProg - program built from composite.vert/.frag, with the
+ *                        samplers accumTex and revealTex added in that order
+ */
+void WeightedOIT::composite(Program& compositeProg) {
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+
+  compositeProg.enable();
+  compositeProg.setTexture(0, accumTex);
+  compositeProg.setTexture(1, revealTex);
+  glState.bindVertexArray(emptyVAO);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glState.countDraw();
+  compositeProg.disable();
+
+  // Back to the blend state OpenGLInit() set up.
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDisable(GL_BLEND);
+  glEnable(GL_DEPTH_TEST);
+}
+
+/**
+ * Reports whether init() succeeded.
+ * @return true if the targets exist
+ */
+bool WeightedOIT::ready() {
+  return this->fboID != 0;
+}
+
+/**
+ * Frees every GL object.
+ */
+void WeightedOIT::Release() {
+  if (fboID)
+    glDeleteFramebuffers(1, &fboID);
+  if (depthID)
+    glDeleteRenderbuffers(1, &depthID);
+  if (emptyVAO)
+    glDeleteVertexArrays(1, &emptyVAO);
+  if (accumTex.present)
+    glDeleteTextures(1, &accumTex.texID);
+  if (revealTex.present)
+    glDeleteTextures(1, &revealTex.texID);
+
+  this->fboID = this->depthID = this->emptyVAO = 0;
+  this->accumTex.present = this->revealTex.present = false;
+}
+
+/**
+ * Finds the depth (and stencil) format of the default framebuffer, for a
+ * depth buffer that can be blitted from it.
+ * @return a renderbuffer internal format
+ */
+GLenum WeightedOIT::DefaultDepthFormat() {
+  GLint depthBits = 24, stencilBits = 0;
+  GLint type = GL_UNSIGNED_NORMALIZED;
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH,
+      GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE, &depthBits);
+  glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_STENCIL,
+      GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE, &stencilBits);
+  glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH,
+      GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &type);
+
+  if (type == GL_FLOAT)
+    return stencilBits ? GL_DEPTH32F_STENCIL8 : GL_DEPTH_COMPONENT32F;
+  if (stencilBits)
+    return GL_DEPTH24_STENCIL8;
+  if (depthBits >= 32)
+    return GL_DEPTH_COMPONENT32;
+  if (depthBits <= 16)
+    return GL_DEPTH_COMPONENT16;
+
+  return GL_DEPTH_COMPONENT24;
+}
+
+/**
+ * Allocates one floating-point color target.
+ */
+TexInfo WeightedOIT::CreateTarget(GLint unit, GLenum format, int width,
+                                  int height) {
+  TexInfo info;
+
+  glGenTextures(1, &info.texID);
+  glBindTexture(GL_TEXTURE_2D, info.texID);
+  glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  info.texUnit = unit;
+  info.texTarget = GL_TEXTURE_2D;
+  info.present = true;
+
+  return info;
+}
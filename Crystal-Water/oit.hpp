@@ -0,0 +1,80 @@
+/**
+ * oit.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  Weighted blended order-independent transparency: translucent surfaces
+ *  are drawn in any order, in one pass, at a cost that does not depend on
+ *  how they overlap.
+ *
+ *  Notes:
+ *
+ *    Opaque geometry is drawn first, as usual. Then, between begin() and
+ *    end(), the TRANSPARENT shader variant writes two render targets
+ *    instead of a color:
+ *
+ *          accumulation  RGBA16F  sum of (rgb * a, a) * weight
+ *          revealage     R16F     product of (1 - a)
+ *
+ *    Both are blended (additive for accumulation, multiplicative for
+ *    revealage), so draw order does not matter. The weight falls off with
+ *    depth, so nearer surfaces dominate the average.
+ *
+ *    The opaque depth buffer is copied into the targets' depth buffer so
+ *    that transparent fragments behind opaque ones are rejected, but depth
+ *    writes stay off. A depth blit needs both sides in the same depth and
+ *    stencil format, so the targets' depth buffer is made in whatever
+ *    format the default framebuffer turned out to have. The first copy is
+ *    checked; should it fail anyway, transparent surfaces are drawn
+ *    against a cleared depth buffer (in front of everything) rather than
+ *    whatever was left in it.
+ *
+ *    composite() then draws one fullscreen triangle that divides the
+ *    accumulated color by its total weight and blends it over the opaque
+ *    image by (1 - revealage). The shaders are shader0.frag (TRANSPARENT)
+ *    and composite.vert/composite.frag.
+ */
+
+#ifndef OIT_HPP_
+#define OIT_HPP_
+
+#include <GL/glew.h>
+
+#include "./mesh.hpp"
+#include "./program.hpp"
+
+
+const GLint OIT_ACCUM_UNIT = 1;             // Texture unit for composite()
+const GLint OIT_REVEAL_UNIT = 2;            // Texture unit for composite()
+
+/**
+ * Render targets and passes for weighted blended transparency.
+ */
+class WeightedOIT {
+ public:
+  WeightedOIT();
+  ~WeightedOIT();
+
+  bool init(int width, int height);
+  void begin();
+  void end();
+  void composite(Program& compositeProg);
+
+  bool ready();
+
+ private:
+  int width, height;
+  GLuint fboID, depthID, emptyVAO;
+  TexInfo accumTex, revealTex;
+  bool depthChecked, depthCopies;
+
+  void Release();
+  static GLenum DefaultDepthFormat();
+  static TexInfo CreateTarget(GLint unit, GLenum format, int width,
+                              int height);
+};
+
+#endif /* OIT_HPP_ */
@@ -0,0 +1,287 @@
+/**
+ * probe.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <algorithm>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "./probe.hpp"
+#include "./glstate.hpp"
+
+using namespace std;
+
+// Look and up directions of each face, in GL cube map order (+X, -X, +Y,
+// -Y, +Z, -Z), such that lookAt() matches the way faces are sampled.
+static const glm::vec3 FACE_DIRECTION[PROBE_FACES] = {
+  glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+  glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+  glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+};
+static const glm::vec3 FACE_UP[PROBE_FACES] = {
+  glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+  glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+  glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+};
+
+
+/**
+ * Default Constructor. No cube map until init().
+ */
+EnvironmentProbe::EnvironmentProbe()
+: size(0),
+  nLevels(0),
+  position(0.0f),
+  fboID(0),
+  depthID(0),
+  readID(0),
+  drawID(0),
+  nextFace(0),
+  currentFace(-1),
+  staleFaces(PROBE_FACES),
+  primed(false) {
+  cube.present = false;
+}
+
+/**
+ * Default Destructor. Frees the cube map and framebuffers.
+ */
+EnvironmentProbe::~EnvironmentProbe() {
+  this->Release();
+}
+
+/**
+ * Creates the mipmapped cube map, its depth buffer, and the framebuffers
+ * used to draw faces and filter mips.
+ * @param size - edge of each face in texels, a power of two
+ * @return true if the face framebuffer is complete
+ */
+bool EnvironmentProbe::init(int size) {
+  GLenum status;
+
+  this->Release();
+  this->size = size;
+  this->nLevels = 1;
+  while ((size >> nLevels) > 0)
+    this->nLevels++;
+
+  glGenTextures(1, &cube.texID);
+  glState.bindTexture(PROBE_TEXTURE_UNIT, GL_TEXTURE_CUBE_MAP, cube.texID);
+  glTexStorage2D(GL_TEXTURE_CUBE_MAP, nLevels, GL_RGBA8, size, size);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, nLevels - 1);
+  cube.texUnit = PROBE_TEXTURE_UNIT;
+  cube.texTarget = GL_TEXTURE_CUBE_MAP;
+  cube.present = true;
+
+  // Filter across face edges, so the seams of lower mips do not show.
+  glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+  glGenRenderbuffers(1, &depthID);
+  glBindRenderbuffer(GL_RENDERBUFFER, depthID);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &fboID);
+  glBindFramebuffer(GL_FRAMEBUFFER, fboID);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+      GL_TEXTURE_CUBE_MAP_POSITIVE_X, cube.texID, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+      GL_RENDERBUFFER, depthID);
+  status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  // Blit source and destination for the mip chain.
+  glGenFramebuffers(1, &readID);
+  glGenFramebuffers(1, &drawID);
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    cout << "Environment probe framebuffer incomplete: 0x" << hex << status
+         << dec << "." << endl;
+    this->Release();
+    return false;
+  }
+
+  this->nextFace = 0;
+  this->currentFace = -1;
+  this->staleFaces = PROBE_FACES;
+  this->primed = false;
+
+  return true;
+}
+
+/**
+ * Moves the probe. Every face is stale if it actually moved.
+ * @param position - probe center in scene space
+ */
+void EnvironmentProbe::setPosition(const glm::vec3& position) {
+  if (position == this->position)
+    return;
+
+  this->position = position;
+  this->invalidate();
+}
+
+/**
+ * Marks every face stale, as when something the probe sees has moved.
+ */
+void EnvironmentProbe::invalidate() {
+  this->staleFaces = PROBE_FACES;
+}
+
+/**
+ * Tells how many faces to draw this frame.
+ * @param perFrame - faces to refresh per frame once the cube is complete
+ * @return number of beginFace()/endFace() pairs to run
+ */
+int EnvironmentProbe::facesDue(int perFrame) {
+  if (!cube.present)
+    return 0;
+
+  return primed ? min(perFrame, PROBE_FACES) : PROBE_FACES;
+}
+
+/**
+ * Binds the next face, in round-robin order, as the render target and
+ * clears it. Draw it with faceView() and projection().
+ * @return the face index, 0 (+X) to 5 (-Z)
+ */
+int EnvironmentProbe::beginFace() {
+  this->currentFace = nextFace;
+  this->nextFace = (nextFace + 1) % PROBE_FACES;
+
+  glGetIntegerv(GL_VIEWPORT, savedViewport);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, fboID);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+      GL_TEXTURE_CUBE_MAP_POSITIVE_X + currentFace, cube.texID, 0);
+  glViewport(0, 0, size, size);
+  glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+
+  return currentFace;
+}
+
+/**
+ * Finishes the face begun last: rebuilds its mips and returns to the
+ * default framebuffer and the window's viewport.
+ */
+void EnvironmentProbe::endFace() {
+  if (currentFace < 0)
+    return;
+
+  this->FilterMips(currentFace);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(savedViewport[0], savedViewport[1], savedViewport[2],
+             savedViewport[3]);
+
+  if (staleFaces > 0)
+    this->staleFaces--;
+  if (currentFace == PROBE_FACES - 1)
+    this->primed = true;
+  this->currentFace = -1;
+}
+
+/**
+ * Builds the view matrix of one face.
+ * @param face - face index, 0 (+X) to 5 (-Z)
+ * @return scene space to face eye space
+ */
+glm::mat4 EnvironmentProbe::faceView(int face) const {
+  return glm::lookAt(position, position + FACE_DIRECTION[face],
+                     FACE_UP[face]);
+}
+
+/**
+ * Builds the projection shared by all faces: 90 degrees, square.
+ * @return projection matrix
+ */
+glm::mat4 EnvironmentProbe::projection() const {
+  return glm::perspective(90.0f, 1.0f, PROBE_NEAR, PROBE_FAR);
+}
+
+/**
+ * Packs the probe center and parallax radius for shader0.frag.
+ * @return center in scene space (xyz) and radius (w)
+ */
+glm::vec4 EnvironmentProbe::lookupSphere() const {
+  return glm::vec4(position, PROBE_PARALLAX_RADIUS);
+}
+
+/**
+ * Retrieves the cube map.
+ * @return texture info, bound under PROBE_TEXTURE_UNIT
+ */
+TexInfo& EnvironmentProbe::texture() {
+  return this->cube;
+}
+
+/**
+ * Retrieves the face size given to init().
+ * @return edge of a face in texels
+ */
+int EnvironmentProbe::getSize() {
+  return this->size;
+}
+
+/**
+ * Reports whether any face is older than the last invalidate().
+ * @return true if more faces need drawing
+ */
+bool EnvironmentProbe::stale() {
+  return this->staleFaces > 0;
+}
+
+/**
+ * Reports whether init() succeeded.
+ * @return true if the cube map exists
+ */
+bool EnvironmentProbe::ready() {
+  return this->cube.present;
+}
+
+/**
+ * Halves the face into each mip level in turn with a linear blit, which
+ * for an exact halving averages each 2x2 block.
+ */
+void EnvironmentProbe::FilterMips(int face) {
+  GLenum target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + face;
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, readID);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawID);
+  for (int l = 1; l < nLevels; l++) {
+    int src = max(size >> (l - 1), 1);
+    int dst = max(size >> l, 1);
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target,
+        cube.texID, l - 1);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target,
+        cube.texID, l);
+    glBlitFramebuffer(0, 0, src, src, 0, 0, dst, dst, GL_COLOR_BUFFER_BIT,
+        GL_LINEAR);
+  }
+}
+
+/**
+ * Frees every GL object.
+ */
+void EnvironmentProbe::Release() {
+  if (fboID)
+    glDeleteFramebuffers(1, &fboID);
+  if (readID)
+    glDeleteFramebuffers(1, &readID);
+  if (drawID)
+    glDeleteFramebuffers(1, &drawID);
+  if (depthID)
+    glDeleteRenderbuffers(1, &depthID);
+  if (cube.present)
+    glDeleteTextures(1, &cube.texID);
+
+  this->fboID = this->readID = this->drawID = this->depthID = 0;
+  this->cube.present = false;
+}
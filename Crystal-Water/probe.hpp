@@ -0,0 +1,95 @@
+/**
+ * probe.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  A dynamic environment probe: a cube map of the scene as seen from one
+ *  point, rendered a face or two at a time, for cheap rasterized
+ *  reflection and refraction.
+ *
+ *  Notes:
+ *
+ *    Every frame, for each face returned by beginFace():
+ *
+ *          beginFace()         // binds the next face as the render target
+ *          faceView(face)      // draw the scene with this and projection()
+ *          endFace()           // filters the face's mips, back to window
+ *
+ *    Faces are taken in round-robin order, so with two faces a frame the
+ *    whole cube is refreshed every three frames at a fixed cost. After each
+ *    face its mip chain is rebuilt by linear blits, level by level, for
+ *    that face alone: the other five keep the mips they already had, and
+ *    no glGenerateMipmap() touches all six.
+ *
+ *    facesDue() tells how many faces to draw this frame: all six the first
+ *    time, so the cube is never sampled half-empty, and the per-frame
+ *    count after that. invalidate() marks every face stale (the probe or
+ *    the scene around it moved); stale() stays true until each has been
+ *    drawn again, so an on-demand frame loop knows to keep going.
+ *
+ *    The faces follow the GL cube map conventions, so a direction in the
+ *    probe's space samples the face it points at. Shading looks up the
+ *    reflected and refracted view directions (shader0.frag, ENVIRONMENT),
+ *    corrected for parallax against a sphere of PROBE_PARALLAX_RADIUS
+ *    around the probe.
+ */
+
+#ifndef PROBE_HPP_
+#define PROBE_HPP_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "./mesh.hpp"
+
+
+const int PROBE_FACES = 6;
+const GLint PROBE_TEXTURE_UNIT = 4;         // Unit for shader0 envMap
+const float PROBE_NEAR = 0.5f;              // Face frustum near plane
+const float PROBE_FAR = 800.0f;             // Face frustum far plane
+const int PROBE_LOD = 1;                    // Detail level of every mesh
+const float PROBE_PARALLAX_RADIUS = 128.0f; // Proxy sphere for lookups
+
+/**
+ * Cube map render target refreshed a few faces per frame.
+ */
+class EnvironmentProbe {
+ public:
+  EnvironmentProbe();
+  ~EnvironmentProbe();
+
+  bool init(int size);
+  void setPosition(const glm::vec3& position);
+  void invalidate();
+
+  int facesDue(int perFrame);
+  int beginFace();
+  void endFace();
+
+  glm::mat4 faceView(int face) const;
+  glm::mat4 projection() const;
+  glm::vec4 lookupSphere() const;
+  TexInfo& texture();
+  int getSize();
+  bool stale();
+  bool ready();
+
+ private:
+  int size, nLevels;
+  glm::vec3 position;
+  GLuint fboID, depthID, readID, drawID;
+  TexInfo cube;
+
+  int nextFace, currentFace;
+  int staleFaces;
+  bool primed;
+  GLint savedViewport[4];
+
+  void FilterMips(int face);
+  void Release();
+};
+
+#endif /* PROBE_HPP_ */
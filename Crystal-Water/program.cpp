@@ -7,10 +7,23 @@
  *  Contributors: [none]
  */
 
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
 #include "./program.hpp"
+#include "./glstate.hpp"
 
 using namespace std;
 
+const char PROGRAM_CACHE_DIR[] = "shadercache";   // In the working directory
+const char PROGRAM_CACHE_MAGIC[4] = { 'C', 'W', 'P', 'B' };
+const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+const unsigned long long FNV_PRIME = 1099511628211ULL;
+
 
 /**
  * Default Constructor.
@@ -18,7 +31,10 @@ using namespace std;
 Program::Program()
 : programId(0),
   samplers(0),
-  stage(0) {
+  stage(0),
+  fromCache(false),
+  building(false),
+  reload(NULL) {
 }
 
 /**
@@ -27,6 +43,8 @@ Program::Program()
 Program::~Program() {
   if (samplers)
     delete samplers;
+  if (reload)
+    delete reload;
 }
 
 /**
@@ -55,6 +73,22 @@ int Program::addShader(string fName, int type) {
   return validFile;
 }
 
+/**
+ * Adds a preprocessor define to every shader of the program, inserted just
+ * after the #version line. Must be called before the program is submitted.
+ * @param name - macro name
+ * @param value - macro value, or empty for a plain #define
+ */
+void Program::addDefine(const string& name, const string& value) {
+  if (stage >= 3) {
+    cout << "Define " << name << " ignored: program already compiled."
+         << endl;
+    return;
+  }
+
+  this->defines.push_back(make_pair(name, value));
+}
+
 /**
  * Shortcut for adding one shader.vert and one shader.frag.
  */
@@ -75,16 +109,22 @@ void Program::addSampler(string sName) {
     this->samplers = new vector<SamplerInfo>();
 
   glGenSamplers(1, &sample);
+  glSamplerParameteri(sample, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glSamplerParameteri(sample, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  const UniformInfo *uniform = this->FindUniform(sName);
 
   info.samplerID = sample;
   info.samplerName = sName;
+  info.location = uniform ? uniform->location : -1;
+  info.unit = -1;
 
   this->samplers->push_back(info);
 }
 
 /**
- * Initializes the program. Then initializes, loads, compiles, and attaches
- * all shaders associated with the Program object.
+ * Initializes the program. Shaders are compiled and attached when the
+ * program is linked, and only if no cached binary can be used.
  */
 void Program::init() {
   int numShaders = this->shaders.size();
@@ -97,25 +137,6 @@ void Program::init() {
   // Init program.
   this->programId = glCreateProgram();
 
-  for (int i = 0; i < numShaders; i++) {
-    // Init shader
-    Shader& shad = this->shaders[i];
-    shad.setId(glCreateShader(shad.type()));
-
-    // Load shader sources.
-    const GLchar *shaderSource = shad.source().c_str();
-    glShaderSource(shad.id(), 1, &shaderSource, NULL);
-
-    // Compile shader from source.
-    glCompileShader(shad.id());
-
-    // Display any problems with shader compilation.
-    displayLogShader(shad.id());
-
-    // Attach compiled shader to program.
-    glAttachShader(this->programId, shad.id());
-  }
-
   this->stage = 2;
 }
 
@@ -138,6 +159,7 @@ void Program::bindAttribute(int location, string name) {
 
   // Bind explicit attribute locations before linking.
   glBindAttribLocation(this->programId, location, name.c_str());
+  this->attributes.push_back(make_pair(location, name));
 
   this->stage = 3;
 }
@@ -147,20 +169,82 @@ void Program::bindAttribute(int location, string name) {
  * Automatically validates the program and displays the info log if the
  * info log is not empty.
  *
+ * If the binary cache holds this program (same sources, attribute
+ * bindings, and driver), the binary is loaded instead and nothing is
+ * compiled. A binary the driver refuses is ignored and the program is
+ * built from source as usual, then written back to the cache.
+ *
  * Note: Some cards print only errors while some print a success statement.
  * @return GLEW_OK on success or an error code on failure.
  */
 GLint Program::linkAndValidate() {
+  this->submit();
+
+  return this->finish();
+}
+
+/**
+ * Starts building the program: loads the cached binary or issues the
+ * compiles and the link. Nothing is queried from GL, so the driver is free
+ * to build in the background until poll() or finish().
+ */
+void Program::submit() {
   if (stage < 2) {
     cout << "Invalid linking. Must init (and bind attributes) first." << endl;
-    return 0;
+    return;
   }
 
+  this->cacheKey = this->CacheKey();
+  this->fromCache = this->LoadBinary(cacheKey);
+  if (!fromCache) {
+    this->CompileShaders();
+
+    // Link the compiled and attached program to this code.
+    if (GLEW_ARB_get_program_binary)
+      glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(programId);
+    if (programId == GL_INVALID_VALUE)
+      exit(-1);
+  }
+
+  this->building = true;
+}
+
+/**
+ * Checks on a submitted build without waiting for it, if the driver can
+ * say (KHR_parallel_shader_compile). Otherwise behaves as finish().
+ * @return true once the build is finished, successful or not
+ */
+bool Program::poll() {
+  if (!building)
+    return stage >= 4;
+
+  if (GLEW_KHR_parallel_shader_compile) {
+    GLint done = GL_FALSE;
+    glGetProgramiv(programId, GL_COMPLETION_STATUS_KHR, &done);
+    if (!done)
+      return false;
+  }
+
+  this->finish();
+  return true;
+}
+
+/**
+ * Waits for a submitted build, then validates the program, prints any
+ * logs, lists its uniforms, and stores its binary in the cache.
+ * @return GLEW_OK on success or an error code on failure.
+ */
+GLint Program::finish() {
+  if (!building)
+    return stage == 5;
+
   GLint programValid;
-  // Link the compiled and attached program to this code.
-  glLinkProgram(programId);
-  if (programId == GL_INVALID_VALUE)
-    exit(-1);
+
+  if (!fromCache) {
+    for (int i = 0; i < shaders.size(); i++)
+      displayLogShader(shaders[i].id());
+  }
 
   // Verify program compilation and linkage.
   glValidateProgram(programId);
@@ -168,11 +252,83 @@ GLint Program::linkAndValidate() {
   if (!programValid)
     displayLogProgram();
 
+  this->building = false;
   this->stage = programValid ? 5 : 4;
+  if (programValid)
+    this->Introspect();
+  if (programValid && !fromCache)
+    this->SaveBinary(cacheKey);
 
   return programValid;
 }
 
+/**
+ * Hot reload. Checks the shader files for changes; if any changed, starts
+ * building a fresh copy of the program from them. Later calls poll that
+ * build and, once it is complete and valid, swap it in. A build that fails
+ * is dropped and the running program is kept. Call between frames.
+ * @return true if a rebuilt program was swapped in by this call
+ */
+bool Program::reloadIfChanged() {
+  if (!reload) {
+    bool changed = false;
+
+    if (stage < 5)
+      return false;
+    for (int i = 0; i < shaders.size(); i++)
+      changed = shaders[i].changedOnDisk() || changed;
+    if (!changed)
+      return false;
+
+    this->reload = new Program();
+    reload->defines = this->defines;
+    for (int i = 0; i < shaders.size(); i++)
+      reload->addShader(shaders[i].file(), shaders[i].type());
+    if (reload->shaders.size() != shaders.size()) {
+      delete reload;
+      this->reload = NULL;
+      return false;
+    }
+
+    reload->init();
+    for (int i = 0; i < attributes.size(); i++)
+      reload->bindAttribute(attributes[i].first, attributes[i].second);
+    reload->submit();
+
+    cout << "Shader source changed; rebuilding " << shaders[0].file()
+         << " in the background." << endl;
+    return false;
+  }
+
+  if (!reload->poll())
+    return false;
+
+  bool swapped = reload->stage == 5;
+  if (swapped) {
+    this->Adopt(*reload);
+    cout << "Reloaded " << shaders[0].file() << "." << endl;
+  } else {
+    cout << "Rebuild failed; keeping the running program." << endl;
+    for (int i = 0; i < reload->shaders.size(); i++)
+      glDeleteShader(reload->shaders[i].id());
+    glDeleteProgram(reload->programId);
+  }
+
+  delete reload;
+  this->reload = NULL;
+
+  return swapped;
+}
+
+/**
+ * Lets the driver compile shaders on as many threads as it likes, when it
+ * supports KHR_parallel_shader_compile. Call once after GLEW is ready.
+ */
+void Program::enableParallelCompile() {
+  if (GLEW_KHR_parallel_shader_compile)
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+}
+
 /**
  * A sequence-protected wrapper for glUseProgram().  This completely preempts
  * the OpenGL graphics pipeline for any shader functions implemented.
@@ -187,7 +343,7 @@ void Program::enable() {
     return;
   }
 
-  glUseProgram(this->programId);
+  glState.useProgram(this->programId);
 }
 
 /**
@@ -195,7 +351,7 @@ void Program::enable() {
  * operation.
  */
 void Program::disable() {
-  glUseProgram(0);
+  glState.useProgram(0);
 }
 
 /**
@@ -204,9 +360,11 @@ void Program::disable() {
  * @param name - string representation of the GLSL uniform name
  * @param n - uniform value
  */
-void Program::setUniform(int type, string name, float n) {
-  GLint loc = glGetUniformLocation(this->programId, name.c_str());
+void Program::setUniform(int type, const string& name, float n) {
+  const UniformInfo *info = this->FindUniform(name);
+  GLint loc = info ? info->location : -1;
 
+  glState.countUniform();
   if (type == GL_FLOAT) {
         glUniform1f(loc, n);
   } else if (type == GL_INT) {
@@ -221,9 +379,12 @@ void Program::setUniform(int type, string name, float n) {
  * @param name - string representation of the GLSL uniform name
  * @param n - pointer to the array of values
  */
-void Program::setUniformv(int count, int type, string name, const float *n) {
-  GLint loc = glGetUniformLocation(this->programId, name.c_str());
+void Program::setUniformv(int count, int type, const string& name,
+                          const float *n) {
+  const UniformInfo *info = this->FindUniform(name);
+  GLint loc = info ? info->location : -1;
 
+  glState.countUniform();
   if (type == GL_FLOAT) {
     switch (count) {
       case 1:
@@ -267,9 +428,11 @@ void Program::setUniformv(int count, int type, string name, const float *n) {
  * @param name - string representation of the GLSL uniform name
  * @param m - pointer to the first matrix value
  */
-void Program::setUniformMatrix(int size, string name, float *m) {
-  GLint loc = glGetUniformLocation(this->programId, name.c_str());
+void Program::setUniformMatrix(int size, const string& name, float *m) {
+  const UniformInfo *info = this->FindUniform(name);
+  GLint loc = info ? info->location : -1;
 
+  glState.countUniform();
   if (size == 4) {
     glUniformMatrix4fv(loc, 1, GL_FALSE, m);
   } else if (size == 3) {
@@ -278,7 +441,8 @@ void Program::setUniformMatrix(int size, string name, float *m) {
 }
 
 /**
- * Single call to bind a sampler2D uniform to an already generated texture.
+ * Single call to bind a sampler2D (or sampler2DArray) uniform to an already
+ * generated texture.
  * @param samplerIdx - index of desired SamplerInfo in added samplers
  * @param texInfo - TexInfo with stored texture ID and associated texture unit
  */
@@ -288,16 +452,114 @@ void Program::setTexture(int samplerIdx, TexInfo& texInfo) {
     return;
   }
 
+  SamplerInfo& sampler = (*this->samplers)[samplerIdx];
   GLint texUnit = texInfo.texUnit;
   GLuint texID = texInfo.texID;
-  GLint loc = glGetUniformLocation(this->programId,
-      (*this->samplers)[samplerIdx].samplerName.c_str());
 
-  glActiveTexture(GL_TEXTURE0 + texUnit);
-  glBindSampler(GL_TEXTURE0 + texUnit, (*this->samplers)[samplerIdx].samplerID);
+  glState.bindSampler(texUnit, sampler.samplerID);
+  glState.bindTexture(texUnit, texInfo.texTarget, texID);
+
+  // The unit is program state; only tell GL when it changes.
+  if (sampler.unit != texUnit) {
+    glState.countUniform();
+    glUniform1i(sampler.location, texUnit);
+    sampler.unit = texUnit;
+  }
+}
+
+/**
+ * Sets a float uniform through a handle from getUniform().
+ * @param u - resolved handle
+ * @param n - uniform value
+ */
+void Program::set(Uniform<float> u, float n) {
+  glState.countUniform();
+  glUniform1f(u.location, n);
+}
+
+/**
+ * Sets an int, bool, or sampler uniform through a handle.
+ * @param u - resolved handle
+ * @param n - uniform value
+ */
+void Program::set(Uniform<int> u, int n) {
+  glState.countUniform();
+  glUniform1i(u.location, n);
+}
+
+/**
+ * Sets a vec3 uniform through a handle.
+ * @param u - resolved handle
+ * @param v - uniform value
+ */
+void Program::set(Uniform<glm::vec3> u, const glm::vec3& v) {
+  glState.countUniform();
+  glUniform3fv(u.location, 1, &v[0]);
+}
+
+/**
+ * Sets a vec4 uniform through a handle.
+ * @param u - resolved handle
+ * @param v - uniform value
+ */
+void Program::set(Uniform<glm::vec4> u, const glm::vec4& v) {
+  glState.countUniform();
+  glUniform4fv(u.location, 1, &v[0]);
+}
+
+/**
+ * Sets a vec4 array uniform through a handle, starting at element 0.
+ * @param u - resolved handle
+ * @param v - pointer to count * 4 floats
+ * @param count - number of vec4s
+ */
+void Program::set(Uniform<glm::vec4> u, const float *v, int count) {
+  glState.countUniform();
+  glUniform4fv(u.location, count, v);
+}
+
+/**
+ * Sets a mat3 uniform through a handle.
+ * @param u - resolved handle
+ * @param m - uniform value
+ */
+void Program::set(Uniform<glm::mat3> u, const glm::mat3& m) {
+  glState.countUniform();
+  glUniformMatrix3fv(u.location, 1, GL_FALSE, &m[0][0]);
+}
+
+/**
+ * Sets a mat4 uniform through a handle.
+ * @param u - resolved handle
+ * @param m - uniform value
+ */
+void Program::set(Uniform<glm::mat4> u, const glm::mat4& m) {
+  glState.countUniform();
+  glUniformMatrix4fv(u.location, 1, GL_FALSE, &m[0][0]);
+}
+
+/**
+ * Points a uniform block at a buffer binding point. Block bindings are
+ * program state, so this is done once after linking, and is repeated
+ * automatically when the program is hot reloaded. Blocks the linker
+ * removed are silently skipped.
+ * @param name - GLSL block name
+ * @param binding - binding point given to glBindBufferBase()
+ */
+void Program::bindUniformBlock(const string& name, GLuint binding) {
+  GLuint block = glGetUniformBlockIndex(this->programId, name.c_str());
+
+  if (block != GL_INVALID_INDEX)
+    glUniformBlockBinding(this->programId, block, binding);
+  this->blocks.push_back(make_pair(name, binding));
+}
 
-  glBindTexture(GL_TEXTURE_2D, texID);
-  glUniform1i(loc, texUnit);
+/**
+ * Reports whether the last link came from the binary cache.
+ * @return true if no shaders were compiled
+ */
+bool Program::loadedFromCache() {
+  return this->fromCache;
 }
 
 /**
@@ -312,18 +574,18 @@ GLuint Program::getProgramId() {
  * Displays the info log for this program.
  */
 void Program::displayLogProgram() {
-  GLsizei logLength;
+  GLint logLength = 0;
   glGetProgramiv(this->programId, GL_INFO_LOG_LENGTH, &logLength);
 
-  GLsizei MAXLENGTH = 1 << 30;
-  GLchar *logBuffer = new GLchar[MAXLENGTH];
-  glGetProgramInfoLog(this->programId, MAXLENGTH, &logLength, logBuffer);
-  if (strlen(logBuffer)) {
-    cout << "************ Begin Program Log ************" << endl;
-    cout << logBuffer << endl;
-    cout << "************* End Program Log *************" << endl;
-  }
-  delete[] logBuffer;
+  // The length counts the terminator; an empty log is 0 or 1.
+  if (logLength <= 1)
+    return;
+
+  vector<GLchar> logBuffer(logLength);
+  glGetProgramInfoLog(this->programId, logLength, NULL, &logBuffer[0]);
+  cout << "************ Begin Program Log ************" << endl;
+  cout << &logBuffer[0] << endl;
+  cout << "************* End Program Log *************" << endl;
 }
 
 /**
@@ -331,16 +593,306 @@ void Program::displayLogProgram() {
  * @param shader - the shader to be evaluated
  */
 void Program::displayLogShader(GLenum shader) {
-  GLsizei logLength;
+  GLint logLength = 0;
   glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
 
-  GLsizei MAXLENGTH = 1 << 30;
-  GLchar *logBuffer = new GLchar[MAXLENGTH];
-  glGetShaderInfoLog(shader, MAXLENGTH, &logLength, logBuffer);
-  if (strlen(logBuffer)) {
-    cout << "************ Begin Shader Log ************" << endl;
-    cout << logBuffer << endl;
-    cout << "************* End Shader Log *************" << endl;
+  if (logLength <= 1)
+    return;
+
+  vector<GLchar> logBuffer(logLength);
+  glGetShaderInfoLog(shader, logLength, NULL, &logBuffer[0]);
+  cout << "************ Begin Shader Log ************" << endl;
+  cout << &logBuffer[0] << endl;
+  cout << "************* End Shader Log *************" << endl;
+}
+
+/**
+ * Lists every active uniform outside a block into the uniform table. Uses
+ * program interface queries where available, glGetActiveUniform() if not.
+ */
+void Program::Introspect() {
+  GLint count = 0;
+
+  this->uniforms.clear();
+
+  if (GLEW_ARB_program_interface_query) {
+    const GLenum props[4] = { GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE,
+                              GL_NAME_LENGTH };
+    GLint values[4];
+
+    glGetProgramInterfaceiv(programId, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    for (int i = 0; i < count; i++) {
+      glGetProgramResourceiv(programId, GL_UNIFORM, i, 4, props, 4, NULL, values);
+      if (values[0] < 0)
+        continue;   // Block member
+
+      vector<GLchar> name(values[3] + 1);
+      glGetProgramResourceName(programId, GL_UNIFORM, i, name.size(), NULL,
+          &name[0]);
+      this->AddUniform(&name[0], values[0], values[1], values[2]);
+    }
+  } else {
+    GLint maxLength = 0;
+
+    glGetProgramiv(programId, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(programId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    vector<GLchar> name(maxLength + 1);
+
+    for (int i = 0; i < count; i++) {
+      GLint size;
+      GLenum type;
+
+      glGetActiveUniform(programId, i, name.size(), NULL, &size, &type, &name[0]);
+      GLint loc = glGetUniformLocation(programId, &name[0]);
+      if (loc < 0)
+        continue;   // Block member
+
+      this->AddUniform(&name[0], loc, type, size);
+    }
+  }
+}
+
+/**
+ * Adds one uniform to the table. Arrays are listed as "name[0]" by GL; they
+ * are also entered under their bare name, and each element under its own
+ * "name[k]" (element locations are consecutive).
+ */
+void Program::AddUniform(const string& name, GLint location, GLenum type,
+                         GLint size) {
+  UniformInfo info = { location, type, size };
+  string::size_type len = name.size();
+
+  this->uniforms[name] = info;
+  if (len <= 3 || name.compare(len - 3, 3, "[0]") != 0)
+    return;
+
+  string base = name.substr(0, len - 3);
+  this->uniforms[base] = info;
+  for (int k = 1; k < size; k++) {
+    ostringstream element;
+    UniformInfo elementInfo = { location + k, type, size - k };
+
+    element << base << "[" << k << "]";
+    this->uniforms[element.str()] = elementInfo;
+  }
+}
+
+/**
+ * Looks a uniform up in the table built at link time.
+ * @return the uniform's info, or NULL if it is not active
+ */
+const UniformInfo *Program::FindUniform(const string& name) {
+  map<string, UniformInfo>::const_iterator it = uniforms.find(name);
+
+  return it == uniforms.end() ? NULL : &it->second;
+}
+
+/**
+ * Creates, compiles, and attaches every shader that has not been compiled
+ * yet.
+ */
+void Program::CompileShaders() {
+  for (int i = 0; i < shaders.size(); i++) {
+    Shader& shad = this->shaders[i];
+    if (shad.id())
+      continue;
+
+    // Init shader
+    shad.setId(glCreateShader(shad.type()));
+
+    // Load shader sources, with any defines.
+    string source = this->PreparedSource(shad);
+    const GLchar *shaderSource = source.c_str();
+    glShaderSource(shad.id(), 1, &shaderSource, NULL);
+
+    // Compile shader from source. Logs are read in finish(), so that
+    // nothing here waits on the compiler.
+    glCompileShader(shad.id());
+
+    // Attach compiled shader to program.
+    glAttachShader(this->programId, shad.id());
   }
-  delete[] logBuffer;
+}
+
+/**
+ * Takes over the GL program of a finished rebuild, deleting the current
+ * one. Block bindings and sampler locations are reapplied to it.
+ */
+void Program::Adopt(Program& built) {
+  for (int i = 0; i < shaders.size(); i++)
+    glDeleteShader(shaders[i].id());
+  glDeleteProgram(this->programId);
+
+  this->programId = built.programId;
+  this->shaders = built.shaders;
+  this->uniforms = built.uniforms;
+  this->fromCache = built.fromCache;
+  built.programId = 0;
+
+  for (int i = 0; i < blocks.size(); i++) {
+    GLuint block = glGetUniformBlockIndex(programId, blocks[i].first.c_str());
+    if (block != GL_INVALID_INDEX)
+      glUniformBlockBinding(programId, block, blocks[i].second);
+  }
+
+  for (int i = 0; samplers && i < samplers->size(); i++) {
+    SamplerInfo& sampler = (*samplers)[i];
+    const UniformInfo *uniform = this->FindUniform(sampler.samplerName);
+
+    sampler.location = uniform ? uniform->location : -1;
+    sampler.unit = -1;
+  }
+}
+
+/**
+ * Returns a shader's source with the program's defines inserted after its
+ * #version line (or at the top if it has none). A #line directive follows
+ * the defines so compile errors still report the file's own line numbers.
+ */
+string Program::PreparedSource(Shader& shad) {
+  if (defines.empty())
+    return shad.source();
+
+  string& source = shad.source();
+  string::size_type pos = 0;
+  ostringstream block;
+
+  if (source.compare(0, 8, "#version") == 0) {
+    pos = source.find('\n');
+    pos = (pos == string::npos) ? source.size() : pos + 1;
+  }
+
+  for (int i = 0; i < defines.size(); i++)
+    block << "#define " << defines[i].first << " " << defines[i].second << "\n";
+  if (pos)
+    block << "#line 2\n";
+
+  return source.substr(0, pos) + block.str() + source.substr(pos);
+}
+
+/**
+ * Builds the binary cache key: a 64-bit FNV-1a hash, in hex, of every
+ * shader's type and source (defines included), the attribute bindings,
+ * and the GL vendor, renderer, and version strings. A driver update
+ * changes the key, so old binaries are simply never looked up again.
+ */
+string Program::CacheKey() {
+  const GLenum driverStrings[3] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+  unsigned long long hash = FNV_OFFSET;
+  ostringstream key;
+
+  for (int i = 0; i < shaders.size(); i++) {
+    GLuint type = shaders[i].type();
+    string source = this->PreparedSource(shaders[i]);
+    hash = HashBytes(hash, &type, sizeof(type));
+    hash = HashBytes(hash, source.data(), source.size());
+  }
+  for (int i = 0; i < attributes.size(); i++) {
+    hash = HashBytes(hash, &attributes[i].first, sizeof(int));
+    hash = HashBytes(hash, attributes[i].second.data(),
+                     attributes[i].second.size());
+  }
+  for (int i = 0; i < 3; i++) {
+    const GLubyte *str = glGetString(driverStrings[i]);
+    if (str)
+      hash = HashBytes(hash, str, strlen(reinterpret_cast<const char *>(str)));
+  }
+
+  key << hex << setw(16) << setfill('0') << hash;
+  return key.str();
+}
+
+/**
+ * Tries to load this program from the binary cache.
+ * @param key - from CacheKey()
+ * @return true if the driver accepted the cached binary
+ */
+bool Program::LoadBinary(const string& key) {
+  GLint numFormats = 0;
+
+  if (!GLEW_ARB_get_program_binary)
+    return false;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+  if (!numFormats)
+    return false;
+
+  string path = string(PROGRAM_CACHE_DIR) + "/" + key + ".bin";
+  ifstream file(path.c_str(), ios::in | ios::binary);
+  if (!file.is_open())
+    return false;
+
+  char magic[4];
+  GLenum format;
+  GLint length;
+  file.read(magic, 4);
+  file.read(reinterpret_cast<char *>(&format), sizeof(format));
+  file.read(reinterpret_cast<char *>(&length), sizeof(length));
+  if (!file || memcmp(magic, PROGRAM_CACHE_MAGIC, 4) || length <= 0)
+    return false;
+
+  vector<char> binary(length);
+  file.read(&binary[0], length);
+  if (!file)
+    return false;
+
+  GLint linked = GL_FALSE;
+  glProgramBinary(programId, format, &binary[0], length);
+  glGetProgramiv(programId, GL_LINK_STATUS, &linked);
+  if (!linked)
+    cout << "Cached program binary rejected; compiling from source." << endl;
+
+  return linked == GL_TRUE;
+}
+
+/**
+ * Writes this program's binary to the cache. The file is written under a
+ * temporary name and renamed into place, so a crash never leaves a torn
+ * binary behind.
+ * @param key - from CacheKey()
+ */
+void Program::SaveBinary(const string& key) {
+  GLint length = 0;
+  GLenum format;
+
+  if (!GLEW_ARB_get_program_binary)
+    return;
+  glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  vector<char> binary(length);
+  glGetProgramBinary(programId, length, NULL, &format, &binary[0]);
+
+  mkdir(PROGRAM_CACHE_DIR, 0755);
+  string path = string(PROGRAM_CACHE_DIR) + "/" + key + ".bin";
+  string temp = path + ".tmp";
+  ofstream file(temp.c_str(), ios::out | ios::binary | ios::trunc);
+  if (!file.is_open())
+    return;
+
+  file.write(PROGRAM_CACHE_MAGIC, 4);
+  file.write(reinterpret_cast<const char *>(&format), sizeof(format));
+  file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+  file.write(&binary[0], length);
+  file.close();
+
+  if (file)
+    rename(temp.c_str(), path.c_str());
+  else
+    remove(temp.c_str());
+}
+
+/**
+ * One step of 64-bit FNV-1a over a run of bytes.
+ */
+unsigned long long Program::HashBytes(unsigned long long hash,
+                                      const void *data, size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
 }
@@ -21,9 +21,11 @@
  *    called out of order.  The correct order is:
  *
  *          addShader()         // as many as you need
+ *          [addDefine()]       // only if you wish, for variants
  *          init()              // called once
  *          [bindAttribute()]   // only if you wish, for VAO/VBOs
- *          linkAndValidate()   // must be run before using program
+ *          linkAndValidate()   // compiles, links; must be run before use
+ *                              // (or submit() now and finish() later)
  *          addSampler()        // called after program is linked for safety
  *          enable()            // to actually use
  *          disable()           // when you're done
@@ -32,6 +34,30 @@
  *    setTexure() by remembering the order in which you added them with
  *    addSampler().
  *
+ *    linkAndValidate() is submit() followed by finish(). To build several
+ *    programs at once, submit() them all first and only then finish() or
+ *    poll() them: no status is queried until then, so drivers with
+ *    KHR_parallel_shader_compile (see enableParallelCompile()) compile
+ *    them side by side. poll() never blocks on such drivers.
+ *
+ *    reloadIfChanged() watches the shader files. When one changes, a copy
+ *    of the program is built in the background with later calls polling
+ *    it; the running program is only replaced, in a single step, once the
+ *    copy has linked and validated. Its uniform table, block bindings, and
+ *    samplers carry over; typed handles must be fetched again.
+ *
+ *    Linked programs are kept as driver binaries in shadercache/ under
+ *    the working directory (where the shader sources are read from too),
+ *    keyed on a hash of the sources, attribute bindings, and driver strings.
+ *    When a matching binary is found, linkAndValidate() loads it and no
+ *    shader is compiled. Deleting the directory is always safe.
+ *
+ *    Every active uniform is listed once, at link time, into a name-to-
+ *    location table. For anything set every frame, ask for a typed handle
+ *    with getUniform<T>() after linking and pass it to set(). That path
+ *    does no string work and no driver lookups. The string setters still
+ *    work, but look names up in the table rather than asking GL.
+ *
  *  This is a work in progress and will be continually improved as I use it.
  *
  *  Feel free to share, expand, and modify as you see fit with attribution
@@ -44,9 +70,12 @@
 #define PROGRAM_HPP_
 
 #include <GL/glew.h>
+#include <glm/glm.hpp>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <map>
+#include <string>
 #include <vector>
 
 #include "./shaderobj.hpp"
@@ -59,8 +88,61 @@
 typedef struct {
   GLuint samplerID;         /**< Generated sampler ID */
   std::string samplerName;  /**< Uniform name as string */
+  GLint location;           /**< Uniform location, or -1 */
+  GLint unit;               /**< Texture unit last assigned, or -1 */
 } SamplerInfo;
 
+/**
+ * One active uniform, as found by introspection after linking.
+ */
+typedef struct {
+  GLint location;           /**< Uniform location */
+  GLenum type;              /**< GLSL type, e.g. GL_FLOAT_MAT4 */
+  GLint size;               /**< Array length, 1 if not an array */
+} UniformInfo;
+
+
+/**
+ * GLSL types a C++ type may be written to. Samplers take texture units
+ * as ints.
+ */
+template <typename T> struct UniformTraits;
+
+template <> struct UniformTraits<float> {
+  static bool accepts(GLenum t) { return t == GL_FLOAT; }
+};
+template <> struct UniformTraits<int> {
+  static bool accepts(GLenum t) {
+    return t == GL_INT || t == GL_BOOL || t == GL_SAMPLER_2D ||
+           t == GL_SAMPLER_2D_ARRAY || t == GL_SAMPLER_CUBE;
+  }
+};
+template <> struct UniformTraits<glm::vec3> {
+  static bool accepts(GLenum t) { return t == GL_FLOAT_VEC3; }
+};
+template <> struct UniformTraits<glm::vec4> {
+  static bool accepts(GLenum t) { return t == GL_FLOAT_VEC4; }
+};
+template <> struct UniformTraits<glm::mat3> {
+  static bool accepts(GLenum t) { return t == GL_FLOAT_MAT3; }
+};
+template <> struct UniformTraits<glm::mat4> {
+  static bool accepts(GLenum t) { return t == GL_FLOAT_MAT4; }
+};
+
+/**
+ * A uniform location resolved once, typed by the value it takes. A default
+ * handle is invalid and setting it does nothing, like location -1 in GL.
+ */
+template <typename T>
+struct Uniform {
+  GLint location;
+
+  Uniform() : location(-1) {}
+  explicit Uniform(GLint loc) : location(loc) {}
+  bool valid() const { return location >= 0; }
+};
+
 
 /**
  * Class representing an OpenGL shader program. Simplifies the initialization
@@ -74,19 +156,37 @@ class Program {
   int addShader(std::string fName, int type);
   void addDefaultShaders();
   void addSampler(std::string sName);
+  void addDefine(const std::string& name, const std::string& value = "");
 
   void init();
   void bindAttribute(int location, std::string name);
   GLint linkAndValidate();
+  void submit();
+  bool poll();
+  GLint finish();
+  bool reloadIfChanged();
+  static void enableParallelCompile();
   void enable();
   void disable();
 
-  void setUniform(int type, std::string name, float n);
-  void setUniformv(int count, int type, std::string name, const float *n);
-  void setUniformMatrix(int size, std::string name, float *m);
+  void setUniform(int type, const std::string& name, float n);
+  void setUniformv(int count, int type, const std::string& name,
+                   const float *n);
+  void setUniformMatrix(int size, const std::string& name, float *m);
   void setTexture(int samplerIdx, TexInfo& texInfo);
 
+  template <typename T> Uniform<T> getUniform(const std::string& name);
+  void set(Uniform<float> u, float n);
+  void set(Uniform<int> u, int n);
+  void set(Uniform<glm::vec3> u, const glm::vec3& v);
+  void set(Uniform<glm::vec4> u, const glm::vec4& v);
+  void set(Uniform<glm::vec4> u, const float *v, int count);
+  void set(Uniform<glm::mat3> u, const glm::mat3& m);
+  void set(Uniform<glm::mat4> u, const glm::mat4& m);
+  void bindUniformBlock(const std::string& name, GLuint binding);
+
   GLuint getProgramId();
+  bool loadedFromCache();
 
   void displayLogProgram();
   void displayLogShader(GLenum shader);
@@ -95,7 +195,52 @@ class Program {
   GLuint programId;
   std::vector<Shader> shaders;
   std::vector<SamplerInfo> *samplers;
+  std::map<std::string, UniformInfo> uniforms;
+  std::vector<std::pair<int, std::string> > attributes;
+  std::vector<std::pair<std::string, GLuint> > blocks;
+  std::vector<std::pair<std::string, std::string> > defines;
   int stage;
+  bool fromCache, building;
+  std::string cacheKey;
+  Program *reload;
+
+  void CompileShaders();
+  std::string PreparedSource(Shader& shad);
+  void Adopt(Program& built);
+  std::string CacheKey();
+  bool LoadBinary(const std::string& key);
+  void SaveBinary(const std::string& key);
+  static unsigned long long HashBytes(unsigned long long hash,
+                                      const void *data, size_t size);
+  void Introspect();
+  void AddUniform(const std::string& name, GLint location, GLenum type,
+                  GLint size);
+  const UniformInfo *FindUniform(const std::string& name);
 };
 
+
+/**
+ * Resolves a uniform to a typed handle. Call after linking, once, and keep
+ * the handle. Prints a warning and returns an invalid handle if the
+ * uniform is not active or its GLSL type does not match T.
+ * @param name - GLSL uniform name; arrays may omit the "[0]"
+ * @return the typed handle
+ */
+template <typename T>
+Uniform<T> Program::getUniform(const std::string& name) {
+  const UniformInfo *info = this->FindUniform(name);
+
+  if (!info) {
+    std::cout << "Uniform " << name << " is not active in program." << std::endl;
+    return Uniform<T>();
+  }
+  if (!UniformTraits<T>::accepts(info->type)) {
+    std::cout << "Uniform " << name << " does not match requested type."
+              << std::endl;
+    return Uniform<T>();
+  }
+
+  return Uniform<T>(info->location);
+}
+
 #endif /* PROGRAM_HPP_ */
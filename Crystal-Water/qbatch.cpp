@@ -0,0 +1,340 @@
+/**
+ * qbatch.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QBATCH_SIMD
+#include <immintrin.h>
+#endif
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "./qbatch.hpp"
+
+using namespace std;
+
+/**
+ * Quaternions by component: one of each (step 0) or one per vector.
+ */
+typedef struct {
+  const float *w, *x, *y, *z;
+  size_t step;
+} QuatStream;
+
+/**
+ * Vectors in and out by component.
+ */
+typedef struct {
+  const float *x, *y, *z;
+  float *outX, *outY, *outZ;
+} Vec3Stream;
+
+/**
+ * Rotates a leading run of the vectors, a whole number of lanes, and
+ * returns how many it did.
+ */
+typedef size_t (*RotateFunction)(const QuatStream& q, const Vec3Stream& v,
+                                 size_t n);
+
+
+/**
+ * Rotates vectors [begin, end) one at a time, as Quaternion::rotate()
+ * does. Every component is read before any is written, so the output may
+ * be the input.
+ */
+static void RotateScalar(const QuatStream& q, const Vec3Stream& v,
+                         size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    size_t k = i * q.step;
+    float qw = q.w[k], qx = q.x[k], qy = q.y[k], qz = q.z[k];
+    float vx = v.x[i], vy = v.y[i], vz = v.z[i];
+    float tx = 2.0f * (qy * vz - qz * vy);
+    float ty = 2.0f * (qz * vx - qx * vz);
+    float tz = 2.0f * (qx * vy - qy * vx);
+
+    v.outX[i] = vx + qw * tx + (qy * tz - qz * ty);
+    v.outY[i] = vy + qw * ty + (qz * tx - qx * tz);
+    v.outZ[i] = vz + qw * tz + (qx * ty - qy * tx);
+  }
+}
+
+/**
+ * No lanes: leaves every vector to RotateScalar().
+ */
+static size_t RotateNone(const QuatStream& q, const Vec3Stream& v,
+                         size_t n) {
+  return 0;
+}
+
+#ifdef QBATCH_SIMD
+/**
+ * Four vectors at a time.
+ */
+__attribute__((target("sse")))
+static size_t RotateSSE(const QuatStream& q, const Vec3Stream& v,
+                        size_t n) {
+  const __m128 two = _mm_set1_ps(2.0f);
+  __m128 qw = _mm_set1_ps(q.w[0]);
+  __m128 qx = _mm_set1_ps(q.x[0]);
+  __m128 qy = _mm_set1_ps(q.y[0]);
+  __m128 qz = _mm_set1_ps(q.z[0]);
+  size_t i;
+
+  for (i = 0; i + 4 <= n; i += 4) {
+    if (q.step) {
+      qw = _mm_loadu_ps(q.w + i);
+      qx = _mm_loadu_ps(q.x + i);
+      qy = _mm_loadu_ps(q.y + i);
+      qz = _mm_loadu_ps(q.z + i);
+    }
+
+    __m128 vx = _mm_loadu_ps(v.x + i);
+    __m128 vy = _mm_loadu_ps(v.y + i);
+    __m128 vz = _mm_loadu_ps(v.z + i);
+    __m128 tx = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qy, vz),
+                                           _mm_mul_ps(qz, vy)));
+    __m128 ty = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qz, vx),
+                                           _mm_mul_ps(qx, vz)));
+    __m128 tz = _mm_mul_ps(two, _mm_sub_ps(_mm_mul_ps(qx, vy),
+                                           _mm_mul_ps(qy, vx)));
+
+    _mm_storeu_ps(v.outX + i, _mm_add_ps(_mm_add_ps(vx, _mm_mul_ps(qw, tx)),
+        _mm_sub_ps(_mm_mul_ps(qy, tz), _mm_mul_ps(qz, ty))));
+    _mm_storeu_ps(v.outY + i, _mm_add_ps(_mm_add_ps(vy, _mm_mul_ps(qw, ty)),
+        _mm_sub_ps(_mm_mul_ps(qz, tx), _mm_mul_ps(qx, tz))));
+    _mm_storeu_ps(v.outZ + i, _mm_add_ps(_mm_add_ps(vz, _mm_mul_ps(qw, tz)),
+        _mm_sub_ps(_mm_mul_ps(qx, ty), _mm_mul_ps(qy, tx))));
+  }
+
+  return i;
+}
+
+/**
+ * Eight vectors at a time, with fused multiply-adds.
+ */
+__attribute__((target("avx2,fma")))
+static size_t RotateAVX2(const QuatStream& q, const Vec3Stream& v,
+                         size_t n) {
+  const __m256 two = _mm256_set1_ps(2.0f);
+  __m256 qw = _mm256_set1_ps(q.w[0]);
+  __m256 qx = _mm256_set1_ps(q.x[0]);
+  __m256 qy = _mm256_set1_ps(q.y[0]);
+  __m256 qz = _mm256_set1_ps(q.z[0]);
+  size_t i;
+
+  for (i = 0; i + 8 <= n; i += 8) {
+    if (q.step) {
+      qw = _mm256_loadu_ps(q.w + i);
+      qx = _mm256_loadu_ps(q.x + i);
+      qy = _mm256_loadu_ps(q.y + i);
+      qz = _mm256_loadu_ps(q.z + i);
+    }
+
+    __m256 vx = _mm256_loadu_ps(v.x + i);
+    __m256 vy = _mm256_loadu_ps(v.y + i);
+    __m256 vz = _mm256_loadu_ps(v.z + i);
+    __m256 tx = _mm256_mul_ps(two, _mm256_fmsub_ps(qy, vz,
+                                                   _mm256_mul_ps(qz, vy)));
+    __m256 ty = _mm256_mul_ps(two, _mm256_fmsub_ps(qz, vx,
+                                                   _mm256_mul_ps(qx, vz)));
+    __m256 tz = _mm256_mul_ps(two, _mm256_fmsub_ps(qx, vy,
+                                                   _mm256_mul_ps(qy, vx)));
+
+    _mm256_storeu_ps(v.outX + i, _mm256_add_ps(_mm256_fmadd_ps(qw, tx, vx),
+        _mm256_fmsub_ps(qy, tz, _mm256_mul_ps(qz, ty))));
+    _mm256_storeu_ps(v.outY + i, _mm256_add_ps(_mm256_fmadd_ps(qw, ty, vy),
+        _mm256_fmsub_ps(qz, tx, _mm256_mul_ps(qx, tz))));
+    _mm256_storeu_ps(v.outZ + i, _mm256_add_ps(_mm256_fmadd_ps(qw, tz, vz),
+        _mm256_fmsub_ps(qx, ty, _mm256_mul_ps(qy, tx))));
+  }
+
+  return i;
+}
+
+/**
+ * Sixteen vectors at a time, with fused multiply-adds.
+ */
+__attribute__((target("avx512f")))
+static size_t RotateAVX512(const QuatStream& q, const Vec3Stream& v,
+                           size_t n) {
+  const __m512 two = _mm512_set1_ps(2.0f);
+  __m512 qw = _mm512_set1_ps(q.w[0]);
+  __m512 qx = _mm512_set1_ps(q.x[0]);
+  __m512 qy = _mm512_set1_ps(q.y[0]);
+  __m512 qz = _mm512_set1_ps(q.z[0]);
+  size_t i;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+    if (q.step) {
+      qw = _mm512_loadu_ps(q.w + i);
+      qx = _mm512_loadu_ps(q.x + i);
+      qy = _mm512_loadu_ps(q.y + i);
+      qz = _mm512_loadu_ps(q.z + i);
+    }
+
+    __m512 vx = _mm512_loadu_ps(v.x + i);
+    __m512 vy = _mm512_loadu_ps(v.y + i);
+    __m512 vz = _mm512_loadu_ps(v.z + i);
+    __m512 tx = _mm512_mul_ps(two, _mm512_fmsub_ps(qy, vz,
+                                                   _mm512_mul_ps(qz, vy)));
+    __m512 ty = _mm512_mul_ps(two, _mm512_fmsub_ps(qz, vx,
+                                                   _mm512_mul_ps(qx, vz)));
+    __m512 tz = _mm512_mul_ps(two, _mm512_fmsub_ps(qx, vy,
+                                                   _mm512_mul_ps(qy, vx)));
+
+    _mm512_storeu_ps(v.outX + i, _mm512_add_ps(_mm512_fmadd_ps(qw, tx, vx),
+        _mm512_fmsub_ps(qy, tz, _mm512_mul_ps(qz, ty))));
+    _mm512_storeu_ps(v.outY + i, _mm512_add_ps(_mm512_fmadd_ps(qw, ty, vy),
+        _mm512_fmsub_ps(qz, tx, _mm512_mul_ps(qx, tz))));
+    _mm512_storeu_ps(v.outZ + i, _mm512_add_ps(_mm512_fmadd_ps(qw, tz, vz),
+        _mm512_fmsub_ps(qx, ty, _mm512_mul_ps(qy, tx))));
+  }
+
+  return i;
+}
+#endif
+
+// Every kernel, widest first; the names are those RotateBatchISA() gives.
+static const char *const ISA_NAMES[] = { "avx512", "avx2", "sse", "scalar" };
+static const int NUM_ISAS = 4;
+
+static const char *rotateISA = "scalar";
+
+/**
+ * Finds the kernel for an instruction set, if it was compiled in and the
+ * CPU supports it.
+ * @return the kernel, or NULL
+ */
+static RotateFunction FindRotate(const string& isa) {
+#ifdef QBATCH_SIMD
+  __builtin_cpu_init();
+  if (isa == "avx512" && __builtin_cpu_supports("avx512f"))
+    return RotateAVX512;
+  if (isa == "avx2" && __builtin_cpu_supports("avx2") &&
+      __builtin_cpu_supports("fma"))
+    return RotateAVX2;
+  if (isa == "sse" && __builtin_cpu_supports("sse"))
+    return RotateSSE;
+#endif
+  if (isa == "scalar")
+    return RotateNone;
+  return NULL;
+}
+
+/**
+ * Picks the instruction set named by QBATCH_ISA, if set and usable, or
+ * else the widest the CPU supports.
+ */
+static RotateFunction PickRotate() {
+  const char *forced = getenv("QBATCH_ISA");
+  RotateFunction fn;
+
+  for (int i = 0; forced && i < NUM_ISAS; i++) {
+    if (forced == string(ISA_NAMES[i]) && (fn = FindRotate(forced))) {
+      rotateISA = ISA_NAMES[i];
+      return fn;
+    }
+  }
+  if (forced)
+    cout << "QBATCH_ISA=" << forced << " is not available here." << endl;
+
+  for (int i = 0; i < NUM_ISAS; i++) {
+    if ((fn = FindRotate(ISA_NAMES[i]))) {
+      rotateISA = ISA_NAMES[i];
+      return fn;
+    }
+  }
+  return RotateNone;
+}
+
+static const RotateFunction pickedLanes = PickRotate();
+static const char *const pickedISA = rotateISA;
+static RotateFunction rotateLanes = pickedLanes;
+
+
+/**
+ * Rotates n vectors by one quaternion.
+ * @param q - the rotation, unit length
+ * @param x - x components of the vectors
+ * @param y - y components
+ * @param z - z components
+ * @param outX - x components of the rotated vectors; may be x
+ * @param outY - y components of the rotated vectors; may be y
+ * @param outZ - z components of the rotated vectors; may be z
+ * @param n - number of vectors
+ */
+void RotateBatch(const Quaternion& q, const float *x, const float *y,
+                 const float *z, float *outX, float *outY, float *outZ,
+                 size_t n) {
+  float w = q.w(), qx = q.x(), qy = q.y(), qz = q.z();
+  QuatStream qs = { &w, &qx, &qy, &qz, 0 };
+  Vec3Stream vs = { x, y, z, outX, outY, outZ };
+
+  RotateScalar(qs, vs, rotateLanes(qs, vs, n), n);
+}
+
+/**
+ * Rotates each of n vectors by its own quaternion.
+ * @param qw - w components of the rotations, unit length
+ * @param qx - x components of the rotations
+ * @param qy - y components of the rotations
+ * @param qz - z components of the rotations
+ * @param x - x components of the vectors
+ * @param y - y components
+ * @param z - z components
+ * @param outX - x components of the rotated vectors; may be x
+ * @param outY - y components of the rotated vectors; may be y
+ * @param outZ - z components of the rotated vectors; may be z
+ * @param n - number of vectors and of quaternions
+ */
+void RotateBatch(const float *qw, const float *qx, const float *qy,
+                 const float *qz, const float *x, const float *y,
+                 const float *z, float *outX, float *outY, float *outZ,
+                 size_t n) {
+  QuatStream qs = { qw, qx, qy, qz, 1 };
+  Vec3Stream vs = { x, y, z, outX, outY, outZ };
+
+  RotateScalar(qs, vs, rotateLanes(qs, vs, n), n);
+}
+
+/**
+ * Names the instruction set RotateBatch() runs on.
+ * @return "avx512", "avx2", "sse" or "scalar"
+ */
+const char* RotateBatchISA() {
+  return rotateISA;
+}
+
+/**
+ * Makes RotateBatch() run on the given instruction set, so each kernel
+ * can be tested on a CPU that would pick a wider one. Not safe while
+ * another thread is in RotateBatch().
+ * @param isa - "avx512", "avx2", "sse" or "scalar"; NULL to go back to
+ *              the choice made at startup (QBATCH_ISA, or the widest)
+ * @return false if that kernel was not compiled in or the CPU lacks it
+ */
+bool RotateBatchForceISA(const char *isa) {
+  RotateFunction fn;
+
+  if (!isa) {
+    rotateLanes = pickedLanes;
+    rotateISA = pickedISA;
+    return true;
+  }
+
+  for (int i = 0; i < NUM_ISAS; i++) {
+    if (isa == string(ISA_NAMES[i]) && (fn = FindRotate(isa))) {
+      rotateLanes = fn;
+      rotateISA = ISA_NAMES[i];
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,52 @@
+/**
+ * qbatch.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  Quaternion rotation of whole arrays of vectors at once, for the places
+ *  where Quaternion::rotate() one vector at a time is too slow: instance
+ *  orientations, normals, anything counted in the hundreds of thousands.
+ *
+ *  Notes:
+ *
+ *    Vectors are passed as structure-of-arrays, one array per component,
+ *    so each SIMD lane holds one vector and no shuffles are needed. Output
+ *    arrays may be the input arrays. Quaternions are either one for the
+ *    whole batch or one per vector, also split by component; both must be
+ *    unit length, as Quaternion keeps them.
+ *
+ *    Each vector is rotated with the same expansion Quaternion::rotate()
+ *    uses, v' = v + w t + u x t with t = 2 (u x v) and q = [w | u]: two
+ *    cross products, no quaternion products. The loop is compiled for
+ *    AVX-512 (16 lanes), AVX2/FMA (8), SSE (4) and plain C++, and the
+ *    widest the CPU supports is chosen at run time. The lanes that are
+ *    left over go through the scalar loop. Results match rotate() to
+ *    float rounding; FMA contracts a few products, nothing more.
+ *
+ *    The environment variable QBATCH_ISA (avx512, avx2, sse or scalar)
+ *    overrides the choice at startup, and RotateBatchForceISA() at any
+ *    time, so every kernel can be checked on one machine.
+ */
+
+#ifndef QBATCH_HPP_
+#define QBATCH_HPP_
+
+#include <cstddef>
+
+#include "./quaternion.hpp"
+
+
+void RotateBatch(const Quaternion& q, const float *x, const float *y,
+                 const float *z, float *outX, float *outY, float *outZ,
+                 size_t n);
+void RotateBatch(const float *qw, const float *qx, const float *qy,
+                 const float *qz, const float *x, const float *y,
+                 const float *z, float *outX, float *outY, float *outZ,
+                 size_t n);
+const char* RotateBatchISA();
+bool RotateBatchForceISA(const char *isa);
+
+#endif /* QBATCH_HPP_ */
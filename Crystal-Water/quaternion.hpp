@@ -28,18 +28,31 @@
  *
  *  There was an interesting challenge with return types. For instance, the
  *  matrix representation of the quaternion is expected in OpenGL as a float
- *  array. To return an array, I'd have to allocate it to the heap (No! I
- *  don't trust programmers to free it later), pass a pointer to a permanent
- *  local copy (No...it solves the memory leak but opens our class copy to
- *  being tampered with), or return some kind of object that could cast to
- *  a float array.  Luckily, OpenGL technically expects,
+ *  array, which OpenGL describes as
  *
  *      "a pointer to 16 consecutive values, which are used as the
- *      elements of a 4x4 column-major matrix,"
+ *      elements of a 4x4 column-major matrix."
  *
- *  which an STL vector certainly satisfies. Thus, all array returns are
- *  passed as copies of an STL vector, leaving memory clean and our
- *  variables safe.
+ *  The matrix is kept in a fixed std::array inside the quaternion, built
+ *  only when asked for after a change, and matrix() returns it as a
+ *  const std::array<float, 16>& (so &q.matrix()[0] is the pointer GL
+ *  wants). Nothing is ever allocated: copying a quaternion is copying 84
+ *  bytes, and matrix() costs nothing between changes.
+ *
+ *  Only the rotate() overloads that take a vector<float> or a float[3]
+ *  still return STL vector copies, for old callers. rotate(glm::vec3)
+ *  returns a glm::vec3 and allocates nothing.
+ *
+ *
+ *  [Inline Storage]
+ *
+ *  Everything used per frame lives in this header, inline, with no
+ *  virtual functions and no user-written copy, so the class is trivially
+ *  copyable and standard-layout: vectors of quaternions are plain memory.
+ *  Only the rarely used array constructors and printing stay in the .cpp.
+ *
+ *  operator* normalizes its product, as it always has. product() skips
+ *  that, for long chains where one normalize() at the end is enough.
  *
  *
  *  [Vector/vertex Rotation]
@@ -59,9 +72,6 @@
  *  quaternion from different representations of rotations and even different
  *  methods of passing array values. When it becomes safe to depend on
  *  constructor delegation (GCC 4.7), I'll refactor for a cleaner class.
- *  I also considered the class template format, but that prohibits the split
- *  of code between a .cpp and a .h file. I'd rather be well-documented and
- *  organized for this learning experience.
  *
  *
  *  [Miscellaneous]
@@ -89,6 +99,9 @@
 #ifndef QUATERNION_HPP_
 #define QUATERNION_HPP_
 
+#include <array>
+#include <cmath>
+#include <type_traits>
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -96,6 +109,8 @@ enum { EULER = 2, EXPLICIT = 4, ANGLE_AXIS = 8, MATRIX = 16 };
 enum { DEG = 1, RAD = 0 };
 
 const float PI = 3.1415926f;
+const float N_TOLERANCE = 1.0001f;          // Normalization tolerance
+const float T_TOLERANCE = 0.0001f;          // Trace tolerance
 
 using namespace std;
 
@@ -106,29 +121,25 @@ class Quaternion {
  private:
   // Data
   float W, X, Y, Z;
-  int dirty;
-  vector<float> rotMatrix;
+  mutable bool dirty;
+  mutable std::array<float, 16> rotMatrix;
 
-  // Constructor Init -- UT Servers use GCC 4.6 with no ctor delegation.
-  void initQAngleAxis(float theta, float *v);
+  // Constructor Init
+  void initQAngleAxis(float theta, const float *v);
   void initQEulerAngles(float vA, float vB, float vC);
   void initQRotationMatrix(float *m);
   void initQArrayUnknown(float *m, int con, int deg_rad);
 
   // Internal operations
-  float magnitude();
-  void normalize();
-  void makeMatrix();
-  void loadMatrix(float *m);
-  void normalizeVector(float *v);
-  Quaternion inverse();
-  Quaternion pureQuaternion(float *v);
-  vector<float> rotateVector(float *v);
+  void makeMatrix() const;
+  Quaternion inverse() const;
+  glm::vec3 rotateVector(const float *v) const;
+  static Quaternion slerpPath(const Quaternion& a, const Quaternion& b,
+                              float t, bool shortest);
 
  public:
   // Constructors
   Quaternion();
-  Quaternion(const Quaternion &b);
   explicit Quaternion(glm::vec3 m, int deg_rad);
   explicit Quaternion(float w, float x, float y, float z);
   explicit Quaternion(float theta, vector<float> axis, int deg_rad);
@@ -138,24 +149,572 @@ class Quaternion {
   explicit Quaternion(float *m, int construct, int deg_rad);
   explicit Quaternion(vector<float> m, int con, int deg_rad);
 
-  // Destructor
-  virtual ~Quaternion();
+  // Components and helpers
+  float w() const { return W; }
+  float x() const { return X; }
+  float y() const { return Y; }
+  float z() const { return Z; }
+  static constexpr float toRadians(float theta, int deg_rad) {
+    return deg_rad ? theta * (PI / 180.0f) : theta;
+  }
+  float dot(const Quaternion& b) const {
+    return W * b.W + X * b.X + Y * b.Y + Z * b.Z;
+  }
+  float lengthSquared() const {
+    return W * W + X * X + Y * Y + Z * Z;
+  }
+
+  // Interpolation
+  static Quaternion slerp(const Quaternion& a, const Quaternion& b, float t);
+  static Quaternion squad(const Quaternion& a, const Quaternion& b,
+                          const Quaternion& sa, const Quaternion& sb,
+                          float t);
+  static Quaternion squadControl(const Quaternion& prev,
+                                 const Quaternion& cur,
+                                 const Quaternion& next);
 
   // Public
-  vector<float> matrix();
-  vector<float> rotate(vector<float> v);
-  vector<float> rotate(float v[3]);
-  glm::vec3 rotate(glm::vec3 v);
+  const std::array<float, 16>& matrix() const;
+  Quaternion conjugate() const;
+  vector<float> rotate(vector<float> v) const;
+  vector<float> rotate(float v[3]) const;
+  glm::vec3 rotate(glm::vec3 v) const;
+  Quaternion product(const Quaternion& b) const;
+  float magnitude() const;
+  void normalize();
   void toString();
   void matrixToString();
   void zero();
 
   // Operators
-  Quaternion operator+ (const Quaternion& b);
-  Quaternion operator* (const Quaternion& b);
-  Quaternion& operator= (const Quaternion& b);
+  Quaternion operator+ (const Quaternion& b) const;
+  Quaternion operator* (const Quaternion& b) const;
   Quaternion& operator+= (const Quaternion& b);
   Quaternion& operator*= (const Quaternion& b);
 };
 
+static_assert(std::is_trivially_copyable<Quaternion>::value &&
+              std::is_standard_layout<Quaternion>::value,
+              "Quaternion must stay plain memory.");
+
+
+
+
+/***************************
+ * Constructors
+ */
+
+
+
+/**
+ * Default constructor.
+ * Initializes to the identity quaternion.
+ */
+inline Quaternion::Quaternion()
+: W(1), X(0), Y(0), Z(0), dirty(true) {
+}
+
+/**
+ * Explicit construction of a quaternion.
+ * Four terms listed individually.
+ * @param w - the W, or rotation, value
+ * @param x - the X component of the arbitrary axis
+ * @param y - the Y component of the arbitrary axis
+ * @param z - the Z component of the arbitrary axis
+ */
+inline Quaternion::Quaternion(float w, float x, float y, float z)
+: W(w), X(x), Y(y), Z(z), dirty(true) {
+  // Only normalize if not a pure quaternion.
+  if (W)
+    this->normalize();
+}
+
+/**
+ * Create quaternion from Euler angles - yaw (Z), pitch (Y), and roll (X).
+ * Three terms listed individually.
+ * @param yaw - rotation about the Z axis
+ * @param pitch - rotation about the Y axis
+ * @param roll - rotation about the X axis
+ * @param deg_rad - constant flag specifying degrees [DEG] or radians [RAD]
+ */
+inline Quaternion::Quaternion(float yaw, float pitch, float roll,
+                              int deg_rad)
+: W(1), X(0), Y(0), Z(0), dirty(true) {
+  this->initQEulerAngles(toRadians(yaw, deg_rad), toRadians(pitch, deg_rad),
+                         toRadians(roll, deg_rad));
+}
+
+/**
+ * Create quaternion from Euler angles - yaw (Z), pitch (Y), and roll (X).
+ * Three terms given by a glm::vec3 array.
+ * @param v3Angles - glm::vec3 of Z, Y, and X rotation values
+ * @param deg_rad - constant flag specifying degrees [DEG] or radians [RAD]
+ */
+inline Quaternion::Quaternion(glm::vec3 v3Angles, int deg_rad)
+: W(1), X(0), Y(0), Z(0), dirty(true) {
+  this->initQEulerAngles(toRadians(v3Angles[0], deg_rad),
+                         toRadians(v3Angles[1], deg_rad),
+                         toRadians(v3Angles[2], deg_rad));
+}
+
+/**
+ * Create quaternion from an angle and axis of rotation.
+ * Axis given by a vector<float> array of 3 terms.
+ * @param theta - angle of rotation
+ * @param axis - axis of rotation
+ * @param deg_rad - constant flag specifying degrees [DEG] or radians [RAD]
+ */
+inline Quaternion::Quaternion(float theta, vector<float> axis, int deg_rad)
+: W(1), X(0), Y(0), Z(0), dirty(true) {
+  this->initQAngleAxis(toRadians(theta, deg_rad), &axis[0]);
+}
+
+/**
+ * Create quaternion from an angle and axis of rotation.
+ * Axis given by a glm::vec3 float array of 3 terms.
+ * @param theta - angle of rotation
+ * @param axis - axis of rotation
+ * @param deg_rad - constant flag specifying degrees [DEG] or radians [RAD]
+ */
+inline Quaternion::Quaternion(float theta, glm::vec3 axis, int deg_rad)
+: W(1), X(0), Y(0), Z(0), dirty(true) {
+  this->initQAngleAxis(toRadians(theta, deg_rad), &axis[0]);
+}
+
+/**
+ * Create quaternion from an angle and axis of rotation.
+ * Axis given by a primitive float array of 3 terms.
+ * @param theta - angle of rotation
+ * @param axis - axis of rotation
+ * @param deg_rad - constant flag specifying degrees [DEG] or radians [RAD]
+ */
+inline Quaternion::Quaternion(float theta, float axis[3], int deg_rad)
+: W(1), X(0), Y(0), Z(0), dirty(true) {
+  this->initQAngleAxis(toRadians(theta, deg_rad), axis);
+}
+
+
+
+
+/***************************
+ * Private
+ */
+
+
+
+/**
+ * Initialization for creating a quaternion from angle-axis. This is the
+ * simplest conversion and generally the first example of a quaternion.
+ * @param theta - angle of rotation
+ * @param axis - axis of rotation
+ */
+inline void Quaternion::initQAngleAxis(float theta, const float *axis) {
+  float mag = sqrt(axis[0] * axis[0] + axis[1] * axis[1] +
+                   axis[2] * axis[2]);
+  float sinTheta = sin(theta / 2.0f) / mag;
+
+  // Scaled by the sine and the axis normalized in one step.
+  this->W = cos(theta / 2.0f);
+  this->X = axis[0] * sinTheta;
+  this->Y = axis[1] * sinTheta;
+  this->Z = axis[2] * sinTheta;
+
+  this->dirty = true;
+  this->normalize();
+}
+
+/**
+ * Create quaternion from yaw, pitch, and roll. The simple but inefficient
+ * solution is to create a quaternion from each angle and multiply. We can
+ * save memory and cycles by directly converting the multiplied Euler angle
+ * transform matrix (in order Z-->Y-->X) to quaternion representation.
+ * @param yaw - Z axis rotation
+ * @param pitch - Y axis rotation
+ * @param roll - X axis rotation
+ */
+inline void Quaternion::initQEulerAngles(float yaw, float pitch,
+                                         float roll) {
+  float sinZ = sin(yaw / 2.0f);
+  float sinY = sin(pitch / 2.0f);
+  float sinX = sin(roll / 2.0f);
+  float cosZ = cos(yaw / 2.0f);
+  float cosY = cos(pitch / 2.0f);
+  float cosX = cos(roll / 2.0f);
+
+  // Started with Wikipedia, but had to swap all X & Z values (empirical).
+  this->W = (cosX * cosY * cosZ) + (sinX * sinY * sinZ);
+  this->X = (sinX * cosY * cosZ) - (cosX * sinY * sinZ);
+  this->Y = (cosX * sinY * cosZ) + (sinX * cosY * sinZ);
+  this->Z = (cosX * cosY * sinZ) - (sinX * sinY * cosZ);
+
+  this->dirty = true;
+  this->normalize();
+}
+
+/**
+ * Compute the rotation matrix representation of this quaternion instance.
+ * This should only be called when the matrix is publicly requested AND an
+ * up-to-date representation does not already exist.
+ */
+inline void Quaternion::makeMatrix() const {
+  // I'm including the (x2) in the local variable declarations to minimize
+  // the loss of "inconsequential" values in the later addition. (Valid?)
+  float xw = this->X * this->W * 2.0f;
+  float xx = this->X * this->X * 2.0f;
+  float xy = this->X * this->Y * 2.0f;
+  float xz = this->X * this->Z * 2.0f;
+  float yw = this->Y * this->W * 2.0f;
+  float yy = this->Y * this->Y * 2.0f;
+  float yz = this->Y * this->Z * 2.0f;
+  float zw = this->Z * this->W * 2.0f;
+  float zz = this->Z * this->Z * 2.0f;
+
+  // This is transposed from the Princeton document's solution, presumably
+  // because of column-major storage. Change based on my testing.
+  this->rotMatrix = {{
+      1.0f - (yy + zz),           (xy + zw),           (xz - yw),          0,
+             (xy - zw),    1.0f - (xx + zz),           (yz + xw),          0,
+             (xz + yw),           (yz - xw),    1.0f - (xx + yy),          0,
+                     0,                   0,                   0,          1
+  }};
+
+  // Flag matrix as up-to-date.
+  this->dirty = false;
+}
+
+/**
+ * Create quaternion inverse or conjugate from current.
+ * @return a copy of the inverse quaternion
+ */
+inline Quaternion Quaternion::inverse() const {
+  return Quaternion(this->W, -this->X, -this->Y, -this->Z);
+}
+
+/**
+ * Spherical linear interpolation, at constant angular speed.
+ * @param a - rotation at t = 0
+ * @param b - rotation at t = 1
+ * @param t - position between them
+ * @param shortest - true to take b or -b, whichever is the shorter arc
+ * @return the unit quaternion in between
+ */
+inline Quaternion Quaternion::slerpPath(const Quaternion& a,
+                                        const Quaternion& b, float t,
+                                        bool shortest) {
+  Quaternion q;
+  float d = a.dot(b);
+  float sign = 1.0f;
+  float wa, wb, inv;
+
+  if (shortest && d < 0.0f) {
+    d = -d;
+    sign = -1.0f;
+  }
+
+  // Nearly the same rotation: the sines vanish, but a lerp is exact.
+  if (d > 0.9995f) {
+    wa = 1.0f - t;
+    wb = t * sign;
+  } else {
+    float theta = acos(d > 1.0f ? 1.0f : (d < -1.0f ? -1.0f : d));
+    float s = sin(theta);
+
+    wa = sin((1.0f - t) * theta) / s;
+    wb = sin(t * theta) / s * sign;
+  }
+
+  q.W = wa * a.W + wb * b.W;
+  q.X = wa * a.X + wb * b.X;
+  q.Y = wa * a.Y + wb * b.Y;
+  q.Z = wa * a.Z + wb * b.Z;
+
+  // Exactly unit, not just within normalize()'s tolerance.
+  inv = 1.0f / q.magnitude();
+  q.W *= inv;
+  q.X *= inv;
+  q.Y *= inv;
+  q.Z *= inv;
+
+  return q;
+}
+
+/**
+ * Applies this rotation to a single vector or vertex represented by a
+ * 3-value array. Expanding (v' = q * v * q^) for a unit quaternion
+ * q = [w | u] gives v' = v + 2w(u x v) + 2u x (u x v), which needs no
+ * intermediate quaternions.
+ * @param v - the vector or vertex to be rotated
+ * @return the rotated vector or vertex
+ */
+inline glm::vec3 Quaternion::rotateVector(const float *v) const {
+  glm::vec3 u(this->X, this->Y, this->Z);
+  glm::vec3 p(v[0], v[1], v[2]);
+  glm::vec3 t = glm::cross(u, p) * 2.0f;
+
+  return p + t * this->W + glm::cross(u, t);
+}
+
+
+
+
+/***************************
+ * Public
+ */
+
+
+
+/**
+ * Provides the current rotation matrix representation of this quaternion.
+ * If the matrix representation has not been computed or has been changed
+ * recently, perform that calculation first.
+ * @return the instance's rotation matrix, column-major
+ */
+inline const std::array<float, 16>& Quaternion::matrix() const {
+  if (this->dirty)
+    this->makeMatrix();
+
+  return this->rotMatrix;
+}
+
+/**
+ * Create the conjugate, which for a unit quaternion is its inverse.
+ * @return a copy of the conjugate
+ */
+inline Quaternion Quaternion::conjugate() const {
+  return this->inverse();
+}
+
+/**
+ * Spherical linear interpolation along the shorter arc.
+ * @param a - rotation at t = 0
+ * @param b - rotation at t = 1
+ * @param t - position between them, 0 to 1
+ * @return the unit quaternion in between
+ */
+inline Quaternion Quaternion::slerp(const Quaternion& a, const Quaternion& b,
+                                    float t) {
+  return slerpPath(a, b, t, true);
+}
+
+/**
+ * Spherical quadrangle interpolation: a slerp that bends through the
+ * control points, so a chain of keys turns smoothly through each one
+ * instead of changing speed and axis abruptly as a chain of slerps does.
+ * @param a - rotation at t = 0
+ * @param b - rotation at t = 1
+ * @param sa - squadControl() of a and its neighbors
+ * @param sb - squadControl() of b and its neighbors
+ * @param t - position between a and b, 0 to 1
+ * @return the unit quaternion in between
+ */
+inline Quaternion Quaternion::squad(const Quaternion& a, const Quaternion& b,
+                                    const Quaternion& sa,
+                                    const Quaternion& sb, float t) {
+  return slerpPath(slerpPath(a, b, t, false), slerpPath(sa, sb, t, false),
+                   2.0f * t * (1.0f - t), false);
+}
+
+/**
+ * The squad() control point of a key, from the keys on either side:
+ * s = q exp(-(log(q^ next) + log(q^ prev)) / 4). The three should lie in
+ * one hemisphere (non-negative dot products).
+ * @param prev - the key before, or cur at the start of a path
+ * @param cur - the key
+ * @param next - the key after, or cur at the end of a path
+ * @return the control point for cur
+ */
+inline Quaternion Quaternion::squadControl(const Quaternion& prev,
+                                           const Quaternion& cur,
+                                           const Quaternion& next) {
+  Quaternion inv = cur.conjugate();
+  Quaternion ends[2] = { inv.product(next), inv.product(prev) };
+  Quaternion e;
+  float lx = 0.0f, ly = 0.0f, lz = 0.0f;
+  float angle, scale;
+
+  // Sum of the logarithms, which are pure: the axis times the half angle.
+  for (int i = 0; i < 2; i++) {
+    const Quaternion& q = ends[i];
+    float sinHalf = sqrt(q.X * q.X + q.Y * q.Y + q.Z * q.Z);
+
+    if (sinHalf > 1e-6f) {
+      scale = atan2(sinHalf, q.W) / sinHalf;
+      lx += q.X * scale;
+      ly += q.Y * scale;
+      lz += q.Z * scale;
+    }
+  }
+  lx *= -0.25f;
+  ly *= -0.25f;
+  lz *= -0.25f;
+
+  // And back through the exponential.
+  angle = sqrt(lx * lx + ly * ly + lz * lz);
+  scale = angle > 1e-6f ? sin(angle) / angle : 1.0f;
+  e.W = cos(angle);
+  e.X = lx * scale;
+  e.Y = ly * scale;
+  e.Z = lz * scale;
+
+  return cur.product(e);
+}
+
+/**
+ * Perform a quaternion rotation on the passed vector object.
+ * @param v - vector<float> form of the 3-value vector or vertex to be rotated
+ * @return a copy of the rotated vector or vertex
+ */
+inline vector<float> Quaternion::rotate(vector<float> v) const {
+  glm::vec3 r = rotateVector(&v[0]);
+
+  v[0] = r[0];
+  v[1] = r[1];
+  v[2] = r[2];
+
+  return v;
+}
+
+/**
+ * Perform a quaternion rotation on the passed vector object. Since it's
+ * a primitive array, we'll enforce a size of [3] in the parameters and
+ * return a copy of a vector<float>. See header comments on Return Types.
+ * @param v - float[] form of the 3-value vector or vertex to be rotated
+ * @return a copy of the rotated vector as an STL vector
+ */
+inline vector<float> Quaternion::rotate(float v[3]) const {
+  glm::vec3 r = rotateVector(v);
+
+  return vector<float>(&r[0], &r[0] + 3);
+}
+
+/**
+ * Perform a quaternion rotation on the passed glm::vec3 object. The hot
+ * path: nothing is allocated.
+ * @param v - glm::vec3 form of the 3-value vector or vertex to be rotated
+ * @return a copy of the rotated glm::vec3
+ */
+inline glm::vec3 Quaternion::rotate(glm::vec3 v) const {
+  return rotateVector(&v[0]);
+}
+
+/**
+ * Multiply the following quaternion by this quaternion, without
+ * normalizing the result.
+ * @param b - the right-hand operand
+ * @return a copy of the quaternion product
+ */
+inline Quaternion Quaternion::product(const Quaternion& b) const {
+  Quaternion qProduct;
+  float W = this->W;
+  float X = this->X;
+  float Y = this->Y;
+  float Z = this->Z;
+
+  qProduct.W = (W * b.W) - (X * b.X) - (Y * b.Y) - (Z * b.Z);
+  qProduct.X = (W * b.X) + (X * b.W) + (Y * b.Z) - (Z * b.Y);
+  qProduct.Y = (W * b.Y) - (X * b.Z) + (Y * b.W) + (Z * b.X);
+  qProduct.Z = (W * b.Z) + (X * b.Y) - (Y * b.X) + (Z * b.W);
+
+  return qProduct;
+}
+
+/**
+ * The magnitude of a quaternion is similar to that of a standard vector.
+ * That is, the root of the sum of the squares.
+ * @return the magnitude of this quaternion
+ */
+inline float Quaternion::magnitude() const {
+  return sqrt(this->lengthSquared());
+}
+
+/**
+ * Normalize this quaternion. Only proceeds if quaternion is not already
+ * normalized. Given tolerance to compensate for float inaccuracies.
+ */
+inline void Quaternion::normalize() {
+  float mag2 = this->lengthSquared();
+
+  // Compared squared, so the common case needs no sqrt().
+  if (mag2 > N_TOLERANCE * N_TOLERANCE) {
+    float inv = 1.0f / sqrt(mag2);
+
+    this->W *= inv;
+    this->X *= inv;
+    this->Y *= inv;
+    this->Z *= inv;
+    this->dirty = true;
+  }
+}
+
+/**
+ * Clears the quaternion back to the default or zero quaternion.
+ */
+inline void Quaternion::zero() {
+  *this = Quaternion();
+}
+
+
+
+
+/***************************
+ * Operators
+ */
+
+
+
+/**
+ * Add two quaternions. This won't be used often, but it is defined.
+ * @param b - the right-hand operand
+ * @return the sum of this and the rhs quaternion
+ */
+inline Quaternion Quaternion::operator+ (const Quaternion &b) const {
+  Quaternion qSum;
+
+  qSum.W = this->W + b.W;
+  qSum.X = this->X + b.X;
+  qSum.Y = this->Y + b.Y;
+  qSum.Z = this->Z + b.Z;
+
+  qSum.normalize();
+
+  return qSum;
+}
+
+/**
+ * Multiply the following quaternion by this quaternion.
+ * @param b - the right-hand operand
+ * @return a copy of the normalized quaternion product
+ */
+inline Quaternion Quaternion::operator* (const Quaternion &b) const {
+  Quaternion qProduct = this->product(b);
+
+  qProduct.normalize();     // Keeps repeated products from drifting.
+
+  return qProduct;
+}
+
+/**
+ * Add the rhs quaternion to this quaternion.
+ * This won't be used often, but it is defined.
+ * @param b - the right-hand operand
+ * @return this updated quaternion as sum
+ */
+inline Quaternion& Quaternion::operator+= (const Quaternion &b) {
+  *this = *this + b;
+
+  return *this;
+}
+
+/**
+ * Make this quaternion the product of it and the rhs quaternion.
+ * We can use the above operator* to retrieve a pre-normalized quaternion.
+ * @param b - the right-hand operand
+ * @return this updated quaternion as product
+ */
+inline Quaternion& Quaternion::operator*= (const Quaternion &b) {
+  *this = *this * b;
+
+  return *this;
+}
+
 #endif /* QUATERNION_H_ */
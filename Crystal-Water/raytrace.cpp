@@ -0,0 +1,674 @@
+/**
+ * raytrace.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "./raytrace.hpp"
+#include "./glstate.hpp"
+
+using namespace std;
+
+
+/**
+ * Radical inverse of i in the given base, a low-discrepancy sequence.
+ * @param i - index into the sequence, from 1
+ * @param base - a prime
+ * @return value in [0, 1)
+ */
+static float Halton(int i, int base) {
+  float f = 1.0f, r = 0.0f;
+
+  for (; i > 0; i /= base) {
+    f /= base;
+    r += f * (i % base);
+  }
+
+  return r;
+}
+
+/**
+ * Looks for an extension in a device's extension string.
+ * @param device - the CL device
+ * @param name - extension name, e.g. "cl_khr_gl_event"
+ * @return true if the device lists it
+ */
+static bool DeviceExtension(cl_device_id device, const string& name) {
+  size_t length = 0;
+
+  clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS, 0, NULL, &length);
+  vector<char> list(length + 1, '\0');
+  clGetDeviceInfo(device, CL_DEVICE_EXTENSIONS, length, &list[0], NULL);
+
+  return (" " + string(&list[0]) + " ").find(" " + name + " ") != string::npos;
+}
+
+/**
+ * Blocks until GL has passed a fence. A wait that times out waits again;
+ * one that fails falls back to glFinish(), which passes every fence.
+ * @param fence - the fence to wait for
+ */
+static void WaitForFence(GLsync fence) {
+  GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+
+  for (;;) {
+    GLenum status = glClientWaitSync(fence, flags, TRACE_FENCE_TIMEOUT);
+
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+      return;
+    if (status != GL_TIMEOUT_EXPIRED) {
+      glFinish();
+      return;
+    }
+    flags = 0;                              // Flushed on the first try
+  }
+}
+
+/**
+ * Default Constructor. Nothing to trace until setGeometry() and init().
+ */
+CrystalTracer::CrystalTracer()
+: width(0),
+  height(0),
+  traceW(0),
+  traceH(0),
+  lightPos(0.0f),
+  context(NULL),
+  queue(NULL),
+  program(NULL),
+  kernel(NULL),
+  resolveKernel(NULL),
+  triangleBuf(NULL),
+  texelBuf(NULL),
+  layerBuf(NULL),
+  sampleBuf(NULL),
+  historyBuf(NULL),
+  current(-1),
+  previous(-1),
+  pipeline(true),
+  clWaitsOnGL(false),
+  glWaitsOnCL(false),
+  reuse(true),
+  frame(0),
+  stillFrames(0),
+  emptyVAO(0),
+  upsampleId(0),
+  millis(0.0) {
+  for (int b = 0; b < TRACE_BUFFERS; b++) {
+    buffers[b].texture.present = false;
+    buffers[b].image = NULL;
+    buffers[b].width = buffers[b].height = 0;
+    buffers[b].scale = 1.0f;
+    buffers[b].traced = buffers[b].resolved = buffers[b].released = NULL;
+    buffers[b].sampled = buffers[b].waited = 0;
+  }
+  prevSize[0] = prevSize[1] = 0;
+}
+
+/**
+ * Default Destructor. Frees the CL and GL objects.
+ */
+CrystalTracer::~CrystalTracer() {
+  this->Release();
+}
+
+/**
+ * Copies the triangles and textures of a mesh for the kernel. Must be
+ * called while the mesh still holds its client-side arrays.
+ * @param mesh - the crystal and everything it should reflect
+ * @param transform - mesh to scene space
+ * @param crystal - index of the crystal's sub-mesh
+ */
+void CrystalTracer::setGeometry(Mesh& mesh, const glm::mat4& transform,
+                                int crystal) {
+  vector<VBOVertex>& vbo = mesh.getVBOVertexArray();
+  vector<vector<GLuint> >& ibos = mesh.getIBOIndexArrays();
+  vector<TexImage>& images = mesh.getTextureImages();
+
+  this->triangles.clear();
+  for (int s = 0; s < ibos.size(); s++) {
+    vector<GLuint>& ibo = ibos[s];
+
+    for (int i = 0; i + 2 < ibo.size(); i += 3) {
+      const VBOVertex *v[3] = { &vbo[ibo[i]], &vbo[ibo[i + 1]],
+                                &vbo[ibo[i + 2]] };
+      glm::vec3 p[3];
+      TraceTriangle tri;
+
+      for (int k = 0; k < 3; k++)
+        p[k] = glm::vec3(transform * glm::vec4(v[k]->position[0],
+            v[k]->position[1], v[k]->position[2], 1.0f));
+
+      tri.v0 = glm::vec4(p[0], s == crystal ? 1.0f : 0.0f);
+      tri.e1 = glm::vec4(p[1] - p[0], v[0]->texLayer);
+      tri.e2 = glm::vec4(p[2] - p[0], 0.0f);
+      tri.uv01 = glm::vec4(v[0]->texture[0], v[0]->texture[1],
+                           v[1]->texture[0], v[1]->texture[1]);
+      tri.uv2 = glm::vec4(v[2]->texture[0], v[2]->texture[1], 0.0f, 0.0f);
+      tri.color = glm::vec4(v[0]->diffuse[0], v[0]->diffuse[1],
+                            v[0]->diffuse[2], v[0]->shininess);
+      this->triangles.push_back(tri);
+    }
+  }
+
+  // Every layer back to back, each with its offset and size.
+  this->texels.clear();
+  this->layers.clear();
+  for (int l = 0; l < images.size(); l++) {
+    TexImage& img = images[l];
+
+    layers.push_back(texels.size() / 4);
+    layers.push_back(img.width);
+    layers.push_back(img.height);
+    layers.push_back(0);
+    texels.insert(texels.end(), img.pixels,
+                  img.pixels + img.width * img.height * 4);
+  }
+}
+
+/**
+ * Builds the kernel, uploads the geometry, and creates the output textures
+ * and their CL images.
+ * @param context - CL context created with GL sharing
+ * @param device - device of the context
+ * @param queue - queue created with CL_QUEUE_PROFILING_ENABLE
+ * @param kernelFile - OpenCL source, trace.cl
+ * @param width - window width in pixels
+ * @param height - window height in pixels
+ * @return true if the tracer is ready
+ */
+bool CrystalTracer::init(cl_context context, cl_device_id device,
+                         cl_command_queue queue, const string& kernelFile,
+                         int width, int height) {
+  cl_int nTriangles = triangles.size();
+  cl_int err;
+
+  this->Release();
+  this->context = context;
+  this->queue = queue;
+  this->width = width;
+  this->height = height;
+
+  if (triangles.empty()) {
+    cout << "No geometry to ray trace." << endl;
+    return false;
+  }
+  if (texels.empty()) {
+    texels.assign(4, 0);
+    layers.assign(4, 0);
+  }
+
+  // Full window size; trace() fills only the lower-left corner it needs.
+  for (int b = 0; b < TRACE_BUFFERS; b++) {
+    TexInfo& output = buffers[b].texture;
+
+    glGenTextures(1, &output.texID);
+    glState.bindTexture(TRACE_TEXTURE_UNIT, GL_TEXTURE_2D, output.texID);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    output.texUnit = TRACE_TEXTURE_UNIT;
+    output.texTarget = GL_TEXTURE_2D;
+    output.present = true;
+
+    // The first acquire waits for the texture to exist.
+    buffers[b].sampled = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+  glFlush();
+
+  // The upsample triangle is made from gl_VertexID alone.
+  glGenVertexArrays(1, &emptyVAO);
+
+  if (!this->BuildKernel(device, kernelFile)) {
+    this->Release();
+    return false;
+  }
+
+  triangleBuf = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+      triangles.size() * sizeof(TraceTriangle), &triangles[0], &err);
+  if (err == CL_SUCCESS)
+    texelBuf = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+        texels.size(), &texels[0], &err);
+  if (err == CL_SUCCESS)
+    layerBuf = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+        layers.size() * sizeof(cl_int), &layers[0], &err);
+  for (int b = 0; b < TRACE_BUFFERS && err == CL_SUCCESS; b++)
+    buffers[b].image = clCreateFromGLTexture(context, CL_MEM_WRITE_ONLY,
+        GL_TEXTURE_2D, 0, buffers[b].texture.texID, &err);
+  if (err == CL_SUCCESS)
+    sampleBuf = clCreateBuffer(context, CL_MEM_READ_WRITE,
+        width * height * TRACE_TEXEL_BYTES, NULL, &err);
+  if (err == CL_SUCCESS)
+    historyBuf = clCreateBuffer(context, CL_MEM_READ_WRITE,
+        width * height * TRACE_TEXEL_BYTES, NULL, &err);
+  if (err != CL_SUCCESS) {
+    cout << "Ray tracer buffers could not be created (OpenCL error " << err
+         << ")." << endl;
+    this->Release();
+    return false;
+  }
+
+  // Arguments that never change; the view goes in with every trace().
+  clSetKernelArg(kernel, 0, sizeof(cl_mem), &triangleBuf);
+  clSetKernelArg(kernel, 1, sizeof(cl_int), &nTriangles);
+  clSetKernelArg(kernel, 2, sizeof(cl_mem), &texelBuf);
+  clSetKernelArg(kernel, 3, sizeof(cl_mem), &layerBuf);
+  clSetKernelArg(kernel, 4, sizeof(cl_mem), &sampleBuf);
+  clSetKernelArg(kernel, 5, sizeof(cl_mem), &historyBuf);
+  clSetKernelArg(resolveKernel, 0, sizeof(cl_mem), &sampleBuf);
+  clSetKernelArg(resolveKernel, 1, sizeof(cl_mem), &historyBuf);
+
+  controller.setRange(TRACE_MIN_SCALE, 1.0f);
+  controller.reset();
+  this->prevSize[0] = this->prevSize[1] = 0;
+  this->stillFrames = 0;
+
+  // Without these, the CPU waits on each hand-off instead of the GPU.
+  this->clWaitsOnGL = DeviceExtension(device, "cl_khr_gl_event");
+  this->glWaitsOnCL = GLEW_ARB_cl_event;
+  if (!clWaitsOnGL || !glWaitsOnCL)
+    cout << "Ray tracer hand-offs wait on the CPU ("
+         << (clWaitsOnGL ? "" : "no cl_khr_gl_event")
+         << (clWaitsOnGL || glWaitsOnCL ? "" : ", ")
+         << (glWaitsOnCL ? "" : "no GL_ARB_cl_event") << ")." << endl;
+
+  return true;
+}
+
+/**
+ * Sets the key light, in eye space as in the Light block.
+ * @param position - light position relative to the camera
+ */
+void CrystalTracer::setLight(const glm::vec3& position) {
+  this->lightPos = position;
+}
+
+/**
+ * Turns the reuse of earlier frames on or off. Off, every pixel is traced
+ * afresh at its center each frame.
+ * @param enabled - true to reproject and accumulate
+ */
+void CrystalTracer::setTemporal(bool enabled) {
+  this->reuse = enabled;
+  this->prevSize[0] = this->prevSize[1] = 0;
+  this->stillFrames = 0;
+}
+
+/**
+ * Chooses which trace composite() draws.
+ * @param enabled - true for the trace of the frame before, which runs
+ *                  beside that frame's GL work; false for this frame's
+ */
+void CrystalTracer::setPipelined(bool enabled) {
+  this->pipeline = enabled;
+}
+
+/**
+ * Enqueues a trace of the crystal from the given view, at the current
+ * render scale and reusing what the last frame saw, into the buffer that
+ * does not hold the last trace. Returns without waiting for it. The
+ * kernels' time of that buffer's previous trace goes to the resolution
+ * controller.
+ * @param view - scene to eye space (mModel)
+ * @param proj - projection matrix
+ */
+void CrystalTracer::trace(const glm::mat4& view, const glm::mat4& proj) {
+  float scale = controller.getScale();
+  glm::mat4 inverseViewProj = glm::inverse(proj * view);
+  glm::mat4 inverseView = glm::inverse(view);
+  glm::mat4 prevViewProj = prevProj * prevView;
+  glm::vec4 eye = inverseView[3];
+  glm::vec4 viewZ(view[0][2], view[1][2], view[2][2], view[3][2]);
+  glm::vec4 prevViewZ(prevView[0][2], prevView[1][2], prevView[2][2],
+                      prevView[3][2]);
+  glm::vec4 light = inverseView * glm::vec4(lightPos, 1.0f);
+  glm::vec2 jitter(0.0f);
+  int visit = frame / TRACE_TEMPORAL_PERIOD + 1;
+  int next = (current + 1) % TRACE_BUFFERS;
+  TraceBuffer& buf = buffers[next];
+  cl_event drawn = NULL;
+  cl_int size[2];
+  size_t global[2];
+  cl_int err;
+
+  if (!kernel)
+    return;
+
+  this->Retire(buf);
+
+  this->traceW = max(1, static_cast<int>(width * scale + 0.5f));
+  this->traceH = max(1, static_cast<int>(height * scale + 0.5f));
+  size[0] = traceW;
+  size[1] = traceH;
+  global[0] = traceW;
+  global[1] = traceH;
+
+  // Samples keep piling up only while the view holds still.
+  if (view == prevView && proj == prevProj)
+    this->stillFrames++;
+  else
+    this->stillFrames = 0;
+  if (!reuse)
+    this->prevSize[0] = this->prevSize[1] = 0;
+  else
+    jitter = glm::vec2(Halton(visit, 2) - 0.5f, Halton(visit, 3) - 0.5f);
+
+  clSetKernelArg(kernel, 6, sizeof(glm::mat4), &inverseViewProj);
+  clSetKernelArg(kernel, 7, sizeof(glm::vec4), &viewZ);
+  clSetKernelArg(kernel, 8, sizeof(glm::vec4), &eye);
+  clSetKernelArg(kernel, 9, sizeof(glm::vec4), &light);
+  clSetKernelArg(kernel, 10, sizeof(size), size);
+  clSetKernelArg(kernel, 11, sizeof(glm::mat4), &prevViewProj);
+  clSetKernelArg(kernel, 12, sizeof(glm::vec4), &prevViewZ);
+  clSetKernelArg(kernel, 13, sizeof(prevSize), prevSize);
+  clSetKernelArg(kernel, 14, sizeof(glm::vec2), &jitter);
+  clSetKernelArg(kernel, 15, sizeof(cl_int), &frame);
+  clSetKernelArg(resolveKernel, 2, sizeof(cl_mem), &buf.image);
+  clSetKernelArg(resolveKernel, 3, sizeof(size), size);
+  clSetKernelArg(resolveKernel, 4, sizeof(cl_int), &frame);
+
+  // GL must be done reading the buffer before CL writes it. Its fence is
+  // kept until this trace retires, since the acquire may still wait on it.
+  buf.waited = buf.sampled;
+  buf.sampled = 0;
+  if (buf.waited && clWaitsOnGL) {
+    drawn = clCreateEventFromGLsyncKHR(context,
+        reinterpret_cast<cl_GLsync>(buf.waited), &err);
+    if (err != CL_SUCCESS)
+      drawn = NULL;
+  }
+  if (buf.waited && !drawn)
+    WaitForFence(buf.waited);
+
+  clEnqueueAcquireGLObjects(queue, 1, &buf.image, drawn ? 1 : 0,
+                            drawn ? &drawn : NULL, NULL);
+  clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global, NULL, 0, NULL,
+                         &buf.traced);
+  clEnqueueNDRangeKernel(queue, resolveKernel, 2, NULL, global, NULL, 0,
+                         NULL, &buf.resolved);
+  clEnqueueReleaseGLObjects(queue, 1, &buf.image, 0, NULL, &buf.released);
+  clFlush(queue);
+  if (drawn)
+    clReleaseEvent(drawn);
+
+  buf.width = traceW;
+  buf.height = traceH;
+  buf.scale = scale;
+  this->previous = current;
+  this->current = next;
+
+  // The history now holds this frame, as seen from this view.
+  this->prevView = view;
+  this->prevProj = proj;
+  this->prevSize[0] = traceW;
+  this->prevSize[1] = traceH;
+  this->frame = (frame + 1) % (TRACE_TEMPORAL_PERIOD * TRACE_JITTER_CYCLE);
+}
+
+/**
+ * Upsamples a trace over the current framebuffer, with depth testing
+ * against what is already there: the one before the last trace() when
+ * pipelined, or the last one. The GPU waits for CL to finish it.
+ * @param upsampleProg - program built from composite.vert and
+ *                       upsample.frag, with the sampler traceTex added
+ * @param zNear - near plane of the traced view
+ * @param zFar - far plane of the traced view
+ */
+void CrystalTracer::composite(Program& upsampleProg, float zNear,
+                              float zFar) {
+  int shown = pipeline ? previous : current;
+
+  if (shown < 0 || !buffers[shown].released)
+    return;
+
+  TraceBuffer& buf = buffers[shown];
+
+  if (glWaitsOnCL) {
+    // Deleted at once; GL keeps it until the wait is over.
+    GLsync written = glCreateSyncFromCLeventARB(context, buf.released, 0);
+    glWaitSync(written, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(written);
+  } else {
+    clWaitForEvents(1, &buf.released);
+  }
+
+  // Handles from a reloaded program are new.
+  if (upsampleProg.getProgramId() != upsampleId) {
+    this->uTraceInfo = upsampleProg.getUniform<glm::vec4>("traceInfo");
+    this->uDepthRange = upsampleProg.getUniform<glm::vec4>("depthRange");
+    this->upsampleId = upsampleProg.getProgramId();
+  }
+
+  upsampleProg.enable();
+  upsampleProg.set(uTraceInfo, glm::vec4(
+      buf.width / static_cast<float>(width),
+      buf.height / static_cast<float>(height), buf.width, buf.height));
+  upsampleProg.set(uDepthRange, glm::vec4(zNear, zFar, 0.0f, 0.0f));
+  upsampleProg.setTexture(0, buf.texture);
+  glState.bindVertexArray(emptyVAO);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glState.countDraw();
+  upsampleProg.disable();
+
+  // The next trace into this buffer waits for this draw, and no more.
+  if (buf.sampled)
+    glDeleteSync(buf.sampled);
+  buf.sampled = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/**
+ * Retrieves the controller that picks the render scale.
+ * @return reference to the controller
+ */
+ResolutionController& CrystalTracer::resolution() {
+  return this->controller;
+}
+
+/**
+ * Retrieves the width the last trace() rendered at.
+ * @return width in pixels
+ */
+int CrystalTracer::traceWidth() {
+  return this->traceW;
+}
+
+/**
+ * Retrieves the height the last trace() rendered at.
+ * @return height in pixels
+ */
+int CrystalTracer::traceHeight() {
+  return this->traceH;
+}
+
+/**
+ * Retrieves the device time of the last trace() to finish.
+ * @return kernel time in milliseconds
+ */
+double CrystalTracer::traceMillis() {
+  return this->millis;
+}
+
+/**
+ * Reports whether earlier frames are reused.
+ * @return true unless setTemporal(false)
+ */
+bool CrystalTracer::temporal() {
+  return this->reuse;
+}
+
+/**
+ * Reports whether composite() draws the trace of the frame before.
+ * @return true unless setPipelined(false)
+ */
+bool CrystalTracer::pipelined() {
+  return this->pipeline;
+}
+
+/**
+ * Reports whether a still view would still change with another frame, so
+ * an on-demand loop should keep drawing: while pixels gain samples, and
+ * for the frame a pipelined trace of the final view needs to be drawn.
+ * @return true until the drawn image holds all its samples
+ */
+bool CrystalTracer::converging() {
+  int lag = pipeline ? 1 : 0;
+
+  return this->kernel && (stillFrames < lag || (reuse &&
+         stillFrames < TRACE_TEMPORAL_PERIOD * TRACE_HISTORY_SAMPLES + lag));
+}
+
+/**
+ * Reports whether init() succeeded.
+ * @return true if the kernel and its buffers exist
+ */
+bool CrystalTracer::ready() {
+  return this->kernel != NULL && this->buffers[0].image != NULL;
+}
+
+/**
+ * Reads and builds trace.cl, printing the build log on failure.
+ */
+bool CrystalTracer::BuildKernel(cl_device_id device,
+                                const string& kernelFile) {
+  fstream file(kernelFile.c_str(), ios::in);
+  ostringstream source, options;
+  string text;
+  const char *src;
+  cl_int err;
+
+  if (!file.is_open()) {
+    cout << "Cannot open " << kernelFile << "." << endl;
+    return false;
+  }
+  source << file.rdbuf();
+  text = source.str();
+  src = text.c_str();
+
+  options << "-cl-fast-relaxed-math -DMAX_BOUNCES=" << TRACE_MAX_BOUNCES
+          << " -DIOR=" << TRACE_IOR << "f -DMAX_SAMPLES="
+          << TRACE_HISTORY_SAMPLES << " -DPERIOD=" << TRACE_TEMPORAL_PERIOD;
+
+  program = clCreateProgramWithSource(context, 1, &src, NULL, &err);
+  if (err == CL_SUCCESS)
+    err = clBuildProgram(program, 1, &device, options.str().c_str(), NULL,
+                         NULL);
+  if (err != CL_SUCCESS) {
+    size_t length = 0;
+
+    clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, NULL,
+                          &length);
+    vector<char> log(length + 1, '\0');
+    clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, length,
+                          &log[0], NULL);
+    cout << kernelFile << " failed to build:" << endl << &log[0] << endl;
+    return false;
+  }
+
+  kernel = clCreateKernel(program, "trace", &err);
+  if (err == CL_SUCCESS)
+    resolveKernel = clCreateKernel(program, "resolve", &err);
+  if (err != CL_SUCCESS) {
+    cout << "No trace and resolve kernels in " << kernelFile << "." << endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Finishes with a buffer's last trace before the buffer is traced into
+ * again. It was enqueued TRACE_BUFFERS frames ago, so waiting for it
+ * rarely takes any time. Its kernels' device time, not the wait, feeds
+ * the resolution controller, since that is what the scale changes.
+ * @param buf - the buffer about to be traced into
+ */
+void CrystalTracer::Retire(TraceBuffer& buf) {
+  cl_ulong start = 0, end = 0;
+
+  if (!buf.released)
+    return;
+
+  clWaitForEvents(1, &buf.released);
+  clGetEventProfilingInfo(buf.traced, CL_PROFILING_COMMAND_START,
+                          sizeof(start), &start, NULL);
+  clGetEventProfilingInfo(buf.resolved, CL_PROFILING_COMMAND_END,
+                          sizeof(end), &end, NULL);
+  clReleaseEvent(buf.traced);
+  clReleaseEvent(buf.resolved);
+  clReleaseEvent(buf.released);
+  buf.traced = buf.resolved = buf.released = NULL;
+  if (buf.waited)
+    glDeleteSync(buf.waited);
+  buf.waited = 0;
+
+  // Retired a frame or two late, so normalize by the scale it ran at,
+  // not the controller's current one.
+  this->millis = (end - start) / 1.0e6;
+  controller.update(millis, buf.scale);
+}
+
+/**
+ * Frees every CL and GL object, once the queue has drained.
+ */
+void CrystalTracer::Release() {
+  if (queue)
+    clFinish(queue);
+  for (int b = 0; b < TRACE_BUFFERS; b++) {
+    TraceBuffer& buf = buffers[b];
+
+    if (buf.released) {
+      clReleaseEvent(buf.traced);
+      clReleaseEvent(buf.resolved);
+      clReleaseEvent(buf.released);
+    }
+    if (buf.sampled)
+      glDeleteSync(buf.sampled);
+    if (buf.waited)
+      glDeleteSync(buf.waited);
+    if (buf.image)
+      clReleaseMemObject(buf.image);
+    if (buf.texture.present)
+      glDeleteTextures(1, &buf.texture.texID);
+
+    buf.traced = buf.resolved = buf.released = NULL;
+    buf.sampled = buf.waited = 0;
+    buf.image = NULL;
+    buf.texture.present = false;
+    buf.width = buf.height = 0;
+  }
+  this->current = this->previous = -1;
+
+  if (historyBuf)
+    clReleaseMemObject(historyBuf);
+  if (sampleBuf)
+    clReleaseMemObject(sampleBuf);
+  if (layerBuf)
+    clReleaseMemObject(layerBuf);
+  if (texelBuf)
+    clReleaseMemObject(texelBuf);
+  if (triangleBuf)
+    clReleaseMemObject(triangleBuf);
+  if (resolveKernel)
+    clReleaseKernel(resolveKernel);
+  if (kernel)
+    clReleaseKernel(kernel);
+  if (program)
+    clReleaseProgram(program);
+  if (emptyVAO)
+    glDeleteVertexArrays(1, &emptyVAO);
+
+  this->layerBuf = this->texelBuf = NULL;
+  this->triangleBuf = this->sampleBuf = this->historyBuf = NULL;
+  this->kernel = this->resolveKernel = NULL;
+  this->program = NULL;
+  this->emptyVAO = 0;
+  this->traceW = this->traceH = 0;
+}
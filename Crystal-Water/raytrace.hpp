@@ -0,0 +1,190 @@
+/**
+ * raytrace.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  The ray traced crystal: an OpenCL kernel (trace.cl) follows the view
+ *  rays that hit the crystal through it, refracting in and out and
+ *  reflecting off it, into a shared GL texture that is then composited
+ *  over the rasterized scene.
+ *
+ *  Notes:
+ *
+ *    The order of use is:
+ *
+ *          setGeometry()       // before Scene::upload() frees the arrays
+ *          init()              // once the GL and CL contexts exist
+ *          trace()             // every frame, as soon as the view is set
+ *          composite()         // after the opaque pass
+ *
+ *    The kernel tests every triangle of one mesh (the crystal and its
+ *    surroundings, here skybox.obj), so its cost goes with the number of
+ *    pixels the crystal covers. To keep that cost flat, trace() renders
+ *    into the lower-left part of the output texture at the scale chosen
+ *    by a ResolutionController from the kernel's own measured time (see
+ *    dynres.hpp), and composite() upsamples that part to the window.
+ *
+ *    Each output texel holds the color and the eye-space depth of the
+ *    crystal, or zero depth where the view ray misses it. The upsample
+ *    (upsample.frag) is edge-aware: of the four nearest texels it blends
+ *    only those that hit the crystal and lie at the nearest depth, so the
+ *    silhouette stays sharp and the background never bleeds in. It writes
+ *    the depth, so anything rasterized in front still hides the crystal.
+ *
+ *    Between frames the camera barely moves, so most of the last image is
+ *    still good. The kernel finds each pixel's surface point with one
+ *    primary ray, looks it up in the last frame (reprojected with the last
+ *    view and projection, and rejected if the depth there disagrees), and
+ *    traces the full refracted path only where nothing was found and for
+ *    one pixel of every 2x2 block per frame. A second kernel clamps each
+ *    reused color to the fresh samples around it, so stale history cannot
+ *    smear, and blends the fresh ones in. Each frame's rays are jittered
+ *    within their pixels, so a still view gathers up to
+ *    TRACE_HISTORY_SAMPLES samples per pixel at a quarter of the paths per
+ *    frame; setTemporal(false) traces every pixel afresh instead.
+ *
+ *    Textures of the mesh are copied into one CL buffer, so the kernel
+ *    needs no image support. The output is shared with GL
+ *    (cl_khr_gl_sharing) through TRACE_BUFFERS textures, used in turn, so
+ *    CL can write one while GL reads another. Neither side is ever
+ *    finished. Each hand-off waits only for the work on the buffer itself:
+ *
+ *          GL to CL: a fence after the composite that read the buffer.
+ *                    The acquire waits on it as a CL event
+ *                    (cl_khr_gl_event), or the CPU waits on it.
+ *          CL to GL: the event of the release. The composite waits on it
+ *                    on the GPU (GL_ARB_cl_event), or the CPU waits on it.
+ *
+ *    trace() only enqueues and flushes; it returns at once. Pipelined (the
+ *    default), composite() draws the trace of the frame before, so one
+ *    frame's kernels run beside the GL work of the frame before them, and
+ *    frame time comes to the larger of the two rather than their sum, at
+ *    one frame of latency for the crystal. setPipelined(false) draws the
+ *    trace of the same frame. The GPU still waits for it, but the CPU does
+ *    not.
+ */
+
+#ifndef RAYTRACE_HPP_
+#define RAYTRACE_HPP_
+
+#include <GL/glew.h>
+#include <CL/cl.h>
+#include <CL/cl_gl.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "./mesh.hpp"
+#include "./program.hpp"
+#include "./dynres.hpp"
+
+
+const GLint TRACE_TEXTURE_UNIT = 5;         // Unit for upsample.frag
+const int TRACE_MAX_BOUNCES = 6;            // Surfaces followed per ray
+const float TRACE_IOR = 1.5f;               // Index of refraction
+const float TRACE_MIN_SCALE = 0.25f;        // Smallest render scale
+const int TRACE_HISTORY_SAMPLES = 16;       // Most samples a pixel keeps
+const int TRACE_TEMPORAL_PERIOD = 4;        // Frames to trace every pixel
+const int TRACE_JITTER_CYCLE = 16;          // Offsets a pixel cycles over
+const size_t TRACE_TEXEL_BYTES = 32;        // TraceSample, History in .cl
+const int TRACE_BUFFERS = 2;                // Output textures used in turn
+const GLuint64 TRACE_FENCE_TIMEOUT = 100000000;   // 100 ms, in ns
+
+/**
+ * One triangle as laid out in the kernel's triangle buffer.
+ */
+typedef struct {
+  glm::vec4 v0;                             /**< xyz; w 1 if crystal */
+  glm::vec4 e1;                             /**< v1 - v0; w texture layer */
+  glm::vec4 e2;                             /**< v2 - v0 */
+  glm::vec4 uv01;                           /**< Tex coords of v0 and v1 */
+  glm::vec4 uv2;                            /**< Tex coords of v2 */
+  glm::vec4 color;                          /**< Diffuse rgb, shininess */
+} TraceTriangle;
+
+
+/**
+ * OpenCL ray tracer for the crystal, composited over the GL scene.
+ */
+class CrystalTracer {
+ public:
+  CrystalTracer();
+  ~CrystalTracer();
+
+  void setGeometry(Mesh& mesh, const glm::mat4& transform, int crystal);
+  bool init(cl_context context, cl_device_id device, cl_command_queue queue,
+            const std::string& kernelFile, int width, int height);
+  void setLight(const glm::vec3& position);
+  void setTemporal(bool enabled);
+  void setPipelined(bool enabled);
+
+  void trace(const glm::mat4& view, const glm::mat4& proj);
+  void composite(Program& upsampleProg, float zNear, float zFar);
+
+  ResolutionController& resolution();
+  int traceWidth();
+  int traceHeight();
+  double traceMillis();
+  bool temporal();
+  bool pipelined();
+  bool converging();
+  bool ready();
+
+ private:
+  /**
+   * One shared output texture, and the hand-offs of its last trace.
+   */
+  typedef struct {
+    TexInfo texture;
+    cl_mem image;
+    int width, height;                      // Part the last trace filled
+    float scale;                            // Render scale it ran at
+    cl_event traced, resolved;              // Its kernels, for timing
+    cl_event released;                      // CL done writing it
+    GLsync sampled;                         // GL done reading it
+    GLsync waited;                          // The fence its trace waited on
+  } TraceBuffer;
+
+  int width, height;
+  int traceW, traceH;
+  glm::vec3 lightPos;
+
+  std::vector<TraceTriangle> triangles;
+  std::vector<unsigned char> texels;        // RGBA8, every layer
+  std::vector<cl_int> layers;               // Offset, width, height, 0
+
+  cl_context context;
+  cl_command_queue queue;
+  cl_program program;
+  cl_kernel kernel, resolveKernel;
+  cl_mem triangleBuf, texelBuf, layerBuf;
+  cl_mem sampleBuf, historyBuf;
+
+  TraceBuffer buffers[TRACE_BUFFERS];
+  int current, previous;                    // Last two traced, or -1
+  bool pipeline;
+  bool clWaitsOnGL, glWaitsOnCL;            // Event sharing extensions
+
+  bool reuse;
+  int frame, stillFrames;
+  cl_int prevSize[2];                       // 0 when there is no history
+  glm::mat4 prevView, prevProj;
+
+  GLuint emptyVAO;
+  Uniform<glm::vec4> uTraceInfo;
+  Uniform<glm::vec4> uDepthRange;
+  GLuint upsampleId;
+
+  ResolutionController controller;
+  double millis;
+
+  bool BuildKernel(cl_device_id device, const std::string& kernelFile);
+  void Retire(TraceBuffer& buf);
+  void Release();
+};
+
+#endif /* RAYTRACE_HPP_ */
@@ -0,0 +1,584 @@
+/**
+ * scene.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <iostream>
+#include <cmath>
+
+#include <algorithm>
+
+#include "./scene.hpp"
+#include "./frustum.hpp"
+#include "./glstate.hpp"
+#include "./variants.hpp"
+#include "./startup.hpp"
+
+using namespace std;
+
+const int LOD_LEVELS = 4;                   // Reduced levels per sub-mesh
+const float LOD_RATIO = 0.5f;               // Triangles kept per level
+const float EMPTY_BOX = 1e30f;              // Padding boxes are never inside
+
+
+/**
+ * Default Constructor.
+ */
+Scene::Scene()
+: indirectID(0),
+  indirectBytes(0),
+  useMultiDraw(false),
+  nBoxes(0),
+  anyDirty(false) {
+}
+
+/**
+ * Default Destructor. Frees every owned Mesh, and every prefetched one
+ * that was never loaded (unless its job is still running).
+ */
+Scene::~Scene() {
+  for (int i = 0; i < meshes.size(); i++)
+    delete meshes[i].mesh;
+  for (int i = 0; i < prefetched.size(); i++) {
+    if (prefetched[i]->done.done()) {
+      delete prefetched[i]->entry.mesh;
+      delete prefetched[i];
+    }
+  }
+}
+
+/**
+ * Starts loading a model file in a job, for a later loadMesh() of the same
+ * file to pick up. Safe to call before any GL context exists.
+ * @param filename - the model file (including path) to be loaded
+ * @param texPath - directory where the model's textures are stored
+ */
+void Scene::prefetch(const string& filename, const string& texPath) {
+  Prefetch *p = new Prefetch;
+
+  p->filename = filename;
+  p->texPath = texPath;
+  p->loaded = false;
+  this->prefetched.push_back(p);
+
+  jobs.run([p]() {
+    p->loaded = PrepareMesh(p->filename, p->texPath, p->entry);
+  }, &p->done);
+}
+
+/**
+ * Loads a model file as a new Mesh and builds its reduced levels of detail.
+ * The Mesh is not placed in the scene until addObject() is called with the
+ * returned index. If the file was prefetch()ed, waits for that instead.
+ * @param filename - the model file (including path) to be loaded
+ * @param texPath - directory where the model's textures are stored
+ * @return the new mesh index, or -1 if loading failed
+ */
+int Scene::loadMesh(const string& filename, const string& texPath) {
+  SceneMesh entry;
+  bool loaded = false;
+  int i;
+
+  for (i = 0; i < prefetched.size(); i++) {
+    if (prefetched[i]->filename == filename &&
+        prefetched[i]->texPath == texPath)
+      break;
+  }
+
+  if (i < prefetched.size()) {
+    Prefetch *p = prefetched[i];
+
+    jobs.wait(&p->done);
+    entry = p->entry;
+    loaded = p->loaded;
+    this->prefetched.erase(prefetched.begin() + i);
+    delete p;
+  } else {
+    loaded = PrepareMesh(filename, texPath, entry);
+  }
+
+  if (!loaded)
+    return -1;
+
+  this->meshes.push_back(entry);
+
+  return meshes.size() - 1;
+}
+
+/**
+ * Reads a model file into a new Mesh with its reduced levels of detail and
+ * the shader variant of every sub-mesh. Touches no GL or Scene state, so it
+ * may run on any thread.
+ * @param filename - the model file (including path) to be loaded
+ * @param texPath - directory where the model's textures are stored
+ * @param entry - filled in; entry.mesh is NULL if loading failed
+ * @return true if loading succeeded
+ */
+bool Scene::PrepareMesh(const string& filename, const string& texPath,
+                        SceneMesh& entry) {
+  int stage = startup.begin("import " + filename);
+
+  entry.mesh = new Mesh();
+  entry.mesh->setTexturePath(texPath);
+  if (!entry.mesh->loadFile(filename)) {
+    delete entry.mesh;
+    entry.mesh = NULL;
+    startup.end(stage);
+    return false;
+  }
+  entry.mesh->buildLODs(LOD_LEVELS, LOD_RATIO);
+  entry.vaoID = 0;
+  entry.vboID = 0;
+
+  // Shader variant of every sub-mesh, and the sub-meshes sorted by it.
+  vector<SubmeshMaterial>& materials = entry.mesh->getMaterials();
+  vector<pair<unsigned, int> > order;
+  for (int i = 0; i < materials.size(); i++) {
+    entry.variants.push_back(MaterialVariant(materials[i]));
+    order.push_back(make_pair(entry.variants[i], i));
+  }
+  stable_sort(order.begin(), order.end());
+  for (int i = 0; i < order.size(); i++)
+    entry.submeshOrder.push_back(order[i].second);
+
+  startup.end(stage);
+
+  return true;
+}
+
+/**
+ * Places a copy of a loaded mesh in the scene.
+ * @param meshIdx - index returned by loadMesh()
+ * @param transform - object-to-scene transform
+ * @return the new object index
+ */
+int Scene::addObject(int meshIdx, const glm::mat4& transform) {
+  SceneObject obj;
+  int nSubmeshes = meshes[meshIdx].mesh->numIBOs();
+
+  obj.meshIdx = meshIdx;
+  obj.transform = transform;
+  obj.firstBound = nBoxes;
+  obj.dirty = true;
+  obj.lodCurrent.assign(nSubmeshes, 0);
+
+  // Boxes go in variant order, so visible draws come out grouped by it.
+  this->ResizeBounds(nBoxes + nSubmeshes);
+  for (int i = 0; i < nSubmeshes; i++) {
+    SceneDraw owner = { static_cast<int>(objects.size()),
+                        meshes[meshIdx].submeshOrder[i] };
+    boxOwner[obj.firstBound + i] = owner;
+  }
+
+  this->objects.push_back(obj);
+  this->anyDirty = true;
+
+  return objects.size() - 1;
+}
+
+/**
+ * Moves an object. Its boxes are recomputed on the next cull().
+ * @param object - index returned by addObject()
+ * @param transform - new object-to-scene transform
+ */
+void Scene::setTransform(int object, const glm::mat4& transform) {
+  objects[object].transform = transform;
+  objects[object].dirty = true;
+  this->anyDirty = true;
+}
+
+/**
+ * Pushes every mesh into GPU buffers: one interleaved VBO and one IBO per
+ * mesh, the IBO holding every LOD of every sub-mesh back to back, a VAO
+ * that binds both, plus the mesh's array texture. The client-side arrays
+ * are freed afterwards.
+ *
+ * This binds through GL directly; call glState.invalidate() afterwards.
+ */
+void Scene::upload() {
+  for (int m = 0; m < meshes.size(); m++) {
+    SceneMesh& entry = meshes[m];
+    Mesh& mesh = *entry.mesh;
+    vector<VBOVertex>& vboArray = mesh.getVBOVertexArray();
+    vector<vector<GLuint> >& iboArrays = mesh.getIBOIndexArrays();
+    int nVBO = vboArray.size();
+    int nIBOs = iboArrays.size();
+    GLuint nIndices = 0;
+
+    // Vertex Buffer Object
+    glGenBuffers(1, &entry.vboID);
+    glBindBuffer(GL_ARRAY_BUFFER, entry.vboID);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(VBOVertex)*nVBO, NULL, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(VBOVertex)*nVBO, &vboArray[0]);
+
+    // Index Buffer Object
+    for (int i = 0; i < nIBOs; i++) {
+      vector<int>& sizes = mesh.lodSizes()[i];
+
+      entry.lodFirst.push_back(vector<GLuint>());
+      for (int l = 0; l < sizes.size(); l++) {
+        entry.lodFirst[i].push_back(nIndices);
+        nIndices += sizes[l];
+      }
+    }
+
+    glGenBuffers(1, &entry.iboID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, entry.iboID);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, nIndices * sizeof(GLuint), NULL,
+        GL_STATIC_DRAW);
+    for (int i = 0; i < nIBOs; i++) {
+      vector<int>& sizes = mesh.lodSizes()[i];
+
+      glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+          entry.lodFirst[i][0] * sizeof(GLuint), sizes[0] * sizeof(GLuint),
+          &iboArrays[i][0]);
+      for (int l = 1; l < sizes.size(); l++) {
+        vector<GLuint>& lod = mesh.getLODIndexArrays()[i][l - 1];
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+            entry.lodFirst[i][l] * sizeof(GLuint), sizes[l] * sizeof(GLuint),
+            &lod[0]);
+      }
+    }
+
+    // Vertex Array Object
+    this->BuildVertexArray(entry);
+
+    // Array texture on unit 0.
+    mesh.uploadTextures(0);
+
+    // Data should now be in GPU memory (server-side), so free heap memory.
+    mesh.freeArrays();
+  }
+
+  // Command buffer for indirect draws, grown on demand in buildCommands().
+  this->useMultiDraw = GLEW_ARB_multi_draw_indirect;
+  if (useMultiDraw)
+    glGenBuffers(1, &indirectID);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Rebuilds the visible draw list by testing every packed box against the
+ * six planes of the frustum (see Frustum::cullBoxes()), then, if given,
+ * against the occlusion pyramid.
+ * @param viewProj - combined projection and model matrix (mProj * mModel)
+ * @param occlusion - culler already rendered this frame, or NULL
+ */
+void Scene::cull(const glm::mat4& viewProj, OcclusionCuller *occlusion) {
+  Frustum frustum(viewProj);
+
+  if (anyDirty) {
+    for (int i = 0; i < objects.size(); i++) {
+      if (objects[i].dirty)
+        this->UpdateBounds(i);
+    }
+    this->anyDirty = false;
+  }
+
+  this->draws.clear();
+  this->inside.clear();
+  if (!nBoxes)
+    return;
+  frustum.cullBoxes(&minX[0], &minY[0], &minZ[0], &maxX[0], &maxY[0], &maxZ[0],
+                    nBoxes, inside);
+  if (occlusion)
+    occlusion->filterBoxes(&minX[0], &minY[0], &minZ[0], &maxX[0], &maxY[0],
+                           &maxZ[0], inside);
+
+  for (int i = 0; i < inside.size(); i++)
+    this->draws.push_back(boxOwner[inside[i]]);
+}
+
+/**
+ * Turns the visible list from cull() into indirect draw commands, one per
+ * sub-mesh at its selected LOD, grouped into one batch per object and
+ * shader variant, and writes them to the GPU command buffer.
+ * @param model - the scene's modelview matrix (mModel)
+ * @param proj - the projection matrix
+ * @param fixedLOD - level to draw everything at (or each sub-mesh's
+ *                   coarsest, if it has fewer), leaving the per-object LOD
+ *                   state alone; -1 to pick by screen size
+ */
+void Scene::buildCommands(const glm::mat4& model, const glm::mat4& proj,
+                          int fixedLOD) {
+  int nDraws = draws.size();
+
+  this->commands.clear();
+  this->drawBatches.clear();
+
+  for (int i = 0; i < nDraws; i++) {
+    SceneObject& obj = objects[draws[i].object];
+    SceneMesh& entry = meshes[obj.meshIdx];
+    int sub = draws[i].submesh;
+    unsigned variant = entry.variants[sub];
+    float opacity = entry.mesh->getMaterials()[sub].opacity;
+
+    // Opacity is a uniform, so transparent sub-meshes only share a batch
+    // when they share an opacity.
+    if (drawBatches.empty() || drawBatches.back().object != draws[i].object ||
+        drawBatches.back().variant != variant ||
+        drawBatches.back().opacity != opacity) {
+      DrawBatch batch = { draws[i].object, variant, opacity,
+                          static_cast<int>(commands.size()), 0 };
+      this->drawBatches.push_back(batch);
+    }
+
+    int lod = (fixedLOD >= 0) ?
+        min(fixedLOD, entry.mesh->numLODs(sub) - 1) :
+        this->selectLOD(draws[i].object, sub, model * obj.transform, proj);
+    DrawCommand cmd;
+    cmd.count = entry.mesh->lodSizes()[sub][lod];
+    cmd.instanceCount = 1;
+    cmd.firstIndex = entry.lodFirst[sub][lod];
+    cmd.baseVertex = 0;
+    cmd.baseInstance = 0;
+
+    this->commands.push_back(cmd);
+    this->drawBatches.back().numCommands++;
+  }
+
+  if (!useMultiDraw || commands.empty())
+    return;
+
+  // Orphan and refill the command buffer; grow it only when needed.
+  GLsizeiptr bytes = commands.size() * sizeof(DrawCommand);
+  glState.bindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectID);
+  if (bytes > indirectBytes) {
+    this->indirectBytes = bytes;
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, bytes, &commands[0], GL_STREAM_DRAW);
+  } else {
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectBytes, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, &commands[0]);
+  }
+}
+
+/**
+ * Issues every command of one batch. The caller must have enabled the
+ * batch's shader variant and bound its VAO, array texture, and object
+ * matrices.
+ * Without ARB_multi_draw_indirect this falls back to one glDrawElements()
+ * per command, still from the same index buffer and texture.
+ * @param batch - index into batches()
+ */
+void Scene::drawBatch(int batch) {
+  DrawBatch& b = drawBatches[batch];
+
+  if (useMultiDraw) {
+    glState.bindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectID);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+        OFFSET_PTR(b.firstCommand * sizeof(DrawCommand)), b.numCommands, 0);
+    glState.countDraw();
+  } else {
+    for (int i = 0; i < b.numCommands; i++) {
+      DrawCommand& cmd = commands[b.firstCommand + i];
+      glDrawElements(GL_TRIANGLES, cmd.count, GL_UNSIGNED_INT,
+          OFFSET_PTR(cmd.firstIndex * sizeof(GLuint)));
+      glState.countDraw();
+    }
+  }
+}
+
+/**
+ * Picks the detail level for a sub-mesh from its projected size. Each level
+ * halves the triangles, so each halving of on-screen height drops one level.
+ * The level only changes once the size has moved LOD_HYSTERESIS of a level
+ * past the boundary, which keeps a mesh from popping back and forth while
+ * the user zooms (vEye.z) across a threshold.
+ * @param object - index of the object being drawn
+ * @param submesh - index of the sub-mesh within the object's mesh
+ * @param modelview - the object's full modelview matrix
+ * @param proj - the projection matrix
+ * @return the detail level to draw
+ */
+int Scene::selectLOD(int object, int submesh, const glm::mat4& modelview,
+                     const glm::mat4& proj) {
+  SceneObject& obj = objects[object];
+  Mesh& mesh = *meshes[obj.meshIdx].mesh;
+  SubmeshBounds& b = mesh.getBounds()[submesh];
+
+  return levelForSize(b, modelview, proj, mesh.numLODs(submesh),
+                      obj.lodCurrent[submesh]);
+}
+
+/**
+ * The screen-size LOD rule shared by every LOD user. See selectLOD().
+ * @param b - object-space bounds of what is being drawn
+ * @param modelview - its full modelview matrix
+ * @param proj - the projection matrix
+ * @param nLevels - number of levels available
+ * @param current - the level drawn last frame; updated in place
+ * @return the detail level to draw
+ */
+int Scene::levelForSize(const SubmeshBounds& b, const glm::mat4& modelview,
+                        const glm::mat4& proj, int nLevels, int& current) {
+  if (nLevels < 2) {
+    current = 0;
+    return current;
+  }
+
+  // Projected height as a fraction of the viewport. proj[1][1] is the
+  // focal scale cot(fovy/2); depth is the view-space distance to the center.
+  glm::vec4 center = modelview * glm::vec4(b.center, 1.0f);
+  float scale = glm::length(glm::vec3(modelview[0]));
+  float radius = b.radius * scale;
+  float depth = -center.z;
+  if (depth <= radius) {
+    current = 0;
+    return current;
+  }
+  float coverage = (radius * proj[1][1]) / depth;
+
+  // Continuous level: 0 at full coverage, +1 per halving.
+  float level = glm::log2(LOD_FULL_COVERAGE / coverage);
+  int target = static_cast<int>(glm::floor(level));
+  target = target < 0 ? 0 : (target >= nLevels ? nLevels - 1 : target);
+
+  if (target > current && level >= target + LOD_HYSTERESIS)
+    current = target;
+  else if (target < current && level <= current - LOD_HYSTERESIS)
+    current = target;
+
+  return current;
+}
+
+/**
+ * Transforms an object-space box into a box around its transformed
+ * corners. Uses the center and extent form so that each box costs one
+ * matrix multiply rather than eight: the new extent is |M| applied to the
+ * old extent.
+ * @param lo, hi - object-space box corners
+ * @param M - object-to-scene transform
+ * @param outLo, outHi - receive the scene-space box corners
+ */
+void Scene::transformBox(const glm::vec3& lo, const glm::vec3& hi,
+                         const glm::mat4& M, glm::vec3& outLo,
+                         glm::vec3& outHi) {
+  glm::vec3 c = glm::vec3(M * glm::vec4((lo + hi) * 0.5f, 1.0f));
+  glm::vec3 e = (hi - lo) * 0.5f;
+  glm::vec3 w;
+
+  for (int r = 0; r < 3; r++) {
+    w[r] = fabs(M[0][r]) * e.x + fabs(M[1][r]) * e.y + fabs(M[2][r]) * e.z;
+  }
+
+  outLo = c - w;
+  outHi = c + w;
+}
+
+/**
+ * Retrieves the number of loaded meshes.
+ * @return number of meshes
+ */
+int Scene::numMeshes() {
+  return this->meshes.size();
+}
+
+/**
+ * Retrieves the number of placed objects.
+ * @return number of objects
+ */
+int Scene::numObjects() {
+  return this->objects.size();
+}
+
+/**
+ * Retrieves a loaded mesh and its GPU buffers.
+ * @param meshIdx - index returned by loadMesh()
+ * @return reference to the SceneMesh
+ */
+SceneMesh& Scene::getMesh(int meshIdx) {
+  return this->meshes[meshIdx];
+}
+
+/**
+ * Retrieves a placed object.
+ * @param object - index returned by addObject()
+ * @return reference to the SceneObject
+ */
+SceneObject& Scene::getObject(int object) {
+  return this->objects[object];
+}
+
+/**
+ * Retrieves the draws that passed the last cull(), ordered by object and
+ * then by sub-mesh variant.
+ * @return reference to an STL vector of visible SceneDraws
+ */
+vector<SceneDraw>& Scene::visible() {
+  return this->draws;
+}
+
+/**
+ * Retrieves the per-object, per-variant batches built by the last
+ * buildCommands().
+ * @return reference to an STL vector of DrawBatches
+ */
+vector<DrawBatch>& Scene::batches() {
+  return this->drawBatches;
+}
+
+/**
+ * Records a mesh's vertex layout (see VBOVertex) and index buffer in a new
+ * VAO. Attribute locations match the bindAttribute() calls in ShaderInit().
+ */
+void Scene::BuildVertexArray(SceneMesh& entry) {
+  glGenVertexArrays(1, &entry.vaoID);
+  glBindVertexArray(entry.vaoID);
+
+  glBindBuffer(GL_ARRAY_BUFFER, entry.vboID);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(0));
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(12));
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(24));
+  glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(32));
+  glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(44));
+  glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(56));
+  glVertexAttribPointer(6, 1, GL_FLOAT, GL_FALSE, sizeof(VBOVertex), OFFSET_PTR(60));
+  for (int i = 0; i < 7; i++)
+    glEnableVertexAttribArray(i);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, entry.iboID);
+  glBindVertexArray(0);
+}
+
+/**
+ * Transforms an object's sub-mesh boxes into scene space.
+ */
+void Scene::UpdateBounds(int object) {
+  SceneObject& obj = objects[object];
+  SceneMesh& entry = meshes[obj.meshIdx];
+  vector<SubmeshBounds>& bounds = entry.mesh->getBounds();
+
+  for (int i = 0; i < bounds.size(); i++) {
+    int b = obj.firstBound + i;
+    int sub = entry.submeshOrder[i];
+    glm::vec3 lo, hi;
+
+    transformBox(bounds[sub].min, bounds[sub].max, obj.transform, lo, hi);
+    minX[b] = lo.x;  maxX[b] = hi.x;
+    minY[b] = lo.y;  maxY[b] = hi.y;
+    minZ[b] = lo.z;  maxZ[b] = hi.z;
+  }
+
+  obj.dirty = false;
+}
+
+/**
+ * Grows the packed box arrays to hold count boxes, keeping the storage a
+ * multiple of four and the padding boxes empty.
+ */
+void Scene::ResizeBounds(int count) {
+  int padded = (count + 3) & ~3;
+
+  minX.resize(padded, EMPTY_BOX);  maxX.resize(padded, -EMPTY_BOX);
+  minY.resize(padded, EMPTY_BOX);  maxY.resize(padded, -EMPTY_BOX);
+  minZ.resize(padded, EMPTY_BOX);  maxZ.resize(padded, -EMPTY_BOX);
+  boxOwner.resize(padded);
+
+  this->nBoxes = count;
+}
@@ -0,0 +1,195 @@
+/**
+ * scene.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  A Scene owns every loaded Mesh along with its GPU buffers, and any
+ *  number of placed objects that reference those meshes with their own
+ *  transforms.
+ *
+ *  Notes:
+ *
+ *    The intended order of use is:
+ *
+ *          prefetch()          // optionally, to load in the background
+ *          loadMesh()          // once per model file
+ *          addObject()         // as many copies of each mesh as you need
+ *          upload()            // once a GL context exists
+ *          cull()              // every frame, then draw visible()
+ *
+ *    World-space boxes for every (object, sub-mesh) pair are kept packed
+ *    as separate min/max coordinate arrays so that culling can test four
+ *    boxes per plane at once with SSE (see Frustum). Boxes are only
+ *    recomputed for objects whose transform changed.
+ *
+ *    The frustum is taken from the combined projection and model matrices
+ *    (mProj * mModel), so the boxes live in the scene's own space. Boxes
+ *    that survive it can also be tested against an OcclusionCuller.
+ *
+ *    Every sub-mesh and LOD of a mesh lives in one index buffer, and all of
+ *    its textures in one array texture, so the visible sub-meshes of an
+ *    object are drawn by a single glMultiDrawElementsIndirect() reading
+ *    commands written to a GPU buffer by buildCommands(). The number of API
+ *    calls per object no longer depends on how many materials it has.
+ *
+ *    Each mesh also gets a vertex array object holding its attribute
+ *    layout and index buffer, so drawing it only needs that VAO bound.
+ *
+ *    Every sub-mesh is given a shader variant from its material (see
+ *    MaterialVariant()). An object's boxes are packed in variant order, so
+ *    its visible sub-meshes come out of cull() already grouped and each
+ *    batch needs only one program.
+ *
+ *    Loading needs no GL context. prefetch() starts the import, texture
+ *    decoding and LOD building of a file as a job, and the later
+ *    loadMesh() of the same file waits for that job instead of starting
+ *    over, so files can load while the window and contexts are created.
+ */
+
+#ifndef SCENE_HPP_
+#define SCENE_HPP_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "./mesh.hpp"
+#include "./occlusion.hpp"
+#include "./jobs.hpp"
+
+
+const float LOD_FULL_COVERAGE = 0.5f;       // Screen height fraction for LOD0
+const float LOD_HYSTERESIS = 0.2f;          // Fraction of a level to overshoot
+
+/**
+ * A loaded Mesh and the buffers it was uploaded to.
+ */
+typedef struct {
+  Mesh *mesh;                                 /**< Owned mesh data */
+  GLuint vaoID;                               /**< Attributes and IBO */
+  GLuint vboID;                               /**< Shared vertex buffer */
+  GLuint iboID;                               /**< All sub-meshes and LODs */
+  std::vector<std::vector<GLuint> > lodFirst; /**< First index per sub/LOD */
+  std::vector<unsigned> variants;             /**< Shader variant per sub */
+  std::vector<int> submeshOrder;              /**< Sub-meshes by variant */
+} SceneMesh;
+
+/**
+ * One placed instance of a SceneMesh.
+ */
+typedef struct {
+  int meshIdx;                                /**< Index into Scene meshes */
+  glm::mat4 transform;                        /**< Object to scene space */
+  int firstBound;                             /**< First packed box */
+  bool dirty;                                 /**< Boxes need recomputing */
+  std::vector<int> lodCurrent;                /**< Current LOD per sub-mesh */
+} SceneObject;
+
+/**
+ * A single sub-mesh draw that survived culling.
+ */
+typedef struct {
+  int object;                                 /**< Index into Scene objects */
+  int submesh;                                /**< Sub-mesh (IBO) index */
+} SceneDraw;
+
+
+/**
+ * Layout of one indirect draw, as read by glMultiDrawElementsIndirect().
+ */
+typedef struct {
+  GLuint count;                               /**< Index count */
+  GLuint instanceCount;                       /**< Instances to draw */
+  GLuint firstIndex;                          /**< Offset into the IBO */
+  GLint baseVertex;                           /**< Added to every index */
+  GLuint baseInstance;                        /**< First instance ID */
+} DrawCommand;
+
+/**
+ * A run of consecutive commands that all belong to one object and are drawn
+ * with the same shader variant (and, if transparent, the same opacity).
+ */
+typedef struct {
+  int object;                                 /**< Index into Scene objects */
+  unsigned variant;                           /**< VARIANT_* key */
+  float opacity;                              /**< Material opacity */
+  int firstCommand;                           /**< Offset into commands */
+  int numCommands;                            /**< Commands in the run */
+} DrawBatch;
+
+
+/**
+ * Container for every mesh and object to be rendered.
+ */
+class Scene {
+ public:
+  Scene();
+  ~Scene();
+
+  void prefetch(const std::string& filename, const std::string& texPath);
+  int loadMesh(const std::string& filename, const std::string& texPath);
+  int addObject(int meshIdx, const glm::mat4& transform);
+  void setTransform(int object, const glm::mat4& transform);
+  void upload();
+
+  void cull(const glm::mat4& viewProj, OcclusionCuller *occlusion = NULL);
+  void buildCommands(const glm::mat4& model, const glm::mat4& proj,
+                     int fixedLOD = -1);
+  void drawBatch(int batch);
+  int selectLOD(int object, int submesh, const glm::mat4& modelview,
+                const glm::mat4& proj);
+
+  static int levelForSize(const SubmeshBounds& b, const glm::mat4& modelview,
+                          const glm::mat4& proj, int nLevels, int& current);
+  static void transformBox(const glm::vec3& lo, const glm::vec3& hi,
+                           const glm::mat4& M, glm::vec3& outLo,
+                           glm::vec3& outHi);
+
+  int numMeshes();
+  int numObjects();
+  SceneMesh& getMesh(int meshIdx);
+  SceneObject& getObject(int object);
+  std::vector<SceneDraw>& visible();
+  std::vector<DrawBatch>& batches();
+
+ private:
+  /**
+   * A mesh being loaded by a job, ahead of its loadMesh().
+   */
+  typedef struct {
+    std::string filename, texPath;
+    SceneMesh entry;
+    bool loaded;
+    JobCounter done;
+  } Prefetch;
+
+  std::vector<SceneMesh> meshes;
+  std::vector<Prefetch *> prefetched;
+  std::vector<SceneObject> objects;
+  std::vector<SceneDraw> draws;
+  std::vector<DrawCommand> commands;
+  std::vector<DrawBatch> drawBatches;
+  GLuint indirectID;
+  GLsizeiptr indirectBytes;
+  bool useMultiDraw;
+
+  // Packed world-space boxes, padded to a multiple of four.
+  std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+  std::vector<SceneDraw> boxOwner;
+  std::vector<int> inside;
+  int nBoxes;
+  bool anyDirty;
+
+  static bool PrepareMesh(const std::string& filename,
+                          const std::string& texPath, SceneMesh& entry);
+  void BuildVertexArray(SceneMesh& entry);
+  void UpdateBounds(int object);
+  void ResizeBounds(int count);
+};
+
+#endif /* SCENE_HPP_ */
@@ -1,5 +1,21 @@
 #version 420
 
+// Variants (see variants.hpp):
+//   TEXTURED         - modulate the diffuse term by the array texture
+//   LIGHTING_BLINN   - Blinn-Phong specular (half vector)
+//   LIGHTING_UNLIT   - no lighting; texture or diffuse color as is
+//   otherwise        - Phong specular (reflection vector)
+//   CLUSTERED_LIGHTS - add the point lights binned into this fragment's
+//                      cluster (see cluster.hpp)
+//   TRANSPARENT      - write weighted blended transparency targets instead
+//                      of a color (see oit.hpp)
+//   ENVIRONMENT      - reflect and refract the environment probe's cube
+//                      map, mixed by a Fresnel term (see probe.hpp)
+
+#ifdef CLUSTERED_LIGHTS
+#extension GL_ARB_shader_storage_buffer_object : require
+#endif
+
 layout (std140) uniform Light {
     vec3 lightPos;
     vec3 lightAmb;
@@ -7,7 +23,46 @@ layout (std140) uniform Light {
     vec3 lightSpec;
 };
 
-uniform sampler2D tex;
+#ifdef TEXTURED
+uniform sampler2DArray tex;
+#endif
+
+#if defined(CLUSTERED_LIGHTS) || defined(ENVIRONMENT)
+layout (std140) uniform Frame {
+    mat4 projectionMatrix;
+    mat4 viewMatrix;
+    vec4 viewport;
+};
+#endif
+
+#ifdef ENVIRONMENT
+uniform samplerCube envMap;
+uniform vec4 envProbe;                      // Scene-space center, radius
+
+const float crystalIOR = 1.5;
+#endif
+
+#ifdef CLUSTERED_LIGHTS
+// Must match CLUSTER_X, CLUSTER_Y, CLUSTER_Z in cluster.hpp.
+const uvec3 clusterGrid = uvec3(16, 9, 24);
+
+struct PointLight {
+    vec4 positionRadius;
+    vec4 color;
+};
+
+layout(std430, binding = 5) readonly buffer Lights {
+    PointLight lights[];
+};
+
+layout(std430, binding = 6) readonly buffer Clusters {
+    uvec2 clusters[];
+};
+
+layout(std430, binding = 7) readonly buffer LightIndices {
+    uint lightIndex[];
+};
+#endif
 
 in vec3 v;
 in vec3 N;
@@ -15,29 +70,133 @@ in vec2 texCoord;
 in vec3 matDiff;
 in vec3 matSpec;
 in float shiny;
+flat in float texLayer;
+
+#ifdef TRANSPARENT
+uniform float opacity;
 
+layout(location = 0) out vec4 accumColor;
+layout(location = 1) out float revealage;
+
+// Depth weight (McGuire and Bavoil 2013, eq. 9) on eye-space distance:
+// falls off with the fourth power of distance, so near surfaces dominate,
+// and the clamp keeps the sums within what a half float target can hold.
+// Window depth would not do; it is nearly 1 for all but the nearest
+// surfaces.
+float Weight(float eyeZ, float alpha) {
+    return alpha * clamp(0.03 / (1e-5 + pow(abs(eyeZ) / 200.0, 4.0)),
+                         1e-2, 3e3);
+}
+#else
 out vec4 phongColor;
+#endif
+
+float Specular(vec3 L, vec3 V) {
+#ifdef LIGHTING_BLINN
+    vec3 H = normalize(L + V);
+    return pow(max(dot(N, H), 0.0), shiny);
+#else
+    vec3 R = normalize(reflect(-L, N));
+    return pow(max(dot(R, V), 0.0), shiny);
+#endif
+}
+
+#ifdef ENVIRONMENT
+// Direction from the probe to where the ray from p along d leaves the
+// probe's sphere, so that nearby points do not all see the same texel.
+vec3 ProbeDirection(vec3 p, vec3 d) {
+    vec3 o = p - envProbe.xyz;
+    float b = dot(o, d);
+    float h = b * b - dot(o, o) + envProbe.w * envProbe.w;
+
+    if (h < 0.0)
+        return d;
+    return o + d * (sqrt(h) - b);
+}
+#endif
+
+#ifdef CLUSTERED_LIGHTS
+uint ClusterIndex() {
+    // Tiles are even in screen space, slices exponential in depth.
+    uvec2 tile = uvec2(gl_FragCoord.xy / viewport.xy * vec2(clusterGrid.xy));
+    float slice = log(-v.z / viewport.z) / log(viewport.w / viewport.z);
+    uint z = uint(clamp(slice * float(clusterGrid.z), 0.0, float(clusterGrid.z - 1u)));
+
+    tile = min(tile, clusterGrid.xy - 1u);
+    return (z * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
+}
+#endif
 
 void main() {
+    vec3 color;
     vec3 ambient;
     vec3 diffuse;
     vec3 specular;
-    vec4 texture;
+    vec4 texColor;
     
+#ifdef TEXTURED
+    texColor = texture(tex, vec3(texCoord.s, texCoord.t, texLayer));
+#else
+    texColor = vec4(1.0);
+#endif
+
+#ifdef LIGHTING_UNLIT
+    color = matDiff * texColor.rgb;
+#else
     vec3 L = normalize(lightPos - v);
-    vec3 R = normalize(reflect(-L, N));
     vec3 V = normalize(-v);
     
     ambient = lightAmb * vec3(0.15, 0.15, 0.15);
     
     diffuse = clamp(lightDiff * matDiff * max(dot(N, L), 0.0), 0.0, 1.0);
-    if (texCoord.s + texCoord.t > 0) {
-      texture = texture2D(tex, vec2(texCoord.s, texCoord.t));
-    } else {
-      texture = vec4(1.0);
-    }
     
-    specular = clamp(lightSpec * matSpec * pow(max(dot(R, V), 0.0), shiny), 0.0, 1.0);
+    specular = clamp(lightSpec * matSpec * Specular(L, V), 0.0, 1.0);
+
+#ifdef CLUSTERED_LIGHTS
+    // Only the lights that can reach this cluster.
+    uvec2 range = clusters[ClusterIndex()];
+    for (uint i = range.x; i < range.x + range.y; i++) {
+        PointLight p = lights[lightIndex[i]];
+        vec3 toLight = p.positionRadius.xyz - v;
+        float dist = length(toLight);
+        float falloff = clamp(1.0 - dist / p.positionRadius.w, 0.0, 1.0);
+        vec3 Lp = toLight / dist;
+
+        falloff *= falloff;
+        diffuse += p.color.rgb * matDiff * max(dot(N, Lp), 0.0) * falloff;
+        specular += p.color.rgb * matSpec * Specular(Lp, V) * falloff;
+    }
+#endif
     
-    phongColor = vec4(clamp(ambient + (diffuse * texture.rgb) + specular, 0.0, 1.0), 1.0);   
+    color = clamp(ambient + (diffuse * texColor.rgb) + specular, 0.0, 1.0);
+#endif
+
+#ifdef ENVIRONMENT
+    // The view matrix is rigid, so its inverse is a transpose and a shift.
+    mat3 toScene = transpose(mat3(viewMatrix));
+    vec3 p = toScene * (v - viewMatrix[3].xyz);
+    vec3 I = normalize(v);
+    vec3 Nf = dot(N, I) > 0.0 ? -N : N;
+    vec3 dReflect = toScene * reflect(I, Nf);
+    vec3 dRefract = toScene * refract(I, Nf, 1.0 / crystalIOR);
+    vec3 reflected = texture(envMap, ProbeDirection(p, dReflect)).rgb;
+    vec3 refracted = texture(envMap, ProbeDirection(p, dRefract)).rgb;
+    float fresnel = 0.04 + 0.96 * pow(1.0 - max(dot(-I, Nf), 0.0), 5.0);
+    vec3 tint = mix(vec3(1.0), matDiff * texColor.rgb, 0.5);
+
+    color = mix(refracted * tint, reflected, fresnel);
+#ifndef LIGHTING_UNLIT
+    color = clamp(color + specular, 0.0, 1.0);
+#endif
+#endif
+
+#ifdef TRANSPARENT
+    // Order-independent: blended additively (accumColor) and
+    // multiplicatively (revealage) by WeightedOIT.
+    float alpha = opacity * texColor.a;
+    accumColor = vec4(color * alpha, alpha) * Weight(v.z, alpha);
+    revealage = alpha;
+#else
+    phongColor = vec4(color, 1.0);
+#endif
 }
@@ -1,14 +1,38 @@
 #version 420
 
+// Variants (see variants.hpp):
+//   INSTANCED - model matrices come from the Instances buffer; the normal
+//               matrix is taken as their upper 3x3, so instance transforms
+//               must be rigid (rotation, translation, uniform scale).
+//   otherwise - modelviewMatrix and normalMatrix are set per object.
+
+#ifdef INSTANCED
+#extension GL_ARB_shader_storage_buffer_object : require
+#endif
+
 in vec3 vertexLocation;
 in vec3 vertexNormal;
 in vec2 vertexTexCoord;
 in vec3 vertexMatDiffuse;
 in vec3 vertexMatSpecular;
 in float vertexShininess;
+in float vertexTexLayer;
+
+layout (std140) uniform Frame {
+    mat4 projectionMatrix;
+    mat4 viewMatrix;
+    vec4 viewport;
+};
 
+#ifdef INSTANCED
+// One LOD bucket of visible instances, bound by InstanceGroup::draw().
+layout(std430, binding = 0) readonly buffer Instances {
+    mat4 instanceMatrix[];
+};
+#else
 uniform mat4 modelviewMatrix;
-uniform mat4 projectionMatrix;
+uniform mat3 normalMatrix;
+#endif
 
 out vec3 v;
 out vec3 N;
@@ -16,11 +40,15 @@ out vec2 texCoord;
 out vec3 matDiff;
 out vec3 matSpec;
 out float shiny;
+flat out float texLayer;
 
 void main() {
+#ifdef INSTANCED
+    mat4 modelviewMatrix = viewMatrix * instanceMatrix[gl_InstanceID];
+    mat3 normalMatrix = mat3(modelviewMatrix);
+#endif
     vec4 vLoc = vec4(vertexLocation, 1.0);
     vec3 newNormal = vec3(-vertexNormal.x, -vertexNormal.y, -vertexNormal.z);
-    mat3 normalMatrix = mat3(transpose(inverse(modelviewMatrix)));
 
     v = (modelviewMatrix * vLoc).xyz;
     N = normalize(normalMatrix * newNormal);
@@ -29,6 +57,7 @@ void main() {
     matDiff = vertexMatDiffuse;
     matSpec = vertexMatSpecular;
     shiny = vertexShininess;
+    texLayer = vertexTexLayer;
         
     gl_Position = projectionMatrix * modelviewMatrix * vLoc;
 }
@@ -7,10 +7,14 @@
  *  Contributors: [none]
  */
 
+#include <sys/stat.h>
+
 #include "./shaderobj.hpp"
 
 using namespace std;
 
+map<string, Shader::CachedSource> Shader::cache;
+mutex Shader::cacheLock;
 
 /**
  * Primary Constructor.
@@ -20,7 +24,8 @@ Shader::Shader(string fName, int type)
   shaderId(0),
   shaderType(type),
   sourceString(""),
-  valid(0) {
+  valid(0),
+  modified(0) {
   this->fileToString();
 }
 
@@ -63,6 +68,30 @@ string& Shader::source() {
   return this->sourceString;
 }
 
+/**
+ * Accessor function for the source file name.
+ * @return the file name given at construction
+ */
+string& Shader::file() {
+  return this->fileName;
+}
+
+/**
+ * Checks whether the source file has been written since it was read or
+ * last checked. Each change is reported once. Only stats the file; the
+ * source is not reloaded.
+ * @return true if the file's modification time has changed
+ */
+bool Shader::changedOnDisk() {
+  time_t now = ModifiedTime(this->fileName);
+
+  if (!now || now == this->modified)
+    return false;
+
+  this->modified = now;
+  return true;
+}
+
 /**
  * Used by Program object to check valid loading of the shader file.
  * @return 1 if successful or 0 if invalid file
@@ -71,17 +100,80 @@ int Shader::isValid() {
   return this->valid;
 }
 
+/**
+ * Reads a shader file ahead of time, on any thread, so that the Shader
+ * constructed from it later takes the text from memory. Programs built in
+ * many variants read each file once this way.
+ * @param fName - the shader file
+ */
+void Shader::prefetch(const string& fName) {
+  CachedSource entry;
+
+  if (ReadSource(fName, entry.source, entry.modified)) {
+    lock_guard<mutex> guard(cacheLock);
+    cache[fName] = entry;
+  }
+}
+
 /**
  * Converts the shader source file to a string for loading by the program.
+ * The cached text is used if the file has not been modified since.
  */
 void Shader::fileToString() {
-  fstream shaderFile(this->fileName.c_str(), ios::in);
+  CachedSource entry;
 
-  if (shaderFile.is_open()) {
-    ostringstream buffer;
-    buffer << shaderFile.rdbuf();
-    this->sourceString = string(buffer.str());
+  this->modified = ModifiedTime(this->fileName);
+  {
+    lock_guard<mutex> guard(cacheLock);
+    map<string, CachedSource>::iterator it = cache.find(this->fileName);
+    if (it != cache.end() && modified && it->second.modified == modified) {
+      this->sourceString = it->second.source;
+      this->valid = 1;
+      return;
+    }
+  }
+
+  if (ReadSource(this->fileName, entry.source, entry.modified)) {
+    this->sourceString = entry.source;
+    this->modified = entry.modified;
     this->valid = 1;
+
+    lock_guard<mutex> guard(cacheLock);
+    cache[fileName] = entry;
   }
 }
 
+/**
+ * Reads a whole file.
+ * @param fName - the file to read
+ * @param source - set to the file's text
+ * @param modified - set to its modification time, taken before reading
+ * @return true if the file could be opened
+ */
+bool Shader::ReadSource(const string& fName, string& source,
+                        time_t& modified) {
+  modified = ModifiedTime(fName);
+  fstream shaderFile(fName.c_str(), ios::in);
+
+  if (!shaderFile.is_open())
+    return false;
+
+  ostringstream buffer;
+  buffer << shaderFile.rdbuf();
+  source = buffer.str();
+
+  return true;
+}
+
+/**
+ * Returns a file's modification time, or 0 if it cannot be read.
+ */
+time_t Shader::ModifiedTime(const string& fName) {
+  struct stat info;
+
+  if (stat(fName.c_str(), &info))
+    return 0;
+
+  return info.st_mtime;
+}
+
@@ -23,6 +23,9 @@
 #define SHADEROBJ_HPP_
 
 #include <GL/glew.h>
+#include <ctime>
+#include <map>
+#include <mutex>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -37,16 +40,36 @@ class Shader {
   GLenum id();
   GLuint type();
   std::string& source();
+  std::string& file();
   int isValid();
+  bool changedOnDisk();
+
+  static void prefetch(const std::string& fName);
 
  private:
+  /**
+   * A source file's text as of its modification time.
+   */
+  typedef struct {
+    std::string source;
+    time_t modified;
+  } CachedSource;
+
+
   GLenum shaderId;
   GLuint shaderType;
   std::string fileName;
   std::string sourceString;
   int valid;
+  time_t modified;
 
   void fileToString();
+  static bool ReadSource(const std::string& fName, std::string& source,
+                         time_t& modified);
+  static time_t ModifiedTime(const std::string& fName);
+
+  static std::map<std::string, CachedSource> cache;
+  static std::mutex cacheLock;
 };
 
 #endif /* SHADER_HPP_ */
@@ -0,0 +1,369 @@
+/**
+ * simplify.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "./simplify.hpp"
+
+using namespace std;
+
+const double BOUNDARY_WEIGHT = 1000.0;      // Penalty for moving open edges
+const float FOLD_TOLERANCE = 0.2f;          // Min cos between old/new normals
+const int MIN_LOD_TRIANGLES = 8;            // Don't bother below this
+
+
+/**
+ * Lexicographic position ordering so that coincident corners sort together.
+ */
+struct PositionLess {
+  bool operator()(const pair<glm::vec3, GLuint>& a,
+                  const pair<glm::vec3, GLuint>& b) const {
+    if (a.first.x != b.first.x) return a.first.x < b.first.x;
+    if (a.first.y != b.first.y) return a.first.y < b.first.y;
+    if (a.first.z != b.first.z) return a.first.z < b.first.z;
+    return a.second < b.second;
+  }
+};
+
+/**
+ * Builds a plane quadric (n.p + d)^2 scaled by weight.
+ */
+static void PlaneQuadric(Quadric& Q, glm::vec3 n, float d, double w) {
+  double a = n.x, b = n.y, c = n.z, e = d;
+
+  Q.q[0] = w*a*a; Q.q[1] = w*a*b; Q.q[2] = w*a*c; Q.q[3] = w*a*e;
+  Q.q[4] = w*b*b; Q.q[5] = w*b*c; Q.q[6] = w*b*e;
+  Q.q[7] = w*c*c; Q.q[8] = w*c*e;
+  Q.q[9] = w*e*e;
+}
+
+static void AddQuadric(Quadric& Q, const Quadric& R) {
+  for (int i = 0; i < 10; i++)
+    Q.q[i] += R.q[i];
+}
+
+/**
+ * Evaluates v^T Q v for the homogeneous point (p, 1).
+ */
+static double QuadricError(const Quadric& Q, const Quadric& R, glm::vec3 p) {
+  double q[10];
+  double x = p.x, y = p.y, z = p.z;
+
+  for (int i = 0; i < 10; i++)
+    q[i] = Q.q[i] + R.q[i];
+
+  return q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x
+       + q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y
+       + q[7]*z*z + 2*q[8]*z
+       + q[9];
+}
+
+
+/**
+ * Primary Constructor. Welds the sub-mesh and builds the initial quadrics
+ * and collapse queue.
+ * @param vbo - the interleaved vertex array shared by all levels
+ * @param ibo - the full-detail index array of one sub-mesh
+ */
+Simplifier::Simplifier(const vector<VBOVertex>& vbo, const vector<GLuint>& ibo)
+: liveTris(0) {
+  this->Weld(vbo, ibo);
+  this->ComputeQuadrics();
+
+  // Each interior edge is seen from both sides; queue it once.
+  vector<pair<GLuint, GLuint> > edges;
+  for (int i = 0; i < tris.size(); i++) {
+    Triangle& t = tris[i];
+    if (t.removed)
+      continue;
+    for (int k = 0; k < 3; k++) {
+      GLuint a = t.v[k], b = t.v[(k + 1) % 3];
+      edges.push_back(make_pair(min(a, b), max(a, b)));
+    }
+  }
+  sort(edges.begin(), edges.end());
+  edges.erase(unique(edges.begin(), edges.end()), edges.end());
+
+  for (int i = 0; i < edges.size(); i++)
+    this->PushEdge(edges[i].first, edges[i].second);
+}
+
+/**
+ * Default Destructor.
+ */
+Simplifier::~Simplifier() {
+  // Nothing on the heap that STL won't clean.
+}
+
+/**
+ * Runs the collapse queue, taking a snapshot each time the live triangle
+ * count falls to the next target. Stops early once a level would fall
+ * below MIN_LOD_TRIANGLES or no more valid collapses remain.
+ * @param levels - maximum number of reduced levels to produce
+ * @param ratio - fraction of triangles kept from one level to the next
+ * @param lods - receives one index array per produced level (LOD1, LOD2...)
+ * @return the number of levels produced
+ */
+int Simplifier::buildLODs(int levels, float ratio,
+                          vector<vector<GLuint> >& lods) {
+  int target = static_cast<int>(liveTris * ratio);
+  int produced = 0;
+
+  while (produced < levels && target >= MIN_LOD_TRIANGLES && !heap.empty()) {
+    Collapse c = heap.front();
+    pop_heap(heap.begin(), heap.end(), CollapseGreater);
+    heap.pop_back();
+
+    // Lazily discard entries made stale by earlier collapses.
+    if (dead[c.from] || dead[c.to] || stamps[c.from] != c.stampFrom ||
+        stamps[c.to] != c.stampTo || this->Flips(c.from, c.to))
+      continue;
+
+    this->ApplyCollapse(c.from, c.to);
+
+    if (liveTris <= target || heap.empty()) {
+      lods.push_back(vector<GLuint>());
+      this->Emit(lods.back());
+      produced++;
+      target = static_cast<int>(liveTris * ratio);
+    }
+  }
+
+  return produced;
+}
+
+/**
+ * Joins the per-corner VBO vertices that share a position into single
+ * welded vertices, and records the first corner of each as its
+ * representative in the VBO.
+ */
+void Simplifier::Weld(const vector<VBOVertex>& vbo, const vector<GLuint>& ibo) {
+  vector<pair<glm::vec3, GLuint> > corners;
+  vector<GLuint> weldOf(ibo.size());
+  int nCorners = ibo.size();
+
+  for (int i = 0; i < nCorners; i++) {
+    const GLfloat *p = vbo[ibo[i]].position;
+    corners.push_back(make_pair(glm::vec3(p[0], p[1], p[2]), i));
+  }
+
+  sort(corners.begin(), corners.end(), PositionLess());
+
+  for (int i = 0; i < nCorners; i++) {
+    if (i == 0 || corners[i].first != corners[i - 1].first) {
+      positions.push_back(corners[i].first);
+      reps.push_back(ibo[corners[i].second]);
+    }
+    weldOf[corners[i].second] = positions.size() - 1;
+  }
+
+  vertTris.resize(positions.size());
+  for (int i = 0; i + 2 < nCorners; i += 3) {
+    Triangle t;
+    for (int k = 0; k < 3; k++) {
+      t.v[k] = weldOf[i + k];
+      t.orig[k] = ibo[i + k];
+    }
+    t.removed = (t.v[0] == t.v[1] || t.v[1] == t.v[2] || t.v[2] == t.v[0]);
+
+    tris.push_back(t);
+    if (!t.removed) {
+      for (int k = 0; k < 3; k++)
+        vertTris[t.v[k]].push_back(tris.size() - 1);
+      liveTris++;
+    }
+  }
+
+  stamps.assign(positions.size(), 0);
+  dead.assign(positions.size(), false);
+}
+
+/**
+ * Accumulates the area-weighted face plane quadrics at each vertex, plus
+ * penalty planes along boundary edges.
+ */
+void Simplifier::ComputeQuadrics() {
+  Quadric zero;
+  memset(&zero, 0, sizeof(Quadric));
+  quadrics.assign(positions.size(), zero);
+
+  for (int i = 0; i < tris.size(); i++) {
+    Triangle& t = tris[i];
+    if (t.removed)
+      continue;
+
+    glm::vec3 p0 = positions[t.v[0]];
+    glm::vec3 p1 = positions[t.v[1]];
+    glm::vec3 p2 = positions[t.v[2]];
+    glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+    float area = glm::length(n);
+    if (area <= 0.0f)
+      continue;
+    n /= area;
+
+    Quadric Q;
+    PlaneQuadric(Q, n, -glm::dot(n, p0), area * 0.5);
+    for (int k = 0; k < 3; k++)
+      AddQuadric(quadrics[t.v[k]], Q);
+
+    // An edge is open if no other triangle at its first vertex shares it.
+    for (int k = 0; k < 3; k++) {
+      GLuint a = t.v[k], b = t.v[(k + 1) % 3];
+      int shared = 0;
+
+      for (int j = 0; j < vertTris[a].size(); j++) {
+        Triangle& o = tris[vertTris[a][j]];
+        if (vertTris[a][j] != i &&
+            (o.v[0] == b || o.v[1] == b || o.v[2] == b))
+          shared++;
+      }
+
+      if (!shared) {
+        glm::vec3 edge = positions[b] - positions[a];
+        glm::vec3 side = glm::cross(edge, n);
+        float len = glm::length(side);
+        if (len <= 0.0f)
+          continue;
+        side /= len;
+
+        Quadric B;
+        PlaneQuadric(B, side, -glm::dot(side, positions[a]),
+                     BOUNDARY_WEIGHT * glm::dot(edge, edge));
+        AddQuadric(quadrics[a], B);
+        AddQuadric(quadrics[b], B);
+      }
+    }
+  }
+}
+
+/**
+ * Heap ordering for the collapse queue (cheapest on top).
+ */
+bool Simplifier::CollapseGreater(const Collapse& a, const Collapse& b) {
+  return a.cost > b.cost;
+}
+
+/**
+ * Queues the cheaper direction of collapsing the edge (a, b).
+ */
+void Simplifier::PushEdge(GLuint a, GLuint b) {
+  Collapse c;
+  double costAB = QuadricError(quadrics[a], quadrics[b], positions[b]);
+  double costBA = QuadricError(quadrics[a], quadrics[b], positions[a]);
+
+  c.from = costAB <= costBA ? a : b;
+  c.to = costAB <= costBA ? b : a;
+  c.cost = costAB <= costBA ? costAB : costBA;
+  c.stampFrom = stamps[c.from];
+  c.stampTo = stamps[c.to];
+
+  heap.push_back(c);
+  push_heap(heap.begin(), heap.end(), CollapseGreater);
+}
+
+/**
+ * Tests whether moving 'from' onto 'to' would flip (or nearly flip) any
+ * triangle that survives the collapse.
+ */
+bool Simplifier::Flips(GLuint from, GLuint to) {
+  vector<int>& faces = vertTris[from];
+
+  for (int i = 0; i < faces.size(); i++) {
+    Triangle& t = tris[faces[i]];
+    if (t.removed || t.v[0] == to || t.v[1] == to || t.v[2] == to)
+      continue;
+
+    glm::vec3 p[3], q[3];
+    for (int k = 0; k < 3; k++) {
+      p[k] = positions[t.v[k]];
+      q[k] = t.v[k] == from ? positions[to] : p[k];
+    }
+
+    glm::vec3 nOld = glm::cross(p[1] - p[0], p[2] - p[0]);
+    glm::vec3 nNew = glm::cross(q[1] - q[0], q[2] - q[0]);
+    float lOld = glm::length(nOld), lNew = glm::length(nNew);
+    if (lNew <= 0.0f)
+      return true;
+    if (lOld > 0.0f && glm::dot(nOld, nNew) < FOLD_TOLERANCE * lOld * lNew)
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * Moves 'from' onto 'to', retires the triangles on the collapsed edge, and
+ * re-queues every edge now touching 'to'.
+ */
+void Simplifier::ApplyCollapse(GLuint from, GLuint to) {
+  vector<int>& faces = vertTris[from];
+  vector<int> live;
+
+  for (int i = 0; i < faces.size(); i++) {
+    Triangle& t = tris[faces[i]];
+    if (t.removed)
+      continue;
+
+    if (t.v[0] == to || t.v[1] == to || t.v[2] == to) {
+      t.removed = true;
+      liveTris--;
+      continue;
+    }
+
+    for (int k = 0; k < 3; k++) {
+      if (t.v[k] == from) {
+        t.v[k] = to;
+        t.orig[k] = reps[to];
+      }
+    }
+    vertTris[to].push_back(faces[i]);
+  }
+  faces.clear();
+
+  AddQuadric(quadrics[to], quadrics[from]);
+  dead[from] = true;
+  stamps[to]++;
+
+  // Compact the surviving faces at 'to' and collect its neighbors.
+  vector<int>& toFaces = vertTris[to];
+  vector<GLuint> neighbors;
+  for (int i = 0; i < toFaces.size(); i++) {
+    Triangle& t = tris[toFaces[i]];
+    if (t.removed)
+      continue;
+
+    live.push_back(toFaces[i]);
+    for (int k = 0; k < 3; k++) {
+      if (t.v[k] != to)
+        neighbors.push_back(t.v[k]);
+    }
+  }
+  toFaces.swap(live);
+
+  sort(neighbors.begin(), neighbors.end());
+  neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+  for (int i = 0; i < neighbors.size(); i++)
+    this->PushEdge(to, neighbors[i]);
+}
+
+/**
+ * Writes the current live triangles as VBO indices, preserving winding.
+ */
+void Simplifier::Emit(vector<GLuint>& out) {
+  out.reserve(liveTris * 3);
+
+  for (int i = 0; i < tris.size(); i++) {
+    if (tris[i].removed)
+      continue;
+    for (int k = 0; k < 3; k++)
+      out.push_back(tris[i].orig[k]);
+  }
+}
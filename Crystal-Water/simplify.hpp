@@ -0,0 +1,95 @@
+/**
+ * simplify.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  Offline mesh simplification using the quadric error metric of Garland
+ *  and Heckbert ("Surface Simplification Using Quadric Error Metrics",
+ *  SIGGRAPH '97).
+ *
+ *  Notes:
+ *
+ *    Every level of detail produced here is only a new index array. The
+ *    collapses are half-edge collapses (one endpoint moves onto the other),
+ *    so no new vertices are ever created and all levels can share the one
+ *    VBO that Mesh already builds.
+ *
+ *    Mesh stores one VBO vertex per face corner, so the simplifier first
+ *    welds corners by position to recover the connectivity. Corners that
+ *    are never moved keep their original VBO index (and so their texture
+ *    coordinates); moved corners take the index of a corner at their new
+ *    position.
+ *
+ *    Boundary edges are held in place by perpendicular penalty planes so
+ *    open meshes keep their silhouettes.
+ */
+
+#ifndef SIMPLIFY_HPP_
+#define SIMPLIFY_HPP_
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "./mesh.hpp"
+
+
+/**
+ * Symmetric 4x4 error quadric, stored as its upper triangle.
+ */
+typedef struct {
+  double q[10];             /**< a2 ab ac ad b2 bc bd c2 cd d2 */
+} Quadric;
+
+
+/**
+ * Simplifies a single triangle list (one Mesh sub-mesh) into progressively
+ * coarser index arrays over the same vertex array.
+ */
+class Simplifier {
+ public:
+  Simplifier(const std::vector<VBOVertex>& vbo,
+             const std::vector<GLuint>& ibo);
+  ~Simplifier();
+
+  int buildLODs(int levels, float ratio,
+                std::vector<std::vector<GLuint> >& lods);
+
+ private:
+  typedef struct {
+    double cost;
+    GLuint from, to;
+    int stampFrom, stampTo;
+  } Collapse;
+
+  typedef struct {
+    GLuint v[3];            // Welded vertex per corner
+    GLuint orig[3];         // Original VBO index per corner
+    bool removed;
+  } Triangle;
+
+  std::vector<glm::vec3> positions;
+  std::vector<GLuint> reps;
+  std::vector<Triangle> tris;
+  std::vector<std::vector<int> > vertTris;
+  std::vector<Quadric> quadrics;
+  std::vector<int> stamps;
+  std::vector<bool> dead;
+  std::vector<Collapse> heap;
+  int liveTris;
+
+  void Weld(const std::vector<VBOVertex>& vbo,
+            const std::vector<GLuint>& ibo);
+  void ComputeQuadrics();
+  static bool CollapseGreater(const Collapse& a, const Collapse& b);
+  void PushEdge(GLuint a, GLuint b);
+  bool Flips(GLuint from, GLuint to);
+  void ApplyCollapse(GLuint from, GLuint to);
+  void Emit(std::vector<GLuint>& out);
+};
+
+#endif /* SIMPLIFY_HPP_ */
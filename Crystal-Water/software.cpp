@@ -0,0 +1,991 @@
+/**
+ * software.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "./software.hpp"
+#include "./jobs.hpp"
+
+using namespace std;
+
+// The lane helpers below return vectors by value; they are always inlined,
+// so the calling convention for them never matters.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+typedef float Lanes __attribute__((vector_size(32)));
+typedef int LaneMask __attribute__((vector_size(32)));
+
+#define LANE_INLINE static inline __attribute__((always_inline))
+
+const int LANES = 8;                        // Pixels per span
+const float AMBIENT_SCALE = 0.15f;          // As in shader0.frag
+const int CLUSTER_GRID[3] = { CLUSTER_X, CLUSTER_Y, CLUSTER_Z };
+
+typedef SoftwareRenderer::ShadedVertex ShadedVertex;
+typedef SoftwareRenderer::SetupTriangle SetupTriangle;
+
+/**
+ * Everything the raster loop needs for one tile and one triangle.
+ */
+typedef struct {
+  // Frame
+  const ShadedVertex *vertices;
+  const ShadedVertex *extra;                // Current chunk's clipped ones
+  float *depth;
+  int width, height, stride;
+  float zNear, zFar;
+
+  // Tile, with planar float color and transparency accumulators
+  int x0, y0, x1, y1;
+  float *color[3];
+  float *accum[4];
+  float *reveal;
+
+  // Lighting
+  glm::vec3 lightPos, lightAmb, lightDiff, lightSpec;
+  const ClusterLight *pointLights;
+  const GLuint *clusters;
+  const GLuint *lightIndex;
+
+  // Material of the current triangle
+  const TexImage *textures;                 // Layers, or NULL if untextured
+  int nLayers;
+  int shading;
+  float opacity;
+  bool transparent;
+
+  long long fragments;
+} RasterJob;
+
+typedef void (*RasterFunction)(RasterJob& job, const SetupTriangle& tri);
+
+
+/*********************************
+ * Lane helpers
+ */
+
+LANE_INLINE Lanes Splat(float f) {
+  Lanes r = { f, f, f, f, f, f, f, f };
+  return r;
+}
+
+LANE_INLINE Lanes Load(const float *p) {
+  Lanes r;
+  memcpy(&r, p, sizeof(r));
+  return r;
+}
+
+LANE_INLINE void Store(float *p, const Lanes& v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+LANE_INLINE Lanes Max(const Lanes& a, const Lanes& b) {
+  return a > b ? a : b;
+}
+
+LANE_INLINE Lanes Clamp01(const Lanes& a) {
+  Lanes zero = Splat(0.0f), one = Splat(1.0f);
+  Lanes low = a < zero ? zero : a;
+  return low > one ? one : low;
+}
+
+LANE_INLINE Lanes Dot(const Lanes *a, const Lanes *b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+LANE_INLINE void Normalize(Lanes *a) {
+  Lanes len = Dot(a, a);
+
+  for (int i = 0; i < LANES; i++)
+    len[i] = 1.0f / sqrtf(len[i]);
+  a[0] *= len;
+  a[1] *= len;
+  a[2] *= len;
+}
+
+LANE_INLINE bool Any(const LaneMask& m) {
+  for (int i = 0; i < LANES; i++) {
+    if (m[i])
+      return true;
+  }
+  return false;
+}
+
+/**
+ * shader0.frag Specular() for unit L and V.
+ */
+LANE_INLINE Lanes Specular(const Lanes *N, const Lanes *L, const Lanes *V,
+                           const Lanes& shiny, int shading) {
+  Lanes dir[3], base;
+
+  if (shading == SHADING_BLINN) {
+    for (int c = 0; c < 3; c++)
+      dir[c] = L[c] + V[c];
+    Normalize(dir);
+    base = Max(Dot(N, dir), Splat(0.0f));
+  } else {
+    // normalize(reflect(-L, N))
+    Lanes twoNL = Dot(N, L) * Splat(2.0f);
+    for (int c = 0; c < 3; c++)
+      dir[c] = N[c] * twoNL - L[c];
+    Normalize(dir);
+    base = Max(Dot(dir, V), Splat(0.0f));
+  }
+
+  for (int i = 0; i < LANES; i++)
+    base[i] = powf(base[i], shiny[i]);
+  return base;
+}
+
+/**
+ * Bilinear, repeating lookup in one texture layer.
+ */
+static void SampleTexture(const TexImage& img, float s, float t,
+                          float *rgba) {
+  float u = (s - floorf(s)) * img.width - 0.5f;
+  float v = (t - floorf(t)) * img.height - 0.5f;
+  int x0 = static_cast<int>(floorf(u)), y0 = static_cast<int>(floorf(v));
+  float fx = u - x0, fy = v - y0;
+  int x1 = x0 + 1, y1 = y0 + 1;
+
+  x0 = (x0 + img.width) % img.width;   x1 = x1 % img.width;
+  y0 = (y0 + img.height) % img.height; y1 = y1 % img.height;
+
+  const unsigned char *a = img.pixels + (y0 * img.width + x0) * 4;
+  const unsigned char *b = img.pixels + (y0 * img.width + x1) * 4;
+  const unsigned char *c = img.pixels + (y1 * img.width + x0) * 4;
+  const unsigned char *d = img.pixels + (y1 * img.width + x1) * 4;
+  for (int k = 0; k < 4; k++) {
+    float top = a[k] + (b[k] - a[k]) * fx;
+    float bottom = c[k] + (d[k] - c[k]) * fx;
+    rgba[k] = (top + (bottom - top) * fy) / 255.0f;
+  }
+}
+
+/**
+ * shader0.frag ClusterIndex() for one pixel.
+ */
+static int ClusterIndex(const RasterJob& job, int x, int y, float depth) {
+  int tx = static_cast<int>((x + 0.5f) / job.width * CLUSTER_GRID[0]);
+  int ty = static_cast<int>((y + 0.5f) / job.height * CLUSTER_GRID[1]);
+  float slice = logf(depth / job.zNear) / logf(job.zFar / job.zNear);
+  float z = slice * CLUSTER_GRID[2];
+
+  // Also catches the NaN of a point behind the eye.
+  if (!(z > 0.0f))
+    z = 0.0f;
+  z = min(z, CLUSTER_GRID[2] - 1.0f);
+  tx = min(tx, CLUSTER_GRID[0] - 1);
+  ty = min(ty, CLUSTER_GRID[1] - 1);
+
+  return (static_cast<int>(z) * CLUSTER_GRID[1] + ty) * CLUSTER_GRID[0] + tx;
+}
+
+/**
+ * shader0.frag main() over eight pixels of row y starting at column x.
+ * @param attr - interpolated outputs of shader0.vert, per lane
+ * @param tex - receives texColor, per lane
+ * @param out - receives the clamped color, per lane
+ */
+LANE_INLINE void Shade(const RasterJob& job, const Lanes *attr, int x, int y,
+                       float texLayer, const LaneMask& mask, Lanes *tex,
+                       Lanes *out) {
+  const Lanes *v = attr, *N = attr + 3, *matDiff = attr + 8;
+  const Lanes *matSpec = attr + 11;
+  Lanes L[3], V[3], diffuse[3], specular[3], nDotL, spec;
+
+  for (int c = 0; c < 4; c++)
+    tex[c] = Splat(1.0f);
+
+  if (job.textures) {
+    int layer = min(max(static_cast<int>(texLayer), 0), job.nLayers - 1);
+    const TexImage& img = job.textures[layer];
+
+    for (int i = 0; i < LANES; i++) {
+      float rgba[4];
+      if (!mask[i])
+        continue;
+      SampleTexture(img, attr[6][i], attr[7][i], rgba);
+      for (int c = 0; c < 4; c++)
+        tex[c][i] = rgba[c];
+    }
+  }
+
+  if (job.shading == SHADING_UNLIT) {
+    for (int c = 0; c < 3; c++)
+      out[c] = matDiff[c] * tex[c];
+    return;
+  }
+
+  for (int c = 0; c < 3; c++) {
+    L[c] = Splat(job.lightPos[c]) - v[c];
+    V[c] = -v[c];
+  }
+  Normalize(L);
+  Normalize(V);
+
+  nDotL = Max(Dot(N, L), Splat(0.0f));
+  spec = Specular(N, L, V, attr[14], job.shading);
+  for (int c = 0; c < 3; c++) {
+    diffuse[c] = Clamp01(Splat(job.lightDiff[c]) * matDiff[c] * nDotL);
+    specular[c] = Clamp01(Splat(job.lightSpec[c]) * matSpec[c] * spec);
+  }
+
+  // Point lights differ per pixel, so one lane at a time.
+  if (job.pointLights) {
+    for (int i = 0; i < LANES; i++) {
+      if (!mask[i])
+        continue;
+
+      glm::vec3 p(v[0][i], v[1][i], v[2][i]);
+      glm::vec3 n(N[0][i], N[1][i], N[2][i]);
+      glm::vec3 view(V[0][i], V[1][i], V[2][i]);
+      int cluster = ClusterIndex(job, x + i, y, -p.z);
+      GLuint first = job.clusters[2 * cluster];
+      GLuint count = job.clusters[2 * cluster + 1];
+
+      for (GLuint k = first; k < first + count; k++) {
+        const ClusterLight& light = job.pointLights[job.lightIndex[k]];
+        glm::vec3 toLight = glm::vec3(light.positionRadius) - p;
+        float dist = glm::length(toLight);
+        float falloff = glm::min(glm::max(
+            1.0f - dist / light.positionRadius.w, 0.0f), 1.0f);
+        glm::vec3 Lp = toLight / dist;
+        glm::vec3 dir;
+        float s;
+
+        if (job.shading == SHADING_BLINN) {
+          dir = glm::normalize(Lp + view);
+          s = powf(glm::max(glm::dot(n, dir), 0.0f), attr[14][i]);
+        } else {
+          dir = glm::normalize(n * (2.0f * glm::dot(n, Lp)) - Lp);
+          s = powf(glm::max(glm::dot(dir, view), 0.0f), attr[14][i]);
+        }
+
+        falloff *= falloff;
+        for (int c = 0; c < 3; c++) {
+          diffuse[c][i] += light.color[c] * matDiff[c][i] *
+                           glm::max(glm::dot(n, Lp), 0.0f) * falloff;
+          specular[c][i] += light.color[c] * matSpec[c][i] * s * falloff;
+        }
+      }
+    }
+  }
+
+  for (int c = 0; c < 3; c++)
+    out[c] = Clamp01(Splat(job.lightAmb[c] * AMBIENT_SCALE) +
+                     diffuse[c] * tex[c] + specular[c]);
+}
+
+/**
+ * Rasterizes one triangle inside the job's tile: coverage with a top-left
+ * fill rule, perspective-correct interpolation, the depth test (LEQUAL),
+ * shading, and then either a depth and color write or, for transparent
+ * materials, the weighted blended accumulation of oit.hpp.
+ */
+LANE_INLINE void RasterBody(RasterJob& job, const SetupTriangle& tri) {
+  const ShadedVertex *vtx[3];
+  float x[3], y[3], z[3], invW[3];
+  float a[3], b[3], c[3];
+  bool topLeft[3];
+  const Lanes lane = { 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f };
+  const LaneMask laneIndex = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+  for (int k = 0; k < 3; k++) {
+    vtx[k] = tri.v[k] >= 0 ? job.vertices + tri.v[k] : job.extra + ~tri.v[k];
+    x[k] = vtx[k]->screen[0];
+    y[k] = vtx[k]->screen[1];
+    z[k] = vtx[k]->screen[2];
+    invW[k] = vtx[k]->screen[3];
+  }
+
+  // Edge e runs from corner e to corner e + 1; it weighs corner e + 2.
+  for (int e = 0; e < 3; e++) {
+    int j = (e + 1) % 3;
+    a[e] = y[e] - y[j];
+    b[e] = x[j] - x[e];
+    c[e] = (y[j] - y[e]) * x[e] - (x[j] - x[e]) * y[e];
+    topLeft[e] = a[e] > 0.0f || (a[e] == 0.0f && b[e] < 0.0f);
+  }
+  float invArea = 1.0f / (c[0] + c[1] + c[2]);
+
+  float lowX = min(x[0], min(x[1], x[2])), highX = max(x[0], max(x[1], x[2]));
+  float lowY = min(y[0], min(y[1], y[2])), highY = max(y[0], max(y[1], y[2]));
+  int colMin = max(job.x0, static_cast<int>(ceilf(lowX - 0.5f)));
+  int colMax = min(job.x1 - 1, static_cast<int>(floorf(highX - 0.5f)));
+  int rowMin = max(job.y0, static_cast<int>(ceilf(lowY - 0.5f)));
+  int rowMax = min(job.y1 - 1, static_cast<int>(floorf(highY - 0.5f)));
+
+  for (int py = rowMin; py <= rowMax; py++) {
+    Lanes fy = Splat(py + 0.5f);
+    float *depthRow = job.depth + py * job.stride;
+    int tileRow = (py - job.y0) * SW_TILE_SIZE;
+
+    for (int px = colMin & ~(LANES - 1); px <= colMax; px += LANES) {
+      Lanes fx = Splat(static_cast<float>(px)) + lane;
+      Lanes e[3];
+      LaneMask mask = laneIndex + px >= colMin && laneIndex + px <= colMax;
+
+      for (int k = 0; k < 3; k++) {
+        e[k] = Splat(a[k]) * fx + Splat(b[k]) * fy + Splat(c[k]);
+        mask = mask && (topLeft[k] ? e[k] >= Splat(0.0f) :
+                                     e[k] > Splat(0.0f));
+      }
+      if (!Any(mask))
+        continue;
+
+      // Screen-space weights for depth, then corrected by 1/w.
+      Lanes w0 = e[1] * Splat(invArea);
+      Lanes w1 = e[2] * Splat(invArea);
+      Lanes w2 = e[0] * Splat(invArea);
+      Lanes fragZ = w0 * Splat(z[0]) + w1 * Splat(z[1]) + w2 * Splat(z[2]);
+      Lanes oldZ = Load(depthRow + px);
+
+      mask = mask && fragZ <= oldZ;
+      if (!Any(mask))
+        continue;
+
+      w0 *= Splat(invW[0]);
+      w1 *= Splat(invW[1]);
+      w2 *= Splat(invW[2]);
+      Lanes norm = Splat(1.0f) / (w0 + w1 + w2);
+      w0 *= norm;
+      w1 *= norm;
+      w2 *= norm;
+
+      Lanes attr[SW_ATTRIBUTES], tex[4], rgb[3];
+      for (int k = 0; k < SW_ATTRIBUTES; k++)
+        attr[k] = w0 * Splat(vtx[0]->attr[k]) + w1 * Splat(vtx[1]->attr[k]) +
+                  w2 * Splat(vtx[2]->attr[k]);
+
+      Shade(job, attr, px, py, tri.texLayer, mask, tex, rgb);
+
+      int t = tileRow + px - job.x0;
+      if (!job.transparent) {
+        Store(depthRow + px, mask ? fragZ : oldZ);
+        for (int k = 0; k < 3; k++) {
+          Lanes old = Load(job.color[k] + t);
+          Store(job.color[k] + t, mask ? rgb[k] : old);
+        }
+      } else {
+        // Weight() in shader0.frag, on the eye-space z (attr[2], its v.z),
+        // then the two blend functions.
+        Lanes alpha = Splat(job.opacity) * tex[3];
+        Lanes weight;
+        for (int i = 0; i < LANES; i++) {
+          float d = powf(fabsf(attr[2][i]) / 200.0f, 4.0f);
+          weight[i] = alpha[i] * min(max(0.03f / (1e-5f + d), 1e-2f), 3e3f);
+        }
+        Lanes contrib[4] = { rgb[0] * alpha * weight, rgb[1] * alpha * weight,
+                             rgb[2] * alpha * weight, alpha * weight };
+        Lanes zero = Splat(0.0f);
+        for (int k = 0; k < 4; k++) {
+          Lanes old = Load(job.accum[k] + t);
+          Store(job.accum[k] + t, old + (mask ? contrib[k] : zero));
+        }
+        Lanes keep = Load(job.reveal + t);
+        Store(job.reveal + t, mask ? keep * (Splat(1.0f) - alpha) : keep);
+      }
+
+      for (int i = 0; i < LANES; i++)
+        job.fragments += mask[i] ? 1 : 0;
+    }
+  }
+}
+
+static void RasterBaseline(RasterJob& job, const SetupTriangle& tri) {
+  RasterBody(job, tri);
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+__attribute__((target("avx2,fma")))
+static void RasterAVX2(RasterJob& job, const SetupTriangle& tri) {
+  RasterBody(job, tri);
+}
+#endif
+
+/**
+ * Picks the widest raster loop the CPU supports.
+ */
+static RasterFunction PickRaster() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return RasterAVX2;
+#endif
+  return RasterBaseline;
+}
+
+static const RasterFunction rasterize = PickRaster();
+
+/**
+ * Window coordinates of a clip-space position in front of the eye.
+ */
+static void Project(ShadedVertex& v, int width, int height) {
+  float inv = 1.0f / v.clip.w;
+
+  v.screen[0] = (v.clip.x * inv * 0.5f + 0.5f) * width;
+  v.screen[1] = (v.clip.y * inv * 0.5f + 0.5f) * height;
+  v.screen[2] = v.clip.z * inv * 0.5f + 0.5f;
+  v.screen[3] = inv;
+}
+
+
+/*********************************
+ * SoftwareRenderer
+ */
+
+/**
+ * Constructor. Allocates the depth and color buffers.
+ * @param width - image width in pixels
+ * @param height - image height in pixels
+ */
+SoftwareRenderer::SoftwareRenderer(int width, int height)
+: width(width),
+  height(height),
+  stride((width + LANES - 1) & ~(LANES - 1)),
+  tilesX((width + SW_TILE_SIZE - 1) / SW_TILE_SIZE),
+  tilesY((height + SW_TILE_SIZE - 1) / SW_TILE_SIZE),
+  lightPos(0.0f),
+  lightAmb(0.0f),
+  lightDiff(1.0f),
+  lightSpec(1.0f),
+  clearColor(1.0f),
+  zNear(1.0f),
+  zFar(100.0f),
+  lights(NULL),
+  nTriangles(0) {
+  chunkTriangles.resize(SW_CHUNKS);
+  chunkVertices.resize(SW_CHUNKS);
+  bins.assign(SW_CHUNKS, vector<vector<int> >(tilesX * tilesY));
+  tileFragments.resize(tilesX * tilesY);
+
+  depth.resize(stride * height);
+  pixels.resize(width * height * 3);
+  memset(&frameStats, 0, sizeof(frameStats));
+}
+
+/**
+ * Default Destructor.
+ */
+SoftwareRenderer::~SoftwareRenderer() {
+}
+
+/**
+ * Sets the key light, as in the Light block of shader0.frag.
+ * @param position - eye-space position
+ * @param ambient - ambient color
+ * @param diffuse - diffuse color
+ * @param specular - specular color
+ */
+void SoftwareRenderer::setLight(const glm::vec3& position,
+                                const glm::vec3& ambient,
+                                const glm::vec3& diffuse,
+                                const glm::vec3& specular) {
+  this->lightPos = position;
+  this->lightAmb = ambient;
+  this->lightDiff = diffuse;
+  this->lightSpec = specular;
+}
+
+/**
+ * Sets the color of pixels nothing is drawn over.
+ * @param color - RGB clear color
+ */
+void SoftwareRenderer::setClearColor(const glm::vec3& color) {
+  this->clearColor = color;
+}
+
+/**
+ * Starts a frame.
+ * @param proj - the projection matrix
+ * @param zNear - near plane distance, for the point light clusters
+ * @param zFar - far plane distance, for the point light clusters
+ */
+void SoftwareRenderer::begin(const glm::mat4& proj, float zNear, float zFar) {
+  this->proj = proj;
+  this->zNear = zNear;
+  this->zFar = zFar;
+  this->draws.clear();
+  this->vertices.clear();
+  this->nTriangles = 0;
+}
+
+/**
+ * Queues a mesh for this frame. The mesh's arrays must still be on the
+ * client side, i.e. it must not have been uploaded.
+ * @param mesh - the mesh
+ * @param modelview - its full modelview matrix
+ * @param lods - detail level of each sub-mesh (0 is full detail)
+ */
+void SoftwareRenderer::drawMesh(Mesh& mesh, const glm::mat4& modelview,
+                                const vector<int>& lods) {
+  vector<vector<GLuint> >& ibos = mesh.getIBOIndexArrays();
+  vector<vector<vector<GLuint> > >& lodArrays = mesh.getLODIndexArrays();
+  DrawRecord draw;
+
+  draw.mesh = &mesh;
+  draw.modelview = modelview;
+  draw.normalMatrix = glm::inverseTranspose(glm::mat3(modelview));
+  draw.lods = lods;
+  draw.lods.resize(ibos.size(), 0);
+  draw.firstVertex = draws.empty() ? 0 :
+      draws.back().firstVertex +
+      draws.back().mesh->getVBOVertexArray().size();
+  draw.firstTriangle = nTriangles;
+
+  for (int s = 0; s < ibos.size(); s++) {
+    int lod = min(draw.lods[s], static_cast<int>(lodArrays[s].size()));
+    draw.lods[s] = lod;
+    this->nTriangles += (lod ? lodArrays[s][lod - 1] : ibos[s]).size() / 3;
+  }
+
+  this->draws.push_back(draw);
+}
+
+/**
+ * Renders everything queued since begin().
+ * @param lights - point lights already updated for this view, or NULL
+ */
+void SoftwareRenderer::finish(LightClusters *lights) {
+  typedef chrono::steady_clock Clock;
+  Clock::time_point t0, t1, t2, t3;
+  int nVertices = draws.empty() ? 0 :
+      draws.back().firstVertex + draws.back().mesh->getVBOVertexArray().size();
+  int nTiles = tilesX * tilesY;
+
+  this->lights = lights;
+  this->vertices.resize(nVertices);
+
+  t0 = Clock::now();
+  jobs.parallelFor(draws.size(), 1, [this](int begin, int end) {
+    for (int d = begin; d < end; d++)
+      this->ShadeVertices(d);
+  });
+
+  t1 = Clock::now();
+  jobs.parallelFor(SW_CHUNKS, 1, [this](int begin, int end) {
+    for (int c = begin; c < end; c++)
+      this->SetupChunk(c);
+  });
+
+  t2 = Clock::now();
+  jobs.parallelFor(nTiles, 1, [this](int begin, int end) {
+    for (int t = begin; t < end; t++)
+      this->RasterTile(t);
+  });
+  t3 = Clock::now();
+
+  frameStats.vertexMillis = chrono::duration<double, milli>(t1 - t0).count();
+  frameStats.setupMillis = chrono::duration<double, milli>(t2 - t1).count();
+  frameStats.rasterMillis = chrono::duration<double, milli>(t3 - t2).count();
+  frameStats.vertices = nVertices;
+  frameStats.triangles = nTriangles;
+  frameStats.binned = 0;
+  frameStats.fragments = 0;
+  for (int c = 0; c < SW_CHUNKS; c++) {
+    for (int t = 0; t < nTiles; t++)
+      frameStats.binned += bins[c][t].size();
+  }
+  for (int t = 0; t < nTiles; t++)
+    frameStats.fragments += tileFragments[t];
+}
+
+/**
+ * Writes the last frame as a binary PPM.
+ * @param filename - output path
+ * @return true on success
+ */
+bool SoftwareRenderer::writeImage(const string& filename) {
+  return writePPM(filename, width, height, &pixels[0]);
+}
+
+/**
+ * Compares the last frame with an image of the same size, such as one
+ * saved from the GL window.
+ * @param filename - PPM to compare against
+ * @param meanError - receives the mean absolute difference per channel
+ * @param maxError - receives the largest difference of any channel
+ * @return false if the image could not be read or differs in size
+ */
+bool SoftwareRenderer::compareImage(const string& filename,
+                                    double& meanError, int& maxError) {
+  vector<unsigned char> other;
+  int w, h;
+  long long total = 0;
+
+  if (!readPPM(filename, w, h, other))
+    return false;
+  if (w != width || h != height) {
+    cout << filename << " is " << w << "x" << h << ", not " << width << "x"
+         << height << "." << endl;
+    return false;
+  }
+
+  maxError = 0;
+  for (int i = 0; i < pixels.size(); i++) {
+    int diff = abs(static_cast<int>(pixels[i]) - other[i]);
+    total += diff;
+    maxError = max(maxError, diff);
+  }
+  meanError = static_cast<double>(total) / pixels.size();
+
+  return true;
+}
+
+/**
+ * Retrieves the work and timing of the last finish().
+ * @return stage statistics
+ */
+const SoftwareStats& SoftwareRenderer::stats() {
+  return this->frameStats;
+}
+
+/**
+ * Writes an RGB8 image as a binary PPM.
+ * @param filename - output path
+ * @param width - width in pixels
+ * @param height - height in pixels
+ * @param rgb - pixels, bottom row first (as glReadPixels() gives them)
+ * @return true on success
+ */
+bool SoftwareRenderer::writePPM(const string& filename, int width, int height,
+                                const unsigned char *rgb) {
+  FILE *file = fopen(filename.c_str(), "wb");
+  bool ok;
+
+  if (!file) {
+    cout << "Could not write " << filename << "." << endl;
+    return false;
+  }
+
+  fprintf(file, "P6\n%d %d\n255\n", width, height);
+  ok = true;
+  for (int y = height - 1; y >= 0 && ok; y--)
+    ok = fwrite(rgb + y * width * 3, 3, width, file) == width;
+  fclose(file);
+
+  return ok;
+}
+
+/**
+ * Reads a binary PPM written by writePPM().
+ * @param filename - input path
+ * @param width - receives the width
+ * @param height - receives the height
+ * @param rgb - receives the pixels, bottom row first
+ * @return true on success
+ */
+bool SoftwareRenderer::readPPM(const string& filename, int& width,
+                               int& height, vector<unsigned char>& rgb) {
+  FILE *file = fopen(filename.c_str(), "rb");
+  int maxValue;
+  bool ok;
+
+  if (!file) {
+    cout << "Could not read " << filename << "." << endl;
+    return false;
+  }
+
+  ok = fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) == 3 &&
+       maxValue == 255 && fgetc(file) != EOF;
+  if (ok) {
+    rgb.resize(width * height * 3);
+    for (int y = height - 1; y >= 0 && ok; y--)
+      ok = fread(&rgb[y * width * 3], 3, width, file) == width;
+  }
+  fclose(file);
+
+  if (!ok)
+    cout << filename << " is not an 8-bit binary PPM." << endl;
+  return ok;
+}
+
+/**
+ * Vertex stage for one draw: shader0.vert, then the viewport transform.
+ */
+void SoftwareRenderer::ShadeVertices(int draw) {
+  DrawRecord& rec = draws[draw];
+  vector<VBOVertex>& vbo = rec.mesh->getVBOVertexArray();
+  glm::mat4 mvp = proj * rec.modelview;
+
+  for (int i = 0; i < vbo.size(); i++) {
+    const VBOVertex& in = vbo[i];
+    ShadedVertex& out = vertices[rec.firstVertex + i];
+    glm::vec4 loc(in.position[0], in.position[1], in.position[2], 1.0f);
+    glm::vec3 normal(-in.normal[0], -in.normal[1], -in.normal[2]);
+    glm::vec3 v = glm::vec3(rec.modelview * loc);
+    glm::vec3 N = glm::normalize(rec.normalMatrix * normal);
+
+    out.clip = mvp * loc;
+    for (int c = 0; c < 3; c++) {
+      out.attr[c] = v[c];
+      out.attr[3 + c] = N[c];
+      out.attr[8 + c] = in.diffuse[c];
+      out.attr[11 + c] = in.specular[c];
+    }
+    out.attr[6] = in.texture[0];
+    out.attr[7] = in.texture[1];
+    out.attr[14] = in.shininess;
+    out.texLayer = in.texLayer;
+
+    if (out.clip.z >= -out.clip.w)
+      Project(out, width, height);
+  }
+}
+
+/**
+ * Setup stage for one chunk of the frame's triangles.
+ */
+void SoftwareRenderer::SetupChunk(int chunk) {
+  int begin = static_cast<long long>(nTriangles) * chunk / SW_CHUNKS;
+  int end = static_cast<long long>(nTriangles) * (chunk + 1) / SW_CHUNKS;
+  int d = 0, t = begin;
+
+  chunkTriangles[chunk].clear();
+  chunkVertices[chunk].clear();
+  for (int i = 0; i < bins[chunk].size(); i++)
+    bins[chunk][i].clear();
+
+  // The last draw starting at or before this chunk.
+  while (d + 1 < draws.size() && draws[d + 1].firstTriangle <= begin)
+    d++;
+
+  for (; t < end; d++) {
+    DrawRecord& rec = draws[d];
+    int local = t - rec.firstTriangle;
+
+    for (int s = 0; s < rec.lods.size() && t < end; s++) {
+      int lod = rec.lods[s];
+      vector<GLuint>& indices = lod ?
+          rec.mesh->getLODIndexArrays()[s][lod - 1] :
+          rec.mesh->getIBOIndexArrays()[s];
+      int n = indices.size() / 3;
+
+      if (local >= n) {
+        local -= n;
+        continue;
+      }
+
+      for (; local < n && t < end; local++, t++) {
+        int index[3];
+        const ShadedVertex *corners[3];
+
+        for (int k = 0; k < 3; k++) {
+          index[k] = rec.firstVertex + indices[3 * local + k];
+          corners[k] = &vertices[index[k]];
+        }
+        this->EmitTriangle(chunk, corners, d, s, index);
+      }
+      local = 0;
+    }
+  }
+}
+
+/**
+ * Clips a triangle against the near plane and bins what is left.
+ */
+void SoftwareRenderer::EmitTriangle(int chunk, const ShadedVertex *corners[3],
+                                    int draw, int submesh,
+                                    const int index[3]) {
+  vector<ShadedVertex>& extra = chunkVertices[chunk];
+  int poly[4];
+  int n = 0;
+  SetupTriangle tri;
+
+  tri.draw = draw;
+  tri.submesh = submesh;
+  tri.texLayer = corners[2]->texLayer;
+
+  // Inside the near plane: z + w >= 0.
+  for (int i = 0; i < 3; i++) {
+    const ShadedVertex& a = *corners[i];
+    const ShadedVertex& b = *corners[(i + 1) % 3];
+    float da = a.clip.z + a.clip.w, db = b.clip.z + b.clip.w;
+
+    if (da >= 0.0f)
+      poly[n++] = index[i];
+    if ((da >= 0.0f) != (db >= 0.0f)) {
+      float t = da / (da - db);
+      ShadedVertex v;
+
+      v.clip = a.clip + (b.clip - a.clip) * t;
+      for (int k = 0; k < SW_ATTRIBUTES; k++)
+        v.attr[k] = a.attr[k] + (b.attr[k] - a.attr[k]) * t;
+      v.texLayer = a.texLayer;
+      Project(v, width, height);
+
+      extra.push_back(v);
+      poly[n++] = ~static_cast<int>(extra.size() - 1);
+    }
+  }
+
+  // A triangle, or a quad split into two.
+  for (int k = 1; k + 1 < n; k++) {
+    float x[3], y[3];
+
+    tri.v[0] = poly[0];
+    tri.v[1] = poly[k];
+    tri.v[2] = poly[k + 1];
+    for (int j = 0; j < 3; j++) {
+      const ShadedVertex& v = tri.v[j] >= 0 ? vertices[tri.v[j]] :
+                                              extra[~tri.v[j]];
+      x[j] = v.screen[0];
+      y[j] = v.screen[1];
+    }
+    this->BinTriangle(chunk, tri, x, y);
+  }
+}
+
+/**
+ * Puts a projected triangle, wound counter-clockwise, into the bins of the
+ * tiles its bounding box touches.
+ */
+void SoftwareRenderer::BinTriangle(int chunk, SetupTriangle& tri,
+                                   const float x[3], const float y[3]) {
+  float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  int colMin, colMax, rowMin, rowMax;
+
+  // No face culling in the GL path either; just fix the winding.
+  if (area == 0.0f || area != area)
+    return;
+  if (area < 0.0f)
+    swap(tri.v[1], tri.v[2]);
+
+  colMin = max(0, static_cast<int>(ceilf(
+      min(x[0], min(x[1], x[2])) - 0.5f)));
+  colMax = min(width - 1, static_cast<int>(floorf(
+      max(x[0], max(x[1], x[2])) - 0.5f)));
+  rowMin = max(0, static_cast<int>(ceilf(
+      min(y[0], min(y[1], y[2])) - 0.5f)));
+  rowMax = min(height - 1, static_cast<int>(floorf(
+      max(y[0], max(y[1], y[2])) - 0.5f)));
+  if (colMin > colMax || rowMin > rowMax)
+    return;
+
+  tri.tileMinX = colMin / SW_TILE_SIZE;
+  tri.tileMaxX = colMax / SW_TILE_SIZE;
+  tri.tileMinY = rowMin / SW_TILE_SIZE;
+  tri.tileMaxY = rowMax / SW_TILE_SIZE;
+
+  vector<SetupTriangle>& tris = chunkTriangles[chunk];
+  tris.push_back(tri);
+  for (int ty = tri.tileMinY; ty <= tri.tileMaxY; ty++) {
+    for (int tx = tri.tileMinX; tx <= tri.tileMaxX; tx++)
+      bins[chunk][ty * tilesX + tx].push_back(tris.size() - 1);
+  }
+}
+
+/**
+ * Raster stage for one tile: opaque triangles, then transparent ones and
+ * their composite, then the 8-bit resolve.
+ */
+void SoftwareRenderer::RasterTile(int tile) {
+  const int area = SW_TILE_SIZE * SW_TILE_SIZE;
+  static thread_local vector<float> storage(area * 8);
+  RasterJob job;
+  bool anyTransparent = false;
+
+  job.vertices = vertices.empty() ? NULL : &vertices[0];
+  job.depth = &depth[0];
+  job.width = width;
+  job.height = height;
+  job.stride = stride;
+  job.zNear = zNear;
+  job.zFar = zFar;
+  job.x0 = (tile % tilesX) * SW_TILE_SIZE;
+  job.y0 = (tile / tilesX) * SW_TILE_SIZE;
+  job.x1 = min(job.x0 + SW_TILE_SIZE, width);
+  job.y1 = min(job.y0 + SW_TILE_SIZE, height);
+  for (int c = 0; c < 3; c++)
+    job.color[c] = &storage[c * area];
+  for (int c = 0; c < 4; c++)
+    job.accum[c] = &storage[(3 + c) * area];
+  job.reveal = &storage[7 * area];
+  job.lightPos = lightPos;
+  job.lightAmb = lightAmb;
+  job.lightDiff = lightDiff;
+  job.lightSpec = lightSpec;
+  job.pointLights = NULL;
+  job.clusters = NULL;
+  job.lightIndex = NULL;
+  if (lights && lights->numIndices()) {
+    job.pointLights = &lights->viewLights()[0];
+    job.clusters = &lights->clusterRanges()[0];
+    job.lightIndex = &lights->lightIndices()[0];
+  }
+  job.fragments = 0;
+
+  for (int c = 0; c < 3; c++)
+    fill_n(job.color[c], area, clearColor[c]);
+  fill_n(job.accum[0], 4 * area, 0.0f);
+  fill_n(job.reveal, area, 1.0f);
+  for (int y = job.y0; y < job.y1; y++)
+    fill(depth.begin() + y * stride + job.x0,
+         depth.begin() + y * stride + job.x1, 1.0f);
+
+  for (int pass = 0; pass < 2; pass++) {
+    if (pass == 1 && !anyTransparent)
+      break;
+
+    for (int c = 0; c < SW_CHUNKS; c++) {
+      vector<int>& bin = bins[c][tile];
+
+      job.extra = chunkVertices[c].empty() ? NULL : &chunkVertices[c][0];
+      for (int i = 0; i < bin.size(); i++) {
+        const SetupTriangle& tri = chunkTriangles[c][bin[i]];
+        Mesh& mesh = *draws[tri.draw].mesh;
+        SubmeshMaterial& material = mesh.getMaterials()[tri.submesh];
+        vector<TexImage>& images = mesh.getTextureImages();
+
+        job.transparent = material.opacity < 1.0f;
+        if (job.transparent != (pass == 1)) {
+          anyTransparent = anyTransparent || job.transparent;
+          continue;
+        }
+
+        job.textures = material.textured && !images.empty() ?
+                       &images[0] : NULL;
+        job.nLayers = images.size();
+        job.shading = material.shading;
+        job.opacity = material.opacity;
+        rasterize(job, tri);
+      }
+    }
+  }
+
+  // composite.frag, blended over the opaque color.
+  for (int y = job.y0; y < job.y1; y++) {
+    for (int x = job.x0; x < job.x1; x++) {
+      int t = (y - job.y0) * SW_TILE_SIZE + x - job.x0;
+      unsigned char *out = &pixels[(y * width + x) * 3];
+      float revealage = job.reveal[t];
+
+      for (int c = 0; c < 3; c++) {
+        float color = job.color[c][t];
+
+        if (revealage < 1.0f) {
+          float average = job.accum[c][t] / max(job.accum[3][t], 1e-5f);
+          color = average * (1.0f - revealage) + color * revealage;
+        }
+        color = min(max(color, 0.0f), 1.0f);
+        out[c] = static_cast<unsigned char>(color * 255.0f + 0.5f);
+      }
+    }
+  }
+
+  tileFragments[tile] = job.fragments;
+}
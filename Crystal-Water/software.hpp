@@ -0,0 +1,176 @@
+/**
+ * software.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  A software renderer for the scene: the shader0 Phong model evaluated on
+ *  the CPU, with no OpenGL at all. Used for regression images and for
+ *  timing on machines without a usable GL driver (main.cpp --software).
+ *
+ *  Notes:
+ *
+ *    The intended order of use, every frame, is:
+ *
+ *          begin()             // projection and view parameters
+ *          drawMesh()          // once per object, with its LOD levels
+ *          finish()            // runs the three stages below
+ *
+ *    finish() works in three stages, each spread over the job pool:
+ *
+ *      1. Vertex: every vertex of every drawMesh() is run through the
+ *         shader0.vert math (eye-space position and normal, clip position)
+ *         and projected to the screen, one job per draw.
+ *      2. Setup: triangles are split into SW_CHUNKS jobs, clipped against
+ *         the near plane and sorted into the SW_TILE_SIZE square screen
+ *         tiles their bounding boxes touch. Each job has its own tile
+ *         bins, so no locks are needed and submission order is kept.
+ *      3. Raster: one job per tile walks the bins in order, first opaque
+ *         and then transparent triangles, eight pixels of a row at a time.
+ *         Coverage, depth test and the whole shader0.frag model (Phong or
+ *         Blinn, texture, clustered point lights, weighted blended
+ *         transparency) are evaluated over the eight lanes at once, then
+ *         the tile is resolved to 8-bit color.
+ *
+ *    The lanes are GCC vector extensions, so the raster loop is compiled
+ *    twice: for AVX2/FMA, used when the CPU has it (chosen at run time),
+ *    and for the baseline instruction set. Both give the same image.
+ *
+ *    Differences from the GL path are kept to what cannot be matched
+ *    exactly: textures are sampled bilinearly from their full-size image
+ *    (no mipmaps), depth is a float rather than 24 bits, and transparency
+ *    accumulates in floats rather than half floats. compareImage() checks
+ *    an image against one written from the GL window (key 'p'), which
+ *    draws that frame without the crystal's probe reflections and
+ *    without the ray traced crystal.
+ */
+
+#ifndef SOFTWARE_HPP_
+#define SOFTWARE_HPP_
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+#include "./mesh.hpp"
+#include "./cluster.hpp"
+
+
+const int SW_TILE_SIZE = 32;                // Tile edge; a multiple of 8
+const int SW_CHUNKS = 64;                   // Setup jobs per frame
+const int SW_ATTRIBUTES = 15;               // v, N, texCoord, matDiff,
+                                            // matSpec, shiny
+
+/**
+ * Work and time spent in each stage of the last finish().
+ */
+typedef struct {
+  double vertexMillis;                      /**< Vertex stage */
+  double setupMillis;                       /**< Clipping and binning */
+  double rasterMillis;                      /**< Raster, shading, resolve */
+  int vertices;                             /**< Vertices shaded */
+  int triangles;                            /**< Triangles submitted */
+  int binned;                               /**< Triangle-tile pairs */
+  long long fragments;                      /**< Pixels shaded */
+} SoftwareStats;
+
+
+/**
+ * Tile-binned, multithreaded CPU rasterizer for shader0.
+ */
+class SoftwareRenderer {
+ public:
+  SoftwareRenderer(int width, int height);
+  ~SoftwareRenderer();
+
+  void setLight(const glm::vec3& position, const glm::vec3& ambient,
+                const glm::vec3& diffuse, const glm::vec3& specular);
+  void setClearColor(const glm::vec3& color);
+
+  void begin(const glm::mat4& proj, float zNear, float zFar);
+  void drawMesh(Mesh& mesh, const glm::mat4& modelview,
+                const std::vector<int>& lods);
+  void finish(LightClusters *lights = NULL);
+
+  bool writeImage(const std::string& filename);
+  bool compareImage(const std::string& filename, double& meanError,
+                    int& maxError);
+  const SoftwareStats& stats();
+
+  static bool writePPM(const std::string& filename, int width, int height,
+                       const unsigned char *rgb);
+  static bool readPPM(const std::string& filename, int& width, int& height,
+                      std::vector<unsigned char>& rgb);
+
+  /**
+   * One vertex after the vertex stage.
+   */
+  typedef struct {
+    glm::vec4 clip;                         /**< Clip-space position */
+    float screen[4];                        /**< Window x, y, z and 1/w */
+    float attr[SW_ATTRIBUTES];              /**< Interpolated outputs */
+    float texLayer;                         /**< Flat texture layer */
+  } ShadedVertex;
+
+  /**
+   * One set-up triangle. Vertex indices at or above zero are into the
+   * vertex stage output, and ~index below zero into the extra vertices
+   * made by near-plane clipping in the same chunk.
+   */
+  typedef struct {
+    int v[3];
+    int draw, submesh;
+    float texLayer;                         /**< From the provoking vertex */
+    int tileMinX, tileMaxX, tileMinY, tileMaxY;
+  } SetupTriangle;
+
+ private:
+  /**
+   * One drawMesh() call.
+   */
+  typedef struct {
+    Mesh *mesh;
+    glm::mat4 modelview;
+    glm::mat3 normalMatrix;
+    std::vector<int> lods;
+    int firstVertex;
+    int firstTriangle;
+  } DrawRecord;
+
+  int width, height, stride;
+  int tilesX, tilesY;
+
+  glm::vec3 lightPos, lightAmb, lightDiff, lightSpec;
+  glm::vec3 clearColor;
+  glm::mat4 proj;
+  float zNear, zFar;
+  LightClusters *lights;
+
+  std::vector<DrawRecord> draws;
+  std::vector<ShadedVertex> vertices;
+  int nTriangles;
+
+  // Setup output, per chunk: triangles, clipped vertices, and tile bins.
+  std::vector<std::vector<SetupTriangle> > chunkTriangles;
+  std::vector<std::vector<ShadedVertex> > chunkVertices;
+  std::vector<std::vector<std::vector<int> > > bins;
+
+  std::vector<float> depth;                 // Window depth, bottom row first
+  std::vector<unsigned char> pixels;        // RGB8, bottom row first
+
+  SoftwareStats frameStats;
+  std::vector<long long> tileFragments;
+
+  void ShadeVertices(int draw);
+  void SetupChunk(int chunk);
+  void RasterTile(int tile);
+  void EmitTriangle(int chunk, const ShadedVertex *corners[3], int draw,
+                    int submesh, const int index[3]);
+  void BinTriangle(int chunk, SetupTriangle& tri, const float x[3],
+                   const float y[3]);
+};
+
+#endif /* SOFTWARE_HPP_ */
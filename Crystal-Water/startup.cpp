@@ -0,0 +1,132 @@
+/**
+ * startup.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <cstdio>
+#include <iostream>
+#include "./startup.hpp"
+
+using namespace std;
+
+
+StartupProfiler startup;
+
+
+/**
+ * Primary Constructor. Starts the clock.
+ */
+StartupProfiler::StartupProfiler()
+: launch(Clock::now()),
+  total(-1.0) {
+  // The global is built during static initialization, on the main
+  // thread, which makes that thread row 0 whoever records first.
+  this->threads.push_back(this_thread::get_id());
+}
+
+/**
+ * Records the start of a stage on the calling thread.
+ * @param stage - name printed in the chart
+ * @return handle for end()
+ */
+int StartupProfiler::begin(const string& stage) {
+  double now = this->elapsedMillis();
+  lock_guard<mutex> guard(lock);
+  Stage s = { stage, this->ThreadIndex(), now, -1.0 };
+
+  this->stages.push_back(s);
+
+  return stages.size() - 1;
+}
+
+/**
+ * Records the end of a stage.
+ * @param stage - handle returned by begin()
+ */
+void StartupProfiler::end(int stage) {
+  double now = this->elapsedMillis();
+  lock_guard<mutex> guard(lock);
+
+  this->stages[stage].end = now;
+}
+
+/**
+ * Ends the timeline, at the first frame, and prints it. Later calls do
+ * nothing, so this may be called after every frame.
+ * @return true if this call ended the timeline
+ */
+bool StartupProfiler::finish() {
+  if (total >= 0.0)
+    return false;
+
+  this->total = this->elapsedMillis();
+  this->print();
+
+  return true;
+}
+
+/**
+ * Prints every stage as a bar across the time from launch to now (or to
+ * the first frame, once finish() has been called).
+ */
+void StartupProfiler::print() {
+  lock_guard<mutex> guard(lock);
+  double span = total >= 0.0 ? total : this->elapsedMillis();
+  double scale = STARTUP_CHART_WIDTH / (span > 0.0 ? span : 1.0);
+  char row[128];
+
+  cout << "Startup, " << span << " ms to "
+       << (total >= 0.0 ? "first frame" : "now") << ":" << endl;
+  for (int i = 0; i < stages.size(); i++) {
+    Stage& s = stages[i];
+    double end = s.end < 0.0 ? span : s.end;
+    int from = static_cast<int>(s.start * scale);
+    int to = static_cast<int>(end * scale);
+    string bar(STARTUP_CHART_WIDTH, ' ');
+    string thread = s.thread ? "job " + to_string(s.thread) : "main";
+
+    for (int c = from; c <= to && c < STARTUP_CHART_WIDTH; c++)
+      bar[c] = '#';
+    snprintf(row, sizeof(row), "  %-24.24s %-6s %8.1f %8.1f%s |%s|",
+             s.name.c_str(), thread.c_str(), s.start, end - s.start,
+             s.end < 0.0 ? "+" : " ", bar.c_str());
+    cout << row << endl;
+  }
+}
+
+/**
+ * Retrieves the time since launch.
+ * @return milliseconds
+ */
+double StartupProfiler::elapsedMillis() {
+  return chrono::duration<double, milli>(Clock::now() - launch).count();
+}
+
+/**
+ * Retrieves the time from launch to the first frame.
+ * @return milliseconds, or a negative number before finish()
+ */
+double StartupProfiler::totalMillis() {
+  return this->total;
+}
+
+/**
+ * Numbers threads in the order they first record a stage, after the main
+ * thread, which the constructor made 0. Called with the lock held.
+ * @return the calling thread's number
+ */
+int StartupProfiler::ThreadIndex() {
+  thread::id self = this_thread::get_id();
+
+  for (int i = 0; i < threads.size(); i++) {
+    if (threads[i] == self)
+      return i;
+  }
+  this->threads.push_back(self);
+
+  return threads.size() - 1;
+}
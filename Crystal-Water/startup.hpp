@@ -0,0 +1,77 @@
+/**
+ * startup.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  A timeline of program startup, from launch to the first presented
+ *  frame: every init stage, the thread it ran on, and when it started and
+ *  finished, printed as one chart once the first frame is up.
+ *
+ *  Notes:
+ *
+ *    Stages may be recorded from any thread, so those run as jobs appear
+ *    on their worker's row beside what the main thread was doing at the
+ *    time:
+ *
+ *          int stage = startup.begin("import skybox.obj");
+ *          ...
+ *          startup.end(stage);
+ *
+ *    Times are measured from the construction of the global `startup`,
+ *    during static initialization, so everything main() does is counted.
+ */
+
+#ifndef STARTUP_HPP_
+#define STARTUP_HPP_
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+const int STARTUP_CHART_WIDTH = 48;         // Columns in the printed chart
+
+/**
+ * Startup stages, in the order they began.
+ */
+class StartupProfiler {
+ public:
+  StartupProfiler();
+
+  int begin(const std::string& stage);
+  void end(int stage);
+  bool finish();
+  void print();
+
+  double elapsedMillis();
+  double totalMillis();
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * One recorded stage; end is negative until it finishes.
+   */
+  typedef struct {
+    std::string name;
+    int thread;
+    double start, end;
+  } Stage;
+
+  Clock::time_point launch;
+  std::mutex lock;
+  std::vector<Stage> stages;
+  std::vector<std::thread::id> threads;     // [0] is the main thread
+  double total;                             // Negative until finish()
+
+  int ThreadIndex();
+};
+
+extern StartupProfiler startup;
+
+#endif /* STARTUP_HPP_ */
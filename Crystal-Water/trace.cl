@@ -1,18 +1,357 @@
-struct VBOVertex {
-  float vPosition[3];
-  float vNormal[3];
-  float vTexCoord[2];
-  float vDiffuse[3];
-  float vSpecular[3];
-  float vShiny;
-  float align;
-};
-
-__kernel void main(__global struct VBOVertex *vbo_array,
-    __global float *ibo_array, __global float matModel[16]) {  
-  const int id = get_global_id(0);
-  float rayVector[3];
-  float eyePos[3];
-  
-  
-}
\ No newline at end of file
+// Ray traced crystal (see raytrace.hpp), in two passes over the scaled
+// image. trace() follows the view ray of each pixel if it hits the
+// crystal, reprojects last frame's result for it, and refracts and
+// reflects a fresh path through the crystal only for a rotating quarter of
+// the pixels and wherever no history survives. resolve() clamps each
+// history to the fresh samples around it and blends in the new one.
+// MAX_BOUNCES, IOR, MAX_SAMPLES and PERIOD (TRACE_TEMPORAL_PERIOD) come
+// from the build options.
+
+#define EPSILON 1e-3f
+#define F0 0.04f
+#define BACKGROUND ((float3)(1.0f, 1.0f, 1.0f))
+
+// History further from the expected depth than this fraction of it is
+// another surface, or was hidden last frame.
+#define DEPTH_TOLERANCE 0.02f
+
+// Must match TraceTriangle in raytrace.hpp.
+typedef struct {
+  float4 v0;                    // xyz; w 1 if crystal
+  float4 e1;                    // v1 - v0; w texture layer, -1 if none
+  float4 e2;                    // v2 - v0
+  float4 uv01;                  // Tex coords of v0 (xy) and v1 (zw)
+  float4 uv2;                   // Tex coords of v2 (xy)
+  float4 color;                 // Diffuse rgb, shininess
+} TraceTriangle;
+
+// Handed from trace() to resolve(). This and History must both stay
+// TRACE_TEXEL_BYTES long (raytrace.hpp).
+typedef struct {
+  float4 fresh;                 // rgb traced this frame, eye depth
+  float4 history;               // rgb reprojected, samples behind it
+} TraceSample;
+
+// Last frame's result, kept per pixel between frames.
+typedef struct {
+  float4 color;                 // rgb, eye depth (0 where missed)
+  float4 samples;               // x frames blended into color
+} History;
+
+// Column-major 4x4 matrix (as glm lays it out) times a vector.
+float4 Transform(float16 m, float4 p) {
+  return m.s0123 * p.x + m.s4567 * p.y + m.s89ab * p.z + m.scdef * p.w;
+}
+
+// Nearest triangle along the ray (Moller-Trumbore), or -1. Fills in the
+// distance and the barycentrics of v1 and v2.
+int Intersect(__global const TraceTriangle *tris, int nTris, float3 o,
+              float3 d, float *tHit, float2 *uvHit) {
+  int best = -1;
+  float tBest = INFINITY;
+
+  for (int i = 0; i < nTris; i++) {
+    float3 e1 = tris[i].e1.xyz;
+    float3 e2 = tris[i].e2.xyz;
+    float3 p = cross(d, e2);
+    float det = dot(e1, p);
+    float inv, u, v, t;
+    float3 s, q;
+
+    if (fabs(det) < 1e-9f)
+      continue;
+    inv = 1.0f / det;
+    s = o - tris[i].v0.xyz;
+    u = dot(s, p) * inv;
+    if (u < 0.0f || u > 1.0f)
+      continue;
+    q = cross(s, e1);
+    v = dot(d, q) * inv;
+    if (v < 0.0f || u + v > 1.0f)
+      continue;
+    t = dot(e2, q) * inv;
+    if (t > EPSILON && t < tBest) {
+      tBest = t;
+      best = i;
+      *uvHit = (float2)(u, v);
+    }
+  }
+
+  *tHit = tBest;
+  return best;
+}
+
+float3 Texel(__global const uchar4 *texels, int4 layer, int x, int y) {
+  uchar4 c;
+
+  x = ((x % layer.y) + layer.y) % layer.y;
+  y = ((y % layer.z) + layer.z) % layer.z;
+  c = texels[layer.x + y * layer.y + x];
+
+  return convert_float3(c.xyz) / 255.0f;
+}
+
+// Bilinear, repeating; rows are stored bottom first, as GL reads them.
+float3 Sample(__global const uchar4 *texels, int4 layer, float2 uv) {
+  float x = uv.x * layer.y - 0.5f;
+  float y = uv.y * layer.z - 0.5f;
+  int x0 = (int) floor(x);
+  int y0 = (int) floor(y);
+  float fx = x - x0;
+  float fy = y - y0;
+  float3 a = mix(Texel(texels, layer, x0, y0),
+                 Texel(texels, layer, x0 + 1, y0), fx);
+  float3 b = mix(Texel(texels, layer, x0, y0 + 1),
+                 Texel(texels, layer, x0 + 1, y0 + 1), fx);
+
+  return mix(a, b, fy);
+}
+
+// Color of a surrounding surface, unlit as a skybox is.
+float3 Surface(__global const TraceTriangle *tris,
+               __global const uchar4 *texels, __global const int4 *layers,
+               int tri, float2 bary) {
+  TraceTriangle t = tris[tri];
+  float2 uv;
+
+  if (t.e1.w < 0.0f)
+    return t.color.xyz;
+
+  uv = t.uv01.xy * (1.0f - bary.x - bary.y) + t.uv01.zw * bary.x +
+       t.uv2.xy * bary.y;
+  return Sample(texels, layers[(int) t.e1.w], uv) * t.color.xyz;
+}
+
+// What a ray leaving the crystal sees. Other crystal faces are not
+// followed any further.
+float3 Environment(__global const TraceTriangle *tris, int nTris,
+                   __global const uchar4 *texels,
+                   __global const int4 *layers, float3 o, float3 d) {
+  float t;
+  float2 bary;
+  int tri = Intersect(tris, nTris, o, d, &t, &bary);
+
+  if (tri < 0 || tris[tri].v0.w > 0.5f)
+    return BACKGROUND;
+  return Surface(tris, texels, layers, tri, bary);
+}
+
+// Whether the pixel traces a fresh path this frame. Fresh paths are traced
+// in a 2x2 pattern, one pixel of it per frame, so PERIOD is 4.
+bool Scheduled(int2 pixel, int frame) {
+  return (pixel.x & 1) + 2 * (pixel.y & 1) == frame % PERIOD;
+}
+
+// Light carried back along a view ray whose first hit, the crystal, is
+// already known.
+float3 Radiance(__global const TraceTriangle *tris, int nTris,
+                __global const uchar4 *texels, __global const int4 *layers,
+                float3 light, float3 o, float3 d, int tri, float t,
+                float2 bary) {
+  float3 result = (float3)(0.0f);
+  float3 throughput = (float3)(1.0f);
+  float3 tint = mix((float3)(1.0f), tris[tri].color.xyz, 0.5f);
+  bool inside = false;
+
+  for (int bounce = 0; bounce < MAX_BOUNCES; bounce++) {
+    float3 p, n, r, h;
+    float eta, cosI, k, fresnel, spec;
+
+    if (bounce > 0) {
+      tri = Intersect(tris, nTris, o, d, &t, &bary);
+      if (tri < 0) {
+        result += throughput * BACKGROUND;
+        break;
+      }
+      if (tris[tri].v0.w < 0.5f) {
+        result += throughput * Surface(tris, texels, layers, tri, bary);
+        break;
+      }
+    }
+
+    p = o + d * t;
+    n = normalize(cross(tris[tri].e1.xyz, tris[tri].e2.xyz));
+    if (dot(n, d) > 0.0f)
+      n = -n;
+    eta = inside ? IOR : 1.0f / IOR;
+    cosI = -dot(d, n);
+    k = 1.0f - eta * eta * (1.0f - cosI * cosI);
+    r = d + 2.0f * cosI * n;
+    fresnel = F0 + (1.0f - F0) * pow(1.0f - cosI, 5.0f);
+
+    // Outside: the reflection and the key light's highlight.
+    if (!inside) {
+      h = normalize(normalize(light - p) - d);
+      spec = pow(max(dot(n, h), 0.0f), max(tris[tri].color.w, 1.0f));
+      result += throughput * (fresnel * Environment(tris, nTris, texels,
+          layers, p + n * EPSILON, r) + 0.6f * spec);
+    }
+
+    // Inside, past the critical angle: reflect and carry on.
+    if (k < 0.0f) {
+      o = p + n * EPSILON;
+      d = r;
+      continue;
+    }
+
+    throughput *= (1.0f - fresnel) * (inside ? (float3)(1.0f) : tint);
+    o = p - n * EPSILON;
+    d = normalize(eta * d + (eta * cosI - sqrt(k)) * n);
+    inside = !inside;
+  }
+
+  return result;
+}
+
+// Last frame's color at scene point p, bilinear over the history texels
+// that saw the same surface. Returns zero samples if none did.
+float4 Reproject(__global const History *history, float16 prevViewProj,
+                 float4 prevViewZ, int2 prevSize, float3 p) {
+  float4 clip = Transform(prevViewProj, (float4)(p, 1.0f));
+  float expected = -dot(prevViewZ, (float4)(p, 1.0f));
+  float4 sum = (float4)(0.0f);
+  float total = 0.0f;
+  float2 ndc, q, f;
+  int2 base;
+
+  if (prevSize.x <= 0 || clip.w <= 0.0f)
+    return sum;
+  ndc = clip.xy / clip.w;
+  if (fabs(ndc.x) > 1.0f || fabs(ndc.y) > 1.0f)
+    return sum;
+
+  q = (ndc * 0.5f + 0.5f) * convert_float2(prevSize) - 0.5f;
+  base = convert_int2(floor(q));
+  f = q - floor(q);
+
+  for (int i = 0; i < 4; i++) {
+    int2 tap = base + (int2)(i & 1, i >> 1);
+    float w = (i & 1 ? f.x : 1.0f - f.x) * (i >> 1 ? f.y : 1.0f - f.y);
+    History h;
+
+    if (tap.x < 0 || tap.y < 0 || tap.x >= prevSize.x ||
+        tap.y >= prevSize.y || w <= 0.0f)
+      continue;
+    h = history[tap.y * prevSize.x + tap.x];
+    if (h.color.w <= 0.0f ||
+        fabs(h.color.w - expected) > DEPTH_TOLERANCE * expected)
+      continue;
+    sum += (float4)(h.color.xyz, h.samples.x) * w;
+    total += w;
+  }
+
+  // A sliver of one texel is too little to stand for the pixel.
+  if (total < 0.25f)
+    return (float4)(0.0f);
+  return sum / total;
+}
+
+__kernel void trace(__global const TraceTriangle *tris, int nTris,
+                    __global const uchar4 *texels,
+                    __global const int4 *layers,
+                    __global TraceSample *samples,
+                    __global const History *history,
+                    float16 inverseViewProj, float4 viewZ, float4 eye,
+                    float4 light, int2 size, float16 prevViewProj,
+                    float4 prevViewZ, int2 prevSize, float2 jitter,
+                    int frame) {
+  int2 pixel = (int2)(get_global_id(0), get_global_id(1));
+  TraceSample s;
+  float2 ndc, bary;
+  float4 pNear, pFar;
+  float3 o, d, p;
+  float t;
+  int tri;
+
+  if (pixel.x >= size.x || pixel.y >= size.y)
+    return;
+
+  // View ray through the pixel, offset within it by this frame's jitter
+  // so the samples a pixel gathers over time cover its whole area.
+  ndc = (convert_float2(pixel) + 0.5f + jitter) / convert_float2(size);
+  ndc = ndc * 2.0f - 1.0f;
+  pNear = Transform(inverseViewProj, (float4)(ndc, -1.0f, 1.0f));
+  pFar = Transform(inverseViewProj, (float4)(ndc, 1.0f, 1.0f));
+  o = eye.xyz;
+  d = normalize(pFar.xyz / pFar.w - pNear.xyz / pNear.w);
+
+  s.fresh = (float4)(0.0f);
+  s.history = (float4)(0.0f);
+
+  // Only rays that first hit the crystal are drawn here; zero depth marks
+  // a pixel it does not cover.
+  tri = Intersect(tris, nTris, o, d, &t, &bary);
+  if (tri >= 0 && tris[tri].v0.w > 0.5f) {
+    p = o + d * t;
+    s.fresh.w = -dot(viewZ, (float4)(p, 1.0f));
+    s.history = Reproject(history, prevViewProj, prevViewZ, prevSize, p);
+    if (s.history.w <= 0.0f || Scheduled(pixel, frame))
+      s.fresh.xyz = Radiance(tris, nTris, texels, layers, light.xyz, o, d,
+                             tri, t, bary);
+  }
+
+  samples[pixel.y * size.x + pixel.x] = s;
+}
+
+__kernel void resolve(__global const TraceSample *samples,
+                      __global History *history,
+                      __write_only image2d_t out, int2 size, int frame) {
+  int2 pixel = (int2)(get_global_id(0), get_global_id(1));
+  TraceSample s;
+  History h;
+  float3 lo = (float3)(INFINITY);
+  float3 hi = (float3)(-INFINITY);
+  float3 color;
+  float n;
+  bool fresh;
+
+  if (pixel.x >= size.x || pixel.y >= size.y)
+    return;
+
+  s = samples[pixel.y * size.x + pixel.x];
+  fresh = s.history.w <= 0.0f || Scheduled(pixel, frame);
+
+  // Every 3x3 window holds each pixel of the pattern, so every history
+  // has fresh samples around it to be clamped to.
+  for (int y = -1; y <= 1; y++) {
+    for (int x = -1; x <= 1; x++) {
+      int2 q = pixel + (int2)(x, y);
+      TraceSample nb;
+
+      if (q.x < 0 || q.y < 0 || q.x >= size.x || q.y >= size.y)
+        continue;
+      nb = samples[q.y * size.x + q.x];
+      if (nb.fresh.w <= 0.0f ||
+          fabs(nb.fresh.w - s.fresh.w) > DEPTH_TOLERANCE * s.fresh.w)
+        continue;
+      if (nb.history.w > 0.0f && !Scheduled(q, frame))
+        continue;
+      lo = min(lo, nb.fresh.xyz);
+      hi = max(hi, nb.fresh.xyz);
+    }
+  }
+
+  if (s.fresh.w <= 0.0f) {
+    color = (float3)(0.0f);
+    n = 0.0f;
+  } else if (s.history.w <= 0.0f) {
+    color = s.fresh.xyz;
+    n = 1.0f;
+  } else {
+    // A history outside what its neighbors see now is stale.
+    color = s.history.xyz;
+    if (lo.x <= hi.x)
+      color = clamp(color, lo, hi);
+    n = s.history.w;
+    if (fresh) {
+      n = min(n, (float) MAX_SAMPLES - 1.0f);
+      color = mix(color, s.fresh.xyz, 1.0f / (n + 1.0f));
+      n += 1.0f;
+    }
+  }
+
+  h.color = (float4)(color, s.fresh.w);
+  h.samples = (float4)(n, 0.0f, 0.0f, 0.0f);
+  history[pixel.y * size.x + pixel.x] = h;
+  write_imagef(out, pixel, h.color);
+}
@@ -0,0 +1,250 @@
+/**
+ * transform.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "./transform.hpp"
+#include "./jobs.hpp"
+
+using namespace std;
+
+const int BATCH_SIZE = 4;                   // Matrices per SSE batch
+const int PARALLEL_BATCHES = 256;           // Depth size worth the job pool
+const int BATCHES_PER_JOB = 64;             // parallelFor() grain
+
+static const glm::mat4 IDENTITY(1.0f);
+
+
+/**
+ * Default Constructor. An empty tree.
+ */
+TransformTree::TransformTree() {
+}
+
+/**
+ * Default Destructor.
+ */
+TransformTree::~TransformTree() {
+}
+
+/**
+ * Adds a node. Its world matrix is computed by the next update().
+ * @param parent - an existing node, or TRANSFORM_ROOT
+ * @param local - transform relative to the parent
+ * @return the new node index
+ */
+int TransformTree::addNode(int parent, const glm::mat4& local) {
+  int node = parents.size();
+  int depth = parent == TRANSFORM_ROOT ? 0 : depths[parent] + 1;
+
+  this->parents.push_back(parent);
+  this->depths.push_back(depth);
+  this->children.push_back(vector<int>());
+  this->locals.push_back(local);
+  this->worlds.push_back(local);
+  this->isMoved.push_back(0);
+  this->dirty.push_back(0);
+  if (depth >= levels.size())
+    this->levels.resize(depth + 1);
+  if (parent != TRANSFORM_ROOT)
+    this->children[parent].push_back(node);
+
+  this->setLocal(node, local);
+
+  return node;
+}
+
+/**
+ * Moves a node relative to its parent. The node and all of its
+ * descendants are recomputed by the next update().
+ * @param node - index returned by addNode()
+ * @param local - new transform relative to the parent
+ */
+void TransformTree::setLocal(int node, const glm::mat4& local) {
+  locals[node] = local;
+
+  if (!isMoved[node]) {
+    isMoved[node] = 1;
+    this->moved.push_back(node);
+  }
+}
+
+/**
+ * Recomputes the world matrices of every node moved since the last call
+ * and of everything below them.
+ * @return number of world matrices recomputed (see changed())
+ */
+int TransformTree::update() {
+  this->changedNodes.clear();
+  if (moved.empty())
+    return 0;
+
+  for (int i = 0; i < moved.size(); i++) {
+    isMoved[moved[i]] = 0;
+    this->MarkSubtree(moved[i]);
+  }
+  this->moved.clear();
+
+  // Parents are final before their children read them.
+  for (int d = 0; d < levels.size(); d++) {
+    vector<int>& nodes = levels[d];
+
+    if (nodes.empty())
+      continue;
+
+    this->UpdateLevel(nodes);
+    for (int i = 0; i < nodes.size(); i++)
+      dirty[nodes[i]] = 0;
+    this->changedNodes.insert(changedNodes.end(), nodes.begin(), nodes.end());
+    nodes.clear();
+  }
+
+  return changedNodes.size();
+}
+
+/**
+ * Retrieves a node's transform relative to its parent.
+ * @param node - node index
+ * @return local matrix
+ */
+const glm::mat4& TransformTree::local(int node) {
+  return this->locals[node];
+}
+
+/**
+ * Retrieves a node's scene-space transform as of the last update().
+ * @param node - node index
+ * @return world matrix
+ */
+const glm::mat4& TransformTree::world(int node) {
+  return this->worlds[node];
+}
+
+/**
+ * Retrieves a node's parent.
+ * @param node - node index
+ * @return parent index, or TRANSFORM_ROOT
+ */
+int TransformTree::parent(int node) {
+  return this->parents[node];
+}
+
+/**
+ * Lists the nodes whose world matrix the last update() recomputed, parents
+ * before children.
+ * @return node indices
+ */
+const vector<int>& TransformTree::changed() {
+  return this->changedNodes;
+}
+
+/**
+ * Retrieves the number of nodes.
+ * @return number of nodes
+ */
+int TransformTree::numNodes() {
+  return this->parents.size();
+}
+
+/**
+ * Marks a node and all of its descendants dirty, filing each under its
+ * depth. A subtree that is already dirty is not walked again.
+ */
+void TransformTree::MarkSubtree(int node) {
+  vector<int> stack(1, node);
+
+  while (!stack.empty()) {
+    int n = stack.back();
+    stack.pop_back();
+
+    if (dirty[n])
+      continue;
+
+    dirty[n] = 1;
+    this->levels[depths[n]].push_back(n);
+    stack.insert(stack.end(), children[n].begin(), children[n].end());
+  }
+}
+
+/**
+ * Recomputes the world matrices of one depth's dirty nodes, four at a
+ * time. The last batch repeats its final node to fill all four lanes.
+ */
+void TransformTree::UpdateLevel(const vector<int>& nodes) {
+  int count = nodes.size();
+  int nBatches = (count + BATCH_SIZE - 1) / BATCH_SIZE;
+  const int *ids = &nodes[0];
+
+  function<void(int, int)> body = [this, ids, count](int begin, int end) {
+    for (int b = begin; b < end; b++) {
+      int batch[BATCH_SIZE];
+
+      for (int j = 0; j < BATCH_SIZE; j++) {
+        int i = b * BATCH_SIZE + j;
+        batch[j] = ids[i < count ? i : count - 1];
+      }
+      this->UpdateBatch(batch);
+    }
+  };
+
+  // Nodes of one depth never read each other, so batches may run at once.
+  if (nBatches >= PARALLEL_BATCHES)
+    jobs.parallelFor(nBatches, BATCHES_PER_JOB, body);
+  else
+    body(0, nBatches);
+}
+
+/**
+ * world = parent's world * local, for four nodes of the same depth.
+ */
+void TransformTree::UpdateBatch(const int *nodes) {
+#ifdef __SSE__
+  // p[k][r]: column k, row r of all four parents; likewise l for locals.
+  __m128 p[4][4], l[4][4], out[4];
+
+  for (int k = 0; k < 4; k++) {
+    for (int j = 0; j < BATCH_SIZE; j++) {
+      int n = nodes[j];
+      const glm::mat4& P =
+          parents[n] == TRANSFORM_ROOT ? IDENTITY : worlds[parents[n]];
+
+      p[k][j] = _mm_loadu_ps(&P[k][0]);
+      l[k][j] = _mm_loadu_ps(&locals[n][k][0]);
+    }
+    _MM_TRANSPOSE4_PS(p[k][0], p[k][1], p[k][2], p[k][3]);
+    _MM_TRANSPOSE4_PS(l[k][0], l[k][1], l[k][2], l[k][3]);
+  }
+
+  // Column c of the product, element r: sum over k of P[k][r] * L[c][k].
+  for (int c = 0; c < 4; c++) {
+    for (int r = 0; r < 4; r++) {
+      __m128 sum = _mm_mul_ps(p[0][r], l[c][0]);
+
+      sum = _mm_add_ps(sum, _mm_mul_ps(p[1][r], l[c][1]));
+      sum = _mm_add_ps(sum, _mm_mul_ps(p[2][r], l[c][2]));
+      sum = _mm_add_ps(sum, _mm_mul_ps(p[3][r], l[c][3]));
+      out[r] = sum;
+    }
+    _MM_TRANSPOSE4_PS(out[0], out[1], out[2], out[3]);
+    for (int j = 0; j < BATCH_SIZE; j++)
+      _mm_storeu_ps(&worlds[nodes[j]][c][0], out[j]);
+  }
+#else
+  for (int j = 0; j < BATCH_SIZE; j++) {
+    int n = nodes[j];
+
+    if (parents[n] == TRANSFORM_ROOT)
+      worlds[n] = locals[n];
+    else
+      worlds[n] = worlds[parents[n]] * locals[n];
+  }
+#endif
+}
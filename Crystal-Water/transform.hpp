@@ -0,0 +1,78 @@
+/**
+ * transform.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  A hierarchy of transforms: every node has a local matrix relative to
+ *  its parent, and update() keeps the world (scene-space) matrices of all
+ *  nodes in step, recomputing only what moved.
+ *
+ *  Notes:
+ *
+ *    A node's parent must exist before the node is added, so parents
+ *    always have lower indices than their children.
+ *
+ *    setLocal() only records the node as moved. update() then marks the
+ *    moved nodes and everything below them dirty, and recomputes the
+ *    dirty world matrices one depth at a time, so each parent is final
+ *    before its children read it:
+ *
+ *          world = parent's world * local
+ *
+ *    Within a depth, dirty nodes are multiplied four at a time with SSE.
+ *    The four parents and four locals are transposed into SoA form (one
+ *    register holds one element of all four matrices), multiplied, and
+ *    transposed back. Large depths are split over the job pool.
+ *
+ *    changed() lists the nodes whose world matrix was recomputed by the
+ *    last update(), so that consumers copy and upload only those. When
+ *    nothing moved, update() does no work at all.
+ */
+
+#ifndef TRANSFORM_HPP_
+#define TRANSFORM_HPP_
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+const int TRANSFORM_ROOT = -1;              // Parent of top-level nodes
+
+/**
+ * Parent/child transforms with lazily updated world matrices.
+ */
+class TransformTree {
+ public:
+  TransformTree();
+  ~TransformTree();
+
+  int addNode(int parent, const glm::mat4& local);
+  void setLocal(int node, const glm::mat4& local);
+  int update();
+
+  const glm::mat4& local(int node);
+  const glm::mat4& world(int node);
+  int parent(int node);
+  const std::vector<int>& changed();
+  int numNodes();
+
+ private:
+  std::vector<int> parents, depths;
+  std::vector<std::vector<int> > children;
+  std::vector<glm::mat4> locals, worlds;
+
+  std::vector<int> moved;                   // setLocal() since update()
+  std::vector<char> isMoved, dirty;
+  std::vector<std::vector<int> > levels;    // Dirty nodes by depth
+  std::vector<int> changedNodes;
+
+  void MarkSubtree(int node);
+  void UpdateLevel(const std::vector<int>& nodes);
+  void UpdateBatch(const int *nodes);
+};
+
+#endif /* TRANSFORM_HPP_ */
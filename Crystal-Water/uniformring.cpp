@@ -0,0 +1,113 @@
+/**
+ * uniformring.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include "./uniformring.hpp"
+#include "./glstate.hpp"
+
+using namespace std;
+
+const GLuint64 RING_FENCE_TIMEOUT = 1000000000;   // 1 s, in nanoseconds
+
+
+/**
+ * Default Constructor. The ring does nothing until init().
+ */
+UniformRing::UniformRing()
+: bufferID(0),
+  binding(0),
+  blockSize(0),
+  stride(0),
+  frames(0),
+  slot(-1) {
+}
+
+/**
+ * Default Destructor. Frees the buffer and any pending fences.
+ */
+UniformRing::~UniformRing() {
+  for (int i = 0; i < fences.size(); i++) {
+    if (fences[i])
+      glDeleteSync(fences[i]);
+  }
+  if (bufferID)
+    glDeleteBuffers(1, &bufferID);
+}
+
+/**
+ * Creates the buffer. Requires a GL context.
+ * @param binding - uniform block binding point to bind each slot to
+ * @param blockSize - size of the std140 block in bytes
+ * @param frames - number of slots, i.e. frames that may be in flight
+ */
+void UniformRing::init(GLuint binding, GLsizeiptr blockSize, int frames) {
+  GLint align = 256;
+
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+
+  this->binding = binding;
+  this->blockSize = blockSize;
+  this->stride = ((blockSize + align - 1) / align) * align;
+  this->frames = frames;
+  this->slot = -1;
+  this->fences.assign(frames, static_cast<GLsync>(0));
+
+  glGenBuffers(1, &bufferID);
+  glBindBuffer(GL_UNIFORM_BUFFER, bufferID);
+  glBufferData(GL_UNIFORM_BUFFER, stride * frames, NULL, GL_STREAM_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/**
+ * Writes one view's block into the next slot and binds it. Call once per
+ * view drawn (the window, a probe face), before any draw that reads it.
+ * @param data - blockSize bytes laid out as the std140 block
+ */
+void UniformRing::push(const void *data) {
+  if (!bufferID)
+    return;
+
+  // Every command that read the previous slot has been issued by now.
+  if (slot >= 0)
+    this->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  this->slot = (slot + 1) % frames;
+
+  if (fences[slot]) {
+    GLenum wait = glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT,
+                                   RING_FENCE_TIMEOUT);
+    if (wait == GL_TIMEOUT_EXPIRED || wait == GL_WAIT_FAILED)
+      cout << "Uniform ring slot still in use; writing anyway." << endl;
+    glDeleteSync(fences[slot]);
+    this->fences[slot] = 0;
+  }
+
+  glState.bindBuffer(GL_UNIFORM_BUFFER, bufferID);
+  void *dest = glMapBufferRange(GL_UNIFORM_BUFFER, slot * stride, blockSize,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+  if (dest) {
+    memcpy(dest, data, blockSize);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+  } else {
+    glBufferSubData(GL_UNIFORM_BUFFER, slot * stride, blockSize, data);
+  }
+
+  glState.bindBufferRange(GL_UNIFORM_BUFFER, binding, bufferID,
+      slot * stride, blockSize);
+}
+
+/**
+ * Accessor function for the buffer ID.
+ * @return the uniform buffer ID
+ */
+GLuint UniformRing::getBufferId() {
+  return this->bufferID;
+}
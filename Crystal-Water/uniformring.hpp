@@ -0,0 +1,53 @@
+/**
+ * uniformring.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  A uniform buffer split into one slot per frame in flight, for constants
+ *  that are rewritten every frame (matrices, time, viewport).
+ *
+ *  Notes:
+ *
+ *    Each push() writes the next slot and binds it to the block's binding
+ *    point with glBindBufferRange(). Because the GPU may still be reading
+ *    the slots of earlier frames, every slot is fenced when the ring moves
+ *    past it and is only written again once that fence has signalled. The
+ *    write itself is then unsynchronized, so the driver never stalls or
+ *    copies the buffer behind our back.
+ *
+ *    Slots are padded to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+ */
+
+#ifndef UNIFORMRING_HPP_
+#define UNIFORMRING_HPP_
+
+#include <GL/glew.h>
+
+#include <vector>
+
+
+/**
+ * Ring of per-frame uniform block slots in one buffer.
+ */
+class UniformRing {
+ public:
+  UniformRing();
+  ~UniformRing();
+
+  void init(GLuint binding, GLsizeiptr blockSize, int frames);
+  void push(const void *data);
+
+  GLuint getBufferId();
+
+ private:
+  GLuint bufferID;
+  GLuint binding;
+  GLsizeiptr blockSize, stride;
+  int frames, slot;
+  std::vector<GLsync> fences;
+};
+
+#endif /* UNIFORMRING_HPP_ */
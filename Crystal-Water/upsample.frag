@@ -0,0 +1,68 @@
+#version 420
+
+// Upsamples the ray traced crystal (see raytrace.hpp) to the window. Only
+// the traceInfo.zw texels at the lower left of traceTex were traced; each
+// holds a color and the eye-space depth, or zero depth for a miss.
+
+uniform sampler2D traceTex;
+uniform vec4 traceInfo;                     // Scale x, y; traced w, h
+uniform vec4 depthRange;                    // Near, far
+
+out vec4 fragColor;
+
+// Texels further behind the nearest one than this fraction of its depth
+// are another surface, and are left out of the blend.
+const float depthEdge = 0.05;
+
+// Pulls the crystal this fraction nearer, so it wins over the rasterized
+// crystal at the same depth.
+const float depthBias = 0.001;
+
+void main() {
+    vec2 p = gl_FragCoord.xy * traceInfo.xy - 0.5;
+    ivec2 base = ivec2(floor(p));
+    vec2 f = p - vec2(base);
+    ivec2 last = ivec2(traceInfo.zw) - 1;
+    vec4 t[4];
+    float w[4];
+    float coverage = 0.0;
+    float nearest = depthRange.y;
+    float total = 0.0;
+    vec3 color = vec3(0.0);
+    float n = depthRange.x;
+    float fz = depthRange.y;
+    float d;
+
+    t[0] = texelFetch(traceTex, clamp(base, ivec2(0), last), 0);
+    t[1] = texelFetch(traceTex, clamp(base + ivec2(1, 0), ivec2(0), last), 0);
+    t[2] = texelFetch(traceTex, clamp(base + ivec2(0, 1), ivec2(0), last), 0);
+    t[3] = texelFetch(traceTex, clamp(base + ivec2(1, 1), ivec2(0), last), 0);
+    w[0] = (1.0 - f.x) * (1.0 - f.y);
+    w[1] = f.x * (1.0 - f.y);
+    w[2] = (1.0 - f.x) * f.y;
+    w[3] = f.x * f.y;
+
+    // Bilinear coverage decides the silhouette, at full resolution.
+    for (int i = 0; i < 4; i++) {
+        if (t[i].a > 0.0 && w[i] > 0.0) {
+            coverage += w[i];
+            nearest = min(nearest, t[i].a);
+        }
+    }
+    if (coverage < 0.5)
+        discard;
+
+    // Blend only the covered texels on the nearest surface.
+    for (int i = 0; i < 4; i++) {
+        if (t[i].a > 0.0 && t[i].a - nearest < depthEdge * nearest) {
+            color += t[i].rgb * w[i];
+            total += w[i];
+        }
+    }
+
+    fragColor = vec4(color / max(total, 1e-5), 1.0);
+
+    // Eye depth back to window depth, so the scene can hide the crystal.
+    d = nearest * (1.0 - depthBias);
+    gl_FragDepth = (fz + n) / (2.0 * (fz - n)) - fz * n / ((fz - n) * d) + 0.5;
+}
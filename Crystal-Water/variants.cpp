@@ -0,0 +1,217 @@
+/**
+ * variants.cpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ */
+
+#include <iostream>
+
+#include "./variants.hpp"
+
+using namespace std;
+
+
+/**
+ * Picks the variant bits a sub-mesh's material needs. The draw path adds
+ * VARIANT_INSTANCED and VARIANT_ENVIRONMENT itself.
+ * @param material - the sub-mesh's material (see Mesh::getMaterials())
+ * @return variant key
+ */
+unsigned MaterialVariant(const SubmeshMaterial& material) {
+  unsigned key = 0;
+
+  if (material.textured)
+    key |= VARIANT_TEXTURED;
+  if (material.shading == SHADING_BLINN)
+    key |= VARIANT_BLINN;
+  else if (material.shading == SHADING_UNLIT)
+    key |= VARIANT_UNLIT;
+  if (material.opacity < 1.0f)
+    key |= VARIANT_TRANSPARENT;
+
+  return key;
+}
+
+
+/**
+ * Default Constructor.
+ */
+ProgramVariants::ProgramVariants() {
+}
+
+/**
+ * Default Destructor. Frees every variant's Program.
+ */
+ProgramVariants::~ProgramVariants() {
+  map<unsigned, Variant>::iterator it;
+
+  for (it = variants.begin(); it != variants.end(); ++it)
+    delete it->second.program;
+}
+
+/**
+ * Names the shader files every variant is built from.
+ * @param vert - vertex shader file
+ * @param frag - fragment shader file
+ */
+void ProgramVariants::setShaders(const string& vert, const string& frag) {
+  this->vertFile = vert;
+  this->fragFile = frag;
+}
+
+/**
+ * Adds a define to every variant built from now on.
+ * @param name - macro name
+ * @param value - macro value, or empty for a plain #define
+ */
+void ProgramVariants::addDefine(const string& name, const string& value) {
+  this->defines.push_back(make_pair(name, value));
+}
+
+/**
+ * Records an attribute binding for every variant built from now on.
+ * @param location - attribute location
+ * @param name - GLSL attribute name
+ */
+void ProgramVariants::bindAttribute(int location, const string& name) {
+  this->attributes.push_back(make_pair(location, name));
+}
+
+/**
+ * Records a sampler for every variant; added once the variant is linked.
+ * @param name - GLSL sampler name
+ */
+void ProgramVariants::addSampler(const string& name) {
+  this->samplers.push_back(name);
+}
+
+/**
+ * Records a uniform block binding for every variant; applied once the
+ * variant is linked.
+ * @param name - GLSL block name
+ * @param binding - binding point
+ */
+void ProgramVariants::bindUniformBlock(const string& name, GLuint binding) {
+  this->blocks.push_back(make_pair(name, binding));
+}
+
+/**
+ * Starts building a variant without waiting for it. Does nothing if the
+ * variant already exists.
+ * @param key - VARIANT_* bits
+ */
+void ProgramVariants::submit(unsigned key) {
+  if (variants.count(key))
+    return;
+
+  Variant variant;
+  Program *prog = new Program();
+
+  prog->addShader(vertFile, GL_VERTEX_SHADER);
+  prog->addShader(fragFile, GL_FRAGMENT_SHADER);
+  if (key & VARIANT_TEXTURED)
+    prog->addDefine("TEXTURED");
+  if (key & VARIANT_BLINN)
+    prog->addDefine("LIGHTING_BLINN");
+  if (key & VARIANT_UNLIT)
+    prog->addDefine("LIGHTING_UNLIT");
+  if (key & VARIANT_INSTANCED)
+    prog->addDefine("INSTANCED");
+  if (key & VARIANT_TRANSPARENT)
+    prog->addDefine("TRANSPARENT");
+  if (key & VARIANT_ENVIRONMENT)
+    prog->addDefine("ENVIRONMENT");
+  for (int i = 0; i < defines.size(); i++)
+    prog->addDefine(defines[i].first, defines[i].second);
+
+  prog->init();
+  for (int i = 0; i < attributes.size(); i++)
+    prog->bindAttribute(attributes[i].first, attributes[i].second);
+  prog->submit();
+
+  variant.program = prog;
+  variant.ready = false;
+  this->variants[key] = variant;
+}
+
+/**
+ * Waits for every submitted variant to finish building.
+ * @return true if all of them linked and validated
+ */
+bool ProgramVariants::finishAll() {
+  map<unsigned, Variant>::iterator it;
+  bool valid = true;
+
+  for (it = variants.begin(); it != variants.end(); ++it) {
+    if (!it->second.ready)
+      valid = this->Finish(it->second) && valid;
+  }
+
+  return valid;
+}
+
+/**
+ * Retrieves a variant, building it now if it was never submitted.
+ * @param key - VARIANT_* bits
+ * @return the variant's Program
+ */
+Program *ProgramVariants::get(unsigned key) {
+  map<unsigned, Variant>::iterator it = variants.find(key);
+
+  if (it == variants.end()) {
+    this->submit(key);
+    it = variants.find(key);
+  }
+  if (!it->second.ready)
+    this->Finish(it->second);
+
+  return it->second.program;
+}
+
+/**
+ * Hot reload for every variant (see Program::reloadIfChanged()).
+ * @return keys of the variants that were swapped in by this call
+ */
+vector<unsigned> ProgramVariants::reloadIfChanged() {
+  map<unsigned, Variant>::iterator it;
+  vector<unsigned> swapped;
+
+  for (it = variants.begin(); it != variants.end(); ++it) {
+    if (it->second.ready && it->second.program->reloadIfChanged())
+      swapped.push_back(it->first);
+  }
+
+  return swapped;
+}
+
+/**
+ * Retrieves the number of variants built or building.
+ * @return number of variants
+ */
+int ProgramVariants::numVariants() {
+  return this->variants.size();
+}
+
+/**
+ * Completes one variant's build and applies its samplers and blocks.
+ */
+bool ProgramVariants::Finish(Variant& variant) {
+  Program& prog = *variant.program;
+  bool valid = prog.finish();
+
+  variant.ready = true;
+  if (!valid) {
+    cout << "Shader variant failed to build." << endl;
+    return false;
+  }
+
+  for (int i = 0; i < samplers.size(); i++)
+    prog.addSampler(samplers[i]);
+  for (int i = 0; i < blocks.size(); i++)
+    prog.bindUniformBlock(blocks[i].first, blocks[i].second);
+
+  return true;
+}
@@ -0,0 +1,101 @@
+/**
+ * variants.hpp
+ *
+ *    Created on: Oct 19, 2026
+ *   Last Update: Oct 19, 2026
+ *  Orig. Author: Wade Burch (nolnoch@cs.utexas.edu)
+ *  Contributors: [none]
+ *
+ *  Shader permutations: one pair of shader files compiled into several
+ *  Programs, each specialized by preprocessor defines, so that choices
+ *  made per material (texture or not, lighting model) and per draw path
+ *  (plain or instanced) cost nothing per vertex or per fragment.
+ *
+ *  Notes:
+ *
+ *    A variant is named by a key made of VARIANT_* bits. Each bit becomes
+ *    one define at the top of both shaders:
+ *
+ *          VARIANT_TEXTURED    TEXTURED        sample the array texture
+ *          VARIANT_BLINN       LIGHTING_BLINN  Blinn-Phong specular
+ *          VARIANT_UNLIT       LIGHTING_UNLIT  texture/diffuse color only
+ *          VARIANT_INSTANCED   INSTANCED       matrices from the SSBO
+ *          VARIANT_TRANSPARENT TRANSPARENT     write the OIT targets
+ *          VARIANT_ENVIRONMENT ENVIRONMENT     reflect/refract the probe
+ *
+ *    MaterialVariant() picks the bits a sub-mesh's material asks for.
+ *    VARIANT_INSTANCED and VARIANT_ENVIRONMENT are added by the draw path.
+ *    Defines that hold for every variant (features the hardware supports,
+ *    say) are added with addDefine() instead.
+ *
+ *    Variants are compiled on first request, or ahead of time with
+ *    submit() and finishAll() so that startup compiles them in parallel.
+ *    Each compiled variant also goes through Program's binary cache, since
+ *    the defines are part of the cache key.
+ */
+
+#ifndef VARIANTS_HPP_
+#define VARIANTS_HPP_
+
+#include <GL/glew.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "./program.hpp"
+#include "./mesh.hpp"
+
+
+// Variant key bits.
+const unsigned VARIANT_TEXTURED = 1 << 0;
+const unsigned VARIANT_BLINN = 1 << 1;
+const unsigned VARIANT_UNLIT = 1 << 2;
+const unsigned VARIANT_INSTANCED = 1 << 3;
+const unsigned VARIANT_TRANSPARENT = 1 << 4;
+const unsigned VARIANT_ENVIRONMENT = 1 << 5;
+
+unsigned MaterialVariant(const SubmeshMaterial& material);
+
+
+/**
+ * A set of Programs built from the same sources with different defines.
+ */
+class ProgramVariants {
+ public:
+  ProgramVariants();
+  ~ProgramVariants();
+
+  void setShaders(const std::string& vert, const std::string& frag);
+  void addDefine(const std::string& name, const std::string& value = "");
+  void bindAttribute(int location, const std::string& name);
+  void addSampler(const std::string& name);
+  void bindUniformBlock(const std::string& name, GLuint binding);
+
+  void submit(unsigned key);
+  bool finishAll();
+  Program *get(unsigned key);
+  std::vector<unsigned> reloadIfChanged();
+
+  int numVariants();
+
+ private:
+  /**
+   * One compiled (or compiling) variant.
+   */
+  typedef struct {
+    Program *program;
+    bool ready;                             /**< finish() has been called */
+  } Variant;
+
+  std::string vertFile, fragFile;
+  std::vector<std::pair<int, std::string> > attributes;
+  std::vector<std::string> samplers;
+  std::vector<std::pair<std::string, GLuint> > blocks;
+  std::vector<std::pair<std::string, std::string> > defines;
+  std::map<unsigned, Variant> variants;
+
+  bool Finish(Variant& variant);
+};
+
+#endif /* VARIANTS_HPP_ */